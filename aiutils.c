@@ -157,6 +157,152 @@ get_asd(const si_t *sih, uint32 **eromptr, uint sp, uint ad, uint st, uint32 *ad
 	return asd;
 }
 
+#ifdef SI_EROM_CACHE
+/*
+ * The EROM describes fixed silicon, so the result of the first successful PCIe
+ * scan is kept for later attaches (Wi-Fi on, devreset) of the same chip. A cached
+ * scan is only reused if chip id/rev/package and EROM base match, the leading
+ * EROM words still checksum the same and the END marker is where it was.
+ */
+#define AI_EROM_CSUM_WORDS	16u
+
+typedef struct ai_erom_cache {
+	bool	valid;
+	uint16	chip;
+	uint16	chiprev;
+	uint16	chippkg;
+	uint16	buscoretype;
+	uint32	erombase;
+	uint32	csum;			/* hndcrc32 of the first AI_EROM_CSUM_WORDS words */
+	uint32	end_off;		/* word offset of the END marker */
+	uint	numcores;
+	uint32	oob_router;
+	uint32	oob_router1;
+	uint	num_br;
+	uint32	br_wrapba[SI_MAXBR];
+	uint	axi_num_wrappers;
+	axi_wrapper_t axi_wrapper[SI_MAX_AXI_WRAPPERS];
+	si_cores_info_t cores_info;	/* backplane addresses only, no mappings */
+} ai_erom_cache_t;
+
+/* attaches are serialized by the bus layer, a single chip is cached */
+static ai_erom_cache_t ai_erom_cache;
+
+#define AI_EROM_CACHE_COPY(dst, src, field) \
+	(void)memcpy_s((dst)->field, sizeof((dst)->field), (src)->field, sizeof((src)->field))
+
+static uint32
+ai_erom_csum(const si_info_t *sii, uint32 *eromptr)
+{
+	uint32 words[AI_EROM_CSUM_WORDS];
+	uint i;
+
+	for (i = 0; i < AI_EROM_CSUM_WORDS; i++) {
+		words[i] = R_REG(sii->osh, &eromptr[i]);
+	}
+
+	return hndcrc32((uint8 *)words, sizeof(words), CRC32_INIT_VALUE);
+}
+
+static bool
+ai_erom_cache_load(si_info_t *sii, uint32 erombase, uint32 *eromptr)
+{
+	const ai_erom_cache_t *c = &ai_erom_cache;
+	si_cores_info_t *cores_info = (si_cores_info_t *)sii->cores_info;
+
+	if (!c->valid || c->chip != sii->pub.chip || c->chiprev != sii->pub.chiprev ||
+		c->chippkg != sii->pub.chippkg || c->erombase != erombase) {
+		return FALSE;
+	}
+	if (R_REG(sii->osh, &eromptr[c->end_off]) != (ER_END | ER_VALID) ||
+		ai_erom_csum(sii, eromptr) != c->csum) {
+		SI_ERROR(("ai_scan: cached EROM of chip 0x%x does not match, rescanning\n",
+			c->chip));
+		return FALSE;
+	}
+
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, coreid);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, coresba);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, coresba2);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, coresba_size);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, coresba2_size);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, wrapba);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, wrapba2);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, wrapba3);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, cia);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, cib);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, csp2ba);
+	AI_EROM_CACHE_COPY(cores_info, &c->cores_info, csp2ba_size);
+
+	if (sii->axi_wrapper) {
+		(void)memcpy_s(sii->axi_wrapper, sizeof(c->axi_wrapper),
+			c->axi_wrapper, sizeof(c->axi_wrapper));
+		sii->axi_num_wrappers = c->axi_num_wrappers;
+	}
+	(void)memcpy_s(sii->br_wrapba, sizeof(sii->br_wrapba),
+		c->br_wrapba, sizeof(c->br_wrapba));
+	sii->num_br = c->num_br;
+	sii->oob_router = c->oob_router;
+	sii->oob_router1 = c->oob_router1;
+	sii->pub.buscoretype = c->buscoretype;
+	sii->numcores = c->numcores;
+
+	sii->attach_prof.scan_cached = TRUE;
+
+	SI_MSG(("ai_scan: reused cached EROM scan, %d cores\n", sii->numcores));
+	return TRUE;
+}
+
+static void
+ai_erom_cache_save(const si_info_t *sii, uint32 erombase, uint32 *erombegin, uint32 *eromend)
+{
+	ai_erom_cache_t *c = &ai_erom_cache;
+	uint i;
+
+	c->valid = FALSE;
+	/* an AXI scan without its wrappers is not worth reusing */
+	if (sii->numcores == 0 || sii->axi_wrapper == NULL) {
+		return;
+	}
+
+	c->chip = sii->pub.chip;
+	c->chiprev = sii->pub.chiprev;
+	c->chippkg = sii->pub.chippkg;
+	c->buscoretype = sii->pub.buscoretype;
+	c->erombase = erombase;
+	c->end_off = (uint32)(eromend - erombegin);
+	c->csum = ai_erom_csum(sii, erombegin);
+	c->numcores = sii->numcores;
+	c->oob_router = sii->oob_router;
+	c->oob_router1 = sii->oob_router1;
+	c->num_br = sii->num_br;
+	(void)memcpy_s(c->br_wrapba, sizeof(c->br_wrapba),
+		sii->br_wrapba, sizeof(sii->br_wrapba));
+	c->axi_num_wrappers = sii->axi_num_wrappers;
+	(void)memcpy_s(c->axi_wrapper, sizeof(c->axi_wrapper),
+		sii->axi_wrapper, sizeof(c->axi_wrapper));
+	(void)memcpy_s(&c->cores_info, sizeof(c->cores_info),
+		sii->cores_info, sizeof(c->cores_info));
+
+	/* mappings belong to the si instance, never reuse them */
+	for (i = 0; i < SI_MAXCORES; i++) {
+		c->cores_info.regs[i] = NULL;
+		c->cores_info.regs2[i] = NULL;
+		c->cores_info.wrappers[i] = NULL;
+		c->cores_info.wrappers2[i] = NULL;
+		c->cores_info.wrappers3[i] = NULL;
+	}
+	c->valid = TRUE;
+}
+
+/* Drop the cached scan, e.g. before attaching to a different dongle */
+void
+ai_erom_cache_invalidate(void)
+{
+	ai_erom_cache.valid = FALSE;
+}
+#endif /* SI_EROM_CACHE */
+
 /* Parse the enumeration rom to identify all cores */
 void
 ai_scan(si_t *sih, void *regs, uint devid)
@@ -166,6 +312,9 @@ ai_scan(si_t *sih, void *regs, uint devid)
 	chipcregs_t *cc = (chipcregs_t *)regs;
 	uint32 erombase, *eromptr, *eromlim;
 	axi_wrapper_t * axi_wrapper = sii->axi_wrapper;
+#ifdef SI_EROM_CACHE
+	uint32 *erombegin;
+#endif /* SI_EROM_CACHE */
 
 	BCM_REFERENCE(devid);
 
@@ -181,7 +330,7 @@ ai_scan(si_t *sih, void *regs, uint devid)
 		sii->curwrap = (void *)((uintptr)regs + SI_CORE_SIZE);
 
 		/* Now point the window at the erom */
-		OSL_PCI_WRITE_CONFIG(sii->osh, PCI_BAR0_WIN, 4, erombase);
+		SI_SET_BAR0_WIN(sii, PCI_BAR0_WIN, bar0win, erombase);
 		eromptr = regs;
 		break;
 
@@ -200,6 +349,13 @@ ai_scan(si_t *sih, void *regs, uint devid)
 	eromlim = eromptr + (ER_REMAPCONTROL / sizeof(uint32));
 	sii->axi_num_wrappers = 0;
 
+#ifdef SI_EROM_CACHE
+	erombegin = eromptr;
+	if (BUSTYPE(sih->bustype) == PCI_BUS && ai_erom_cache_load(sii, erombase, eromptr)) {
+		return;
+	}
+#endif /* SI_EROM_CACHE */
+
 	SI_VMSG(("ai_scan: regs = 0x%p, erombase = 0x%08x, eromptr = 0x%p, eromlim = 0x%p\n",
 	         OSL_OBFUSCATE_BUF(regs), erombase,
 		OSL_OBFUSCATE_BUF(eromptr), OSL_OBFUSCATE_BUF(eromlim)));
@@ -215,6 +371,11 @@ ai_scan(si_t *sih, void *regs, uint devid)
 		cia = get_erom_ent(sih, &eromptr, ER_TAG, ER_CI);
 		if (cia == (ER_END | ER_VALID)) {
 			SI_VMSG(("Found END of erom after %d cores\n", sii->numcores));
+#ifdef SI_EROM_CACHE
+			if (BUSTYPE(sih->bustype) == PCI_BUS) {
+				ai_erom_cache_save(sii, erombase, erombegin, eromptr - 1);
+			}
+#endif /* SI_EROM_CACHE */
 			return;
 		}
 
@@ -563,13 +724,13 @@ _ai_setcoreidx(si_t *sih, uint coreidx, uint use_wrapn)
 #endif /* AXI_TIMEOUTS_NIC */
 			{
 				/* point bar0 window */
-				OSL_PCI_WRITE_CONFIG(sii->osh, PCI_BAR0_WIN, 4, addr);
+				SI_SET_BAR0_WIN(sii, PCI_BAR0_WIN, bar0win, addr);
 			}
 
 			if (PCIE_GEN2(sii))
-				OSL_PCI_WRITE_CONFIG(sii->osh, PCIE2_BAR0_WIN2, 4, wrap);
+				SI_SET_BAR0_WIN(sii, PCIE2_BAR0_WIN2, bar0win2, wrap);
 			else
-				OSL_PCI_WRITE_CONFIG(sii->osh, PCI_BAR0_WIN2, 4, wrap);
+				SI_SET_BAR0_WIN(sii, PCI_BAR0_WIN2, bar0win2, wrap);
 
 			break;
 
@@ -586,8 +747,8 @@ _ai_setcoreidx(si_t *sih, uint coreidx, uint use_wrapn)
 			regs = (volatile uint8 *)regs + PCI_SEC_BAR0_WIN_OFFSET;
 			sii->curwrap = (void *)((uintptr)regs + SI_CORE_SIZE);
 
-			/* point bar0 window */
-			OSL_PCI_WRITE_CONFIG(sii->osh, PCIE2_BAR0_CORE2_WIN, 4, addr);
+			/* point bar0 window, shared with si_backplane_access() */
+			SI_SET_BAR0_WIN(sii, PCIE2_BAR0_CORE2_WIN, second_bar0win, addr);
 			OSL_PCI_WRITE_CONFIG(sii->osh, PCIE2_BAR0_CORE2_WIN2, 4, wrap);
 			break;
 
@@ -976,6 +1137,7 @@ ai_corereg(si_t *sih, uint coreidx, uint regoff, uint mask, uint val)
 	}
 
 	if (!fast) {
+		SI_BAR0_WIN_STAT_INCR(sii, corereg_switch);
 		INTR_OFF(sii, &intr_val);
 
 		/* save current core index */
@@ -984,6 +1146,8 @@ ai_corereg(si_t *sih, uint coreidx, uint regoff, uint mask, uint val)
 		/* switch core */
 		r = (volatile uint32*) ((volatile uchar*) ai_setcoreidx(&sii->pub, coreidx) +
 		               regoff);
+	} else {
+		SI_BAR0_WIN_STAT_INCR(sii, corereg_fast);
 	}
 	ASSERT(r != NULL);
 
@@ -1070,6 +1234,7 @@ ai_corereg_writeonly(si_t *sih, uint coreidx, uint regoff, uint mask, uint val)
 	}
 
 	if (!fast) {
+		SI_BAR0_WIN_STAT_INCR(sii, corereg_switch);
 		INTR_OFF(sii, &intr_val);
 
 		/* save current core index */
@@ -1078,6 +1243,8 @@ ai_corereg_writeonly(si_t *sih, uint coreidx, uint regoff, uint mask, uint val)
 		/* switch core */
 		r = (volatile uint32*) ((volatile uchar*) ai_setcoreidx(&sii->pub, coreidx) +
 		               regoff);
+	} else {
+		SI_BAR0_WIN_STAT_INCR(sii, corereg_fast);
 	}
 	ASSERT(r != NULL);
 
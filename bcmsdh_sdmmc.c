@@ -458,7 +458,10 @@ enum {
 	IOV_HCIREGS,
 	IOV_POWER,
 	IOV_CLOCK,
-	IOV_RXCHAIN
+	IOV_RXCHAIN,
+#ifdef BCMSDIOH_TX_BURST
+	IOV_TXCHAIN_CMD53
+#endif /* BCMSDIOH_TX_BURST */
 };
 
 const bcm_iovar_t sdioh_iovars[] = {
@@ -475,6 +478,9 @@ const bcm_iovar_t sdioh_iovars[] = {
 	{"sd_mode",	IOV_SDMODE,	0, 0,	IOVT_UINT32,	100},
 	{"sd_highspeed", IOV_HISPEED,	0, 0,	IOVT_UINT32,	0 },
 	{"sd_rxchain",  IOV_RXCHAIN,    0, 0, 	IOVT_BOOL,	0 },
+#ifdef BCMSDIOH_TX_BURST
+	{"sd_txchain_cmd53", IOV_TXCHAIN_CMD53, 0, 0, IOVT_UINT32,	0 },
+#endif /* BCMSDIOH_TX_BURST */
 	{NULL, 0, 0, 0, 0, 0 }
 };
 
@@ -689,6 +695,17 @@ sdioh_iovar_op(sdioh_info_t *si, const char *name,
 		int_val = (int32)0;
 		bcopy(&int_val, arg, val_size);
 		break;
+
+#ifdef BCMSDIOH_TX_BURST
+	case IOV_GVAL(IOV_TXCHAIN_CMD53):
+		int_val = (int32)si->tx_chain_cmd53;
+		bcopy(&int_val, arg, val_size);
+		break;
+
+	case IOV_SVAL(IOV_TXCHAIN_CMD53):
+		si->tx_chain_cmd53 = (uint32)int_val;
+		break;
+#endif /* BCMSDIOH_TX_BURST */
 	default:
 		bcmerror = BCME_UNSUPPORTED;
 		break;
@@ -1055,6 +1072,10 @@ sdioh_request_packet_chain(sdioh_info_t *sd, uint fix_inc, uint write, uint func
 	pkt_offset = 0;
 	pnext = pkt;
 
+#ifdef BCMSDIOH_TX_BURST
+	/* one claim covers every CMD53 the chain is split into */
+	sdio_claim_host(sdio_func);
+#endif /* BCMSDIOH_TX_BURST */
 	while (pnext != NULL) {
 		ttl_len = 0;
 		sg_count = 0;
@@ -1086,7 +1107,8 @@ sdioh_request_packet_chain(sdioh_info_t *sd, uint fix_inc, uint write, uint func
 					" sd blk_size=%u\n",
 					__FUNCTION__, sg_count, ARRAYSIZE(sd->sg_list),
 					blk_size));
-				return (SDIOH_API_RC_FAIL);
+				err_ret = -EINVAL;
+				goto exit;
 			}
 			pdata += pkt_offset;
 
@@ -1113,7 +1135,8 @@ sdioh_request_packet_chain(sdioh_info_t *sd, uint fix_inc, uint write, uint func
 		if (ttl_len % blk_size != 0) {
 			sd_err(("%s, data length %d not aligned to block size %d\n",
 				__FUNCTION__,  ttl_len, blk_size));
-			return SDIOH_API_RC_FAIL;
+			err_ret = -EINVAL;
+			goto exit;
 		}
 		blk_num = ttl_len / blk_size;
 		mmc_dat.sg = sd->sg_list;
@@ -1134,19 +1157,33 @@ sdioh_request_packet_chain(sdioh_info_t *sd, uint fix_inc, uint write, uint func
 		if (!fifo)
 			addr += ttl_len;
 
+#ifndef BCMSDIOH_TX_BURST
 		sdio_claim_host(sdio_func);
+#endif /* !BCMSDIOH_TX_BURST */
 		mmc_set_data_timeout(&mmc_dat, sdio_func->card);
 		mmc_wait_for_req(host, &mmc_req);
+#ifndef BCMSDIOH_TX_BURST
 		sdio_release_host(sdio_func);
+#else
+		if (write)
+			sd->tx_chain_cmd53++;
+#endif /* !BCMSDIOH_TX_BURST */
 
 		err_ret = mmc_cmd.error? mmc_cmd.error : mmc_dat.error;
 		if (0 != err_ret) {
 			sd_err(("%s:CMD53 %s failed with code %d\n",
 				__FUNCTION__, write ? "write" : "read", err_ret));
-			return SDIOH_API_RC_FAIL;
+			goto exit;
 		}
 	}
 
+exit:
+#ifdef BCMSDIOH_TX_BURST
+	sdio_release_host(sdio_func);
+#endif /* BCMSDIOH_TX_BURST */
+	if (err_ret)
+		return SDIOH_API_RC_FAIL;
+
 	sd_trace(("%s: Exit\n", __FUNCTION__));
 	return SDIOH_API_RC_SUCCESS;
 }
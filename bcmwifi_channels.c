@@ -182,6 +182,13 @@ static const uint8 wf_5g_160m_chans[] = {
 #define WFC_NCBW_EQ(bw, val)	(FALSE)
 #endif
 
+#ifdef WF_CHSPEC_TBL
+/* The arithmetic helpers stay exported as *_ref for cross checking the tables */
+#define WF_CHSPEC_REF(fn)	fn##_ref
+#else
+#define WF_CHSPEC_REF(fn)	fn
+#endif /* WF_CHSPEC_TBL */
+
 static void wf_chanspec_iter_firstchan(wf_chanspec_iter_t *iter);
 static chanspec_bw_t wf_iter_next_bw(chanspec_bw_t bw);
 static bool wf_chanspec_iter_next_2g(wf_chanspec_iter_t *iter);
@@ -808,7 +815,7 @@ done_read:
  * @return Returns TRUE if the chanspec is malformed, FALSE if it looks good.
  */
 bool
-wf_chspec_malformed(chanspec_t chanspec)
+WF_CHSPEC_REF(wf_chspec_malformed)(chanspec_t chanspec)
 {
 	uint chspec_bw = CHSPEC_BW(chanspec);
 	uint chspec_sb;
@@ -928,7 +935,7 @@ wf_chspec_malformed(chanspec_t chanspec)
  * @return  Returns TRUE if the chanspec is a valid 802.11 channel
  */
 bool
-wf_chspec_valid(chanspec_t chanspec)
+WF_CHSPEC_REF(wf_chspec_valid)(chanspec_t chanspec)
 {
 	chanspec_band_t chspec_band = CHSPEC_BAND(chanspec);
 	chanspec_bw_t chspec_bw = CHSPEC_BW(chanspec);
@@ -2195,7 +2202,7 @@ wf_create_chspec_from_primary(uint primary_channel, chanspec_bw_t bw, chanspec_b
  * @return Returns the channel number of the primary 20MHz channel
  */
 uint8
-wf_chspec_primary20_chan(chanspec_t chspec)
+WF_CHSPEC_REF(wf_chspec_primary20_chan)(chanspec_t chspec)
 {
 	uint center_chan = INVCHANNEL;
 	chanspec_bw_t bw;
@@ -2524,7 +2531,7 @@ wf_mhz2channel(uint freq, uint start_factor)
  * @see  WF_CHAN_FACTOR_6_G
  */
 int
-wf_channel2mhz(uint ch, uint start_factor)
+WF_CHSPEC_REF(wf_channel2mhz)(uint ch, uint start_factor)
 {
 	int freq;
 
@@ -3012,3 +3019,223 @@ wf_create_160160MHz_chspec_sb(uint sb, uint chan0, uint chan1, chanspec_band_t b
 	         sb | WL_CHANSPEC_BW_160160 | band);
 	return wf_chspec_valid(chspec) ? chspec : INVCHANSPEC;
 }
+
+#ifdef WF_CHSPEC_TBL
+/*
+ * Lookup tables for the chanspec helpers used in scan, roam and ACS loops.
+ *
+ * The upper chanspec byte (band, bandwidth, sideband) selects a row, and only
+ * the few combinations that can be well formed get one. Each row keeps, per low
+ * byte, well formed and valid bits plus the primary 20MHz channel. Channel to
+ * frequency conversion gets a table per default band start factor. Everything
+ * is derived from the arithmetic helpers by wf_chspec_tbl_init(), which must run
+ * before the helpers are used concurrently; until then they fall back to the
+ * arithmetic versions.
+ */
+#ifdef WFC_NON_CONT_CHAN
+#define WF_CHSPEC_TBL_ROWS	72u	/* 65 rows in use with 80+80 and 160+160 */
+#else
+#define WF_CHSPEC_TBL_ROWS	48u	/* 41 rows in use with 320MHz */
+#endif /* WFC_NON_CONT_CHAN */
+#define WF_CHSPEC_TBL_NOROW	0xFFu
+
+typedef struct wf_chspec_tbl_row {
+	uint8 wellformed[256 / NBBY];
+	uint8 valid[256 / NBBY];
+	uint8 pri20[256];
+} wf_chspec_tbl_row_t;
+
+static bool wf_chspec_tbl_ready = FALSE;
+static uint8 wf_chspec_tbl_rowidx[256];
+static wf_chspec_tbl_row_t wf_chspec_tbl_rows[WF_CHSPEC_TBL_ROWS];
+/* center frequency in MHz per channel for the 2.4, 5 and 6GHz start factors */
+static int16 wf_chspec_tbl_mhz[3][256];
+
+static int
+wf_chspec_tbl_factor_idx(uint start_factor)
+{
+	switch (start_factor) {
+	case WF_CHAN_FACTOR_2_4_G:
+		return 0;
+	case WF_CHAN_FACTOR_5_G:
+		return 1;
+	case WF_CHAN_FACTOR_6_G:
+		return 2;
+	default:
+		return -1;
+	}
+}
+
+static const wf_chspec_tbl_row_t *
+wf_chspec_tbl_row(chanspec_t chanspec)
+{
+	uint8 row;
+
+	if (!wf_chspec_tbl_ready) {
+		return NULL;
+	}
+	row = wf_chspec_tbl_rowidx[chanspec >> 8];
+	return (row == WF_CHSPEC_TBL_NOROW) ? NULL : &wf_chspec_tbl_rows[row];
+}
+
+/**
+ * Build the chanspec lookup tables from the arithmetic helpers.
+ *
+ * @return BCME_OK, or BCME_NORESOURCE if the row table is too small, in which
+ *         case the arithmetic helpers keep being used.
+ */
+int
+wf_chspec_tbl_init(void)
+{
+	uint hi, lo, f;
+	uint nrows = 0;
+	static const uint factors[] = {
+		WF_CHAN_FACTOR_2_4_G, WF_CHAN_FACTOR_5_G, WF_CHAN_FACTOR_6_G
+	};
+
+	if (wf_chspec_tbl_ready) {
+		return BCME_OK;
+	}
+
+	for (hi = 0; hi < 256; hi++) {
+		wf_chspec_tbl_row_t *row = NULL;
+
+		wf_chspec_tbl_rowidx[hi] = WF_CHSPEC_TBL_NOROW;
+		for (lo = 0; lo < 256; lo++) {
+			chanspec_t chanspec = (chanspec_t)((hi << 8) | lo);
+
+			if (wf_chspec_malformed_ref(chanspec)) {
+				continue;
+			}
+			if (row == NULL) {
+				if (nrows == WF_CHSPEC_TBL_ROWS) {
+					return BCME_NORESOURCE;
+				}
+				wf_chspec_tbl_rowidx[hi] = (uint8)nrows;
+				row = &wf_chspec_tbl_rows[nrows++];
+				bzero(row, sizeof(*row));
+			}
+			setbit(row->wellformed, lo);
+			if (wf_chspec_valid_ref(chanspec)) {
+				setbit(row->valid, lo);
+			}
+			row->pri20[lo] = wf_chspec_primary20_chan_ref(chanspec);
+		}
+	}
+
+	for (f = 0; f < ARRAYSIZE(factors); f++) {
+		for (lo = 0; lo < 256; lo++) {
+			wf_chspec_tbl_mhz[f][lo] = (int16)wf_channel2mhz_ref(lo, factors[f]);
+		}
+	}
+
+	wf_chspec_tbl_ready = TRUE;
+
+	return BCME_OK;
+}
+
+bool
+wf_chspec_malformed(chanspec_t chanspec)
+{
+	const wf_chspec_tbl_row_t *row;
+
+	if (!wf_chspec_tbl_ready) {
+		return wf_chspec_malformed_ref(chanspec);
+	}
+	row = wf_chspec_tbl_row(chanspec);
+
+	return (row == NULL) || !isset(row->wellformed, chanspec & 0xFFu);
+}
+
+bool
+wf_chspec_valid(chanspec_t chanspec)
+{
+	const wf_chspec_tbl_row_t *row;
+
+	if (!wf_chspec_tbl_ready) {
+		return wf_chspec_valid_ref(chanspec);
+	}
+	row = wf_chspec_tbl_row(chanspec);
+
+	return (row != NULL) && isset(row->valid, chanspec & 0xFFu);
+}
+
+uint8
+wf_chspec_primary20_chan(chanspec_t chspec)
+{
+	const wf_chspec_tbl_row_t *row = wf_chspec_tbl_row(chspec);
+
+	if (row == NULL || !isset(row->wellformed, chspec & 0xFFu)) {
+		/* let the arithmetic version deal with (and assert on) malformed input */
+		return wf_chspec_primary20_chan_ref(chspec);
+	}
+
+	return row->pri20[chspec & 0xFFu];
+}
+
+int
+wf_channel2mhz(uint ch, uint start_factor)
+{
+	int f = wf_chspec_tbl_factor_idx(start_factor);
+
+	if (!wf_chspec_tbl_ready || f < 0 || ch > 0xFFu) {
+		return wf_channel2mhz_ref(ch, start_factor);
+	}
+
+	return wf_chspec_tbl_mhz[f][ch];
+}
+
+#ifdef WF_CHSPEC_TBL_CHECK
+/**
+ * Compare the table driven helpers against the arithmetic versions for every
+ * chanspec, and wf_channel2mhz() for every table channel and start factor.
+ * On any mismatch the tables are disabled and the helpers fall back to the
+ * arithmetic versions.
+ *
+ * @return number of mismatches; the first one is returned in first_bad as the
+ *         offending chanspec, or channel for wf_channel2mhz().
+ */
+uint
+wf_chspec_tbl_check(uint32 *first_bad)
+{
+	uint32 c;
+	uint f;
+	uint nbad = 0;
+	static const uint factors[] = {
+		WF_CHAN_FACTOR_2_4_G, WF_CHAN_FACTOR_5_G, WF_CHAN_FACTOR_6_G
+	};
+
+	for (c = 0; c <= 0xFFFFu; c++) {
+		chanspec_t chanspec = (chanspec_t)c;
+		bool malformed = wf_chspec_malformed_ref(chanspec);
+		bool bad;
+
+		bad = (wf_chspec_malformed(chanspec) != malformed) ||
+			(wf_chspec_valid(chanspec) != wf_chspec_valid_ref(chanspec));
+		/* the arithmetic primary20 asserts on malformed input */
+		if (!malformed && (wf_chspec_primary20_chan(chanspec) !=
+			wf_chspec_primary20_chan_ref(chanspec))) {
+			bad = TRUE;
+		}
+		if (bad && (nbad++ == 0) && first_bad) {
+			*first_bad = c;
+		}
+	}
+
+	for (f = 0; f < ARRAYSIZE(factors); f++) {
+		for (c = 0; c <= 0xFFu; c++) {
+			if ((wf_channel2mhz(c, factors[f]) != wf_channel2mhz_ref(c, factors[f])) &&
+				(nbad++ == 0) && first_bad) {
+				*first_bad = c;
+			}
+		}
+	}
+
+	if (nbad) {
+		wf_chspec_tbl_ready = FALSE;
+	}
+
+	return nbad;
+}
+#endif /* WF_CHSPEC_TBL_CHECK */
+#endif /* WF_CHSPEC_TBL */
@@ -42,6 +42,7 @@
 #include <linux/etherdevice.h>
 #include <linux/random.h>
 #include <linux/spinlock.h>
+#include <linux/hrtimer.h>
 #include <linux/ethtool.h>
 #include <linux/proc_fs.h>
 #include <asm/uaccess.h>
@@ -635,6 +636,7 @@ typedef struct dhd_dma_buf {
 } dhd_dma_buf_t;
 
 /* host reordering packts logic */
+#define DHD_REORDER_MAX_SLOTS	256	/* max_idx is a uint8 */
 /* followed the structure to hold the reorder buffers (void **p) */
 typedef struct reorder_info {
 	void **p;
@@ -643,6 +645,14 @@ typedef struct reorder_info {
 	uint8 exp_idx;
 	uint8 max_idx;
 	uint8 pend_pkts;
+#ifdef DHD_HOSTREORDER_TIMER
+	uint8 ifidx;		/* interface the held packets are delivered to */
+	uint32 occ[DHD_REORDER_MAX_SLOTS / 32];	/* slots holding a packet */
+	uint64 hold_start;	/* when the oldest held packet was queued, ns */
+	uint64 *enq_ns;		/* when each slot was filled, ns */
+	struct hrtimer timer;	/* releases held packets if the firmware does not */
+	struct dhd_pub *dhdp;
+#endif /* DHD_HOSTREORDER_TIMER */
 } reorder_info_t;
 
 /* throughput test packet format */
@@ -1171,9 +1181,11 @@ typedef struct dhd_pub {
 	#define WLC_IOCTL_MAXBUF_FWCAP	1024
 	char  fw_capabilities[WLC_IOCTL_MAXBUF_FWCAP];
 	#define MAXSKBPEND 1024
+#ifndef DHD_RXF_RING
 	void *skbbuf[MAXSKBPEND];
 	uint32 store_idx;
 	uint32 sent_idx;
+#endif /* !DHD_RXF_RING */
 #ifdef DHDTCPACK_SUPPRESS
 	uint8 tcpack_sup_mode;		/* TCPACK suppress mode */
 	void *tcpack_sup_module;	/* TCPACK suppress module */
@@ -1197,6 +1209,9 @@ typedef struct dhd_pub {
 #endif /* CUSTOM_SET_CPUCORE */
 	void    *sta_pool;          /* pre-allocated pool of sta objects */
 	void    *staid_allocator;   /* allocator of sta indexes */
+#if defined(PCIE_FULL_DONGLE) && defined(DHD_STA_RCU_HASH)
+	void    *sta_pool_lock;     /* staid_allocator against deferred releases */
+#endif /* PCIE_FULL_DONGLE && DHD_STA_RCU_HASH */
 #ifdef PCIE_FULL_DONGLE
 	bool	flow_rings_inited;	/* set this flag after initializing flow rings */
 #endif /* PCIE_FULL_DONGLE */
@@ -1208,6 +1223,9 @@ typedef struct dhd_pub {
 #endif /* DHD_HTPUT_TUNABLES */
 	void	*flow_ring_table;   /* flow ring table, include prot and bus info */
 	void	*if_flow_lkup;      /* per interface flowid lkup hash table */
+#ifdef DHD_FLOWID_CACHE
+	struct flowid_cache_stats __percpu *flowid_cache_stats; /* per-CPU hit/miss */
+#endif /* DHD_FLOWID_CACHE */
 	void    *flowid_lock;       /* per os lock for flowid info protection */
 	void    *flowring_list_lock;       /* per os lock for flowring list protection */
 	uint8	max_multi_client_flow_rings;
@@ -1391,6 +1409,9 @@ typedef struct dhd_pub {
 	uint64 debug_dump_time_sec;
 	bool hscb_enable;
 	uint32 logset_prsrv_mask;
+#ifdef DHD_EVENTLOG_PASSTHROUGH
+	uint32 logset_text_mask;	/* sets kept in text form with LOGTRACE_BIN_FMT */
+#endif /* DHD_EVENTLOG_PASSTHROUGH */
 #ifdef DHD_PKT_LOGGING
 	struct dhd_pktlog *pktlog;
 	char debug_dump_time_pktlog_str[DEBUG_DUMP_TIME_BUF_LEN];
@@ -1586,6 +1607,49 @@ typedef struct dhd_pkttag_fd {
 #endif
 #endif /* PCIE_FULL_DONGLE */
 
+/*
+ * L2-L4 classification of a data packet, computed once when the packet enters
+ * the driver (dhd_start_xmit/dhd_sendpkt on TX, dhd_rx_frame on RX) and kept
+ * in the last bytes of the packet tag, past the bus specific tag fields.
+ * Offsets are relative to the ethernet header so the result survives bus
+ * header push/pull.
+ */
+typedef struct dhd_pktcls {
+	uint16	ether_type;	/* host order */
+	uint16	flags;		/* DHD_PKTCLS_F_xxx */
+	uint16	dport;		/* TCP/UDP destination port, host order */
+	uint8	l4_off;		/* L4 header offset from the ethernet header */
+	uint8	ip_prot;	/* IPv4 protocol or IPv6 next header */
+} dhd_pktcls_t;
+
+#define DHD_PKTCLS_F_VALID	0x0001u
+#define DHD_PKTCLS_F_MCAST	0x0002u	/* multicast/broadcast destination */
+#define DHD_PKTCLS_F_IPV4	0x0004u
+#define DHD_PKTCLS_F_IPV6	0x0008u
+#define DHD_PKTCLS_F_TCP	0x0010u
+#define DHD_PKTCLS_F_UDP	0x0020u
+#define DHD_PKTCLS_F_ICMP	0x0040u
+#define DHD_PKTCLS_F_ICMPV6	0x0080u
+#define DHD_PKTCLS_F_ARP	0x0100u
+#define DHD_PKTCLS_F_EAPOL	0x0200u
+#define DHD_PKTCLS_F_DHCP	0x0400u
+#define DHD_PKTCLS_F_DNS	0x0800u
+
+#define DHD_PKTCLS_OFFSET	(OSL_PKTTAG_SZ - sizeof(dhd_pktcls_t))
+#define DHD_PKTCLS(pkt)		((dhd_pktcls_t *)((uint8 *)PKTTAG(pkt) + DHD_PKTCLS_OFFSET))
+#define DHD_PKTCLS_IS(cls, f)	(((cls)->flags & (f)) != 0)
+
+/*
+ * Classification of a TX packet already handed to the bus. Under
+ * BCM_OBJECT_TRACE the wlfc tag fills the whole packet tag, so consumers get
+ * NULL there and parse the packet themselves.
+ */
+#if defined(PROP_TXSTATUS) && defined(BCM_OBJECT_TRACE)
+#define DHD_PKTCLS_TXQ(pkt)	((dhd_pktcls_t *)NULL)
+#else
+#define DHD_PKTCLS_TXQ(pkt)	DHD_PKTCLS(pkt)
+#endif /* PROP_TXSTATUS && BCM_OBJECT_TRACE */
+
 #if defined(BCMWDF)
 typedef struct {
 	dhd_pub_t *dhd_pub;
@@ -2410,6 +2474,9 @@ extern struct dhd_sta *dhd_find_sta(void *pub, int ifidx, void *ea);
 extern struct dhd_sta *dhd_findadd_sta(void *pub, int ifidx, void *ea);
 extern void dhd_del_all_sta(void *pub, int ifidx);
 extern void dhd_del_sta(void *pub, int ifidx, void *ea);
+#if defined(PCIE_FULL_DONGLE) && defined(DHD_STA_RCU_HASH)
+extern void dhd_sta_stats_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf);
+#endif /* PCIE_FULL_DONGLE && DHD_STA_RCU_HASH */
 extern int dhd_get_ap_isolate(dhd_pub_t *dhdp, uint32 idx);
 extern int dhd_set_ap_isolate(dhd_pub_t *dhdp, uint32 idx, int val);
 extern int dhd_bssidx2idx(dhd_pub_t *dhdp, uint32 bssidx);
@@ -3100,11 +3167,16 @@ int dhd_event_logtrace_infobuf_pkt_process(dhd_pub_t *dhdp, void *pktbuf,
  * "0" -> do not print event log messages in any form
  * "1" -> print event log messages as EL
  * "2" -> print event log messages as formatted CONSOLE_E if logstrs.bin etc. files are available
+ * "3" -> push event log records unformatted to the verbose ring, except for the
+ *        sets in logset_text_mask which are still printed as in "2"
  */
 typedef enum logtrace_ctrl {
 	LOGTRACE_DISABLE = 0,
 	LOGTRACE_RAW_FMT = 1,
-	LOGTRACE_PARSED_FMT = 2
+	LOGTRACE_PARSED_FMT = 2,
+#ifdef DHD_EVENTLOG_PASSTHROUGH
+	LOGTRACE_BIN_FMT = 3
+#endif /* DHD_EVENTLOG_PASSTHROUGH */
 } logtrace_ctrl_t;
 
 #define DEFAULT_CONTROL_LOGTRACE	LOGTRACE_PARSED_FMT
@@ -3331,6 +3403,19 @@ extern void dhd_schedule_reset(dhd_pub_t *dhdp);
 static INLINE void dhd_schedule_reset(dhd_pub_t *dhdp) {;}
 #endif
 
+#ifdef DHD_HOSTREORDER_TIMER
+extern void dhd_schedule_reorder_expire(dhd_pub_t *dhdp);
+#endif /* DHD_HOSTREORDER_TIMER */
+
+#ifdef DHD_WQ_DISPATCH
+extern void dhd_deferred_wq_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf);
+#endif /* DHD_WQ_DISPATCH */
+
+#ifdef DHD_RXF_RING
+extern bool dhd_rxf_throttled(dhd_pub_t *dhdp);
+extern void dhd_rxf_ring_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf);
+#endif /* DHD_RXF_RING */
+
 extern void init_dhd_timeouts(dhd_pub_t *pub);
 extern void deinit_dhd_timeouts(dhd_pub_t *pub);
 
@@ -106,6 +106,15 @@ extern void dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf);
 /* Clear any bus counters */
 extern void dhd_bus_clearcounts(dhd_pub_t *dhdp);
 
+#if defined(BCMPCIE) && defined(DHD_DPC_SCHED)
+/* Per ring item bounds and per pass time budget of the DPC, tunable at runtime */
+extern uint dhd_txbound;
+extern uint dhd_rxbound;
+extern uint dhd_infobound;
+extern uint dhd_dpc_budget_us;
+extern void dhd_bus_dpc_sched_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf);
+#endif /* BCMPCIE && DHD_DPC_SCHED */
+
 /* return the dongle chipid */
 extern uint dhd_bus_chip(struct dhd_bus *bus);
 
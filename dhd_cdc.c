@@ -58,10 +58,24 @@
 #define DEFAULT_WLC_API_VERSION_MAJOR	3
 #define DEFAULT_WLC_API_VERSION_MINOR	0
 
+#ifdef DHD_HOSTREORDER_TIMER
+/* Held packets are released if the firmware has not moved the window by then */
+#ifndef DHD_REORDER_TIMEOUT_MS
+#define DHD_REORDER_TIMEOUT_MS	50
+#endif
+#define DHD_REORDER_HOLD_BINS	9	/* <1, <2, <4 .. <128, >=128 ms */
+#define DHD_REORDER_TIMEOUT_NS	((uint64)DHD_REORDER_TIMEOUT_MS * NSEC_PER_MSEC)
+#endif /* DHD_HOSTREORDER_TIMER */
+
 typedef struct dhd_prot {
 	uint16 reqid;
 	uint8 pending;
 	uint32 lastcmd;
+#ifdef DHD_HOSTREORDER_TIMER
+	uint32 reorder_hold[DHD_REORDER_HOLD_BINS];	/* per flush, oldest packet hold */
+	uint32 reorder_timeouts;	/* holds ended by the timer */
+	uint32 reorder_timeout_pkts;	/* packets released by the timer */
+#endif /* DHD_HOSTREORDER_TIMER */
 	uint8 bus_header[BUS_HEADER_LEN];
 	cdc_ioctl_t msg;
 	unsigned char buf[WLC_IOCTL_MAXLEN + ROUND_UP_MARGIN];
@@ -404,6 +418,22 @@ dhd_prot_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 	}
 
 	bcm_bprintf(strbuf, "Protocol CDC: reqid %d\n", dhdp->prot->reqid);
+#ifdef DHD_HOSTREORDER_TIMER
+	{
+		dhd_prot_t *cdc = dhdp->prot;
+		int i;
+
+		bcm_bprintf(strbuf, "reorder timeout %u ms: timeouts %u pkts %u\n",
+			DHD_REORDER_TIMEOUT_MS, cdc->reorder_timeouts,
+			cdc->reorder_timeout_pkts);
+		bcm_bprintf(strbuf, "reorder hold ms:");
+		for (i = 0; i < DHD_REORDER_HOLD_BINS - 1; i++) {
+			bcm_bprintf(strbuf, " <%u %u", 1u << i, cdc->reorder_hold[i]);
+		}
+		bcm_bprintf(strbuf, " >=%u %u\n", 1u << (DHD_REORDER_HOLD_BINS - 2),
+			cdc->reorder_hold[DHD_REORDER_HOLD_BINS - 1]);
+	}
+#endif /* DHD_HOSTREORDER_TIMER */
 #ifdef PROP_TXSTATUS
 	dhd_wlfc_dump(dhdp, strbuf);
 #endif
@@ -646,8 +676,221 @@ dhd_prot_stop(dhd_pub_t *dhd)
 /* Nothing to do for CDC */
 }
 
+static INLINE void
+dhd_reorder_slot_set(struct reorder_info *ptr, uint8 idx, void *p)
+{
+	ptr->p[idx] = p;
+#ifdef DHD_HOSTREORDER_TIMER
+	ptr->occ[idx >> 5] |= (1u << (idx & 31));
+	ptr->enq_ns[idx] = OSL_LOCALTIME_NS();
+#endif /* DHD_HOSTREORDER_TIMER */
+}
+
+#ifdef DHD_HOSTREORDER_TIMER
+/* Count a flush in the histogram by how long its oldest packet was held */
+static void
+dhd_reorder_hold_done(dhd_pub_t *dhd, uint64 oldest)
+{
+	dhd_prot_t *cdc = dhd->prot;
+	uint32 ms;
+	int bin = 0;
+
+	ms = (uint32)DIV_U64_BY_U32(OSL_LOCALTIME_NS() - oldest, NSEC_PER_MSEC);
+	while (ms && (bin < (DHD_REORDER_HOLD_BINS - 1))) {
+		ms >>= 1;
+		bin++;
+	}
+	cdc->reorder_hold[bin]++;
+}
+
+/* Queue time of the oldest packet still held, 0 if none is */
+static uint64
+dhd_reorder_oldest(struct reorder_info *ptr)
+{
+	uint64 oldest = 0;
+	uint32 bits;
+	uint w, idx;
+
+	for (w = 0; w < ARRAYSIZE(ptr->occ); w++) {
+		for (bits = ptr->occ[w]; bits; bits &= bits - 1) {
+			idx = (w << 5) + __builtin_ctz(bits);
+			if (!oldest || (ptr->enq_ns[idx] < oldest))
+				oldest = ptr->enq_ns[idx];
+		}
+	}
+
+	return oldest;
+}
+
+/* Start the hold clock and timer when packets are held, stop them when none are */
+static void
+dhd_reorder_hold_update(struct reorder_info *ptr)
+{
+	uint64 held;
+
+	if (ptr->pend_pkts == 0) {
+		ptr->hold_start = 0;
+		hrtimer_try_to_cancel(&ptr->timer);
+		return;
+	}
+
+	if (!ptr->hold_start)
+		ptr->hold_start = OSL_LOCALTIME_NS();
+	if (!hrtimer_active(&ptr->timer)) {
+		/* Expire when the oldest held packet has waited the timeout */
+		held = OSL_LOCALTIME_NS() - ptr->hold_start;
+		hrtimer_start(&ptr->timer, ns_to_ktime((held < DHD_REORDER_TIMEOUT_NS) ?
+			(DHD_REORDER_TIMEOUT_NS - held) : 0), HRTIMER_MODE_REL);
+	}
+}
+
+static enum hrtimer_restart
+dhd_reorder_timer(struct hrtimer *timer)
+{
+	struct reorder_info *ptr;
+
+	GCC_DIAGNOSTIC_PUSH_SUPPRESS_CAST();
+	ptr = container_of(timer, struct reorder_info, timer);
+	GCC_DIAGNOSTIC_POP();
+
+	/* The flush needs the bus lock, do it from the deferred work */
+	dhd_schedule_reorder_expire(ptr->dhdp);
+
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Pull the held packets in [start, end) off the ring, all of them when
+ * start == end. Empty slots are skipped a word at a time through the
+ * occupancy bitmap and each run of held packets is found with one ffz.
+ */
+static void
+dhd_get_hostreorder_pkts(dhd_pub_t *dhd, struct reorder_info *ptr, void **pkt,
+	uint32 *pkt_count, void **pplast, uint8 start, uint8 end)
+{
+	void *plast = NULL, *p;
+	uint32 pkt_cnt = 0;
+	uint n = ptr->max_idx + 1;
+	uint idx = start, left, run;
+	uint32 bits, mask;
+	uint64 oldest = 0;
+
+	if (ptr->pend_pkts == 0) {
+		DHD_REORDER(("%s: no packets in reorder queue \n", __FUNCTION__));
+		*pplast = NULL;
+		*pkt_count = 0;
+		*pkt = NULL;
+		return;
+	}
+
+	left = (start == end) ? n : ((end + n - start) % n);
+	while (left && (pkt_cnt < ptr->pend_pkts)) {
+		bits = ptr->occ[idx >> 5] >> (idx & 31);
+		if (bits == 0) {
+			/* Nothing held in the rest of this word */
+			run = MIN(32 - (idx & 31), n - idx);
+			if (run >= left)
+				break;
+			left -= run;
+			idx += run;
+			if (idx == n)
+				idx = 0;
+			continue;
+		}
+
+		/* Skip to the next held packet, it is in this word */
+		run = __builtin_ctz(bits);
+		if (run) {
+			if (run >= left)
+				break;
+			left -= run;
+			idx += run;
+			continue;
+		}
+
+		/* Take the run of held packets starting here */
+		run = (~bits) ? __builtin_ctz(~bits) : 32;
+		run = MIN(run, left);
+		mask = (run == 32) ? ~0u : (((1u << run) - 1) << (idx & 31));
+		ptr->occ[idx >> 5] &= ~mask;
+		left -= run;
+		for (; run; run--, idx++) {
+			p = ptr->p[idx];
+			ptr->p[idx] = NULL;
+			if (!oldest || (ptr->enq_ns[idx] < oldest))
+				oldest = ptr->enq_ns[idx];
+			if (plast == NULL)
+				*pkt = p;
+			else
+				PKTSETNEXT(dhd->osh, plast, p);
+			plast = p;
+			pkt_cnt++;
+		}
+		if (idx == n)
+			idx = 0;
+	}
+	*pplast = plast;
+	*pkt_count = pkt_cnt;
+	ptr->pend_pkts -= (uint8)pkt_cnt;
+
+	if (pkt_cnt) {
+		dhd_reorder_hold_done(dhd, oldest);
+		/* After a partial flush the clock follows the oldest packet left */
+		ptr->hold_start = ptr->pend_pkts ? dhd_reorder_oldest(ptr) : 0;
+	}
+}
+
+/* Deliver the packets of flows held past the timeout, called from deferred work */
+void
+dhd_prot_reorder_expire(dhd_pub_t *dhd)
+{
+	dhd_prot_t *cdc = dhd->prot;
+	struct reorder_info *ptr;
+	void *pkt, *plast;
+	uint64 held;
+	uint32 cnt;
+	uint8 ifidx;
+	int i;
+
+	dhd_os_sdlock(dhd);
+	for (i = 0; i < WLHOST_REORDERDATA_MAXFLOWS; i++) {
+		ptr = dhd->reorder_bufs[i];
+		if ((ptr == NULL) || (ptr->pend_pkts == 0))
+			continue;
+
+		/* A slot refilled in place may have taken the oldest packet with it */
+		ptr->hold_start = dhd_reorder_oldest(ptr);
+		held = OSL_LOCALTIME_NS() - ptr->hold_start;
+		if (held < DHD_REORDER_TIMEOUT_NS) {
+			/* Armed for a packet flushed since, wait for the oldest one left */
+			hrtimer_start(&ptr->timer, ns_to_ktime(DHD_REORDER_TIMEOUT_NS - held),
+				HRTIMER_MODE_REL);
+			continue;
+		}
+
+		DHD_REORDER(("%s: flow %d held %d packets past %u ms, exp_idx %d\n",
+			__FUNCTION__, i, ptr->pend_pkts, DHD_REORDER_TIMEOUT_MS,
+			ptr->exp_idx));
+		cdc->reorder_timeouts++;
+		cdc->reorder_timeout_pkts += ptr->pend_pkts;
+
+		/* Give up on the hole and deliver everything held, in order */
+		pkt = NULL;
+		dhd_get_hostreorder_pkts(dhd, ptr, &pkt, &cnt, &plast,
+			ptr->exp_idx, ptr->exp_idx);
+		if (cnt == 0)
+			continue;
+
+		ifidx = ptr->ifidx;
+		dhd_os_sdunlock(dhd);
+		dhd_rx_frame(dhd, ifidx, pkt, cnt, 0);
+		dhd_os_sdlock(dhd);
+	}
+	dhd_os_sdunlock(dhd);
+}
+#else
 static void
-dhd_get_hostreorder_pkts(void *osh, struct reorder_info *ptr, void **pkt,
+dhd_get_hostreorder_pkts(dhd_pub_t *dhd, struct reorder_info *ptr, void **pkt,
 	uint32 *pkt_count, void **pplast, uint8 start, uint8 end)
 {
 	void *plast = NULL, *p;
@@ -668,7 +911,7 @@ dhd_get_hostreorder_pkts(void *osh, struct reorder_info *ptr, void **pkt,
 			if (plast == NULL)
 				*pkt = p;
 			else
-				PKTSETNEXT(osh, plast, p);
+				PKTSETNEXT(dhd->osh, plast, p);
 
 			plast = p;
 			pkt_cnt++;
@@ -681,10 +924,11 @@ dhd_get_hostreorder_pkts(void *osh, struct reorder_info *ptr, void **pkt,
 	*pkt_count = pkt_cnt;
 	ptr->pend_pkts -= (uint8)pkt_cnt;
 }
+#endif /* DHD_HOSTREORDER_TIMER */
 
 int
-dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reorder_info_len,
-	void **pkt, uint32 *pkt_count)
+dhd_process_pkt_reorder_info(dhd_pub_t *dhd, int ifidx, uchar *reorder_info_buf,
+	uint reorder_info_len, void **pkt, uint32 *pkt_count)
 {
 	uint8 flow_id, max_idx, cur_idx, exp_idx;
 	struct reorder_info *ptr;
@@ -731,7 +975,7 @@ dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reord
 			return 0;
 		}
 
-		dhd_get_hostreorder_pkts(dhd->osh, ptr, pkt, &cnt, &plast,
+		dhd_get_hostreorder_pkts(dhd, ptr, pkt, &cnt, &plast,
 			ptr->exp_idx, ptr->exp_idx);
 		/* set it to the last packet */
 		if (plast) {
@@ -747,6 +991,10 @@ dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reord
 			cnt = 1;
 		}
 		buf_size += ((ptr->max_idx + 1) * sizeof(void *));
+#ifdef DHD_HOSTREORDER_TIMER
+		buf_size += ((ptr->max_idx + 1) * sizeof(uint64));
+		hrtimer_cancel(&ptr->timer);
+#endif /* DHD_HOSTREORDER_TIMER */
 		MFREE(dhd->osh, ptr, buf_size);
 		dhd->reorder_bufs[flow_id] = NULL;
 		*pkt_count = cnt;
@@ -758,6 +1006,9 @@ dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reord
 		max_idx = reorder_info_buf[WLHOST_REORDERDATA_MAXIDX_OFFSET];
 
 		buf_size_alloc += ((max_idx + 1) * sizeof(void*));
+#ifdef DHD_HOSTREORDER_TIMER
+		buf_size_alloc += ((max_idx + 1) * sizeof(uint64));
+#endif /* DHD_HOSTREORDER_TIMER */
 		/* allocate space to hold the buffers, index etc */
 
 		DHD_REORDER(("%s: alloc buffer of size %d size, reorder info id %d, maxidx %d\n",
@@ -772,19 +1023,30 @@ dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reord
 		dhd->reorder_bufs[flow_id] = ptr;
 		ptr->p = (void *)(ptr+1);
 		ptr->max_idx = max_idx;
+#ifdef DHD_HOSTREORDER_TIMER
+		/* the queue times follow the slots, uint64 aligned */
+		ptr->enq_ns = (uint64 *)(ptr+1);
+		ptr->p = (void **)&ptr->enq_ns[max_idx + 1];
+		ptr->dhdp = dhd;
+		hrtimer_init(&ptr->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+		ptr->timer.function = dhd_reorder_timer;
+#endif /* DHD_HOSTREORDER_TIMER */
 	}
+#ifdef DHD_HOSTREORDER_TIMER
+	ptr->ifidx = (uint8)ifidx;
+#endif /* DHD_HOSTREORDER_TIMER */
 	/* XXX: validate cur, exp indices */
 	if (flags & WLHOST_REORDERDATA_NEW_HOLE)  {
 		DHD_REORDER(("%s: new hole, so cleanup pending buffers\n", __FUNCTION__));
 		if (ptr->pend_pkts) {
-			dhd_get_hostreorder_pkts(dhd->osh, ptr, pkt, &cnt, &plast,
+			dhd_get_hostreorder_pkts(dhd, ptr, pkt, &cnt, &plast,
 				ptr->exp_idx, ptr->exp_idx);
 			ptr->pend_pkts = 0;
 		}
 		ptr->cur_idx = reorder_info_buf[WLHOST_REORDERDATA_CURIDX_OFFSET];
 		ptr->exp_idx = reorder_info_buf[WLHOST_REORDERDATA_EXPIDX_OFFSET];
 		ptr->max_idx = reorder_info_buf[WLHOST_REORDERDATA_MAXIDX_OFFSET];
-		ptr->p[ptr->cur_idx] = cur_pkt;
+		dhd_reorder_slot_set(ptr, ptr->cur_idx, cur_pkt);
 		ptr->pend_pkts++;
 		*pkt_count = cnt;
 	}
@@ -800,8 +1062,9 @@ dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reord
 					__FUNCTION__));
 				PKTFREE(dhd->osh, ptr->p[cur_idx], TRUE);
 				ptr->p[cur_idx] = NULL;
+				ptr->pend_pkts--;
 			}
-			ptr->p[cur_idx] = cur_pkt;
+			dhd_reorder_slot_set(ptr, cur_idx, cur_pkt);
 			ptr->pend_pkts++;
 			ptr->cur_idx = cur_idx;
 			DHD_REORDER(("%s: fill up a hole..pending packets is %d\n",
@@ -818,14 +1081,15 @@ dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reord
 					__FUNCTION__));
 				PKTFREE(dhd->osh, ptr->p[cur_idx], TRUE);
 				ptr->p[cur_idx] = NULL;
+				ptr->pend_pkts--;
 			}
-			ptr->p[cur_idx] = cur_pkt;
+			dhd_reorder_slot_set(ptr, cur_idx, cur_pkt);
 			ptr->pend_pkts++;
 
 			ptr->cur_idx = cur_idx;
 			ptr->exp_idx = exp_idx;
 
-			dhd_get_hostreorder_pkts(dhd->osh, ptr, pkt, &cnt, &plast,
+			dhd_get_hostreorder_pkts(dhd, ptr, pkt, &cnt, &plast,
 				cur_idx, exp_idx);
 			*pkt_count = cnt;
 			DHD_REORDER(("%s: freeing up buffers %d, still pending %d\n",
@@ -844,7 +1108,7 @@ dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reord
 				end_idx = exp_idx;
 
 			/* flush pkts first */
-			dhd_get_hostreorder_pkts(dhd->osh, ptr, pkt, &cnt, &plast,
+			dhd_get_hostreorder_pkts(dhd, ptr, pkt, &cnt, &plast,
 				ptr->exp_idx, end_idx);
 
 			if (cur_idx == ptr->max_idx) {
@@ -862,7 +1126,7 @@ dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reord
 				cnt++;
 			}
 			else {
-				ptr->p[cur_idx] = cur_pkt;
+				dhd_reorder_slot_set(ptr, cur_idx, cur_pkt);
 				ptr->pend_pkts++;
 			}
 			ptr->exp_idx = exp_idx;
@@ -882,7 +1146,7 @@ dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reord
 		else
 			end_idx =  exp_idx;
 
-		dhd_get_hostreorder_pkts(dhd->osh, ptr, pkt, &cnt, &plast, ptr->exp_idx, end_idx);
+		dhd_get_hostreorder_pkts(dhd, ptr, pkt, &cnt, &plast, ptr->exp_idx, end_idx);
 		if (plast)
 			PKTSETNEXT(dhd->osh, plast, cur_pkt);
 		else
@@ -892,5 +1156,8 @@ dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reord
 		/* set the new expected idx */
 		ptr->exp_idx = exp_idx;
 	}
+#ifdef DHD_HOSTREORDER_TIMER
+	dhd_reorder_hold_update(ptr);
+#endif /* DHD_HOSTREORDER_TIMER */
 	return 0;
 }
@@ -218,6 +218,9 @@ char bus_api_revision[BUS_API_REV_STR_LEN] = "\0";
 void dhd_set_timer(void *bus, uint wdtick);
 
 static char* ioctl2str(uint32 ioctl);
+#ifdef DHD_DEBUG
+static int dhd_pktq_bench(dhd_pub_t *dhdp, struct bcmstrbuf *b);
+#endif /* DHD_DEBUG */
 
 /* IOVar table */
 enum {
@@ -309,6 +312,12 @@ enum {
 	IOV_TX_PROFILE_DUMP,
 #endif /* defined(DHD_TX_PROFILE) */
 	IOV_DBGRING_MSGLEVEL,
+#ifdef DHD_DEBUG
+	IOV_PKTQ_BENCH,
+#endif /* DHD_DEBUG */
+#if defined(DHD_DEBUG) && defined(PNO_SUPPORT)
+	IOV_PNO_BATCH_BENCH,
+#endif /* DHD_DEBUG && PNO_SUPPORT */
 	IOV_LAST
 };
 
@@ -414,6 +423,12 @@ const bcm_iovar_t dhd_iovars[] = {
 	{"tx_profile_dump",	IOV_TX_PROFILE_DUMP,	0,	0,	IOVT_UINT32,	0},
 #endif /* defined(DHD_TX_PROFILE) */
 	{"dbgring_msglevel",    IOV_DBGRING_MSGLEVEL,       0,  0, IOVT_UINT32, 0},
+#ifdef DHD_DEBUG
+	{"pktq_bench",	IOV_PKTQ_BENCH,	0,	0, IOVT_BUFFER,	0},
+#endif /* DHD_DEBUG */
+#if defined(DHD_DEBUG) && defined(PNO_SUPPORT)
+	{"pno_batch_bench",	IOV_PNO_BATCH_BENCH,	0,	0, IOVT_BUFFER,	0},
+#endif /* DHD_DEBUG && PNO_SUPPORT */
 	/* --- add new iovars *ABOVE* this line --- */
 	{NULL, 0, 0, 0, 0, 0 }
 };
@@ -1146,6 +1161,14 @@ dhd_dump(dhd_pub_t *dhdp, char *buf, int buflen)
 	/* Add any bus info */
 	dhd_bus_dump(dhdp, strbuf);
 
+#ifdef DHD_RXF_RING
+	dhd_rxf_ring_dump(dhdp, strbuf);
+#endif /* DHD_RXF_RING */
+
+#ifdef DHD_WQ_DISPATCH
+	dhd_deferred_wq_dump(dhdp, strbuf);
+#endif /* DHD_WQ_DISPATCH */
+
 #if defined(DHD_LB_STATS)
 	dhd_lb_stats_dump(dhdp, strbuf);
 #endif /* DHD_LB_STATS */
@@ -1188,6 +1211,18 @@ dhd_dump(dhd_pub_t *dhdp, char *buf, int buflen)
 	dhd_mqstats_dump(dhdp, strbuf);
 #endif
 
+#if defined(DEBUGABILITY) && defined(DHD_DBG_RING_PCPU_STAGE)
+	dhd_dbg_stage_dump(dhdp, strbuf);
+#endif /* DEBUGABILITY && DHD_DBG_RING_PCPU_STAGE */
+
+#if defined(PCIE_FULL_DONGLE) && defined(DHD_STA_RCU_HASH)
+	dhd_sta_stats_dump(dhdp, strbuf);
+#endif /* PCIE_FULL_DONGLE && DHD_STA_RCU_HASH */
+
+#ifdef PNO_SUPPORT
+	dhd_pno_batch_stats_dump(dhdp, strbuf);
+#endif /* PNO_SUPPORT */
+
 #ifdef DHD_WET
 	if (dhd_get_wet_mode(dhdp)) {
 		bcm_bprintf(strbuf, "Wet Dump:\n");
@@ -1974,6 +2009,25 @@ dhd_doiovar(dhd_pub_t *dhd_pub, const bcm_iovar_t *vi, uint32 actionid, const ch
 			bcmerror = BCME_OK;
 		break;
 
+#ifdef DHD_DEBUG
+	case IOV_GVAL(IOV_PKTQ_BENCH):
+	{
+		struct bcmstrbuf bench_b;
+		bcm_binit(&bench_b, arg, len);
+		bcmerror = dhd_pktq_bench(dhd_pub, &bench_b);
+		break;
+	}
+#endif /* DHD_DEBUG */
+#if defined(DHD_DEBUG) && defined(PNO_SUPPORT)
+	case IOV_GVAL(IOV_PNO_BATCH_BENCH):
+	{
+		struct bcmstrbuf bench_b;
+		bcm_binit(&bench_b, arg, len);
+		bcmerror = dhd_pno_batch_bench(dhd_pub, &bench_b);
+		break;
+	}
+#endif /* DHD_DEBUG && PNO_SUPPORT */
+
 	case IOV_GVAL(IOV_DCONSOLE_POLL):
 		int_val = (int32)dhd_pub->dhd_console_ms;
 		bcopy(&int_val, arg, val_size);
@@ -2883,6 +2937,8 @@ dhd_prec_drop_pkts(dhd_pub_t *dhdp, struct pktq *pq, int prec, f_droppkt_t fn)
 		prev_first = prev;
 	}
 
+	/* the dropped run may cover the last two packets */
+	PKTQ_PREC_TAIL_PREV_SET(q, NULL);
 	p = first;
 	while (p) {
 		next = PKTLINK(p);
@@ -2916,6 +2972,143 @@ dhd_prec_drop_pkts(dhd_pub_t *dhdp, struct pktq *pq, int prec, f_droppkt_t fn)
 	return TRUE;
 }
 
+#ifdef DHD_DEBUG
+#define PKTQ_BENCH_NPREC	8
+#define PKTQ_BENCH_QLEN		512	/* queue evicted from */
+#define PKTQ_BENCH_GLOM_PKTS	64	/* packets queued per glom round */
+#define PKTQ_BENCH_GLOM		32
+#define PKTQ_BENCH_EVICT_OPS	100000u
+#define PKTQ_BENCH_GLOM_ROUNDS	10000u
+
+/* Two glom dequeues of PKTQ_BENCH_GLOM packets, as dhdsdio_sendfromq takes them */
+static int
+dhd_pktq_bench_deq(struct pktq *pq, void **pkts)
+{
+	int n = 0;
+	int g, i;
+	int prec;
+#ifdef HND_PKTQ_PREC_BMP
+	struct spktq chain;
+#endif /* HND_PKTQ_PREC_BMP */
+
+	for (g = 0; g < (PKTQ_BENCH_GLOM_PKTS / PKTQ_BENCH_GLOM); g++) {
+#ifdef HND_PKTQ_PREC_BMP
+		BCM_REFERENCE(prec);
+		spktq_init(&chain, PKTQ_BENCH_GLOM);
+		pktq_mdeq_n(pq, ~0u, PKTQ_BENCH_GLOM, &chain);
+		for (i = 0; i < PKTQ_BENCH_GLOM; i++) {
+			if ((pkts[n] = spktq_deq(&chain)) == NULL)
+				break;
+			n++;
+		}
+		spktq_deinit(&chain);
+#else
+		for (i = 0; i < PKTQ_BENCH_GLOM; i++) {
+			if ((pkts[n] = pktq_mdeq(pq, ~0u, &prec)) == NULL)
+				break;
+			n++;
+		}
+#endif /* HND_PKTQ_PREC_BMP */
+	}
+
+	return n;
+}
+
+/*
+ * Time the pktq operations on the DHD tx path over a mixed precedence queue
+ * of synthetic packets: evicting the tail of a full queue and enqueueing
+ * again, as dhd_prec_enq does, and enqueueing a full queue then taking it
+ * out in two gloms. Reported per operation and per packet, respectively.
+ */
+static int
+dhd_pktq_bench(dhd_pub_t *dhdp, struct bcmstrbuf *b)
+{
+	struct pktq *pq;
+	void **bufs;		/* owned packets, then dequeue scratch */
+	void **pkts;
+	uint32 bufs_len = (PKTQ_BENCH_QLEN + PKTQ_BENCH_GLOM_PKTS) * sizeof(void *);
+	uint64 start, evict_ns, glom_ns;
+	uint32 r;
+	int prec;
+	int i, n = 0;
+	int ret = BCME_OK;
+
+	pq = (struct pktq *)MALLOCZ(dhdp->osh, sizeof(*pq));
+	bufs = (void **)MALLOCZ(dhdp->osh, bufs_len);
+	if (pq == NULL || bufs == NULL) {
+		ret = BCME_NOMEM;
+		goto done;
+	}
+	pkts = &bufs[PKTQ_BENCH_QLEN];
+	pktq_init(pq, PKTQ_BENCH_NPREC, PKTQ_BENCH_QLEN);
+
+	for (n = 0; n < PKTQ_BENCH_QLEN; n++) {
+		if ((bufs[n] = PKTGET(dhdp->osh, ETHER_MIN_LEN, TRUE)) == NULL) {
+			ret = BCME_NOMEM;
+			goto exit;
+		}
+	}
+
+	/* full queue, every precedence holding QLEN / NPREC packets */
+	for (i = 0; i < PKTQ_BENCH_QLEN; i++) {
+		pktq_penq(pq, i % PKTQ_BENCH_NPREC, bufs[i]);
+	}
+	start = OSL_LOCALTIME_NS();
+	for (r = 0; r < PKTQ_BENCH_EVICT_OPS; r++) {
+		if (pktq_peek_tail(pq, &prec) == NULL) {
+			ret = BCME_ERROR;
+			goto exit;
+		}
+		pktq_penq(pq, prec, pktq_pdeq_tail(pq, prec));
+	}
+	evict_ns = OSL_LOCALTIME_NS() - start;
+	while (pktq_deq(pq, NULL))
+		;
+
+	start = OSL_LOCALTIME_NS();
+	for (r = 0; r < PKTQ_BENCH_GLOM_ROUNDS; r++) {
+		for (i = 0; i < PKTQ_BENCH_GLOM_PKTS; i++) {
+			pktq_penq(pq, i % PKTQ_BENCH_NPREC, bufs[i]);
+		}
+		if (dhd_pktq_bench_deq(pq, pkts) != PKTQ_BENCH_GLOM_PKTS) {
+			ret = BCME_ERROR;
+			goto exit;
+		}
+	}
+	glom_ns = OSL_LOCALTIME_NS() - start;
+
+#ifdef HND_PKTQ_PREC_BMP
+	bcm_bprintf(b, "pktq (prec bitmap), %d prec\n", PKTQ_BENCH_NPREC);
+#else
+	bcm_bprintf(b, "pktq, %d prec\n", PKTQ_BENCH_NPREC);
+#endif /* HND_PKTQ_PREC_BMP */
+	bcm_bprintf(b, "full %d pkt queue, evict tail + enq %u ns/op\n", PKTQ_BENCH_QLEN,
+		(uint32)DIV_U64_BY_U32(evict_ns, PKTQ_BENCH_EVICT_OPS));
+	bcm_bprintf(b, "%d pkt enq + %dx%d glom deq %u ps/pkt\n", PKTQ_BENCH_GLOM_PKTS,
+		PKTQ_BENCH_GLOM_PKTS / PKTQ_BENCH_GLOM, PKTQ_BENCH_GLOM,
+		(uint32)DIV_U64_BY_U32(glom_ns * 1000u,
+		PKTQ_BENCH_GLOM_ROUNDS * PKTQ_BENCH_GLOM_PKTS));
+
+exit:
+	/* the queue never owns the packets, bufs[] does */
+	while (pktq_deq(pq, NULL))
+		;
+	for (i = 0; i < n; i++) {
+		PKTFREE(dhdp->osh, bufs[i], TRUE);
+	}
+	pktq_deinit(pq);
+done:
+	if (bufs) {
+		MFREE(dhdp->osh, bufs, bufs_len);
+	}
+	if (pq) {
+		MFREE(dhdp->osh, pq, sizeof(*pq));
+	}
+
+	return ret;
+}
+#endif /* DHD_DEBUG */
+
 static int
 dhd_iovar_op(dhd_pub_t *dhd_pub, const char *name,
 	void *params, int plen, void *arg, uint len, bool set)
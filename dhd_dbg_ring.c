@@ -30,6 +30,51 @@
 #include <dhd.h>
 #include <dhd_dbg.h>
 #include <dhd_dbg_ring.h>
+#if defined(__linux__) && defined(DHD_DBG_RING_MMAP)
+#include <linux/vmalloc.h>
+#include <linux/slab.h>
+#endif /* __linux__ && DHD_DBG_RING_MMAP */
+
+#ifdef DHD_DBG_RING_MMAP
+/* ring data starts on the page after the shared header */
+#define DHD_DBG_RING_SHM_HDR_LEN	PAGE_SIZE
+
+/* Publish the ring pointers to mmap readers, called with ring->lock held */
+static INLINE void
+dhd_dbg_ring_shm_update(dhd_dbg_ring_t *ring)
+{
+	dhd_dbg_ring_shm_t *shm = ring->shm;
+
+	if (!shm) {
+		return;
+	}
+
+	shm->seq++;
+	OSL_SMP_WMB();
+	shm->wp = ring->wp;
+	shm->rp = ring->rp;
+	shm->wrap_off = ring->tail_padded ? (ring->ring_size - ring->rem_len) : 0;
+	shm->written_records = ring->stat.written_records;
+	shm->written_bytes = ring->stat.written_bytes;
+	shm->read_bytes = ring->stat.read_bytes;
+	OSL_SMP_WMB();
+	shm->seq++;
+}
+#else
+#define dhd_dbg_ring_shm_update(ring)	do { } while (0)
+#endif /* DHD_DBG_RING_MMAP */
+
+#if defined(__linux__) && defined(DHD_DBG_RING_PCPU_STAGE)
+static void dhd_dbg_ring_stage_alloc(dhd_pub_t *dhdp, dhd_dbg_ring_t *ring);
+static void dhd_dbg_ring_stage_free(dhd_pub_t *dhdp, dhd_dbg_ring_t *ring);
+static void dhd_dbg_ring_stage_drain_locked(dhd_dbg_ring_t *ring);
+static void dhd_dbg_ring_stage_drain(dhd_dbg_ring_t *ring);
+#else
+#define dhd_dbg_ring_stage_alloc(dhdp, ring)	do { } while (0)
+#define dhd_dbg_ring_stage_free(dhdp, ring)	do { } while (0)
+#define dhd_dbg_ring_stage_drain_locked(ring)	do { } while (0)
+#define dhd_dbg_ring_stage_drain(ring)		do { } while (0)
+#endif /* __linux__ && DHD_DBG_RING_PCPU_STAGE */
 
 int
 dhd_dbg_ring_init(dhd_pub_t *dhdp, dhd_dbg_ring_t *ring, uint16 id, uint8 *name,
@@ -59,6 +104,8 @@ dhd_dbg_ring_init(dhd_pub_t *dhdp, dhd_dbg_ring_t *ring, uint16 id, uint8 *name,
 	ring->pull_inactive = pull_inactive;
 	DHD_DBG_RING_UNLOCK(ring->lock, flags);
 
+	dhd_dbg_ring_stage_alloc(dhdp, ring);
+
 	return BCME_OK;
 }
 
@@ -76,7 +123,23 @@ dhd_dbg_ring_deinit(dhd_pub_t *dhdp, dhd_dbg_ring_t *ring)
 	ring->state = RING_STOP;
 	DHD_DBG_RING_UNLOCK(ring->lock, flags);
 
+	/* waits for a pending drain, which takes the ring lock */
+	dhd_dbg_ring_stage_free(dhdp, ring);
+
 	DHD_DBG_RING_LOCK_DEINIT(dhdp->osh, ring->lock);
+
+#ifdef DHD_DBG_RING_MMAP
+	if (ring->map) {
+		dhd_dbg_ring_map_t *map = ring->map;
+
+		ring->shm = NULL;
+		ring->map = NULL;
+		/* ring_buf was part of the mapping, callers must not free it */
+		ring->ring_buf = NULL;
+		/* user mappings keep the area until they are unmapped */
+		dhd_dbg_ring_map_put(map);
+	}
+#endif /* DHD_DBG_RING_MMAP */
 }
 
 void
@@ -86,6 +149,24 @@ dhd_dbg_ring_sched_pull(dhd_dbg_ring_t *ring, uint32 pending_len,
 	unsigned long flags = 0;
 
 	DHD_DBG_RING_LOCK(ring->lock, flags);
+#ifdef DHD_DBG_RING_MMAP
+	/* While the ring is mapped, waking the poll waiters replaces the pull */
+	if (ring->map && atomic_read(&ring->map->mmap_cnt) > 0) {
+		bool wake = FALSE;
+
+		if (ring->threshold > 0 &&
+			(ring->stat.written_bytes - ring->wake_bytes) >= ring->threshold) {
+			ring->wake_bytes = ring->stat.written_bytes;
+			ring->wake_gen++;
+			wake = TRUE;
+		}
+		DHD_DBG_RING_UNLOCK(ring->lock, flags);
+		if (wake) {
+			wake_up_interruptible(&ring->wq);
+		}
+		return;
+	}
+#endif /* DHD_DBG_RING_MMAP */
 	/* if the current pending size is bigger than threshold and
 	 * threshold is set
 	 */
@@ -124,32 +205,15 @@ dhd_dbg_ring_get_pending_len(dhd_dbg_ring_t *ring)
 	return pending_len;
 }
 
-int
-dhd_dbg_ring_push(dhd_dbg_ring_t *ring, dhd_dbg_ring_entry_t *hdr, void *data)
+/* Append one record, called with ring->lock held */
+static int
+dhd_dbg_ring_push_locked(dhd_dbg_ring_t *ring, dhd_dbg_ring_entry_t *hdr, void *data)
 {
-	unsigned long flags;
 	uint32 w_len;
 	uint32 avail_size;
 	dhd_dbg_ring_entry_t *w_entry, *r_entry;
 
-	if (!ring || !hdr || !data) {
-		return BCME_BADARG;
-	}
-
-#if defined(__linux__)
-	/* Prevents the case of accessing the ring buffer in the HardIRQ context.
-	 * If an interrupt arise after holding ring lock, It could try the same lock.
-	 * This is to use the ring lock as spin_lock_bh instead of spin_lock_irqsave.
-	 */
-	if (in_irq()) {
-		return BCME_BUSY;
-	}
-#endif /* defined(__linux__) */
-
-	DHD_DBG_RING_LOCK(ring->lock, flags);
-
 	if (ring->state != RING_ACTIVE) {
-		DHD_DBG_RING_UNLOCK(ring->lock, flags);
 		return BCME_OK;
 	}
 
@@ -161,7 +225,6 @@ dhd_dbg_ring_push(dhd_dbg_ring_t *ring, dhd_dbg_ring_entry_t *hdr, void *data)
 		ring->ring_buf, ring->ring_size));
 
 	if (w_len > ring->ring_size) {
-		DHD_DBG_RING_UNLOCK(ring->lock, flags);
 		DHD_ERROR(("%s: RING%d[%s] w_len=%u, ring_size=%u,"
 			" write size exceeds ring size !\n",
 			__FUNCTION__, ring->id, ring->name, w_len, ring->ring_size));
@@ -211,7 +274,6 @@ dhd_dbg_ring_push(dhd_dbg_ring_t *ring, dhd_dbg_ring_entry_t *hdr, void *data)
 						__FUNCTION__, ring->id, ring->name, ring->wp,
 						ring->rp, ring->ring_size));
 					ASSERT(0);
-					DHD_DBG_RING_UNLOCK(ring->lock, flags);
 					return BCME_BUFTOOSHORT;
 				}
 				ring->rp += ENTRY_LENGTH(r_entry);
@@ -242,7 +304,6 @@ dhd_dbg_ring_push(dhd_dbg_ring_t *ring, dhd_dbg_ring_entry_t *hdr, void *data)
 			"wp=%d, ring_size=%d, w_len=%u\n", __FUNCTION__, ring->id,
 			ring->name, ring->wp, ring->ring_size, w_len));
 		ASSERT(0);
-		DHD_DBG_RING_UNLOCK(ring->lock, flags);
 		return BCME_BUFTOOLONG;
 	}
 
@@ -263,10 +324,298 @@ dhd_dbg_ring_push(dhd_dbg_ring_t *ring, dhd_dbg_ring_entry_t *hdr, void *data)
 		ring->stat.written_records, ring->stat.written_bytes, ring->stat.read_bytes,
 		ring->threshold, ring->wp, ring->rp));
 
-	DHD_DBG_RING_UNLOCK(ring->lock, flags);
 	return BCME_OK;
 }
 
+#if defined(__linux__) && defined(DHD_DBG_RING_PCPU_STAGE)
+/* Staged record: staging timestamp and ring entry header, then the payload */
+typedef struct dhd_dbg_stage_rec {
+	uint64 ts;
+	dhd_dbg_ring_entry_t hdr;
+} dhd_dbg_stage_rec_t;
+
+static void
+dhd_dbg_ring_stage_copy_in(dhd_dbg_ring_stage_t *st, uint32 pos, const void *src, uint32 len)
+{
+	uint32 off = pos & (DHD_DBG_RING_STAGE_SIZE - 1);
+	uint32 n = MIN(len, DHD_DBG_RING_STAGE_SIZE - off);
+
+	memcpy(st->buf + off, src, n);
+	memcpy(st->buf, (const uint8 *)src + n, len - n);
+}
+
+static void
+dhd_dbg_ring_stage_copy_out(dhd_dbg_ring_stage_t *st, uint32 pos, void *dst, uint32 len)
+{
+	uint32 off = pos & (DHD_DBG_RING_STAGE_SIZE - 1);
+	uint32 n = MIN(len, DHD_DBG_RING_STAGE_SIZE - off);
+
+	memcpy(dst, st->buf + off, n);
+	memcpy((uint8 *)dst + n, st->buf, len - n);
+}
+
+static void
+dhd_dbg_ring_stage_free(dhd_pub_t *dhdp, dhd_dbg_ring_t *ring)
+{
+	int cpu;
+
+	if (ring->stage) {
+		cancel_work_sync(&ring->stage_work);
+		for_each_possible_cpu(cpu) {
+			dhd_dbg_ring_stage_t *st = per_cpu_ptr(ring->stage, cpu);
+
+			if (st->buf) {
+				MFREE(dhdp->osh, st->buf, DHD_DBG_RING_STAGE_SIZE);
+			}
+		}
+		free_percpu(ring->stage);
+		ring->stage = NULL;
+	}
+	if (ring->stage_scratch) {
+		MFREE(dhdp->osh, ring->stage_scratch, DHD_DBG_RING_STAGE_SIZE);
+		ring->stage_scratch = NULL;
+	}
+}
+
+static void
+dhd_dbg_ring_stage_work(struct work_struct *work)
+{
+	dhd_dbg_ring_t *ring = container_of(work, dhd_dbg_ring_t, stage_work);
+
+	dhd_dbg_ring_stage_drain(ring);
+}
+
+/* On failure the ring works without staging */
+static void
+dhd_dbg_ring_stage_alloc(dhd_pub_t *dhdp, dhd_dbg_ring_t *ring)
+{
+	int cpu;
+
+	INIT_WORK(&ring->stage_work, dhd_dbg_ring_stage_work);
+	ring->stage_committed = 0;
+	ring->stage_scratch = MALLOCZ(dhdp->osh, DHD_DBG_RING_STAGE_SIZE);
+	ring->stage = alloc_percpu(dhd_dbg_ring_stage_t);
+	if (!ring->stage_scratch || !ring->stage) {
+		goto fail;
+	}
+	for_each_possible_cpu(cpu) {
+		dhd_dbg_ring_stage_t *st = per_cpu_ptr(ring->stage, cpu);
+
+		bzero(st, sizeof(*st));
+		st->buf = MALLOCZ(dhdp->osh, DHD_DBG_RING_STAGE_SIZE);
+		if (!st->buf) {
+			goto fail;
+		}
+	}
+	return;
+
+fail:
+	DHD_ERROR(("%s: RING%d[%s] no staging memory, pushing directly\n",
+		__FUNCTION__, ring->id, ring->name));
+	dhd_dbg_ring_stage_free(dhdp, ring);
+}
+
+/*
+ * Stage a record on the local CPU. Safe in any context including hard IRQ;
+ * nothing is shared with other CPUs but the drainer's tail. The records are
+ * committed by the drain work, or inline once the CPU's staging is half full.
+ * Returns BCME_NORESOURCE or BCME_BUFTOOLONG if the record does not fit and
+ * the caller can push it directly, BCME_BUSY if it was dropped in hard IRQ.
+ */
+static int
+dhd_dbg_ring_stage_put(dhd_dbg_ring_t *ring, dhd_dbg_ring_entry_t *hdr, void *data)
+{
+	dhd_dbg_ring_stage_t *st;
+	dhd_dbg_stage_rec_t rec;
+	uint32 need = sizeof(rec) + hdr->len;
+	uint32 fill = 0;
+	unsigned long flags;
+	int ret = BCME_OK;
+
+	if (ring->state != RING_ACTIVE) {
+		return BCME_OK;
+	}
+
+	local_irq_save(flags);
+	st = this_cpu_ptr(ring->stage);
+	if (need > DHD_DBG_RING_STAGE_SIZE) {
+		ret = BCME_BUFTOOLONG;
+	} else if (need > (DHD_DBG_RING_STAGE_SIZE - (st->head - READ_ONCE(st->tail)))) {
+		ret = BCME_NORESOURCE;
+	} else {
+		rec.ts = local_clock();
+		memcpy(&rec.hdr, hdr, DBG_RING_ENTRY_SIZE);
+		dhd_dbg_ring_stage_copy_in(st, st->head, &rec, sizeof(rec));
+		dhd_dbg_ring_stage_copy_in(st, st->head + sizeof(rec), data, hdr->len);
+		/* record contents before the new head */
+		smp_wmb();
+		WRITE_ONCE(st->head, st->head + need);
+		st->staged++;
+		fill = st->head - READ_ONCE(st->tail);
+	}
+	if (ret != BCME_OK) {
+		if (in_irq()) {
+			/* the ring lock cannot be taken here */
+			st->drops[(ret == BCME_BUFTOOLONG) ?
+				DHD_DBG_STAGE_DROP_TOOBIG : DHD_DBG_STAGE_DROP_FULL]++;
+			ret = BCME_BUSY;
+		} else {
+			st->direct++;
+		}
+	}
+	local_irq_restore(flags);
+
+	if (ret == BCME_OK) {
+		if (fill >= DHD_DBG_RING_STAGE_DRAIN_THRESH && !in_irq()) {
+			dhd_dbg_ring_stage_drain(ring);
+		} else {
+			/* new head before the check, a drain starting after it sees the record */
+			smp_mb();
+			if (!work_pending(&ring->stage_work)) {
+				schedule_work(&ring->stage_work);
+			}
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * Commit staged records into the ring, oldest staging timestamp first across
+ * all CPUs. Called with ring->lock held, which also keeps drainers apart.
+ * Records staged while the ring is not active are dropped.
+ */
+static void
+dhd_dbg_ring_stage_drain_locked(dhd_dbg_ring_t *ring)
+{
+	dhd_dbg_ring_stage_t *st, *best;
+	dhd_dbg_stage_rec_t rec, best_rec;
+	int cpu;
+
+	if (!ring->stage) {
+		return;
+	}
+
+	do {
+		best = NULL;
+		for_each_possible_cpu(cpu) {
+			st = per_cpu_ptr(ring->stage, cpu);
+			if (READ_ONCE(st->head) == st->tail) {
+				continue;
+			}
+			/* head before the record it covers */
+			smp_rmb();
+			dhd_dbg_ring_stage_copy_out(st, st->tail, &rec, sizeof(rec));
+			if (!best || rec.ts < best_rec.ts) {
+				best = st;
+				best_rec = rec;
+			}
+		}
+		if (!best) {
+			break;
+		}
+
+		dhd_dbg_ring_stage_copy_out(best, best->tail + sizeof(rec),
+			ring->stage_scratch, best_rec.hdr.len);
+		if (ring->state != RING_ACTIVE) {
+			best->drops[DHD_DBG_STAGE_DROP_INACTIVE]++;
+		} else if (dhd_dbg_ring_push_locked(ring, &best_rec.hdr,
+			ring->stage_scratch) != BCME_OK) {
+			best->drops[DHD_DBG_STAGE_DROP_COMMIT]++;
+		} else {
+			ring->stage_committed++;
+		}
+		/* done with the record before the producer may reuse it */
+		smp_mb();
+		WRITE_ONCE(best->tail, best->tail + sizeof(rec) + best_rec.hdr.len);
+	} while (TRUE);
+	dhd_dbg_ring_shm_update(ring);
+}
+
+static void
+dhd_dbg_ring_stage_drain(dhd_dbg_ring_t *ring)
+{
+	unsigned long flags;
+
+	if (!ring->stage || in_irq()) {
+		return;
+	}
+
+	DHD_DBG_RING_LOCK(ring->lock, flags);
+	dhd_dbg_ring_stage_drain_locked(ring);
+	DHD_DBG_RING_UNLOCK(ring->lock, flags);
+}
+
+void
+dhd_dbg_ring_stage_dump(dhd_dbg_ring_t *ring, struct bcmstrbuf *b)
+{
+	uint32 staged = 0, direct = 0, pending = 0;
+	uint32 drops[DHD_DBG_STAGE_DROP_MAX] = {0};
+	int cpu, i;
+
+	if (!ring || !ring->stage) {
+		return;
+	}
+
+	for_each_possible_cpu(cpu) {
+		dhd_dbg_ring_stage_t *st = per_cpu_ptr(ring->stage, cpu);
+
+		staged += st->staged;
+		direct += st->direct;
+		pending += READ_ONCE(st->head) - READ_ONCE(st->tail);
+		for (i = 0; i < DHD_DBG_STAGE_DROP_MAX; i++) {
+			drops[i] += st->drops[i];
+		}
+	}
+
+	bcm_bprintf(b, "RING%d[%s] staged %u committed %u direct %u pending %u bytes"
+		" drop: full %u toobig %u inactive %u commit %u\n",
+		ring->id, ring->name, staged, ring->stage_committed, direct, pending,
+		drops[DHD_DBG_STAGE_DROP_FULL], drops[DHD_DBG_STAGE_DROP_TOOBIG],
+		drops[DHD_DBG_STAGE_DROP_INACTIVE], drops[DHD_DBG_STAGE_DROP_COMMIT]);
+}
+#endif /* __linux__ && DHD_DBG_RING_PCPU_STAGE */
+
+int
+dhd_dbg_ring_push(dhd_dbg_ring_t *ring, dhd_dbg_ring_entry_t *hdr, void *data)
+{
+	unsigned long flags;
+	int ret;
+
+	if (!ring || !hdr || !data) {
+		return BCME_BADARG;
+	}
+
+#if defined(__linux__) && defined(DHD_DBG_RING_PCPU_STAGE)
+	if (ring->stage) {
+		ret = dhd_dbg_ring_stage_put(ring, hdr, data);
+		if (ret == BCME_OK || ret == BCME_BUSY) {
+			return ret;
+		}
+		/* staging full or record too big, push it directly below */
+	}
+#endif /* __linux__ && DHD_DBG_RING_PCPU_STAGE */
+
+#if defined(__linux__)
+	/* Prevents the case of accessing the ring buffer in the HardIRQ context.
+	 * If an interrupt arise after holding ring lock, It could try the same lock.
+	 * This is to use the ring lock as spin_lock_bh instead of spin_lock_irqsave.
+	 */
+	if (in_irq()) {
+		return BCME_BUSY;
+	}
+#endif /* defined(__linux__) */
+
+	DHD_DBG_RING_LOCK(ring->lock, flags);
+	/* records still staged are older than this one */
+	dhd_dbg_ring_stage_drain_locked(ring);
+	ret = dhd_dbg_ring_push_locked(ring, hdr, data);
+	dhd_dbg_ring_shm_update(ring);
+	DHD_DBG_RING_UNLOCK(ring->lock, flags);
+
+	return ret;
+}
+
 /*
  * This function folds ring->lock, so callers of this function
  * should not hold ring->lock.
@@ -361,6 +710,7 @@ dhd_dbg_ring_pull_single(dhd_dbg_ring_t *ring, void *data, uint32 buf_len, bool
 	ring->stat.read_bytes += ENTRY_LENGTH(r_entry);
 	DHD_DBGIF(("%s RING%d[%s]read_bytes %d, wp=%d, rp=%d\n", __FUNCTION__,
 		ring->id, ring->name, ring->stat.read_bytes, ring->wp, ring->rp));
+	dhd_dbg_ring_shm_update(ring);
 
 exit:
 	DHD_DBG_RING_UNLOCK(ring->lock, flags);
@@ -377,6 +727,8 @@ dhd_dbg_ring_pull(dhd_dbg_ring_t *ring, void *data, uint32 buf_len, bool strip_h
 	if (!ring || !data)
 		return 0;
 
+	dhd_dbg_ring_stage_drain(ring);
+
 	DHD_DBG_RING_LOCK(ring->lock, flags);
 	if (!ring->pull_inactive && (ring->state != RING_ACTIVE)) {
 		DHD_DBG_RING_UNLOCK(ring->lock, flags);
@@ -409,6 +761,9 @@ dhd_dbg_ring_config(dhd_dbg_ring_t *ring, int log_level, uint32 threshold)
 
 	DHD_DBG_RING_LOCK(ring->lock, flags);
 
+	/* staged records belong to the state being left */
+	dhd_dbg_ring_stage_drain_locked(ring);
+
 	if (log_level == 0)
 		ring->state = RING_SUSPEND;
 	else
@@ -430,9 +785,126 @@ dhd_dbg_ring_start(dhd_dbg_ring_t *ring)
 
 	/* Initialize the information for the ring */
 	ring->state = RING_SUSPEND;
+	/* drop what was staged for the previous session */
+	dhd_dbg_ring_stage_drain(ring);
 	ring->log_level = 0;
 	ring->rp = ring->wp = 0;
 	ring->threshold = 0;
 	memset(&ring->stat, 0, sizeof(struct ring_statistics));
 	memset(ring->ring_buf, 0, ring->ring_size);
+#ifdef DHD_DBG_RING_MMAP
+	ring->wake_bytes = 0;
+	ring->tail_padded = FALSE;
+	ring->rem_len = 0;
+	dhd_dbg_ring_shm_update(ring);
+#endif /* DHD_DBG_RING_MMAP */
+}
+
+#ifdef DHD_DBG_RING_MMAP
+/*
+ * Initialize a ring whose header and data live in one page aligned,
+ * zeroed area that can be mapped to userspace. Copy based readers use the
+ * ring exactly like one set up by dhd_dbg_ring_init().
+ */
+int
+dhd_dbg_ring_init_mmap(dhd_pub_t *dhdp, dhd_dbg_ring_t *ring, uint16 id, uint8 *name,
+		uint32 ring_sz, bool pull_inactive)
+{
+	dhd_dbg_ring_map_t *map;
+	dhd_dbg_ring_shm_t *shm;
+	uint32 shm_len;
+	int ret;
+
+	STATIC_ASSERT(sizeof(dhd_dbg_ring_shm_t) <= DHD_DBG_RING_SHM_HDR_LEN);
+
+	/* freed from the last kref_put, which has no osh */
+	map = (dhd_dbg_ring_map_t *)kzalloc(sizeof(*map), GFP_KERNEL);
+	if (!map) {
+		return BCME_NOMEM;
+	}
+
+	shm_len = PAGE_ALIGN(DHD_DBG_RING_SHM_HDR_LEN + ring_sz);
+	shm = (dhd_dbg_ring_shm_t *)vmalloc_user(shm_len);
+	if (!shm) {
+		DHD_ERROR(("%s: RING%d failed to allocate %u bytes\n",
+			__FUNCTION__, id, shm_len));
+		kfree(map);
+		return BCME_NOMEM;
+	}
+
+	ret = dhd_dbg_ring_init(dhdp, ring, id, name, ring_sz,
+		(uint8 *)shm + DHD_DBG_RING_SHM_HDR_LEN, pull_inactive);
+	if (ret != BCME_OK) {
+		vfree(shm);
+		kfree(map);
+		return ret;
+	}
+
+	shm->magic = DHD_DBG_RING_SHM_MAGIC;
+	shm->version = DHD_DBG_RING_SHM_VERSION;
+	shm->hdr_len = DHD_DBG_RING_SHM_HDR_LEN;
+	shm->ring_id = id;
+	shm->ring_size = ring_sz;
+
+	kref_init(&map->ref);
+	atomic_set(&map->mmap_cnt, 0);
+	map->area = shm;
+	map->len = shm_len;
+
+	ring->wake_gen = 0;
+	ring->wake_bytes = 0;
+	init_waitqueue_head(&ring->wq);
+	ring->map = map;
+	/* publish last, the proc mmap handler checks ring->shm */
+	OSL_SMP_WMB();
+	ring->shm = shm;
+
+	return BCME_OK;
+}
+
+static void
+dhd_dbg_ring_map_release(struct kref *ref)
+{
+	dhd_dbg_ring_map_t *map;
+
+	GCC_DIAGNOSTIC_PUSH_SUPPRESS_CAST();
+	map = container_of(ref, dhd_dbg_ring_map_t, ref);
+	GCC_DIAGNOSTIC_POP();
+
+	vfree(map->area);
+	kfree(map);
+}
+
+/* Take a reference on the ring's area for a new user mapping */
+dhd_dbg_ring_map_t *
+dhd_dbg_ring_map_get(dhd_dbg_ring_t *ring)
+{
+	dhd_dbg_ring_map_t *map = ring->map;
+
+	if (map) {
+		kref_get(&map->ref);
+	}
+
+	return map;
+}
+
+/* Drop a reference; the last one frees the area, must be called from process context */
+void
+dhd_dbg_ring_map_put(dhd_dbg_ring_map_t *map)
+{
+	kref_put(&map->ref, dhd_dbg_ring_map_release);
+}
+
+uint32
+dhd_dbg_ring_get_wake_gen(dhd_dbg_ring_t *ring)
+{
+	uint32 gen;
+	unsigned long flags = 0;
+
+	DHD_DBG_RING_LOCK(ring->lock, flags);
+	gen = ring->wake_gen;
+	DHD_DBG_RING_UNLOCK(ring->lock, flags);
+
+	return gen;
 }
+#endif /* DHD_DBG_RING_MMAP */
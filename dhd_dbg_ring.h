@@ -27,6 +27,14 @@
 #define __DHD_DBG_RING_H__
 
 #include <bcmutils.h>
+#if defined(__linux__) && defined(DHD_DBG_RING_MMAP)
+#include <linux/wait.h>
+#include <linux/kref.h>
+#endif /* __linux__ && DHD_DBG_RING_MMAP */
+#if defined(__linux__) && defined(DHD_DBG_RING_PCPU_STAGE)
+#include <linux/percpu.h>
+#include <linux/workqueue.h>
+#endif /* __linux__ && DHD_DBG_RING_PCPU_STAGE */
 
 #define PACKED_STRUCT __attribute__ ((packed))
 
@@ -72,6 +80,79 @@ typedef struct dhd_dbg_ring_status {
 	uint32 written_records;
 } dhd_dbg_ring_status_t;
 
+#ifdef DHD_DBG_RING_MMAP
+/*
+ * Header page of an mmap-able ring, followed by the ring data at hdr_len.
+ * Userspace maps both read-only and keeps its own read offset:
+ *  - snapshot wp/rp/wrap_off while seq is even and unchanged across the reads
+ *  - records in [offset, wp) are complete; an offset equal to wrap_off
+ *    continues at 0
+ *  - if the offset is no longer between rp and wp, records were overwritten
+ *    and reading restarts at rp
+ * The driver's rp only moves for copy based readers and for overwrites.
+ */
+#define DHD_DBG_RING_SHM_MAGIC		0x52474244u	/* "DBGR" */
+#define DHD_DBG_RING_SHM_VERSION	1u
+
+typedef struct dhd_dbg_ring_shm {
+	uint32 magic;
+	uint32 version;
+	uint32 hdr_len;		/* offset of the ring data in the mapping */
+	uint32 ring_id;
+	uint32 ring_size;	/* bytes of ring data */
+	uint32 seq;		/* odd while the fields below are updated */
+	uint32 wp;		/* end of the last complete record */
+	uint32 rp;		/* oldest record kept in the ring */
+	uint32 wrap_off;	/* start of tail padding, 0 if none */
+	uint32 written_records;
+	uint32 written_bytes;
+	uint32 read_bytes;
+} dhd_dbg_ring_shm_t;
+
+#if defined(__linux__)
+/*
+ * Backing area of an mmap-able ring. Held by the ring and by every user
+ * mapping, so the area outlives dhd_dbg_ring_deinit() until the last munmap.
+ */
+typedef struct dhd_dbg_ring_map {
+	struct kref ref;
+	atomic_t mmap_cnt;	/* active user mappings */
+	void *area;		/* vmalloc_user() area, shm header then ring data */
+	uint32 len;		/* length of the area */
+} dhd_dbg_ring_map_t;
+#endif /* __linux__ */
+#endif /* DHD_DBG_RING_MMAP */
+
+#ifdef DHD_DBG_RING_PCPU_STAGE
+/* per CPU staging bytes, must be a power of 2 */
+#define DHD_DBG_RING_STAGE_SIZE		4096u
+/* a producer filling its staging past this drains it inline */
+#define DHD_DBG_RING_STAGE_DRAIN_THRESH	(DHD_DBG_RING_STAGE_SIZE / 2u)
+
+/* reasons a record never made it into the ring */
+enum dhd_dbg_stage_drop {
+	DHD_DBG_STAGE_DROP_FULL = 0,	/* staging buffer of the CPU full in hard IRQ */
+	DHD_DBG_STAGE_DROP_TOOBIG = 1,	/* larger than staging, pushed from hard IRQ */
+	DHD_DBG_STAGE_DROP_INACTIVE = 2, /* ring suspended before the record was committed */
+	DHD_DBG_STAGE_DROP_COMMIT = 3,	/* ring rejected the record */
+	DHD_DBG_STAGE_DROP_MAX = 4
+};
+
+/*
+ * Per CPU single producer/single consumer byte FIFO. Producers on the CPU
+ * are serialized by disabling local interrupts, the consumer drains under
+ * the ring lock. head and tail are free running.
+ */
+typedef struct dhd_dbg_ring_stage {
+	uint8 *buf;
+	uint32 head;		/* written by the producer */
+	uint32 tail;		/* written by the drainer */
+	uint32 staged;		/* records staged on this CPU */
+	uint32 direct;		/* records pushed past staging, full or too big */
+	uint32 drops[DHD_DBG_STAGE_DROP_MAX];
+} dhd_dbg_ring_stage_t;
+#endif /* DHD_DBG_RING_PCPU_STAGE */
+
 typedef struct dhd_dbg_ring {
 	int     id;		/* ring id */
 	uint8   name[DBGRING_NAME_MAX]; /* name string */
@@ -89,6 +170,21 @@ typedef struct dhd_dbg_ring {
 	uint32 rem_len;		/* number of bytes from wp_pad to end */
 	bool sched_pull;	/* schedule reader immediately */
 	bool pull_inactive;	/* pull contents from ring even if it is inactive */
+#ifdef DHD_DBG_RING_MMAP
+	dhd_dbg_ring_shm_t *shm;	/* shared header, NULL if ring is not mmap-able */
+	uint32 wake_gen;	/* bumped on every poll wakeup */
+	uint32 wake_bytes;	/* written_bytes at the last poll wakeup */
+#if defined(__linux__)
+	dhd_dbg_ring_map_t *map;	/* area holding shm, one reference held by the ring */
+	wait_queue_head_t wq;	/* poll waiters */
+#endif /* __linux__ */
+#endif /* DHD_DBG_RING_MMAP */
+#if defined(__linux__) && defined(DHD_DBG_RING_PCPU_STAGE)
+	dhd_dbg_ring_stage_t __percpu *stage;	/* NULL if records go straight to the ring */
+	uint8 *stage_scratch;	/* drainer copy of one staged payload */
+	struct work_struct stage_work;	/* deferred drain */
+	uint32 stage_committed;	/* staged records committed to the ring */
+#endif /* __linux__ && DHD_DBG_RING_PCPU_STAGE */
 } dhd_dbg_ring_t;
 
 #define DBGRING_FLUSH_THRESHOLD(ring)		(ring->ring_size / 3)
@@ -134,4 +230,14 @@ void dhd_dbg_ring_sched_pull(dhd_dbg_ring_t *ring, uint32 pending_len,
 		os_pullreq_t pull_fn, void *os_pvt, const int id);
 int dhd_dbg_ring_config(dhd_dbg_ring_t *ring, int log_level, uint32 threshold);
 void dhd_dbg_ring_start(dhd_dbg_ring_t *ring);
+#if defined(__linux__) && defined(DHD_DBG_RING_PCPU_STAGE)
+void dhd_dbg_ring_stage_dump(dhd_dbg_ring_t *ring, struct bcmstrbuf *b);
+#endif /* __linux__ && DHD_DBG_RING_PCPU_STAGE */
+#ifdef DHD_DBG_RING_MMAP
+int dhd_dbg_ring_init_mmap(dhd_pub_t *dhdp, dhd_dbg_ring_t *ring, uint16 id, uint8 *name,
+		uint32 ring_sz, bool pull_inactive);
+uint32 dhd_dbg_ring_get_wake_gen(dhd_dbg_ring_t *ring);
+dhd_dbg_ring_map_t *dhd_dbg_ring_map_get(dhd_dbg_ring_t *ring);
+void dhd_dbg_ring_map_put(dhd_dbg_ring_map_t *map);
+#endif /* DHD_DBG_RING_MMAP */
 #endif /* __DHD_DBG_RING_H__ */
@@ -203,6 +203,31 @@ dhd_dbg_get_ring_from_ring_id(dhd_pub_t *dhdp, int ring_id)
 	return &dhdp->dbg->dbg_rings[ring_id];
 }
 
+#if defined(__linux__) && defined(DHD_DBG_RING_PCPU_STAGE)
+void
+dhd_dbg_stage_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
+{
+	int ring_id;
+
+	if (!dhdp || !dhdp->dbg) {
+		return;
+	}
+
+	bcm_bprintf(strbuf, "\nDebug ring staging:\n");
+	for (ring_id = DEBUG_RING_ID_INVALID + 1; ring_id < DEBUG_RING_ID_MAX; ring_id++) {
+		if (VALID_RING(dhdp->dbg->dbg_rings[ring_id].id)) {
+			dhd_dbg_ring_stage_dump(&dhdp->dbg->dbg_rings[ring_id], strbuf);
+		}
+	}
+#ifdef EWP_ECNTRS_LOGGING
+	dhd_dbg_ring_stage_dump((dhd_dbg_ring_t *)dhdp->ecntr_dbg_ring, strbuf);
+#endif /* EWP_ECNTRS_LOGGING */
+#ifdef EWP_RTT_LOGGING
+	dhd_dbg_ring_stage_dump((dhd_dbg_ring_t *)dhdp->rtt_dbg_ring, strbuf);
+#endif /* EWP_RTT_LOGGING */
+}
+#endif /* __linux__ && DHD_DBG_RING_PCPU_STAGE */
+
 int
 dhd_dbg_pull_single_from_ring(dhd_pub_t *dhdp, int ring_id, void *data, uint32 buf_len,
 	bool strip_header)
@@ -583,13 +608,86 @@ dhd_dbg_verboselog_handler(dhd_pub_t *dhdp, prcd_event_log_hdr_t *plog_hdr,
 	dhd_dbg_verboselog_printf(dhdp, plog_hdr, raw_event_ptr, log_ptr, logset, block);
 }
 
+/* Returns TRUE if the tag is above the current log level of the verbose ring */
+static bool
+dhd_dbg_verboselog_filtered(dhd_pub_t *dhdp, uint32 tag)
+{
+	int log_level, id;
+
+	if (!dhdp->dbg) {
+		return FALSE;
+	}
+
+	log_level = dhdp->dbg->dbg_rings[FW_VERBOSE_RING_ID].log_level;
+	for (id = 0; id < ARRAYSIZE(fw_verbose_level_map); id++) {
+		if ((fw_verbose_level_map[id].tag == tag) &&
+			(fw_verbose_level_map[id].log_level > log_level))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+#ifdef DHD_EVENTLOG_PASSTHROUGH
+/*
+ * Push the record to the verbose ring as is, leaving the formatting against
+ * logstrs.bin to the reader. Returns FALSE if the record has to go through
+ * the text path instead.
+ */
+static bool
+dhd_dbg_verboselog_bin(dhd_pub_t *dhdp, prcd_event_log_hdr_t *plog_hdr,
+	uint32 *log_ptr, uint32 logset, uint16 block)
+{
+	uint32 buf[(sizeof(dhd_evtlog_bin_t) / sizeof(uint32)) + MAX_NO_OF_ARG];
+	dhd_evtlog_bin_t *rec = (dhd_evtlog_bin_t *)buf;
+	dhd_dbg_ring_entry_t msg_hdr;
+	uint32 nargs;
+
+	if (plog_hdr->binary_payload || plog_hdr->count == 0 ||
+		(plog_hdr->count - 1) > MAX_NO_OF_ARG) {
+		return FALSE;
+	}
+
+	/* preserve sets go to debug_dump, text sets are formatted as before */
+	if (logset < dhdp->event_log_max_sets &&
+		((0x01u << logset) & (dhdp->logset_prsrv_mask | dhdp->logset_text_mask))) {
+		return FALSE;
+	}
+
+	if (dhd_dbg_verboselog_filtered(dhdp, plog_hdr->tag)) {
+		return TRUE;
+	}
+
+	nargs = plog_hdr->count - 1;
+	rec->version = DHD_EVTLOG_BIN_VERSION;
+	rec->count = (uint8)nargs;
+	rec->tag = (uint16)plog_hdr->tag;
+	rec->fmt_num = (uint16)plog_hdr->fmt_num;
+	rec->fmt_num_raw = (uint16)plog_hdr->fmt_num_raw;
+	rec->logset = (uint16)logset;
+	rec->block = block;
+	/* last word of the payload is the dongle time */
+	rec->fw_ts = log_ptr[nargs];
+	memcpy(rec->args, log_ptr, nargs * sizeof(uint32));
+
+	memset(&msg_hdr, 0, sizeof(msg_hdr));
+	msg_hdr.type = DBG_RING_ENTRY_DATA_TYPE;
+	msg_hdr.flags = DBG_RING_ENTRY_FLAGS_HAS_BINARY | DBG_RING_ENTRY_FLAGS_HAS_TIMESTAMP;
+	msg_hdr.timestamp = DIV_U64_BY_U32(OSL_LOCALTIME_NS(), NSEC_PER_MSEC);
+	msg_hdr.len = (uint16)(sizeof(*rec) + (nargs * sizeof(uint32)));
+
+	dhd_dbg_push_to_ring(dhdp, FW_VERBOSE_RING_ID, &msg_hdr, rec);
+
+	return TRUE;
+}
+#endif /* DHD_EVENTLOG_PASSTHROUGH */
+
 void
 dhd_dbg_verboselog_printf(dhd_pub_t *dhdp, prcd_event_log_hdr_t *plog_hdr,
 	void *raw_event_ptr, uint32 *log_ptr, uint32 logset, uint16 block)
 {
 	dhd_event_log_t *raw_event = (dhd_event_log_t *)raw_event_ptr;
 	uint16 count;
-	int log_level, id;
 	char fmtstr_loc_buf[ROMSTR_SIZE] = { 0 };
 	char (*str_buf)[SIZE_LOC_STR] = NULL;
 	char *str_tmpptr = NULL;
@@ -628,15 +726,16 @@ dhd_dbg_verboselog_printf(dhd_pub_t *dhdp, prcd_event_log_hdr_t *plog_hdr,
 	}
 
 #endif /* DHD_LOG_PRINT_RATE_LIMIT */
+#ifdef DHD_EVENTLOG_PASSTHROUGH
+	if (control_logtrace == LOGTRACE_BIN_FMT &&
+		dhd_dbg_verboselog_bin(dhdp, plog_hdr, log_ptr, logset, block)) {
+		return;
+	}
+#endif /* DHD_EVENTLOG_PASSTHROUGH */
 	/* print the message out in a logprint  */
 	if ((control_logtrace == LOGTRACE_RAW_FMT) || !(raw_event->fmts)) {
-		if (dhdp->dbg) {
-			log_level = dhdp->dbg->dbg_rings[FW_VERBOSE_RING_ID].log_level;
-			for (id = 0; id < ARRAYSIZE(fw_verbose_level_map); id++) {
-				if ((fw_verbose_level_map[id].tag == plog_hdr->tag) &&
-					(fw_verbose_level_map[id].log_level > log_level))
-					return;
-			}
+		if (dhd_dbg_verboselog_filtered(dhdp, plog_hdr->tag)) {
+			return;
 		}
 		if (plog_hdr->binary_payload) {
 			DHD_ECNTR_LOG(("%d.%d EL:tag=%d len=%d fmt=0x%x",
@@ -2718,6 +2817,14 @@ dhd_dbg_attach(dhd_pub_t *dhdp, dbg_pullreq_t os_pullreq,
 	if (!dbg)
 		return BCME_NOMEM;
 
+#ifdef DHD_DBG_RING_MMAP
+	/* verbose ring can be mapped by the HAL through /proc/dhd_trace */
+	ret = dhd_dbg_ring_init_mmap(dhdp, &dbg->dbg_rings[FW_VERBOSE_RING_ID],
+			FW_VERBOSE_RING_ID, (uint8 *)FW_VERBOSE_RING_NAME,
+			FW_VERBOSE_RING_SIZE, FALSE);
+	if (ret)
+		goto error;
+#else
 	buf = MALLOCZ(dhdp->osh, FW_VERBOSE_RING_SIZE);
 	if (!buf)
 		goto error;
@@ -2725,6 +2832,7 @@ dhd_dbg_attach(dhd_pub_t *dhdp, dbg_pullreq_t os_pullreq,
 			(uint8 *)FW_VERBOSE_RING_NAME, FW_VERBOSE_RING_SIZE, buf, FALSE);
 	if (ret)
 		goto error;
+#endif /* DHD_DBG_RING_MMAP */
 
 	buf = MALLOCZ(dhdp->osh, DHD_EVENT_RING_SIZE);
 	if (!buf)
@@ -766,6 +766,27 @@ typedef struct prcd_event_log_hdr {
 	bool binary_payload;	/* 0 - non binary payload, 1 - binary payload */
 } prcd_event_log_hdr_t;		/* Processed event log header */
 
+#ifdef DHD_EVENTLOG_PASSTHROUGH
+/*
+ * Unformatted event log record pushed to the verbose ring with LOGTRACE_BIN_FMT.
+ * The ring entry carries DBG_RING_ENTRY_FLAGS_HAS_BINARY; fmt_num indexes the
+ * same logstrs.bin the host would otherwise use to format the record.
+ */
+#define DHD_EVTLOG_BIN_VERSION	1u
+
+typedef struct dhd_evtlog_bin {
+	uint8 version;
+	uint8 count;		/* number of args, dongle timestamp excluded */
+	uint16 tag;
+	uint16 fmt_num;		/* index into logstrs.bin */
+	uint16 fmt_num_raw;	/* format number as sent by the dongle */
+	uint16 logset;
+	uint16 block;
+	uint32 fw_ts;		/* dongle timestamp, msec */
+	uint32 args[];
+} dhd_evtlog_bin_t;
+#endif /* DHD_EVENTLOG_PASSTHROUGH */
+
 /* dhd_dbg functions */
 extern void dhd_dbg_trace_evnt_handler(dhd_pub_t *dhdp, void *event_data,
 		void *raw_event_ptr, uint datalen);
@@ -781,6 +802,9 @@ extern int dhd_dbg_set_configuration(dhd_pub_t *dhdp, int ring_id,
 		int log_level, int flags, uint32 threshold);
 extern int dhd_dbg_find_ring_id(dhd_pub_t *dhdp, char *ring_name);
 extern dhd_dbg_ring_t *dhd_dbg_get_ring_from_ring_id(dhd_pub_t *dhdp, int ring_id);
+#if defined(__linux__) && defined(DHD_DBG_RING_PCPU_STAGE)
+extern void dhd_dbg_stage_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf);
+#endif /* __linux__ && DHD_DBG_RING_PCPU_STAGE */
 extern void *dhd_dbg_get_priv(dhd_pub_t *dhdp);
 extern int dhd_dbg_send_urgent_evt(dhd_pub_t *dhdp, const void *data, const uint32 len);
 extern void dhd_dbg_verboselog_printf(dhd_pub_t *dhdp, prcd_event_log_hdr_t *plog_hdr,
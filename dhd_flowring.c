@@ -442,7 +442,21 @@ dhd_flow_rings_init(dhd_pub_t *dhdp, uint32 num_h2d_rings)
 		if_flow_lkup[idx].role = 0;
 		for (hash_ix = 0; hash_ix < DHD_FLOWRING_HASH_SIZE; hash_ix++)
 			if_flow_lkup[idx].fl_hash[hash_ix] = NULL;
+#ifdef DHD_FLOWID_CACHE
+		for (hash_ix = 0; hash_ix < DHD_FLOWID_CACHE_SIZE; hash_ix++) {
+			seqcount_init(&if_flow_lkup[idx].fl_cache[hash_ix].seq);
+			if_flow_lkup[idx].fl_cache[hash_ix].valid = FALSE;
+		}
+#endif /* DHD_FLOWID_CACHE */
+	}
+
+#ifdef DHD_FLOWID_CACHE
+	dhdp->flowid_cache_stats = alloc_percpu(flowid_cache_stats_t);
+	if (dhdp->flowid_cache_stats == NULL) {
+		DHD_ERROR(("%s: flowid cache stats alloc failure\n", __FUNCTION__));
+		goto fail;
 	}
+#endif /* DHD_FLOWID_CACHE */
 
 	lock = osl_spin_lock_init(dhdp->osh);
 	if (lock == NULL)
@@ -479,6 +493,12 @@ lock_fail:
 	osl_spin_lock_deinit(dhdp->osh, lock);
 
 fail:
+#ifdef DHD_FLOWID_CACHE
+	if (dhdp->flowid_cache_stats != NULL) {
+		free_percpu(dhdp->flowid_cache_stats);
+		dhdp->flowid_cache_stats = NULL;
+	}
+#endif /* DHD_FLOWID_CACHE */
 	/* Destruct the per interface flow lkup table */
 	if (if_flow_lkup != NULL) {
 		DHD_OS_PREFREE(dhdp, if_flow_lkup, if_flow_lkup_sz);
@@ -569,6 +589,13 @@ void dhd_flow_rings_deinit(dhd_pub_t *dhdp)
 	osl_spin_lock_deinit(dhdp->osh, dhdp->flowring_list_lock);
 	dhdp->flowring_list_lock = NULL;
 
+#ifdef DHD_FLOWID_CACHE
+	if (dhdp->flowid_cache_stats != NULL) {
+		free_percpu(dhdp->flowid_cache_stats);
+		dhdp->flowid_cache_stats = NULL;
+	}
+#endif /* DHD_FLOWID_CACHE */
+
 	ASSERT(dhdp->if_flow_lkup == NULL);
 	ASSERT(dhdp->flow_ring_table == NULL);
 	dhdp->flow_rings_inited = FALSE;
@@ -604,6 +631,104 @@ bool is_tdls_destination(dhd_pub_t *dhdp, uint8 *da)
 }
 #endif /* WLTDLS */
 
+#ifdef DHD_FLOWID_CACHE
+/* TDLS peers override the per prio mapping of a STA, do not cache around them */
+#ifdef WLTDLS
+#define DHD_FLOWID_CACHE_BYPASS(dhdp)	((dhdp)->peer_tbl.tdls_peer_count != 0)
+#else
+#define DHD_FLOWID_CACHE_BYPASS(dhdp)	FALSE
+#endif /* WLTDLS */
+
+/** Lockless lookup in the flowid cache, FLOWID_INVALID on a miss */
+static INLINE uint16
+dhd_flowid_cache_get(dhd_pub_t *dhdp, uint8 ifindex, uint8 prio, char *da)
+{
+	if_flow_lkup_t *if_flow_lkup = (if_flow_lkup_t *)dhdp->if_flow_lkup;
+	flowid_cache_ent_t *ent;
+	uint16 flowid = FLOWID_INVALID;
+	unsigned int seq;
+
+	if (!DHD_FLOWID_CACHE_BYPASS(dhdp)) {
+		ent = &if_flow_lkup[ifindex].fl_cache[DHD_FLOWID_CACHE_IDX(da, prio)];
+		seq = raw_read_seqcount(&ent->seq);
+		if (!(seq & 1) && ent->valid && (ent->prio == prio) &&
+			!memcmp(ent->da, da, ETHER_ADDR_LEN)) {
+			flowid = ent->flowid;
+		}
+		if (read_seqcount_retry(&ent->seq, seq)) {
+			flowid = FLOWID_INVALID;
+		}
+	}
+
+	if (flowid != FLOWID_INVALID) {
+		this_cpu_inc(dhdp->flowid_cache_stats->hit);
+	} else {
+		this_cpu_inc(dhdp->flowid_cache_stats->miss);
+	}
+
+	return flowid;
+}
+
+/** Remember a resolved flowid, called with flowid_lock held */
+static INLINE void
+dhd_flowid_cache_set(dhd_pub_t *dhdp, if_flow_lkup_t *lkup, uint8 prio, char *da,
+	uint16 flowid)
+{
+	flowid_cache_ent_t *ent = &lkup->fl_cache[DHD_FLOWID_CACHE_IDX(da, prio)];
+
+	if (DHD_FLOWID_CACHE_BYPASS(dhdp)) {
+		return;
+	}
+
+	write_seqcount_begin(&ent->seq);
+	memcpy(ent->da, da, ETHER_ADDR_LEN);
+	ent->prio = prio;
+	ent->flowid = flowid;
+	ent->valid = TRUE;
+	write_seqcount_end(&ent->seq);
+}
+
+/** Drop all cached flowids of an interface, called with flowid_lock held */
+static void
+dhd_flowid_cache_flush(if_flow_lkup_t *lkup)
+{
+	flowid_cache_ent_t *ent;
+	int i;
+
+	for (i = 0; i < DHD_FLOWID_CACHE_SIZE; i++) {
+		ent = &lkup->fl_cache[i];
+		if (ent->valid) {
+			write_seqcount_begin(&ent->seq);
+			ent->valid = FALSE;
+			write_seqcount_end(&ent->seq);
+		}
+	}
+}
+
+void
+dhd_flowid_cache_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
+{
+	flowid_cache_stats_t *st;
+	uint32 hit = 0, miss = 0;
+	uint64 total;
+	int cpu;
+
+	if (dhdp->flowid_cache_stats == NULL) {
+		return;
+	}
+
+	for_each_possible_cpu(cpu) {
+		st = per_cpu_ptr(dhdp->flowid_cache_stats, cpu);
+		hit += st->hit;
+		miss += st->miss;
+	}
+	total = (uint64)hit + miss;
+
+	bcm_bprintf(strbuf, "flowid_cache hit:%u miss:%u hit_rate:%u%%\n", hit, miss,
+		total ? (uint32)DIV_U64_BY_U32((uint64)hit * 100, total) : 0);
+}
+#endif /* DHD_FLOWID_CACHE */
+
 /** Uses hash table to quickly map from ifindex+prio+da to a flow ring id */
 static INLINE uint16
 dhd_flowid_find(dhd_pub_t *dhdp, uint8 ifindex, uint8 prio, char *sa, char *da)
@@ -643,6 +768,9 @@ dhd_flowid_find(dhd_pub_t *dhdp, uint8 ifindex, uint8 prio, char *sa, char *da)
 		/* For STA non TDLS dest and WDS dest flow ring id is mapped based on prio only */
 		cur = if_flow_lkup[ifindex].fl_hash[prio];
 		if (cur) {
+#ifdef DHD_FLOWID_CACHE
+			dhd_flowid_cache_set(dhdp, &if_flow_lkup[ifindex], prio, da, cur->flowid);
+#endif /* DHD_FLOWID_CACHE */
 			DHD_FLOWID_UNLOCK(dhdp->flowid_lock, flags);
 			return cur->flowid;
 		}
@@ -661,6 +789,10 @@ dhd_flowid_find(dhd_pub_t *dhdp, uint8 ifindex, uint8 prio, char *sa, char *da)
 			if ((ismcast && ETHER_ISMULTI(cur->flow_info.da)) ||
 				(!memcmp(cur->flow_info.da, da, ETHER_ADDR_LEN) &&
 				(cur->flow_info.tid == prio))) {
+#ifdef DHD_FLOWID_CACHE
+				dhd_flowid_cache_set(dhdp, &if_flow_lkup[ifindex], prio, da,
+					cur->flowid);
+#endif /* DHD_FLOWID_CACHE */
 				DHD_FLOWID_UNLOCK(dhdp->flowid_lock, flags);
 				return cur->flowid;
 			}
@@ -822,6 +954,10 @@ dhd_flowid_lookup(dhd_pub_t *dhdp, uint8 ifindex,
 
 	flow_ring_table = (flow_ring_table_t *)dhdp->flow_ring_table;
 
+#ifdef DHD_FLOWID_CACHE
+	id = dhd_flowid_cache_get(dhdp, ifindex, prio, da);
+	if (id == FLOWID_INVALID)
+#endif /* DHD_FLOWID_CACHE */
 	id = dhd_flowid_find(dhdp, ifindex, prio, sa, da);
 
 	if (id == FLOWID_INVALID) {
@@ -883,6 +1019,9 @@ dhd_flowid_lookup(dhd_pub_t *dhdp, uint8 ifindex,
 		flow_ring_node->flow_info.ifindex = ifindex;
 		flow_ring_node->active = TRUE;
 		flow_ring_node->status = FLOW_RING_STATUS_CREATE_PENDING;
+#ifdef DHD_STA_RCU_HASH
+		WRITE_ONCE(flow_ring_node->sta, NULL);
+#endif /* DHD_STA_RCU_HASH */
 
 #ifdef TX_STATUS_LATENCY_STATS
 		flow_ring_node->flow_info.num_tx_status = 0;
@@ -1109,6 +1248,9 @@ dhd_flowid_free(dhd_pub_t *dhdp, uint8 ifindex, uint16 flowid)
 
 				/* deregister flowid from dhd_pub. */
 				dhd_del_flowid(dhdp, ifindex, flowid);
+#ifdef DHD_FLOWID_CACHE
+				dhd_flowid_cache_flush(&if_flow_lkup[ifindex]);
+#endif /* DHD_FLOWID_CACHE */
 
 				dhd_flowid_map_free(dhdp, ifindex, flowid);
 				DHD_FLOWID_UNLOCK(dhdp->flowid_lock, flags);
@@ -1245,6 +1387,10 @@ dhd_update_interface_flow_info(dhd_pub_t *dhdp, uint8 ifindex,
 	if (op == WLC_E_IF_ADD || op == WLC_E_IF_CHANGE) {
 
 		if_flow_lkup[ifindex].role = role;
+#ifdef DHD_FLOWID_CACHE
+		/* the mapping depends on the role */
+		dhd_flowid_cache_flush(&if_flow_lkup[ifindex]);
+#endif /* DHD_FLOWID_CACHE */
 
 		if (role == WLC_E_IF_ROLE_WDS) {
 			/**
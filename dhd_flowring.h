@@ -37,6 +37,10 @@
 #ifndef _dhd_flowrings_h_
 #define _dhd_flowrings_h_
 
+#ifdef DHD_FLOWID_CACHE
+#include <linux/seqlock.h>
+#endif /* DHD_FLOWID_CACHE */
+
 /* Max pkts held in a flow ring's backup queue */
 #define FLOW_RING_QUEUE_THRESHOLD       (2048)
 
@@ -240,6 +244,9 @@ typedef struct flow_ring_node {
 #ifdef IDLE_TX_FLOW_MGMT
 	uint64		last_active_ts; /* contains last active timestamp */
 #endif /* IDLE_TX_FLOW_MGMT */
+#ifdef DHD_STA_RCU_HASH
+	struct dhd_sta	*sta; /* destination STA for accounting, revalidated on use */
+#endif /* DHD_STA_RCU_HASH */
 } flow_ring_node_t;
 
 typedef flow_ring_node_t flow_ring_table_t;
@@ -250,10 +257,38 @@ typedef struct flow_hash_info {
 	struct flow_hash_info	*next;
 } flow_hash_info_t;
 
+#ifdef DHD_FLOWID_CACHE
+/*
+ * Direct mapped cache of resolved (da, prio) -> flowid, read without the
+ * flowid lock. Entries are filled from the hash and flushed under the lock,
+ * readers treat a torn or in-progress entry as a miss.
+ */
+#define DHD_FLOWID_CACHE_SIZE	32	/* power of 2 */
+#define DHD_FLOWID_CACHE_IDX(ea, prio) \
+	(DHD_FLOWRING_HASHINDEX(ea, prio) & (DHD_FLOWID_CACHE_SIZE - 1))
+
+typedef struct flowid_cache_ent {
+	seqcount_t	seq;
+	uint8		da[ETHER_ADDR_LEN];
+	uint8		prio;
+	bool		valid;
+	uint16		flowid;
+} flowid_cache_ent_t;
+
+/* Kept per CPU so the TX path does not bounce a shared line */
+typedef struct flowid_cache_stats {
+	uint32		hit;	/* lockless flowid lookups */
+	uint32		miss;	/* lookups that took the flowid lock */
+} flowid_cache_stats_t;
+#endif /* DHD_FLOWID_CACHE */
+
 typedef struct if_flow_lkup {
 	bool		status;
 	uint8		role; /* Interface role: STA/AP */
 	flow_hash_info_t *fl_hash[DHD_FLOWRING_HASH_SIZE]; /* Lkup Hash table */
+#ifdef DHD_FLOWID_CACHE
+	flowid_cache_ent_t fl_cache[DHD_FLOWID_CACHE_SIZE];
+#endif /* DHD_FLOWID_CACHE */
 } if_flow_lkup_t;
 
 static INLINE flow_ring_node_t *
@@ -307,4 +342,7 @@ extern int dhd_flow_prio_map(dhd_pub_t *dhd, uint8 *map, bool set);
 extern int dhd_update_flow_prio_map(dhd_pub_t *dhdp, uint8 map);
 extern uint32 dhd_active_tx_flowring_bkpq_len(dhd_pub_t *dhdp);
 extern uint8 dhd_flow_rings_ifindex2role(dhd_pub_t *dhdp, uint8 ifindex);
+#ifdef DHD_FLOWID_CACHE
+extern void dhd_flowid_cache_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf);
+#endif /* DHD_FLOWID_CACHE */
 #endif /* _dhd_flowrings_h_ */
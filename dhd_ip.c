@@ -712,7 +712,7 @@ bool
 dhd_tcpack_suppress(dhd_pub_t *dhdp, void *pkt)
 {
 	uint8 *new_ether_hdr;	/* Ethernet header of the new packet */
-	uint16 new_ether_type;	/* Ethernet type of the new packet */
+	dhd_pktcls_t *cls;		/* cached classification of the new packet */
 	uint8 *new_ip_hdr;		/* IP header of the new packet */
 	uint8 *new_tcp_hdr;		/* TCP header of the new packet */
 	uint32 new_ip_hdr_len;	/* IP header length of the new packet */
@@ -739,30 +739,18 @@ dhd_tcpack_suppress(dhd_pub_t *dhdp, void *pkt)
 		goto exit;
 	}
 
-	new_ether_type = new_ether_hdr[12] << 8 | new_ether_hdr[13];
-
-	if (new_ether_type != ETHER_TYPE_IP) {
-		DHD_TRACE(("%s %d: Not a IP packet 0x%x\n",
-			__FUNCTION__, __LINE__, new_ether_type));
+	/* classified in dhd_start_xmit/dhd_rx_frame */
+	cls = DHD_PKTCLS(pkt);
+	if (!DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_IPV4) || !DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_TCP)) {
+		DHD_TRACE(("%s %d: Not IPv4 nor TCP! ether type 0x%x, prot %d\n",
+			__FUNCTION__, __LINE__, cls->ether_type, cls->ip_prot));
 		goto exit;
 	}
 
-	DHD_TRACE(("%s %d: IP pkt! 0x%x\n", __FUNCTION__, __LINE__, new_ether_type));
-
 	new_ip_hdr = new_ether_hdr + ETHER_HDR_LEN;
-	cur_framelen -= ETHER_HDR_LEN;
-
-	ASSERT(cur_framelen >= IPV4_MIN_HEADER_LEN);
-
-	new_ip_hdr_len = IPV4_HLEN(new_ip_hdr);
-	if (IP_VER(new_ip_hdr) != IP_VER_4 || IPV4_PROT(new_ip_hdr) != IP_PROT_TCP) {
-		DHD_TRACE(("%s %d: Not IPv4 nor TCP! ip ver %d, prot %d\n",
-			__FUNCTION__, __LINE__, IP_VER(new_ip_hdr), IPV4_PROT(new_ip_hdr)));
-		goto exit;
-	}
-
-	new_tcp_hdr = new_ip_hdr + new_ip_hdr_len;
-	cur_framelen -= new_ip_hdr_len;
+	new_tcp_hdr = new_ether_hdr + cls->l4_off;
+	new_ip_hdr_len = cls->l4_off - ETHER_HDR_LEN;
+	cur_framelen -= cls->l4_off;
 
 	ASSERT(cur_framelen >= TCP_MIN_HEADER_LEN);
 
@@ -935,7 +923,7 @@ bool
 dhd_tcpdata_info_get(dhd_pub_t *dhdp, void *pkt)
 {
 	uint8 *ether_hdr;	/* Ethernet header of the new packet */
-	uint16 ether_type;	/* Ethernet type of the new packet */
+	dhd_pktcls_t *cls;		/* cached classification of the new packet */
 	uint8 *ip_hdr;		/* IP header of the new packet */
 	uint8 *tcp_hdr;		/* TCP header of the new packet */
 	uint32 ip_hdr_len;	/* IP header length of the new packet */
@@ -959,30 +947,18 @@ dhd_tcpdata_info_get(dhd_pub_t *dhdp, void *pkt)
 	ether_hdr = PKTDATA(dhdp->osh, pkt);
 	cur_framelen = PKTLEN(dhdp->osh, pkt);
 
-	ether_type = ether_hdr[12] << 8 | ether_hdr[13];
-
-	if (ether_type != ETHER_TYPE_IP) {
-		DHD_TRACE(("%s %d: Not a IP packet 0x%x\n",
-			__FUNCTION__, __LINE__, ether_type));
+	/* classified in dhd_start_xmit/dhd_rx_frame */
+	cls = DHD_PKTCLS(pkt);
+	if (!DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_IPV4) || !DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_TCP)) {
+		DHD_TRACE(("%s %d: Not IPv4 nor TCP! ether type 0x%x, prot %d\n",
+			__FUNCTION__, __LINE__, cls->ether_type, cls->ip_prot));
 		goto exit;
 	}
 
-	DHD_TRACE(("%s %d: IP pkt! 0x%x\n", __FUNCTION__, __LINE__, ether_type));
-
 	ip_hdr = ether_hdr + ETHER_HDR_LEN;
-	cur_framelen -= ETHER_HDR_LEN;
-
-	ASSERT(cur_framelen >= IPV4_MIN_HEADER_LEN);
-
-	ip_hdr_len = IPV4_HLEN(ip_hdr);
-	if (IP_VER(ip_hdr) != IP_VER_4 || IPV4_PROT(ip_hdr) != IP_PROT_TCP) {
-		DHD_TRACE(("%s %d: Not IPv4 nor TCP! ip ver %d, prot %d\n",
-			__FUNCTION__, __LINE__, IP_VER(ip_hdr), IPV4_PROT(ip_hdr)));
-		goto exit;
-	}
-
-	tcp_hdr = ip_hdr + ip_hdr_len;
-	cur_framelen -= ip_hdr_len;
+	tcp_hdr = ether_hdr + cls->l4_off;
+	ip_hdr_len = cls->l4_off - ETHER_HDR_LEN;
+	cur_framelen -= cls->l4_off;
 
 	ASSERT(cur_framelen >= TCP_MIN_HEADER_LEN);
 
@@ -1164,7 +1140,7 @@ bool
 dhd_tcpack_hold(dhd_pub_t *dhdp, void *pkt, int ifidx)
 {
 	uint8 *new_ether_hdr;	/* Ethernet header of the new packet */
-	uint16 new_ether_type;	/* Ethernet type of the new packet */
+	dhd_pktcls_t *cls;		/* cached classification of the new packet */
 	uint8 *new_ip_hdr;		/* IP header of the new packet */
 	uint8 *new_tcp_hdr;		/* TCP header of the new packet */
 	uint32 new_ip_hdr_len;	/* IP header length of the new packet */
@@ -1195,30 +1171,18 @@ dhd_tcpack_hold(dhd_pub_t *dhdp, void *pkt, int ifidx)
 		goto exit;
 	}
 
-	new_ether_type = new_ether_hdr[12] << 8 | new_ether_hdr[13];
-
-	if (new_ether_type != ETHER_TYPE_IP) {
-		DHD_TRACE(("%s %d: Not a IP packet 0x%x\n",
-			__FUNCTION__, __LINE__, new_ether_type));
+	/* classified in dhd_start_xmit/dhd_rx_frame */
+	cls = DHD_PKTCLS(pkt);
+	if (!DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_IPV4) || !DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_TCP)) {
+		DHD_TRACE(("%s %d: Not IPv4 nor TCP! ether type 0x%x, prot %d\n",
+			__FUNCTION__, __LINE__, cls->ether_type, cls->ip_prot));
 		goto exit;
 	}
 
-	DHD_TRACE(("%s %d: IP pkt! 0x%x\n", __FUNCTION__, __LINE__, new_ether_type));
-
 	new_ip_hdr = new_ether_hdr + ETHER_HDR_LEN;
-	cur_framelen -= ETHER_HDR_LEN;
-
-	ASSERT(cur_framelen >= IPV4_MIN_HEADER_LEN);
-
-	new_ip_hdr_len = IPV4_HLEN(new_ip_hdr);
-	if (IP_VER(new_ip_hdr) != IP_VER_4 || IPV4_PROT(new_ip_hdr) != IP_PROT_TCP) {
-		DHD_TRACE(("%s %d: Not IPv4 nor TCP! ip ver %d, prot %d\n",
-			__FUNCTION__, __LINE__, IP_VER(new_ip_hdr), IPV4_PROT(new_ip_hdr)));
-		goto exit;
-	}
-
-	new_tcp_hdr = new_ip_hdr + new_ip_hdr_len;
-	cur_framelen -= new_ip_hdr_len;
+	new_tcp_hdr = new_ether_hdr + cls->l4_off;
+	new_ip_hdr_len = cls->l4_off - ETHER_HDR_LEN;
+	cur_framelen -= cls->l4_off;
 
 	ASSERT(cur_framelen >= TCP_MIN_HEADER_LEN);
 
@@ -48,6 +48,9 @@
 #include <linux/spinlock.h>
 #include <linux/ethtool.h>
 #include <linux/fcntl.h>
+#ifdef DHD_STA_RCU_HASH
+#include <linux/rculist_nulls.h>
+#endif /* DHD_STA_RCU_HASH */
 #include <linux/ip.h>
 #include <linux/reboot.h>
 #include <linux/notifier.h>
@@ -1087,6 +1090,38 @@ static void dhd_sta_pool_fini(dhd_pub_t *dhdp, int max_sta);
 /* Clear the pool of dhd_sta_t objects for built-in type driver */
 static void dhd_sta_pool_clear(dhd_pub_t *dhdp, int max_sta);
 
+/** Unlink a dhd_sta from its interface, caller holds sta_list_lock. */
+static inline void
+dhd_sta_unlink(dhd_sta_t *sta)
+{
+	list_del(&sta->list);
+#ifdef DHD_STA_RCU_HASH
+	/* keeps the forward link, lockless readers may still be walking it */
+	hlist_nulls_del_rcu(&sta->hnode);
+#endif /* DHD_STA_RCU_HASH */
+}
+
+#ifdef DHD_STA_RCU_HASH
+/** Return the index of a dhd_sta unlinked from its hash, once readers are done. */
+static void
+dhd_sta_release_rcu(struct rcu_head *rcu)
+{
+	dhd_sta_t *sta;
+	dhd_pub_t *dhdp;
+	unsigned long flags;
+
+	GCC_DIAGNOSTIC_PUSH_SUPPRESS_CAST();
+	sta = container_of(rcu, dhd_sta_t, rcu);
+	GCC_DIAGNOSTIC_POP();
+	dhdp = (dhd_pub_t *)sta->pub;
+
+	flags = osl_spin_lock(dhdp->sta_pool_lock);
+	id16_map_free(dhdp->staid_allocator,
+		(uint16)(sta - (dhd_sta_t *)dhdp->sta_pool));
+	osl_spin_unlock(dhdp->sta_pool_lock, flags);
+}
+#endif /* DHD_STA_RCU_HASH */
+
 /** Reset a dhd_sta object and free into the dhd pool. */
 static void
 dhd_sta_free(dhd_pub_t * dhdp, dhd_sta_t * sta)
@@ -1138,6 +1173,14 @@ dhd_sta_free(dhd_pub_t * dhdp, dhd_sta_t * sta)
 		sta->flowid[prio] = FLOWID_INVALID;
 	}
 
+#ifdef DHD_STA_RCU_HASH
+	if (sta->hashed) {
+		/* lockless readers may still hold it, reuse only after a grace period */
+		sta->hashed = FALSE;
+		sta->pub = dhdp;
+		call_rcu(&sta->rcu, dhd_sta_release_rcu);
+	} else
+#endif /* DHD_STA_RCU_HASH */
 	id16_map_free(dhdp->staid_allocator, sta->idx);
 	DHD_CUMM_CTR_INIT(&sta->cumm_ctr);
 	sta->ifp = DHD_IF_NULL; /* dummy dhd_if object */
@@ -1154,10 +1197,19 @@ dhd_sta_alloc(dhd_pub_t * dhdp)
 	uint16 idx;
 	dhd_sta_t * sta;
 	dhd_sta_pool_t * sta_pool;
+#ifdef DHD_STA_RCU_HASH
+	unsigned long flags;
+#endif /* DHD_STA_RCU_HASH */
 
 	ASSERT((dhdp->staid_allocator != NULL) && (dhdp->sta_pool != NULL));
 
+#ifdef DHD_STA_RCU_HASH
+	flags = osl_spin_lock(dhdp->sta_pool_lock);
 	idx = id16_map_alloc(dhdp->staid_allocator);
+	osl_spin_unlock(dhdp->sta_pool_lock, flags);
+#else
+	idx = id16_map_alloc(dhdp->staid_allocator);
+#endif /* DHD_STA_RCU_HASH */
 	if (idx == ID16_INVALID) {
 		DHD_ERROR(("%s: cannot get free staid\n", __FUNCTION__));
 		return DHD_STA_NULL;
@@ -1170,6 +1222,9 @@ dhd_sta_alloc(dhd_pub_t * dhdp)
 	       (sta->ifp == DHD_IF_NULL) && (sta->ifidx == DHD_BAD_IF));
 
 	DHD_CUMM_CTR_INIT(&sta->cumm_ctr);
+#ifdef DHD_STA_RCU_HASH
+	bzero(&sta->cnt, sizeof(sta->cnt));
+#endif /* DHD_STA_RCU_HASH */
 
 	sta->idx = idx; /* implying allocated */
 
@@ -1187,7 +1242,7 @@ dhd_if_del_sta_list(dhd_if_t *ifp)
 	GCC_DIAGNOSTIC_PUSH_SUPPRESS_CAST();
 	list_for_each_entry_safe(sta, next, &ifp->sta_list, list) {
 		GCC_DIAGNOSTIC_POP();
-		list_del(&sta->list);
+		dhd_sta_unlink(sta);
 		dhd_sta_free(&ifp->info->pub, sta);
 	}
 
@@ -1224,6 +1279,16 @@ dhd_sta_pool_init(dhd_pub_t *dhdp, int max_sta)
 		return BCME_ERROR;
 	}
 
+#ifdef DHD_STA_RCU_HASH
+	dhdp->sta_pool_lock = osl_spin_lock_init(dhdp->osh);
+	if (dhdp->sta_pool_lock == NULL) {
+		DHD_ERROR(("%s: sta pool lock init failure\n", __FUNCTION__));
+		MFREE(dhdp->osh, sta_pool, sta_pool_memsz);
+		id16_map_fini(dhdp->osh, staid_allocator);
+		return BCME_ERROR;
+	}
+#endif /* DHD_STA_RCU_HASH */
+
 	dhdp->sta_pool = sta_pool;
 	dhdp->staid_allocator = staid_allocator;
 
@@ -1255,6 +1320,11 @@ dhd_sta_pool_fini(dhd_pub_t *dhdp, int max_sta)
 {
 	dhd_sta_pool_t * sta_pool = (dhd_sta_pool_t *)dhdp->sta_pool;
 
+#ifdef DHD_STA_RCU_HASH
+	/* let deferred releases finish before the pool goes away */
+	rcu_barrier();
+#endif /* DHD_STA_RCU_HASH */
+
 	if (sta_pool) {
 		int idx;
 		int sta_pool_memsz = ((max_sta + 1) * sizeof(dhd_sta_t));
@@ -1267,6 +1337,12 @@ dhd_sta_pool_fini(dhd_pub_t *dhdp, int max_sta)
 
 	id16_map_fini(dhdp->osh, dhdp->staid_allocator);
 	dhdp->staid_allocator = NULL;
+#ifdef DHD_STA_RCU_HASH
+	if (dhdp->sta_pool_lock) {
+		osl_spin_lock_deinit(dhdp->osh, dhdp->sta_pool_lock);
+		dhdp->sta_pool_lock = NULL;
+	}
+#endif /* DHD_STA_RCU_HASH */
 }
 
 /* Clear the pool of dhd_sta_t objects for built-in type driver */
@@ -1296,6 +1372,11 @@ dhd_sta_pool_clear(dhd_pub_t *dhdp, int max_sta)
 		return;
 	}
 
+#ifdef DHD_STA_RCU_HASH
+	/* deferred releases would free ids of the cleared allocator */
+	rcu_barrier();
+#endif /* DHD_STA_RCU_HASH */
+
 	/* clear free pool */
 	sta_pool_memsz = ((max_sta + 1) * sizeof(dhd_sta_t));
 	bzero((uchar *)sta_pool, sta_pool_memsz);
@@ -1319,6 +1400,43 @@ dhd_sta_pool_clear(dhd_pub_t *dhdp, int max_sta)
 	}
 }
 
+#ifdef DHD_STA_RCU_HASH
+/**
+ * Find STA with MAC address ea in an interface's STA hash, lockless.
+ * Callers that dereference the result must hold rcu_read_lock() across the
+ * lookup and every use, the entry may be deleted and reused after that.
+ */
+dhd_sta_t *
+BCMFASTPATH(dhd_find_sta)(void *pub, int ifidx, void *ea)
+{
+	dhd_sta_t *sta;
+	dhd_if_t *ifp;
+	struct hlist_nulls_node *node;
+	uint32 hash;
+
+	ASSERT(ea != NULL);
+	ifp = dhd_get_ifp((dhd_pub_t *)pub, ifidx);
+	if (ifp == NULL)
+		return DHD_STA_NULL;
+
+	hash = DHD_STA_HASH(ea);
+
+	rcu_read_lock();
+begin:
+	hlist_nulls_for_each_entry_rcu(sta, node, &ifp->sta_hash[hash], hnode) {
+		if (sta->ifidx == ifidx && !memcmp(sta->ea.octet, ea, ETHER_ADDR_LEN)) {
+			rcu_read_unlock();
+			return sta;
+		}
+	}
+	/* an entry was freed and reused on another chain while we walked it */
+	if (get_nulls_value(node) != DHD_STA_HASH_NULLS(ifidx, hash))
+		goto begin;
+	rcu_read_unlock();
+
+	return DHD_STA_NULL;
+}
+#else
 /** Find STA with MAC address ea in an interface's STA list. */
 dhd_sta_t *
 dhd_find_sta(void *pub, int ifidx, void *ea)
@@ -1348,6 +1466,7 @@ dhd_find_sta(void *pub, int ifidx, void *ea)
 
 	return DHD_STA_NULL;
 }
+#endif /* DHD_STA_RCU_HASH */
 
 /** Add STA into the interface's STA list. */
 dhd_sta_t *
@@ -1383,6 +1502,11 @@ dhd_add_sta(void *pub, int ifidx, void *ea)
 	DHD_IF_STA_LIST_LOCK(&ifp->sta_list_lock, flags);
 
 	list_add_tail(&sta->list, &ifp->sta_list);
+#ifdef DHD_STA_RCU_HASH
+	/* ea and ifidx are published along with the link */
+	sta->hashed = TRUE;
+	hlist_nulls_add_head_rcu(&sta->hnode, &ifp->sta_hash[DHD_STA_HASH(ea)]);
+#endif /* DHD_STA_RCU_HASH */
 
 	DHD_ERROR(("%s: Adding  STA " MACDBG "\n",
 		__FUNCTION__, MAC2STRDBG((char *)ea)));
@@ -1408,7 +1532,7 @@ dhd_del_all_sta(void *pub, int ifidx)
 	GCC_DIAGNOSTIC_PUSH_SUPPRESS_CAST();
 	list_for_each_entry_safe(sta, next, &ifp->sta_list, list) {
 		GCC_DIAGNOSTIC_POP();
-		list_del(&sta->list);
+		dhd_sta_unlink(sta);
 		dhd_sta_free(&ifp->info->pub, sta);
 #ifdef DHD_L2_FILTER
 		if (ifp->parp_enable) {
@@ -1445,7 +1569,12 @@ dhd_del_sta(void *pub, int ifidx, void *ea)
 		if (!memcmp(sta->ea.octet, ea, ETHER_ADDR_LEN)) {
 			DHD_ERROR(("%s: Deleting STA " MACDBG "\n",
 				__FUNCTION__, MAC2STRDBG(sta->ea.octet)));
-			list_del(&sta->list);
+#ifdef DHD_STA_RCU_HASH
+			DHD_ERROR(("%s: tx %llu/%llu rx %llu/%llu pkts/bytes\n", __FUNCTION__,
+				sta->cnt.tx_pkts, sta->cnt.tx_bytes,
+				sta->cnt.rx_pkts, sta->cnt.rx_bytes));
+#endif /* DHD_STA_RCU_HASH */
+			dhd_sta_unlink(sta);
 			dhd_sta_free(&ifp->info->pub, sta);
 		}
 	}
@@ -1477,6 +1606,69 @@ dhd_findadd_sta(void *pub, int ifidx, void *ea)
 	return sta;
 }
 
+#ifdef DHD_STA_RCU_HASH
+/**
+ * Account a data packet to the associated STA with MAC address ea. *hint caches
+ * the STA of the flow (TX) or interface (RX) and is only searched for when it no
+ * longer matches.
+ */
+static void
+BCMFASTPATH(dhd_sta_account)(dhd_pub_t *dhdp, int ifidx, void *ea, uint32 len, bool tx,
+	struct dhd_sta **hint)
+{
+	dhd_sta_t *sta;
+
+	rcu_read_lock();
+	sta = READ_ONCE(*hint);
+	if ((sta == DHD_STA_NULL) || (sta->ifidx != ifidx) ||
+		memcmp(sta->ea.octet, ea, ETHER_ADDR_LEN)) {
+		sta = dhd_find_sta(dhdp, ifidx, ea);
+		WRITE_ONCE(*hint, sta);
+	}
+	if (sta == DHD_STA_NULL) {
+		rcu_read_unlock();
+		return;
+	}
+
+	if (tx) {
+		sta->cnt.tx_pkts++;
+		sta->cnt.tx_bytes += len;
+	} else {
+		sta->cnt.rx_pkts++;
+		sta->cnt.rx_bytes += len;
+	}
+	rcu_read_unlock();
+}
+
+void
+dhd_sta_stats_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
+{
+	dhd_info_t *dhd = (dhd_info_t *)dhdp->info;
+	dhd_sta_t *sta;
+	dhd_if_t *ifp;
+	unsigned long flags;
+	int i;
+
+	bcm_bprintf(strbuf, "\nSTA stats (tx pkts/bytes rx pkts/bytes):\n");
+	for (i = 0; i < DHD_MAX_IFS; i++) {
+		ifp = dhd->iflist[i];
+		if (ifp == NULL)
+			continue;
+
+		DHD_IF_STA_LIST_LOCK(&ifp->sta_list_lock, flags);
+		GCC_DIAGNOSTIC_PUSH_SUPPRESS_CAST();
+		list_for_each_entry(sta, &ifp->sta_list, list) {
+			GCC_DIAGNOSTIC_POP();
+			bcm_bprintf(strbuf, "%s " MACDBG " %llu/%llu %llu/%llu\n",
+				ifp->name, MAC2STRDBG(sta->ea.octet),
+				sta->cnt.tx_pkts, sta->cnt.tx_bytes,
+				sta->cnt.rx_pkts, sta->cnt.rx_bytes);
+		}
+		DHD_IF_STA_LIST_UNLOCK(&ifp->sta_list_lock, flags);
+	}
+}
+#endif /* DHD_STA_RCU_HASH */
+
 #if defined(DHD_IGMP_UCQUERY) || defined(DHD_UCAST_UPNP)
 static struct list_head *
 dhd_sta_list_snapshot(dhd_info_t *dhd, dhd_if_t *ifp, struct list_head *snapshot_list)
@@ -1566,6 +1758,168 @@ int dhd_bssidx2idx(dhd_pub_t *dhdp, uint32 bssidx)
 	return i;
 }
 
+#ifdef DHD_RXF_RING
+#define DHD_RXF_HIWAT	(MAXSKBPEND - (MAXSKBPEND / 4))	/* pause DPC rx reads */
+#define DHD_RXF_LOWAT	(MAXSKBPEND / 4)		/* resume the DPC */
+
+static inline int dhd_rxf_enqueue(dhd_pub_t *dhdp, void* skb)
+{
+	dhd_rxf_ring_t *ring = &dhdp->info->rxf_ring;
+	uint32 wr, occ;
+
+	/* wr & (MAXSKBPEND - 1) relies on it */
+	STATIC_ASSERT((MAXSKBPEND & (MAXSKBPEND - 1)) == 0);
+
+	if (!skb) {
+		DHD_ERROR(("dhd_rxf_enqueue: NULL skb!!!\n"));
+		return BCME_ERROR;
+	}
+
+	dhd_os_rxflock(dhdp);
+	wr = ring->wr;
+	occ = wr - smp_load_acquire(&ring->rd);
+	if (occ >= MAXSKBPEND) {
+		ring->full++;
+		dhd_os_rxfunlock(dhdp);
+		return BCME_NORESOURCE;
+	}
+	ring->buf[wr & (MAXSKBPEND - 1)] = skb;
+	/* the slot must be visible before the consumer sees the new wr */
+	smp_store_release(&ring->wr, wr + 1);
+	occ++;
+	ring->enq++;
+	ring->occ_max = MAX(ring->occ_max, occ);
+	ring->occ_hist[MIN(fls(occ) - 1, DHD_RXF_OCC_BINS - 1)]++;
+	dhd_os_rxfunlock(dhdp);
+
+	return BCME_OK;
+}
+
+/* Takes up to max chains off the ring, called from the RXF thread only */
+static inline uint dhd_rxf_dequeue(dhd_pub_t *dhdp, void **skbs, uint max)
+{
+	dhd_rxf_ring_t *ring = &dhdp->info->rxf_ring;
+	uint32 rd = ring->rd;
+	uint32 n, i;
+
+	n = MIN(smp_load_acquire(&ring->wr) - rd, max);
+	if (n == 0) {
+		return 0;
+	}
+	for (i = 0; i < n; i++) {
+		skbs[i] = ring->buf[(rd + i) & (MAXSKBPEND - 1)];
+	}
+	/* slots are handed back to the producers once rd moves past them */
+	smp_store_release(&ring->rd, rd + n);
+	ring->deq += n;
+	ring->batches++;
+	ring->batch_hist[MIN(fls(n) - 1, DHD_RXF_BATCH_BINS - 1)]++;
+
+	/* pairs with the barrier in dhd_rxf_throttled() */
+	smp_mb();
+	if (READ_ONCE(ring->throttled) &&
+		(READ_ONCE(ring->wr) - (rd + n)) < DHD_RXF_LOWAT &&
+		xchg(&ring->throttled, FALSE)) {
+		ring->kick++;
+		dhd_sched_dpc(dhdp);
+	}
+
+	return n;
+}
+
+static void dhd_rxf_sendup(dhd_pub_t *dhdp, void *skb)
+{
+	while (skb) {
+		void *skbnext = PKTNEXT(dhdp->osh, skb);
+		PKTSETNEXT(dhdp->osh, skb, NULL);
+		bcm_object_trace_opr(skb, BCM_OBJDBG_REMOVE,
+			__FUNCTION__, __LINE__);
+		netif_rx_ni(skb);
+		skb = skbnext;
+	}
+}
+
+static void dhd_rxf_drop(dhd_pub_t *dhdp, void *skb)
+{
+	dhd_rxf_ring_t *ring = &dhdp->info->rxf_ring;
+	uint32 cnt = 0;
+	void *p;
+
+	if (!skb) {
+		return;
+	}
+	for (p = skb; p; p = PKTNEXT(dhdp->osh, p)) {
+		cnt++;
+	}
+	dhd_os_rxflock(dhdp);
+	ring->full_pkts += cnt;
+	dhdp->rx_dropped += cnt;
+	dhd_os_rxfunlock(dhdp);
+	PKTFREE(dhdp->osh, skb, FALSE);
+}
+
+/*
+ * Called by the SDIO DPC before reading more frames. Above the high watermark
+ * the DPC stops reading and is rescheduled by the RXF thread once the ring
+ * drains below the low watermark.
+ */
+bool dhd_rxf_throttled(dhd_pub_t *dhdp)
+{
+	dhd_info_t *dhd = (dhd_info_t *)dhdp->info;
+	dhd_rxf_ring_t *ring;
+
+	if (!dhd || !dhd->rxthread_enabled) {
+		return FALSE;
+	}
+	ring = &dhd->rxf_ring;
+
+	if ((READ_ONCE(ring->wr) - READ_ONCE(ring->rd)) < DHD_RXF_HIWAT) {
+		if (READ_ONCE(ring->throttled)) {
+			WRITE_ONCE(ring->throttled, FALSE);
+		}
+		return FALSE;
+	}
+	if (!READ_ONCE(ring->throttled)) {
+		WRITE_ONCE(ring->throttled, TRUE);
+		ring->throttle++;
+		/* recheck in case the RXF thread drained before seeing the flag */
+		smp_mb();
+		if ((READ_ONCE(ring->wr) - READ_ONCE(ring->rd)) < DHD_RXF_HIWAT) {
+			WRITE_ONCE(ring->throttled, FALSE);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+void dhd_rxf_ring_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
+{
+	dhd_info_t *dhd = (dhd_info_t *)dhdp->info;
+	dhd_rxf_ring_t *ring;
+	int i;
+
+	if (!dhd || !dhd->rxthread_enabled) {
+		return;
+	}
+	ring = &dhd->rxf_ring;
+
+	bcm_bprintf(strbuf, "\nRXF ring: occ %u/%u max %u enq %u deq %u batches %u\n",
+		ring->wr - ring->rd, MAXSKBPEND, ring->occ_max, ring->enq, ring->deq,
+		ring->batches);
+	bcm_bprintf(strbuf, "RXF full %u (%u pkts) throttle %u kick %u throttled %u\n",
+		ring->full, ring->full_pkts, ring->throttle, ring->kick, ring->throttled);
+	bcm_bprintf(strbuf, "RXF occupancy:");
+	for (i = 0; i < DHD_RXF_OCC_BINS; i++) {
+		bcm_bprintf(strbuf, " %u:%u", 1 << i, ring->occ_hist[i]);
+	}
+	bcm_bprintf(strbuf, "\nRXF batch:");
+	for (i = 0; i < DHD_RXF_BATCH_BINS; i++) {
+		bcm_bprintf(strbuf, " %u:%u", 1 << i, ring->batch_hist[i]);
+	}
+	bcm_bprintf(strbuf, "\n");
+}
+#else
 static inline int dhd_rxf_enqueue(dhd_pub_t *dhdp, void* skb)
 {
 	uint32 store_idx;
@@ -1630,6 +1984,7 @@ static inline void* dhd_rxf_dequeue(dhd_pub_t *dhdp)
 
 	return skb;
 }
+#endif /* DHD_RXF_RING */
 
 int dhd_process_cid_mac(dhd_pub_t *dhdp, bool prepost)
 {
@@ -3260,11 +3615,16 @@ BCMFASTPATH(__dhd_sendpkt)(dhd_pub_t *dhdp, int ifidx, void *pktbuf)
 	/* Update multicast statistic */
 	if (PKTLEN(dhdp->osh, pktbuf) >= ETHER_HDR_LEN) {
 		uint8 *pktdata = (uint8 *)PKTDATA(dhdp->osh, pktbuf);
+		/* every path here is classified in dhd_start_xmit or dhd_sendpkt */
+		dhd_pktcls_t *cls = DHD_PKTCLS(pktbuf);
+
+		ASSERT(DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_VALID));
+
 		eh = (struct ether_header *)pktdata;
 
-		if (ETHER_ISMULTI(eh->ether_dhost))
+		if (DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_MCAST))
 			dhdp->tx_multicast++;
-		if (ntoh16(eh->ether_type) == ETHER_TYPE_802_1X) {
+		if (DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_EAPOL)) {
 #ifdef DHD_LOSSLESS_ROAMING
 			uint8 prio = (uint8)PKTPRIO(pktbuf);
 
@@ -3279,20 +3639,12 @@ BCMFASTPATH(__dhd_sendpkt)(dhd_pub_t *dhdp, int ifidx, void *pktbuf)
 				pktdata, PKTLEN(dhdp->osh, pktbuf), TRUE);
 #endif /* WL_CFG80211 && WL_WPS_SYNC */
 		}
-		if (ntoh16(eh->ether_type) == ETHER_TYPE_IP) {
-			if (dhd_check_dhcp(pktdata)) {
-				dhd_udr = TRUE;
-			} else if (dhd_check_dns(pktdata)) {
-				dhd_udr = TRUE;
-			}
-		}
-		if (ntoh16(eh->ether_type) == ETHER_TYPE_ARP) {
-			if (dhd_check_arp(pktdata)) {
-				dhd_udr = TRUE;
-			}
+		if (DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_DHCP | DHD_PKTCLS_F_DNS |
+			DHD_PKTCLS_F_ARP)) {
+			dhd_udr = TRUE;
 		}
 		dhd_dump_pkt(dhdp, ifidx, pktdata,
-			(uint32)PKTLEN(dhdp->osh, pktbuf), TRUE, NULL, NULL);
+			(uint32)PKTLEN(dhdp->osh, pktbuf), cls, TRUE, NULL, NULL);
 	} else {
 		PKTCFREE(dhdp->osh, pktbuf, TRUE);
 		return BCME_ERROR;
@@ -3368,6 +3720,18 @@ BCMFASTPATH(__dhd_sendpkt)(dhd_pub_t *dhdp, int ifidx, void *pktbuf)
 		PKTCFREE(dhd->pub.osh, pktbuf, TRUE);
 		return ret;
 	}
+
+#ifdef DHD_STA_RCU_HASH
+	if (DHD_IF_ROLE_MULTI_CLIENT(dhdp, ifidx) && ETHER_ISUCAST(eh->ether_dhost)) {
+		flow_ring_node_t *flow_ring_node;
+
+		flow_ring_node = dhd_flow_ring_node(dhdp, DHD_PKT_GET_FLOWID(pktbuf));
+		if (flow_ring_node) {
+			dhd_sta_account(dhdp, ifidx, eh->ether_dhost,
+				PKTLEN(dhdp->osh, pktbuf), TRUE, &flow_ring_node->sta);
+		}
+	}
+#endif /* DHD_STA_RCU_HASH */
 #endif /* PCIE_FULL_DONGLE */
 
 #ifdef PROP_TXSTATUS
@@ -3470,6 +3834,7 @@ BCMFASTPATH(dhd_sendpkt)(dhd_pub_t *dhdp, int ifidx, void *pktbuf)
 	}
 	DHD_GENERAL_UNLOCK(dhdp, flags);
 
+	dhd_pkt_classify_tag(dhdp, pktbuf);
 	ret = __dhd_sendpkt(dhdp, ifidx, pktbuf);
 
 #ifdef DHD_PCIE_RUNTIMEPM
@@ -3720,6 +4085,9 @@ BCMFASTPATH(dhd_start_xmit)(struct sk_buff *skb, struct net_device *net)
 	}
 #endif /* DHD_PSTA */
 
+	/* Classify once; tcpack, pktdump and the bus layer reuse the tag */
+	dhd_pkt_classify_tag(&dhd->pub, pktbuf);
+
 #ifdef DHDTCPSYNC_FLOOD_BLK
 	if (dhd_tcpdata_get_flag(&dhd->pub, pktbuf) == FLAG_SYNCACK) {
 		ifp->tsyncack_txed ++;
@@ -4452,12 +4820,10 @@ dhd_schedule_edl_work(dhd_pub_t *dhdp, uint delay_ms)
 
 #ifdef ENABLE_WAKEUP_PKT_DUMP
 static void
-update_wake_pkt_info(struct sk_buff *skb)
+update_wake_pkt_info(struct sk_buff *skb, const dhd_pktcls_t *cls)
 {
 	struct iphdr *ip_header;
 	struct ipv6hdr *ipv6_header;
-	struct udphdr *udp_header;
-	struct tcphdr *tcp_header;
 	uint16 dport = 0;
 
 	ip_header = (struct iphdr *)(skb->data);
@@ -4508,14 +4874,9 @@ update_wake_pkt_info(struct sk_buff *skb)
 		} else if (ip_header->version == 4) {
 			temp_raw |= ((long long)ip_header->protocol) << 40;
 
-#define IP_HDR_OFFSET	((char *)ip_header + IPV4_HLEN(ip_header))
-			if (ip_header->protocol == IPPROTO_TCP) {
-				tcp_header = (struct tcphdr *)IP_HDR_OFFSET;
-				dport = ntohs(tcp_header->dest);
-			}
-			else if (ip_header->protocol == IPPROTO_UDP) {
-				udp_header = (struct udphdr *)IP_HDR_OFFSET;
-				dport = ntohs(udp_header->dest);
+			/* TCP/UDP port was parsed by the classifier in dhd_rx_frame */
+			if (DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_TCP | DHD_PKTCLS_F_UDP)) {
+				dport = cls->dport;
 			}
 
 			if (ipv4_is_multicast(ip_header->daddr)) {
@@ -4550,7 +4911,7 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 	int tout_ctrl = 0;
 	void *skbhead = NULL;
 	void *skbprev = NULL;
-	uint16 protocol;
+	dhd_pktcls_t rxcls;
 	unsigned char *dump_data;
 #ifdef DHD_MCAST_REGEN
 	uint8 interface_role;
@@ -4629,6 +4990,10 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 #endif /* DHD_WAKE_STATUS */
 
 		eh = (struct ether_header *)PKTDATA(dhdp->osh, pktbuf);
+		/* Classify once; the tag copy is used by tcpack, the local copy
+		 * survives PKTTONATIVE clearing the tag.
+		 */
+		rxcls = *dhd_pkt_classify_tag(dhdp, pktbuf);
 		if (dhd->pub.tput_data.tput_test_running &&
 			dhd->pub.tput_data.direction == TPUT_DIR_RX &&
 			ntoh16(eh->ether_type) == ETHER_TYPE_IP) {
@@ -4806,6 +5171,13 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 #endif /* DHD_PSTA */
 
 #ifdef PCIE_FULL_DONGLE
+#ifdef DHD_STA_RCU_HASH
+		if (DHD_IF_ROLE_MULTI_CLIENT(dhdp, ifidx)) {
+			eh = (struct ether_header *)PKTDATA(dhdp->osh, pktbuf);
+			dhd_sta_account(dhdp, ifidx, eh->ether_shost,
+				PKTLEN(dhdp->osh, pktbuf), FALSE, &ifp->rx_sta);
+		}
+#endif /* DHD_STA_RCU_HASH */
 		if ((DHD_IF_ROLE_AP(dhdp, ifidx) || DHD_IF_ROLE_P2PGO(dhdp, ifidx)) &&
 			(!ifp->ap_isolate)) {
 			eh = (struct ether_header *)PKTDATA(dhdp->osh, pktbuf);
@@ -4845,9 +5217,8 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 		eth = skb->data;
 		len = skb->len;
 		dump_data = skb->data;
-		protocol = (skb->data[12] << 8) | skb->data[13];
 
-		if (protocol == ETHER_TYPE_802_1X) {
+		if (DHD_PKTCLS_IS(&rxcls, DHD_PKTCLS_F_EAPOL)) {
 			DBG_EVENT_LOG(dhdp, WIFI_EVENT_DRIVER_EAPOL_FRAME_RECEIVED);
 #if defined(WL_CFG80211) && defined(WL_WPS_SYNC)
 			wl_handle_wps_states(ifp->net, dump_data, len, FALSE);
@@ -4859,7 +5230,7 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 #endif /* DHD_4WAYM4_FAIL_DISCONNECT */
 		}
 		dhd_rx_pkt_dump(dhdp, ifidx, dump_data, len);
-		dhd_dump_pkt(dhdp, ifidx, dump_data, len, FALSE, NULL, NULL);
+		dhd_dump_pkt(dhdp, ifidx, dump_data, len, &rxcls, FALSE, NULL, NULL);
 
 #if defined(DHD_WAKE_STATUS) && defined(DHD_WAKEPKT_DUMP)
 		if (pkt_wake) {
@@ -4895,7 +5266,7 @@ dhd_rx_frame(dhd_pub_t *dhdp, int ifidx, void *pktbuf, int numpkt, uint8 chan)
 			if (DHD_INFO_ON()) {
 				prhex("wake_pkt", (char*) eth, MIN(len, 48));
 			}
-			update_wake_pkt_info(skb);
+			update_wake_pkt_info(skb, &rxcls);
 #ifdef CONFIG_IRQ_HISTORY
 			add_irq_history(0, "WIFI");
 #endif
@@ -5617,7 +5988,12 @@ dhd_rxf_thread(void *data)
 	/* Run until signal received */
 	while (1) {
 		if (down_interruptible(&tsk->sema) == 0) {
+#ifdef DHD_RXF_RING
+			void *skbs[DHD_RXF_BATCH];
+			uint i, n;
+#else
 			void *skb;
+#endif /* DHD_RXF_RING */
 #ifdef ENABLE_ADAPTIVE_SCHED
 			dhd_sched_policy(dhd_rxf_prio);
 #endif /* ENABLE_ADAPTIVE_SCHED */
@@ -5628,6 +6004,14 @@ dhd_rxf_thread(void *data)
 				DHD_OS_WAKE_UNLOCK(pub);
 				break;
 			}
+#ifdef DHD_RXF_RING
+			/* one wakeup may find chains from several enqueues, or none */
+			while ((n = dhd_rxf_dequeue(pub, skbs, DHD_RXF_BATCH)) != 0) {
+				for (i = 0; i < n; i++) {
+					dhd_rxf_sendup(pub, skbs[i]);
+				}
+			}
+#else
 			skb = dhd_rxf_dequeue(pub);
 
 			if (skb == NULL) {
@@ -5641,6 +6025,7 @@ dhd_rxf_thread(void *data)
 				netif_rx_ni(skb);
 				skb = skbnext;
 			}
+#endif /* DHD_RXF_RING */
 #if defined(WAIT_DEQUEUE)
 			if (OSL_SYSUPTIME() - watchdogTime > RXF_WATCHDOG_TIME) {
 				OSL_SLEEP(1);
@@ -5792,10 +6177,20 @@ dhd_sched_rxf(dhd_pub_t *dhdp, void *skb)
 	DHD_OS_WAKE_LOCK(dhdp);
 
 	DHD_TRACE(("dhd_sched_rxf: Enter\n"));
+#ifdef DHD_RXF_RING
+	if (dhd_rxf_enqueue(dhdp, skb) != BCME_OK) {
+		/*
+		 * Ring full: drop the chain rather than spin waiting for the RXF
+		 * thread. Delivering it here would overtake the queued chains.
+		 */
+		dhd_rxf_drop(dhdp, skb);
+	}
+#else
 	do {
 		if (dhd_rxf_enqueue(dhdp, skb) == BCME_OK)
 			break;
 	} while (1);
+#endif /* DHD_RXF_RING */
 	if (dhd->thr_rxf_ctl.thr_pid >= 0) {
 		up(&dhd->thr_rxf_ctl.sema);
 	} else {
@@ -8195,6 +8590,16 @@ dhd_allocate_if(dhd_pub_t *dhdpub, int ifidx, const char *name,
 	/* Initialize STA info list */
 	INIT_LIST_HEAD(&ifp->sta_list);
 	DHD_IF_STA_LIST_LOCK_INIT(&ifp->sta_list_lock);
+#ifdef DHD_STA_RCU_HASH
+	{
+		uint32 hash;
+
+		for (hash = 0; hash < DHD_STA_HASH_SIZE; hash++) {
+			INIT_HLIST_NULLS_HEAD(&ifp->sta_hash[hash],
+				DHD_STA_HASH_NULLS(ifidx, hash));
+		}
+	}
+#endif /* DHD_STA_RCU_HASH */
 #endif /* PCIE_FULL_DONGLE */
 
 #ifdef DHD_L2_FILTER
@@ -8469,7 +8874,12 @@ dhd_init_logstrs_array(osl_t *osh, dhd_event_log_t *temp)
 	int logstrs_size = 0;
 	int error = 0;
 
-	if (control_logtrace != LOGTRACE_PARSED_FMT) {
+	if (control_logtrace != LOGTRACE_PARSED_FMT
+#ifdef DHD_EVENTLOG_PASSTHROUGH
+		/* text sets are still formatted in passthrough mode */
+		&& control_logtrace != LOGTRACE_BIN_FMT
+#endif /* DHD_EVENTLOG_PASSTHROUGH */
+		) {
 		DHD_ERROR_NO_HW4(("%s : turned off logstr parsing\n", __FUNCTION__));
 		return BCME_ERROR;
 	}
@@ -9313,7 +9723,11 @@ dhd_attach(osl_t *osh, struct dhd_bus *bus, uint bus_hdrlen)
 	}
 
 	if (dhd->rxthread_enabled) {
+#ifdef DHD_RXF_RING
+		bzero(&dhd->rxf_ring, sizeof(dhd->rxf_ring));
+#else
 		bzero(&dhd->pub.skbbuf[0], sizeof(void *) * MAXSKBPEND);
+#endif /* DHD_RXF_RING */
 		/* Initialize RXF thread */
 		PROC_START(dhd_rxf_thread, dhd, &dhd->thr_rxf_ctl, 0, "dhd_rxf");
 		if (dhd->thr_rxf_ctl.thr_pid < 0) {
@@ -14137,7 +14551,11 @@ dhd_free(dhd_pub_t *dhdp)
 				DHD_REORDER(("free flow id buf %d, maxidx is %d, buf_size %d\n",
 					i, ptr->max_idx, buf_size));
 
+#ifdef DHD_HOSTREORDER_TIMER
+				hrtimer_cancel(&ptr->timer);
+#endif /* DHD_HOSTREORDER_TIMER */
 				MFREE(dhdp->osh, dhdp->reorder_bufs[i], buf_size);
+				dhdp->reorder_bufs[i] = NULL;
 			}
 		}
 
@@ -14184,7 +14602,11 @@ dhd_clear(dhd_pub_t *dhdp)
 				DHD_REORDER(("free flow id buf %d, maxidx is %d, buf_size %d\n",
 					i, ptr->max_idx, buf_size));
 
+#ifdef DHD_HOSTREORDER_TIMER
+				hrtimer_cancel(&ptr->timer);
+#endif /* DHD_HOSTREORDER_TIMER */
 				MFREE(dhdp->osh, dhdp->reorder_bufs[i], buf_size);
+				dhdp->reorder_bufs[i] = NULL;
 			}
 		}
 
@@ -14271,6 +14693,29 @@ dhd_module_init(void)
 {
 	int err;
 
+#ifdef WF_CHSPEC_TBL
+	/* before any scan/roam path can look at chanspecs */
+	if (wf_chspec_tbl_init() != BCME_OK) {
+		DHD_ERROR(("%s: chanspec tables unavailable, using arithmetic helpers\n",
+			__FUNCTION__));
+	}
+#ifdef WF_CHSPEC_TBL_CHECK
+	{
+		uint32 first_bad = 0;
+		uint nbad = wf_chspec_tbl_check(&first_bad);
+
+		if (nbad) {
+			DHD_ERROR(("%s: chanspec tables disagree with the arithmetic helpers "
+				"in %u cases, first 0x%04x, tables disabled\n",
+				__FUNCTION__, nbad, first_bad));
+			ASSERT(0);
+		} else {
+			DHD_INFO(("%s: chanspec tables checked\n", __FUNCTION__));
+		}
+	}
+#endif /* WF_CHSPEC_TBL_CHECK */
+#endif /* WF_CHSPEC_TBL */
+
 	err = _dhd_module_init();
 #ifdef DHD_SUPPORT_HDM
 	if (err && !dhd_download_fw_on_driverload) {
@@ -22894,6 +23339,50 @@ dhd_schedule_reset(dhd_pub_t *dhdp)
 }
 #endif /* DHD_ERPOM */
 
+#ifdef DHD_HOSTREORDER_TIMER
+static void
+dhd_reorder_expire_handler(void *handle, void *event_info, u8 event)
+{
+	dhd_info_t *dhd = handle;
+
+	if (event != DHD_WQ_WORK_REORDER_EXPIRE) {
+		DHD_ERROR(("%s: unexpected event %d\n", __FUNCTION__, event));
+		return;
+	}
+
+	if (!dhd) {
+		DHD_ERROR(("%s: dhd is NULL\n", __FUNCTION__));
+		return;
+	}
+
+	dhd_prot_reorder_expire(&dhd->pub);
+}
+
+/* Called from the reorder hrtimer, the flush itself needs process context */
+void
+dhd_schedule_reorder_expire(dhd_pub_t *dhdp)
+{
+	/* A hold may still time out while the driver is detaching */
+	if (!dhdp->info->dhd_deferred_wq)
+		return;
+
+	dhd_deferred_schedule_work(dhdp->info->dhd_deferred_wq, NULL,
+		DHD_WQ_WORK_REORDER_EXPIRE, dhd_reorder_expire_handler,
+		DHD_WQ_WORK_PRIORITY_HIGH);
+}
+#endif /* DHD_HOSTREORDER_TIMER */
+
+#ifdef DHD_WQ_DISPATCH
+void
+dhd_deferred_wq_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
+{
+	if (!dhdp->info || !dhdp->info->dhd_deferred_wq)
+		return;
+
+	dhd_deferred_work_dump(dhdp->info->dhd_deferred_wq, strbuf);
+}
+#endif /* DHD_WQ_DISPATCH */
+
 #ifdef DHD_PKT_LOGGING
 int
 dhd_pktlog_debug_dump(dhd_pub_t *dhdp)
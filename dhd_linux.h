@@ -50,6 +50,9 @@
 #ifdef PCIE_FULL_DONGLE
 #include <etd.h>
 #endif /* PCIE_FULL_DONGLE */
+#ifdef DHD_STA_RCU_HASH
+#include <linux/list_nulls.h>
+#endif /* DHD_STA_RCU_HASH */
 
 #ifdef WL_MONITOR
 #define MAX_RADIOTAP_SIZE      256 /* Maximum size to hold HE Radiotap header format */
@@ -99,6 +102,29 @@ typedef struct bcmdhd_wifi_platdata {
 	wifi_adapter_info_t	*adapters;
 } bcmdhd_wifi_platdata_t;
 
+#ifdef DHD_STA_RCU_HASH
+/*
+ * Per interface STA hash. dhd_sta objects come from a static pool and go back
+ * to it only after a grace period, so a dhd_sta found under rcu_read_lock()
+ * keeps its identity until rcu_read_unlock(). Each chain is terminated by a
+ * nulls marker unique to (ifidx, bucket) and readers restart a lookup that
+ * ended on a foreign chain.
+ */
+#define DHD_STA_HASH_SIZE	32u	/* power of 2 */
+#define DHD_STA_HASH(ea) \
+	((((const uint8 *)(ea))[3] ^ ((const uint8 *)(ea))[4] ^ \
+	((const uint8 *)(ea))[5]) & (DHD_STA_HASH_SIZE - 1u))
+#define DHD_STA_HASH_NULLS(ifidx, hash)	(((uint32)(ifidx) * DHD_STA_HASH_SIZE) + (hash))
+
+/* Per STA data path counters, best effort like the netdev stats */
+typedef struct dhd_sta_cnt {
+	uint64 tx_pkts;
+	uint64 tx_bytes;
+	uint64 rx_pkts;
+	uint64 rx_bytes;
+} dhd_sta_cnt_t;
+#endif /* DHD_STA_RCU_HASH */
+
 /** Per STA params. A list of dhd_sta objects are managed in dhd_if */
 typedef struct dhd_sta {
 	cumm_ctr_t cumm_ctr;    /* cummulative queue length of child flowrings */
@@ -108,6 +134,13 @@ typedef struct dhd_sta {
 	struct list_head list;  /* link into dhd_if::sta_list */
 	int idx;                /* index of self in dhd_pub::sta_pool[] */
 	int ifidx;              /* index of interface in dhd */
+#ifdef DHD_STA_RCU_HASH
+	struct hlist_nulls_node hnode;	/* link into dhd_if::sta_hash */
+	bool hashed;			/* idx goes back to the pool after a grace period */
+	struct rcu_head rcu;
+	void *pub;			/* dhd_pub of the pool, for the deferred release */
+	dhd_sta_cnt_t cnt;
+#endif /* DHD_STA_RCU_HASH */
 } dhd_sta_t;
 typedef dhd_sta_t dhd_sta_pool_t;
 
@@ -299,6 +332,11 @@ typedef struct dhd_if {
 #ifdef PCIE_FULL_DONGLE
 	struct list_head sta_list;		/* sll of associated stations */
 	spinlock_t	sta_list_lock;		/* lock for manipulating sll */
+#ifdef DHD_STA_RCU_HASH
+	/* RCU readers, writers hold sta_list_lock */
+	struct hlist_nulls_head sta_hash[DHD_STA_HASH_SIZE];
+	struct dhd_sta *rx_sta;			/* last RX accounted STA, revalidated */
+#endif /* DHD_STA_RCU_HASH */
 #endif /* PCIE_FULL_DONGLE */
 	uint32  ap_isolate;			/* ap-isolation settings */
 #ifdef DHD_L2_FILTER
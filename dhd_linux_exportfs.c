@@ -26,6 +26,10 @@
 #include <linux/kobject.h>
 #include <linux/proc_fs.h>
 #include <linux/sysfs.h>
+#ifdef DHD_DBG_RING_MMAP
+#include <linux/mm.h>
+#include <linux/poll.h>
+#endif /* DHD_DBG_RING_MMAP */
 #include <osl.h>
 #include <dhd.h>
 #include <dhd_dbg.h>
@@ -33,6 +37,9 @@
 #if defined(DHD_ADPS_BAM_EXPORT) && defined(WL_BAM)
 #include <wl_bam.h>
 #endif	/* DHD_ADPS_BAM_EXPORT && WL_BAM */
+#if defined(BCMPCIE) && defined(DHD_DPC_SCHED)
+#include <dhd_bus.h>
+#endif /* BCMPCIE && DHD_DPC_SCHED */
 #ifdef PWRSTATS_SYSFS
 #include <wldev_common.h>
 #endif
@@ -41,17 +48,34 @@
 extern dhd_pub_t* g_dhd_pub;
 static int dhd_ring_proc_open(struct inode *inode, struct file *file);
 ssize_t dhd_ring_proc_read(struct file *file, char *buffer, size_t tt, loff_t *loff);
+#ifdef DHD_DBG_RING_MMAP
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4, 16, 0))
+typedef __poll_t dhd_poll_t;
+#else
+typedef unsigned int dhd_poll_t;
+#endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(4, 16, 0) */
+static int dhd_ring_proc_mmap(struct file *file, struct vm_area_struct *vma);
+static dhd_poll_t dhd_ring_proc_poll(struct file *file, poll_table *wait);
+#endif /* DHD_DBG_RING_MMAP */
 
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(5, 6, 0))
 static const struct file_operations dhd_ring_proc_ops = {
 	.open = dhd_ring_proc_open,
 	.read = dhd_ring_proc_read,
+#ifdef DHD_DBG_RING_MMAP
+	.mmap = dhd_ring_proc_mmap,
+	.poll = dhd_ring_proc_poll,
+#endif /* DHD_DBG_RING_MMAP */
 	.release = single_release,
 };
 #else
 static const struct proc_ops dhd_ring_proc_ops = {
 	.proc_open = dhd_ring_proc_open,
 	.proc_read = dhd_ring_proc_read,
+#ifdef DHD_DBG_RING_MMAP
+	.proc_mmap = dhd_ring_proc_mmap,
+	.proc_poll = dhd_ring_proc_poll,
+#endif /* DHD_DBG_RING_MMAP */
 	.proc_release = single_release,
 };
 #endif
@@ -109,6 +133,111 @@ exit:
 	return ret;
 }
 
+#ifdef DHD_DBG_RING_MMAP
+/*
+ * vm_private_data holds the ring's map, not the ring: the ring is freed with
+ * dhd_dbg_t on detach while the mapping may live on until munmap.
+ */
+static void
+dhd_ring_vma_open(struct vm_area_struct *vma)
+{
+	dhd_dbg_ring_map_t *map = (dhd_dbg_ring_map_t *)vma->vm_private_data;
+
+	/* fork or split of an existing mapping */
+	kref_get(&map->ref);
+	atomic_inc(&map->mmap_cnt);
+}
+
+static void
+dhd_ring_vma_close(struct vm_area_struct *vma)
+{
+	dhd_dbg_ring_map_t *map = (dhd_dbg_ring_map_t *)vma->vm_private_data;
+
+	atomic_dec(&map->mmap_cnt);
+	dhd_dbg_ring_map_put(map);
+}
+
+static const struct vm_operations_struct dhd_ring_vm_ops = {
+	.open = dhd_ring_vma_open,
+	.close = dhd_ring_vma_close,
+};
+
+/* Map the ring header and data read-only; only rings set up by
+ * dhd_dbg_ring_init_mmap() can be mapped.
+ */
+static int
+dhd_ring_proc_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	dhd_dbg_ring_t *ring = (dhd_dbg_ring_t *)((struct seq_file *)(file->private_data))->private;
+	unsigned long len = vma->vm_end - vma->vm_start;
+	dhd_dbg_ring_map_t *map;
+	int ret;
+
+	if (ring == NULL || ring->shm == NULL) {
+		return -ENODEV;
+	}
+
+	if (vma->vm_pgoff != 0 || len > ring->map->len) {
+		return -EINVAL;
+	}
+
+	if (vma->vm_flags & VM_WRITE) {
+		return -EPERM;
+	}
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0))
+	vm_flags_clear(vma, VM_MAYWRITE);
+#else
+	vma->vm_flags &= ~VM_MAYWRITE;
+#endif /* LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0) */
+
+	map = dhd_dbg_ring_map_get(ring);
+	if (map == NULL) {
+		return -ENODEV;
+	}
+
+	ret = remap_vmalloc_range(vma, map->area, 0);
+	if (ret) {
+		DHD_ERROR(("%s: RING%d remap failed %d\n", __FUNCTION__, ring->id, ret));
+		dhd_dbg_ring_map_put(map);
+		return ret;
+	}
+
+	/* the reference taken above is the one dropped by dhd_ring_vma_close() */
+	vma->vm_private_data = map;
+	vma->vm_ops = &dhd_ring_vm_ops;
+	atomic_inc(&map->mmap_cnt);
+
+	return 0;
+}
+
+/*
+ * Readable once per wakeup raised by dhd_dbg_ring_sched_pull(). The last
+ * generation seen by this file is kept in the seq_file index, which
+ * single_open() files do not otherwise use.
+ */
+static dhd_poll_t
+dhd_ring_proc_poll(struct file *file, poll_table *wait)
+{
+	struct seq_file *m = (struct seq_file *)file->private_data;
+	dhd_dbg_ring_t *ring = (dhd_dbg_ring_t *)m->private;
+	uint32 gen;
+
+	if (ring == NULL || ring->shm == NULL) {
+		return POLLERR;
+	}
+
+	poll_wait(file, &ring->wq, wait);
+
+	gen = dhd_dbg_ring_get_wake_gen(ring);
+	if (gen != (uint32)m->index) {
+		m->index = gen;
+		return POLLIN | POLLRDNORM;
+	}
+
+	return 0;
+}
+#endif /* DHD_DBG_RING_MMAP */
+
 void
 dhd_dbg_ring_proc_create(dhd_pub_t *dhdp)
 {
@@ -1431,6 +1560,40 @@ set_control_logtrace(struct dhd_info *dev, const char *buf, size_t count)
 
 static struct dhd_attr dhd_attr_control_logtrace =
 __ATTR(control_logtrace, 0660, show_control_logtrace, set_control_logtrace);
+
+#ifdef DHD_EVENTLOG_PASSTHROUGH
+static ssize_t
+show_logtrace_text_sets(struct dhd_info *dev, char *buf)
+{
+	ssize_t ret = 0;
+
+	if (!dev) {
+		DHD_ERROR(("%s: dhd is NULL\n", __FUNCTION__));
+		return ret;
+	}
+
+	ret = scnprintf(buf, PAGE_SIZE - 1, "0x%x\n", dev->pub.logset_text_mask);
+	return ret;
+}
+
+static ssize_t
+set_logtrace_text_sets(struct dhd_info *dev, const char *buf, size_t count)
+{
+	if (!dev) {
+		DHD_ERROR(("%s: dhd is NULL\n", __FUNCTION__));
+		return count;
+	}
+
+	/* bit n set keeps event log set n in text form with control_logtrace 3 */
+	dev->pub.logset_text_mask = (uint32)bcm_strtoul(buf, NULL, 0);
+	DHD_ERROR(("%s: Set logtrace text sets: 0x%x\n", __FUNCTION__,
+		dev->pub.logset_text_mask));
+	return count;
+}
+
+static struct dhd_attr dhd_attr_logtrace_text_sets =
+__ATTR(logtrace_text_sets, 0660, show_logtrace_text_sets, set_logtrace_text_sets);
+#endif /* DHD_EVENTLOG_PASSTHROUGH */
 #endif /* SHOW_LOGTRACE */
 
 #if defined(DISABLE_HE_ENAB) || defined(CUSTOM_CONTROL_HE_ENAB)
@@ -1498,6 +1661,119 @@ static struct dhd_attr dhd_attr_wl_accel_force_reg_on=
 __ATTR(wl_accel_force_reg_on, 0660, show_wl_accel_force_reg_on, set_wl_accel_force_reg_on);
 #endif /* WLAN_ACCEL_BOOT */
 
+#if defined(BCMPCIE) && defined(DHD_DPC_SCHED)
+#define DPC_SCHED_MAX_BOUND	2048
+#define DPC_SCHED_MAX_BUDGET_US	100000
+
+static ssize_t
+set_dpc_tunable(uint *tunable, uint min, uint max, const char *buf, size_t count)
+{
+	uint32 val;
+
+	if (sscanf(buf, "%u", &val) != 1 || val < min || val > max) {
+		DHD_ERROR(("%s: invalid value, range %u..%u\n", __FUNCTION__, min, max));
+		return -EINVAL;
+	}
+
+	*tunable = val;
+	return count;
+}
+
+static ssize_t
+show_dpc_budget_us(struct dhd_info *dev, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE - 1, "%u\n", dhd_dpc_budget_us);
+}
+
+static ssize_t
+set_dpc_budget_us(struct dhd_info *dev, const char *buf, size_t count)
+{
+	return set_dpc_tunable(&dhd_dpc_budget_us, 0, DPC_SCHED_MAX_BUDGET_US, buf, count);
+}
+
+static struct dhd_attr dhd_attr_dpc_budget_us =
+	__ATTR(dpc_budget_us, 0660, show_dpc_budget_us, set_dpc_budget_us);
+
+static ssize_t
+show_dpc_txbound(struct dhd_info *dev, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE - 1, "%u\n", dhd_txbound);
+}
+
+static ssize_t
+set_dpc_txbound(struct dhd_info *dev, const char *buf, size_t count)
+{
+	return set_dpc_tunable(&dhd_txbound, 1, DPC_SCHED_MAX_BOUND, buf, count);
+}
+
+static struct dhd_attr dhd_attr_dpc_txbound =
+	__ATTR(dpc_txbound, 0660, show_dpc_txbound, set_dpc_txbound);
+
+static ssize_t
+show_dpc_rxbound(struct dhd_info *dev, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE - 1, "%u\n", dhd_rxbound);
+}
+
+static ssize_t
+set_dpc_rxbound(struct dhd_info *dev, const char *buf, size_t count)
+{
+	return set_dpc_tunable(&dhd_rxbound, 1, DPC_SCHED_MAX_BOUND, buf, count);
+}
+
+static struct dhd_attr dhd_attr_dpc_rxbound =
+	__ATTR(dpc_rxbound, 0660, show_dpc_rxbound, set_dpc_rxbound);
+
+static ssize_t
+show_dpc_infobound(struct dhd_info *dev, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE - 1, "%u\n", dhd_infobound);
+}
+
+static ssize_t
+set_dpc_infobound(struct dhd_info *dev, const char *buf, size_t count)
+{
+	return set_dpc_tunable(&dhd_infobound, 1, DPC_SCHED_MAX_BOUND, buf, count);
+}
+
+static struct dhd_attr dhd_attr_dpc_infobound =
+	__ATTR(dpc_infobound, 0660, show_dpc_infobound, set_dpc_infobound);
+
+/* Read for the per ring DPC statistics, write 0 to clear them */
+static ssize_t
+show_dpc_sched(struct dhd_info *dev, char *buf)
+{
+	struct bcmstrbuf b;
+
+	if (dev->pub.bus == NULL) {
+		return -ENODEV;
+	}
+
+	bcm_binit(&b, buf, PAGE_SIZE);
+	dhd_bus_dpc_sched_dump(&dev->pub, &b);
+	return b.origsize - b.size;
+}
+
+static ssize_t
+set_dpc_sched(struct dhd_info *dev, const char *buf, size_t count)
+{
+	uint32 val;
+
+	if (sscanf(buf, "%u", &val) != 1 || val != 0) {
+		return -EINVAL;
+	}
+	if (dev->pub.bus == NULL) {
+		return -ENODEV;
+	}
+
+	dhd_bus_clearcounts(&dev->pub);
+	return count;
+}
+
+static struct dhd_attr dhd_attr_dpc_sched =
+	__ATTR(dpc_sched, 0660, show_dpc_sched, set_dpc_sched);
+#endif /* BCMPCIE && DHD_DPC_SCHED */
+
 /* Attribute object that gets registered with "wifi" kobject tree */
 static struct attribute *default_file_attrs[] = {
 #ifdef DHD_MAC_ADDR_EXPORT
@@ -1552,6 +1828,9 @@ static struct attribute *default_file_attrs[] = {
 #endif /* DHD_SEND_HANG_PRIVCMD_ERRORS */
 #if defined(SHOW_LOGTRACE)
 	&dhd_attr_control_logtrace.attr,
+#ifdef DHD_EVENTLOG_PASSTHROUGH
+	&dhd_attr_logtrace_text_sets.attr,
+#endif /* DHD_EVENTLOG_PASSTHROUGH */
 #endif /* SHOW_LOGTRACE */
 #if defined(DHD_TRACE_WAKE_LOCK)
 	&dhd_attr_wklock.attr,
@@ -1576,6 +1855,13 @@ static struct attribute *default_file_attrs[] = {
 #ifdef PWRSTATS_SYSFS
 	&dhd_attr_pwrstats_path.attr,
 #endif
+#if defined(BCMPCIE) && defined(DHD_DPC_SCHED)
+	&dhd_attr_dpc_budget_us.attr,
+	&dhd_attr_dpc_txbound.attr,
+	&dhd_attr_dpc_rxbound.attr,
+	&dhd_attr_dpc_infobound.attr,
+	&dhd_attr_dpc_sched.attr,
+#endif /* BCMPCIE && DHD_DPC_SCHED */
 	NULL
 };
 
@@ -37,6 +37,7 @@
 #include <bcmdhcp.h>
 #include <bcmarp.h>
 #include <bcmicmp.h>
+#include <bcmtcp.h>
 #include <dhd_linux_pktdump.h>
 
 #define DHD_PKTDUMP(arg)	DHD_ERROR(arg)
@@ -346,12 +347,132 @@ dhd_is_4way_msg(uint8 *pktdata)
 	return type;
 }
 
+/*
+ * Parse the L2-L4 headers once and record what the packet is. Every header
+ * access is bounded by pktlen.
+ */
+void
+BCMFASTPATH(dhd_pkt_classify)(uint8 *pktdata, uint32 pktlen, dhd_pktcls_t *cls)
+{
+	struct ether_header *eh = (struct ether_header *)pktdata;
+	uint8 *iph;
+	uint8 *l4h;
+	uint32 iphlen;
+	uint16 sport = 0;
+
+	bzero(cls, sizeof(*cls));
+	cls->flags = DHD_PKTCLS_F_VALID;
+
+	if (!pktdata || pktlen < ETHER_HDR_LEN) {
+		return;
+	}
+
+	cls->ether_type = ntoh16(eh->ether_type);
+	if (ETHER_ISMULTI(eh->ether_dhost)) {
+		cls->flags |= DHD_PKTCLS_F_MCAST;
+	}
+
+	iph = pktdata + ETHER_HDR_LEN;
+	switch (cls->ether_type) {
+	case ETHER_TYPE_802_1X:
+		cls->flags |= DHD_PKTCLS_F_EAPOL;
+		return;
+	case ETHER_TYPE_ARP:
+		if (pktlen >= (ETHER_HDR_LEN + ARP_DATA_LEN) &&
+			((struct bcmarp *)iph)->htype == hton16(HTYPE_ETHERNET) &&
+			((struct bcmarp *)iph)->hlen == ETHER_ADDR_LEN &&
+			((struct bcmarp *)iph)->plen == IPV4_ADDR_LEN) {
+			cls->flags |= DHD_PKTCLS_F_ARP;
+		}
+		return;
+	case ETHER_TYPE_IP:
+		if (pktlen < (ETHER_HDR_LEN + IPV4_MIN_HEADER_LEN) ||
+			IP_VER(iph) != IP_VER_4 || IPV4_HLEN(iph) < IPV4_HLEN_MIN) {
+			return;
+		}
+		cls->flags |= DHD_PKTCLS_F_IPV4;
+		cls->ip_prot = IPV4_PROT(iph);
+		iphlen = IPV4_HLEN(iph);
+		break;
+	case ETHER_TYPE_IPV6:
+		if (pktlen < (ETHER_HDR_LEN + IPV6_MIN_HLEN) || IP_VER(iph) != IP_VER_6) {
+			return;
+		}
+		cls->flags |= DHD_PKTCLS_F_IPV6;
+		cls->ip_prot = IPV6_PROT(iph);
+		iphlen = IPV6_MIN_HLEN;
+		break;
+	default:
+		return;
+	}
+
+	cls->l4_off = (uint8)(ETHER_HDR_LEN + iphlen);
+	l4h = pktdata + cls->l4_off;
+
+	switch (cls->ip_prot) {
+	case IP_PROT_TCP:
+		cls->flags |= DHD_PKTCLS_F_TCP;
+		if (pktlen >= (cls->l4_off + TCP_MIN_HEADER_LEN)) {
+			cls->dport = ntoh16_ua(l4h + TCP_DEST_PORT_OFFSET);
+		}
+		break;
+	case IP_PROT_UDP:
+		cls->flags |= DHD_PKTCLS_F_UDP;
+		if (pktlen < (cls->l4_off + UDP_HDR_LEN)) {
+			break;
+		}
+		sport = ntoh16_ua(l4h);
+		cls->dport = ntoh16_ua(l4h + UDP_DEST_PORT_OFFSET);
+		if (!(cls->flags & DHD_PKTCLS_F_IPV4) ||
+			ntoh16_ua(iph + IPV4_PKTLEN_OFFSET) <
+			(ntoh16_ua(l4h + UDP_LEN_OFFSET) + UDP_HDR_LEN)) {
+			break;
+		}
+		if (sport == DHCP_PORT_SERVER || sport == DHCP_PORT_CLIENT ||
+			cls->dport == DHCP_PORT_SERVER || cls->dport == DHCP_PORT_CLIENT) {
+			cls->flags |= DHD_PKTCLS_F_DHCP;
+		} else if (sport == UDP_PORT_DNS || cls->dport == UDP_PORT_DNS) {
+			cls->flags |= DHD_PKTCLS_F_DNS;
+		}
+		break;
+	case IP_PROT_ICMP:
+		if ((cls->flags & DHD_PKTCLS_F_IPV4) &&
+			pktlen >= (cls->l4_off + sizeof(struct bcmicmp_hdr)) &&
+			(ntoh16_ua(iph + IPV4_PKTLEN_OFFSET) - iphlen) >=
+			sizeof(struct bcmicmp_hdr)) {
+			cls->flags |= DHD_PKTCLS_F_ICMP;
+		}
+		break;
+	case IP_PROT_ICMP6:
+		if (cls->flags & DHD_PKTCLS_F_IPV6) {
+			cls->flags |= DHD_PKTCLS_F_ICMPV6;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/* Classify a packet entering the driver and cache the result in its tag */
+dhd_pktcls_t *
+BCMFASTPATH(dhd_pkt_classify_tag)(dhd_pub_t *dhdp, void *pkt)
+{
+	dhd_pktcls_t *cls = DHD_PKTCLS(pkt);
+
+#ifdef PCIE_FULL_DONGLE
+	/* must not overlap the bus tag fields */
+	STATIC_ASSERT(sizeof(dhd_pkttag_fd_t) <= DHD_PKTCLS_OFFSET);
+#endif /* PCIE_FULL_DONGLE */
+
+	dhd_pkt_classify((uint8 *)PKTDATA(dhdp->osh, pkt), PKTLEN(dhdp->osh, pkt), cls);
+	return cls;
+}
+
 void
 dhd_dump_pkt(dhd_pub_t *dhdp, int ifidx, uint8 *pktdata, uint32 pktlen,
-	bool tx, uint32 *pkthash, uint16 *pktfate)
+	const dhd_pktcls_t *cls, bool tx, uint32 *pkthash, uint16 *pktfate)
 {
-	struct ether_header *eh;
-	uint16 ether_type;
+	dhd_pktcls_t lcls;
 
 	if (!pktdata || pktlen < ETHER_HDR_LEN) {
 		return;
@@ -363,25 +484,22 @@ dhd_dump_pkt(dhd_pub_t *dhdp, int ifidx, uint8 *pktdata, uint32 pktlen,
 	}
 #endif /* BCMPCIE && DHD_PKT_LOGGING */
 
-	eh = (struct ether_header *)pktdata;
-	ether_type = ntoh16(eh->ether_type);
-	if (ether_type == ETHER_TYPE_802_1X) {
+	if (!cls || !DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_VALID)) {
+		dhd_pkt_classify(pktdata, pktlen, &lcls);
+		cls = &lcls;
+	}
+
+	if (DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_EAPOL)) {
 		dhd_dump_eapol_message(dhdp, ifidx, pktdata, pktlen,
 			tx, pkthash, pktfate);
-	}
-	if (ether_type == ETHER_TYPE_IP) {
-		if (dhd_check_dhcp(pktdata)) {
-			dhd_dhcp_dump(dhdp, ifidx, pktdata, tx, pkthash, pktfate);
-		} else if (dhd_check_icmp(pktdata)) {
-			dhd_icmp_dump(dhdp, ifidx, pktdata, tx, pkthash, pktfate);
-		} else if (dhd_check_dns(pktdata)) {
-			dhd_dns_dump(dhdp, ifidx, pktdata, tx, pkthash, pktfate);
-		}
-	}
-	if (ether_type == ETHER_TYPE_ARP) {
-		if (dhd_check_arp(pktdata)) {
-			dhd_arp_dump(dhdp, ifidx, pktdata, tx, pkthash, pktfate);
-		}
+	} else if (DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_DHCP)) {
+		dhd_dhcp_dump(dhdp, ifidx, pktdata, tx, pkthash, pktfate);
+	} else if (DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_ICMP)) {
+		dhd_icmp_dump(dhdp, ifidx, pktdata, tx, pkthash, pktfate);
+	} else if (DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_DNS)) {
+		dhd_dns_dump(dhdp, ifidx, pktdata, tx, pkthash, pktfate);
+	} else if (DHD_PKTCLS_IS(cls, DHD_PKTCLS_F_ARP)) {
+		dhd_arp_dump(dhdp, ifidx, pktdata, tx, pkthash, pktfate);
 	}
 }
 
@@ -869,34 +987,6 @@ dhd_dump_eapol_message(dhd_pub_t *dhd, int ifidx, uint8 *pktdata,
 }
 #endif /* DHD_8021X_DUMP */
 
-bool
-dhd_check_dhcp(uint8 *pktdata)
-{
-	hdr_fmt_t *b = (hdr_fmt_t *)&pktdata[ETHER_HDR_LEN];
-	struct ipv4_hdr *iph = &b->iph;
-
-	/* check IP header */
-	if ((IPV4_HLEN(iph) < IPV4_HLEN_MIN) ||
-	        IP_VER(iph) != IP_VER_4 ||
-	        IPV4_PROT(iph) != IP_PROT_UDP) {
-	        return FALSE;
-	}
-
-	/* check UDP port for bootp (67, 68) */
-	if (b->udph.src_port != htons(DHCP_PORT_SERVER) &&
-	        b->udph.src_port != htons(DHCP_PORT_CLIENT) &&
-	        b->udph.dst_port != htons(DHCP_PORT_SERVER) &&
-	        b->udph.dst_port != htons(DHCP_PORT_CLIENT)) {
-	        return FALSE;
-	}
-
-	/* check header length */
-	if (ntohs(iph->tot_len) < ntohs(b->udph.len) + sizeof(struct bcmudp_hdr)) {
-	        return FALSE;
-	}
-	return TRUE;
-}
-
 #ifdef DHD_DHCP_DUMP
 #define BOOTP_CHADDR_LEN		16
 #define BOOTP_SNAME_LEN			64
@@ -1006,26 +1096,6 @@ dhd_dhcp_dump(dhd_pub_t *dhdp, int ifidx, uint8 *pktdata, bool tx,
 }
 #endif /* DHD_DHCP_DUMP */
 
-bool
-dhd_check_icmp(uint8 *pktdata)
-{
-	uint8 *pkt = (uint8 *)&pktdata[ETHER_HDR_LEN];
-	struct ipv4_hdr *iph = (struct ipv4_hdr *)pkt;
-
-	/* check IP header */
-	if ((IPV4_HLEN(iph) < IPV4_HLEN_MIN) ||
-		IP_VER(iph) != IP_VER_4 ||
-		IPV4_PROT(iph) != IP_PROT_ICMP) {
-		return FALSE;
-	}
-
-	/* check header length */
-	if (ntohs(iph->tot_len) - IPV4_HLEN(iph) < sizeof(struct bcmicmp_hdr)) {
-		return FALSE;
-	}
-	return TRUE;
-}
-
 #ifdef DHD_ICMP_DUMP
 #define ICMP_TYPE_DEST_UNREACH		3
 #define ICMP_ECHO_SEQ_OFFSET		6
@@ -1088,21 +1158,6 @@ dhd_icmp_dump(dhd_pub_t *dhdp, int ifidx, uint8 *pktdata, bool tx,
 }
 #endif /* DHD_ICMP_DUMP */
 
-bool
-dhd_check_arp(uint8 *pktdata)
-{
-	uint8 *pkt = (uint8 *)&pktdata[ETHER_HDR_LEN];
-	struct bcmarp *arph = (struct bcmarp *)pkt;
-
-	/* validation check */
-	if (arph->htype != hton16(HTYPE_ETHERNET) ||
-		arph->hlen != ETHER_ADDR_LEN ||
-		arph->plen != 4) {
-		return FALSE;
-	}
-	return TRUE;
-}
-
 #ifdef DHD_ARP_DUMP
 #ifdef BOARD_HIKEY
 /* On Hikey, due to continuous ARP prints
@@ -1179,33 +1234,6 @@ dhd_arp_dump(dhd_pub_t *dhdp, int ifidx, uint8 *pktdata, bool tx,
 }
 #endif /* DHD_ARP_DUMP */
 
-bool
-dhd_check_dns(uint8 *pktdata)
-{
-	hdr_fmt_t *dnsh = (hdr_fmt_t *)&pktdata[ETHER_HDR_LEN];
-	struct ipv4_hdr *iph = &dnsh->iph;
-
-	/* check IP header */
-	if ((IPV4_HLEN(iph) < IPV4_HLEN_MIN) ||
-		IP_VER(iph) != IP_VER_4 ||
-		IPV4_PROT(iph) != IP_PROT_UDP) {
-		return FALSE;
-	}
-
-	/* check UDP port for DNS */
-	if (dnsh->udph.src_port != hton16(UDP_PORT_DNS) &&
-		dnsh->udph.dst_port != hton16(UDP_PORT_DNS)) {
-		return FALSE;
-	}
-
-	/* check header length */
-	if (ntoh16(iph->tot_len) < (ntoh16(dnsh->udph.len) +
-		sizeof(struct bcmudp_hdr))) {
-		return FALSE;
-	}
-	return TRUE;
-}
-
 #ifdef DHD_DNS_DUMP
 typedef struct dns_fmt {
 	struct ipv4_hdr iph;
@@ -49,7 +49,11 @@ typedef enum pkt_cnt_rsn {
 
 extern msg_eapol_t dhd_is_4way_msg(uint8 *pktdata);
 extern void dhd_dump_pkt(dhd_pub_t *dhd, int ifidx, uint8 *pktdata,
-	uint32 pktlen, bool tx, uint32 *pkthash, uint16 *pktfate);
+	uint32 pktlen, const dhd_pktcls_t *cls, bool tx, uint32 *pkthash, uint16 *pktfate);
+
+/* Single pass packet classification, cached in the packet tag */
+extern void dhd_pkt_classify(uint8 *pktdata, uint32 pktlen, dhd_pktcls_t *cls);
+extern dhd_pktcls_t *dhd_pkt_classify_tag(dhd_pub_t *dhdp, void *pkt);
 
 #ifdef DHD_PKTDUMP_ROAM
 extern void dhd_dump_mod_pkt_timer(dhd_pub_t *dhdp, uint16 rsn);
@@ -117,8 +121,4 @@ static INLINE void dhd_dump_eapol_message(dhd_pub_t *dhd, int ifidx,
         uint8 *pktdata, uint32 pktlen, bool tx, uint32 *pkthash, uint16 *pktfate) { }
 #endif /* DHD_8021X_DUMP */
 
-extern bool dhd_check_dhcp(uint8 *pktdata);
-extern bool dhd_check_icmp(uint8 *pktdata);
-extern bool dhd_check_arp(uint8 *pktdata);
-extern bool dhd_check_dns(uint8 *pktdata);
 #endif /* __DHD_LINUX_PKTDUMP_H_ */
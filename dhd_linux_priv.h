@@ -52,6 +52,37 @@
 #include <dhd_flowring.h>
 #endif /* PCIE_FULL_DONGLE */
 
+#ifdef DHD_RXF_RING
+#define DHD_RXF_OCC_BINS	11	/* log2 bins, 1 .. MAXSKBPEND chains */
+#define DHD_RXF_BATCH		32	/* chains taken per dequeue */
+#define DHD_RXF_BATCH_BINS	6	/* log2 bins, 1 .. DHD_RXF_BATCH chains */
+
+/*
+ * RX frame chains handed from the DPC to the RXF thread. wr is advanced only
+ * by producers (serialized on rxf_lock) and rd only by the RXF thread, so the
+ * consumer never takes a lock. Indices run free, occupancy is wr - rd.
+ */
+typedef struct dhd_rxf_ring {
+	/* producer side */
+	uint32 wr ____cacheline_aligned_in_smp;
+	uint32 enq;
+	uint32 full;			/* chains dropped, ring full */
+	uint32 full_pkts;		/* packets in those chains */
+	uint32 throttle;		/* DPC rx reads paused */
+	uint32 occ_max;
+	uint32 occ_hist[DHD_RXF_OCC_BINS];
+	/* consumer side */
+	uint32 rd ____cacheline_aligned_in_smp;
+	uint32 deq;
+	uint32 batches;
+	uint32 kick;			/* DPC rescheduled after a pause */
+	uint32 batch_hist[DHD_RXF_BATCH_BINS];
+	/* set by the DPC, cleared by whoever resumes it */
+	uint32 throttled ____cacheline_aligned_in_smp;
+	void *buf[MAXSKBPEND];
+} dhd_rxf_ring_t;
+#endif /* DHD_RXF_RING */
+
 /*
  * Do not include this header except for the dhd_linux.c dhd_linux_sysfs.c
  * Local private structure (extension of pub)
@@ -102,6 +133,9 @@ typedef struct dhd_info {
 	tsk_ctl_t	thr_rxf_ctl;
 	spinlock_t	rxf_lock;
 	bool		rxthread_enabled;
+#ifdef DHD_RXF_RING
+	dhd_rxf_ring_t	rxf_ring;
+#endif /* DHD_RXF_RING */
 
 	/* Wakelocks */
 #if defined(CONFIG_HAS_WAKELOCK)
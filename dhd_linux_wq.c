@@ -49,9 +49,20 @@
  */
 typedef struct dhd_deferred_event {
 	u8 event;		/* holds the event */
+#ifdef DHD_WQ_DISPATCH
+	u8 priority;		/* DHD_WQ_WORK_PRIORITY_xxx, priority events run first */
+	u32 seq;		/* submission order across CPUs */
+#endif /* DHD_WQ_DISPATCH */
 	void *event_data;	/* holds event specific data */
 	event_handler_t event_handler;
+#ifdef DHD_WQ_DISPATCH
+	u64 enq_ns;		/* submission time, for service latency */
+#if BITS_PER_LONG == 32
+	u64 pad;		/* for memory alignment to power of 2 */
+#endif
+#else
 	unsigned long pad;	/* for memory alignment to power of 2 */
+#endif /* DHD_WQ_DISPATCH */
 } dhd_deferred_event_t;
 
 #define DEFRD_EVT_SIZE	(sizeof(dhd_deferred_event_t))
@@ -68,6 +79,488 @@ typedef struct dhd_deferred_event {
 #define DHD_FIFO_HAS_ENOUGH_DATA(fifo) \
 	((fifo) && (kfifo_len(fifo) >= DEFRD_EVT_SIZE))
 
+#ifdef DHD_WQ_DISPATCH
+/*
+ * Events are queued on per CPU fifos so submitters on different CPUs do not
+ * share a lock. Each dispatch class has its own work item, queued on its own
+ * workqueue, which pulls everything pending on all CPUs and runs it in
+ * submission order, priority events first.
+ */
+enum dhd_wq_class_id {
+	DHD_WQ_CLASS_DEFAULT = 0,	/* system_wq, as schedule_work() */
+	DHD_WQ_CLASS_HIGHPRI,		/* system_highpri_wq */
+	DHD_WQ_MAX_CLASS
+};
+
+/*
+ * Events only leave the default class when their handlers do not depend on
+ * ordering against interface add/delete.
+ *
+ * Only events whose data is a key (ifidx, ifp or NULL) rather than an
+ * allocation owned by the handler may coalesce; the handler then acts on the
+ * latest state for that key.
+ */
+#define DHD_WQ_F_COALESCE	0x1	/* keep one pending event per event_data */
+
+typedef struct dhd_wq_event_attr {
+	u8 class;
+	u8 flags;
+} dhd_wq_event_attr_t;
+
+static const dhd_wq_event_attr_t dhd_wq_event_attr[DHD_MAX_WQ_EVENTS] = {
+	[DHD_WQ_WORK_SET_MAC] = {DHD_WQ_CLASS_DEFAULT, DHD_WQ_F_COALESCE},
+	[DHD_WQ_WORK_SET_MCAST_LIST] = {DHD_WQ_CLASS_DEFAULT, DHD_WQ_F_COALESCE},
+	[DHD_WQ_WORK_H2D_CONSOLE_TIME_STAMP_MATCH] = {DHD_WQ_CLASS_DEFAULT, DHD_WQ_F_COALESCE},
+#ifdef DHD_HOSTREORDER_TIMER
+	[DHD_WQ_WORK_REORDER_EXPIRE] = {DHD_WQ_CLASS_HIGHPRI, DHD_WQ_F_COALESCE},
+#endif /* DHD_HOSTREORDER_TIMER */
+};
+
+/* fifo depth per CPU, in events */
+static const struct {
+	u16 prio;
+	u16 work;
+} dhd_wq_fifo_len[DHD_WQ_MAX_CLASS] = {
+	{16, 64},
+	{8, 8}
+};
+
+static const char *dhd_wq_class_name[DHD_WQ_MAX_CLASS] = {
+	"default", "highpri"
+};
+
+#define DHD_WQ_LAT_BINS		16	/* log2 usec */
+
+struct dhd_wq_cpu {
+	spinlock_t lock;
+	struct kfifo prio_fifo;
+	struct kfifo work_fifo;
+	u32 submitted;
+	u32 dropped;
+	u32 depth_max;
+} ____cacheline_aligned_in_smp;
+
+struct dhd_wq_class {
+	struct work_struct work;
+	struct workqueue_struct *wq;
+	struct dhd_deferred_wq *parent;
+	struct dhd_wq_cpu *cpus;	/* nr_cpu_ids entries */
+	dhd_deferred_event_t *batch;	/* events pulled off all CPUs, worker only */
+	u32 batch_len;
+	/* worker only */
+	u32 dispatched;
+	u32 batches;
+	u64 lat_total_ns;
+	u64 lat_max_ns;
+	u32 lat_hist[DHD_WQ_LAT_BINS];
+};
+
+struct dhd_wq_coalesce {
+	spinlock_t lock;
+	u32 queued;		/* events of this type not yet pulled by the worker */
+	void *last_data;	/* event_data of the latest one queued */
+	u32 coalesced;
+};
+
+struct dhd_deferred_wq {
+	struct dhd_wq_class class[DHD_WQ_MAX_CLASS];
+	struct dhd_wq_coalesce coalesce[DHD_MAX_WQ_EVENTS];
+	atomic_t seq;
+	void *dhd_info;
+	u32 event_skip_mask;
+};
+
+/* deferred work functions */
+static void dhd_deferred_work_handler(struct work_struct *data);
+
+/* Events missing from dhd_wq_event_attr[] are in the default class */
+static bool
+dhd_deferred_class_used(int id)
+{
+	int i;
+
+	for (i = 0; i < DHD_MAX_WQ_EVENTS; i++) {
+		if (dhd_wq_event_attr[i].class == id) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static int
+dhd_deferred_class_init(struct dhd_deferred_wq *deferred_wq, int id)
+{
+	struct dhd_wq_class *wq_class = &deferred_wq->class[id];
+	u32 prio_size = dhd_wq_fifo_len[id].prio * DEFRD_EVT_SIZE;
+	u32 work_size = dhd_wq_fifo_len[id].work * DEFRD_EVT_SIZE;
+	u8 *buf;
+	int cpu;
+
+	INIT_WORK(&wq_class->work, dhd_deferred_work_handler);
+	wq_class->parent = deferred_wq;
+	wq_class->wq = (id == DHD_WQ_CLASS_HIGHPRI) ? system_highpri_wq : system_wq;
+
+	ASSERT(is_power_of_2(prio_size) && is_power_of_2(work_size));
+
+	wq_class->cpus = (struct dhd_wq_cpu *)kzalloc(nr_cpu_ids * sizeof(struct dhd_wq_cpu),
+		GFP_KERNEL);
+	if (!wq_class->cpus) {
+		return DHD_WQ_STS_FAILED;
+	}
+
+	for_each_possible_cpu(cpu) {
+		struct dhd_wq_cpu *c = &wq_class->cpus[cpu];
+
+		spin_lock_init(&c->lock);
+		buf = (u8 *)kzalloc(prio_size, GFP_KERNEL);
+		if (!buf) {
+			return DHD_WQ_STS_FAILED;
+		}
+		kfifo_init(&c->prio_fifo, buf, prio_size);
+		buf = (u8 *)kzalloc(work_size, GFP_KERNEL);
+		if (!buf) {
+			return DHD_WQ_STS_FAILED;
+		}
+		kfifo_init(&c->work_fifo, buf, work_size);
+	}
+
+	/* large enough to empty every fifo of the class twice, see dhd_get_scheduled_work() */
+	wq_class->batch_len = 2 * num_possible_cpus() *
+		(dhd_wq_fifo_len[id].prio + dhd_wq_fifo_len[id].work);
+	wq_class->batch = (dhd_deferred_event_t *)kzalloc(wq_class->batch_len * DEFRD_EVT_SIZE,
+		GFP_KERNEL);
+	if (!wq_class->batch) {
+		return DHD_WQ_STS_FAILED;
+	}
+
+	return DHD_WQ_STS_OK;
+}
+
+static void
+dhd_deferred_class_deinit(struct dhd_wq_class *wq_class)
+{
+	int cpu;
+
+	if (!wq_class->cpus) {
+		return;
+	}
+
+	/* cancel the deferred work handling */
+	cancel_work_sync(&wq_class->work);
+
+	/* kfifo_free frees locally allocated fifo buffer */
+	for_each_possible_cpu(cpu) {
+		kfifo_free(&wq_class->cpus[cpu].prio_fifo);
+		kfifo_free(&wq_class->cpus[cpu].work_fifo);
+	}
+	kfree(wq_class->cpus);
+	wq_class->cpus = NULL;
+
+	if (wq_class->batch) {
+		kfree(wq_class->batch);
+		wq_class->batch = NULL;
+	}
+}
+
+void*
+dhd_deferred_work_init(void *dhd_info)
+{
+	struct dhd_deferred_wq	*work = NULL;
+	int i;
+
+	if (!dhd_info) {
+		DHD_ERROR(("%s: dhd info not initialized\n", __FUNCTION__));
+		goto return_null;
+	}
+
+	/* per CPU fifos are sized for possible CPUs, this is only called from attach */
+	work = (struct dhd_deferred_wq *)kzalloc(sizeof(struct dhd_deferred_wq),
+		GFP_KERNEL);
+	if (!work) {
+		DHD_ERROR(("%s: work queue creation failed\n", __FUNCTION__));
+		goto return_null;
+	}
+
+	for (i = 0; i < DHD_WQ_MAX_CLASS; i++) {
+		/* no fifos for a class no event of this build maps to */
+		if (!dhd_deferred_class_used(i)) {
+			continue;
+		}
+		if (dhd_deferred_class_init(work, i) != DHD_WQ_STS_OK) {
+			DHD_ERROR(("%s: %s work fifo allocation failed\n",
+				__FUNCTION__, dhd_wq_class_name[i]));
+			goto return_null;
+		}
+	}
+	for (i = 0; i < DHD_MAX_WQ_EVENTS; i++) {
+		spin_lock_init(&work->coalesce[i].lock);
+	}
+	atomic_set(&work->seq, 0);
+
+	work->dhd_info = dhd_info;
+	work->event_skip_mask = 0;
+	DHD_ERROR(("%s: work queue initialized\n", __FUNCTION__));
+	return work;
+
+return_null:
+	if (work) {
+		dhd_deferred_work_deinit(work);
+	}
+
+	return NULL;
+}
+
+void
+dhd_deferred_work_deinit(void *work)
+{
+	struct dhd_deferred_wq *deferred_work = work;
+	int i;
+
+	if (!deferred_work) {
+		DHD_ERROR(("%s: deferred work has been freed already\n",
+			__FUNCTION__));
+		return;
+	}
+
+	for (i = 0; i < DHD_WQ_MAX_CLASS; i++) {
+		dhd_deferred_class_deinit(&deferred_work->class[i]);
+	}
+
+	kfree(deferred_work);
+}
+
+/* Queue on the local CPU; the sequence is taken under the CPU lock so
+ * each fifo stays in sequence order
+ */
+static int
+dhd_deferred_work_enqueue(struct dhd_deferred_wq *deferred_wq,
+	struct dhd_wq_class *wq_class, dhd_deferred_event_t *deferred_event, u8 priority)
+{
+	struct dhd_wq_cpu *c;
+	struct kfifo *fifo;
+	unsigned long flags;
+	int bytes_copied = 0;
+	u32 depth;
+
+	c = &wq_class->cpus[get_cpu()];
+	fifo = (priority == DHD_WQ_WORK_PRIORITY_HIGH) ? &c->prio_fifo : &c->work_fifo;
+
+	spin_lock_irqsave(&c->lock, flags);
+	if (kfifo_avail(fifo) >= DEFRD_EVT_SIZE) {
+		deferred_event->seq = (u32)atomic_inc_return(&deferred_wq->seq);
+		deferred_event->enq_ns = OSL_LOCALTIME_NS();
+		bytes_copied = kfifo_in(fifo, deferred_event, DEFRD_EVT_SIZE);
+	}
+	if (bytes_copied == DEFRD_EVT_SIZE) {
+		c->submitted++;
+		depth = (kfifo_len(&c->prio_fifo) + kfifo_len(&c->work_fifo)) / DEFRD_EVT_SIZE;
+		c->depth_max = MAX(c->depth_max, depth);
+	} else {
+		c->dropped++;
+	}
+	spin_unlock_irqrestore(&c->lock, flags);
+	put_cpu();
+
+	return (bytes_copied == DEFRD_EVT_SIZE) ? DHD_WQ_STS_OK : DHD_WQ_STS_SCHED_FAILED;
+}
+
+/*
+ *	Prepares event to be queued
+ *	Schedules the event
+ */
+int
+dhd_deferred_schedule_work(void *workq, void *event_data, u8 event,
+	event_handler_t event_handler, u8 priority)
+{
+	struct dhd_deferred_wq *deferred_wq = (struct dhd_deferred_wq *)workq;
+	const dhd_wq_event_attr_t *attr;
+	struct dhd_wq_class *wq_class;
+	struct dhd_wq_coalesce *co;
+	dhd_deferred_event_t deferred_event;
+	unsigned long flags;
+	int ret;
+
+	if (!deferred_wq) {
+		DHD_ERROR(("%s: work queue not initialized\n", __FUNCTION__));
+		ASSERT(0);
+		return DHD_WQ_STS_UNINITIALIZED;
+	}
+
+	if (!event || (event >= DHD_MAX_WQ_EVENTS)) {
+		DHD_ERROR(("%s: unknown event, event=%d\n", __FUNCTION__,
+			event));
+		return DHD_WQ_STS_UNKNOWN_EVENT;
+	}
+
+	if (!priority || (priority >= DHD_WQ_MAX_PRIORITY)) {
+		DHD_ERROR(("%s: unknown priority, priority=%d\n",
+			__FUNCTION__, priority));
+		return DHD_WQ_STS_UNKNOWN_PRIORITY;
+	}
+
+	if ((deferred_wq->event_skip_mask & (1 << event))) {
+		DHD_ERROR(("%s: Skip event requested. Mask = 0x%x\n",
+			__FUNCTION__, deferred_wq->event_skip_mask));
+		return DHD_WQ_STS_EVENT_SKIPPED;
+	}
+
+	bzero(&deferred_event, sizeof(deferred_event));
+	deferred_event.event = event;
+	deferred_event.priority = priority;
+	deferred_event.event_data = event_data;
+	deferred_event.event_handler = event_handler;
+
+	attr = &dhd_wq_event_attr[event];
+	wq_class = &deferred_wq->class[attr->class];
+
+	if (attr->flags & DHD_WQ_F_COALESCE) {
+		co = &deferred_wq->coalesce[event];
+		spin_lock_irqsave(&co->lock, flags);
+		/*
+		 * The pending one has not been pulled by the worker yet, so its
+		 * handler runs after this call and sees the caller's latest state.
+		 */
+		if (co->queued && co->last_data == event_data) {
+			co->coalesced++;
+			spin_unlock_irqrestore(&co->lock, flags);
+			return DHD_WQ_STS_OK;
+		}
+		ret = dhd_deferred_work_enqueue(deferred_wq, wq_class, &deferred_event, priority);
+		if (ret == DHD_WQ_STS_OK) {
+			co->queued++;
+			co->last_data = event_data;
+		}
+		spin_unlock_irqrestore(&co->lock, flags);
+	} else {
+		ret = dhd_deferred_work_enqueue(deferred_wq, wq_class, &deferred_event, priority);
+	}
+
+	if (ret != DHD_WQ_STS_OK) {
+		DHD_ERROR(("%s: failed to schedule deferred work, "
+			"event=%d priority=%d\n", __FUNCTION__, event, priority));
+		return ret;
+	}
+	queue_work(wq_class->wq, &wq_class->work);
+	return DHD_WQ_STS_OK;
+}
+
+/* Priority events first, each group in submission order */
+static INLINE bool
+dhd_deferred_work_before(const dhd_deferred_event_t *a, const dhd_deferred_event_t *b)
+{
+	if (a->priority != b->priority) {
+		return (a->priority == DHD_WQ_WORK_PRIORITY_HIGH);
+	}
+	return ((s32)(a->seq - b->seq) < 0);
+}
+
+static void
+dhd_deferred_work_sort(dhd_deferred_event_t *events, u32 n)
+{
+	dhd_deferred_event_t cur;
+	u32 i, j;
+
+	for (i = 1; i < n; i++) {
+		cur = events[i];
+		for (j = i; j > 0 && dhd_deferred_work_before(&cur, &events[j - 1]); j--) {
+			events[j] = events[j - 1];
+		}
+		events[j] = cur;
+	}
+}
+
+/*
+ * Moves events from the head of fifo to batch[n..], all of them or only those
+ * with seq up to max_seq. Called with the fifo's CPU lock held.
+ */
+static u32
+dhd_deferred_work_pull(struct kfifo *fifo, dhd_deferred_event_t *batch, u32 n, u32 batch_len,
+	bool bounded, u32 max_seq)
+{
+	while (kfifo_len(fifo) >= DEFRD_EVT_SIZE && n < batch_len) {
+		if (kfifo_out_peek(fifo, &batch[n], DEFRD_EVT_SIZE) != DEFRD_EVT_SIZE) {
+			break;
+		}
+		if (bounded && (s32)(batch[n].seq - max_seq) > 0) {
+			break;
+		}
+		/* consume what was peeked; kfifo_skip() only drops one byte here */
+		n += kfifo_out(fifo, &batch[n], DEFRD_EVT_SIZE) / DEFRD_EVT_SIZE;
+	}
+
+	return n;
+}
+
+/*
+ * Pulls every event queued for the class off all CPUs into wq_class->batch,
+ * priority events first. Returns the number of events pulled.
+ *
+ * A submitter that migrates can queue A on a CPU already visited and then B
+ * on one not yet visited, so the first pass may see B without A. A's seq was
+ * taken before B's under its CPU lock, so a second pass that takes each lock
+ * again finds every event older than the newest one pulled. Each pass pulls
+ * at most one fifo's worth per fifo, hence the batch holds two.
+ */
+static u32
+dhd_get_scheduled_work(struct dhd_deferred_wq *deferred_wq, struct dhd_wq_class *wq_class)
+{
+	dhd_deferred_event_t *batch = wq_class->batch;
+	unsigned long flags;
+	u32 max_seq = 0;
+	u32 n = 0;
+	u32 i;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct dhd_wq_cpu *c = &wq_class->cpus[cpu];
+
+		spin_lock_irqsave(&c->lock, flags);
+		n = dhd_deferred_work_pull(&c->prio_fifo, batch, n, wq_class->batch_len, FALSE, 0);
+		n = dhd_deferred_work_pull(&c->work_fifo, batch, n, wq_class->batch_len, FALSE, 0);
+		spin_unlock_irqrestore(&c->lock, flags);
+	}
+	if (n == 0) {
+		return 0;
+	}
+
+	if (num_possible_cpus() > 1) {
+		max_seq = batch[0].seq;
+		for (i = 1; i < n; i++) {
+			if ((s32)(batch[i].seq - max_seq) > 0) {
+				max_seq = batch[i].seq;
+			}
+		}
+		for_each_possible_cpu(cpu) {
+			struct dhd_wq_cpu *c = &wq_class->cpus[cpu];
+
+			spin_lock_irqsave(&c->lock, flags);
+			n = dhd_deferred_work_pull(&c->prio_fifo, batch, n, wq_class->batch_len,
+				TRUE, max_seq);
+			n = dhd_deferred_work_pull(&c->work_fifo, batch, n, wq_class->batch_len,
+				TRUE, max_seq);
+			spin_unlock_irqrestore(&c->lock, flags);
+		}
+		dhd_deferred_work_sort(batch, n);
+	}
+
+	/* pulled events may coalesce no more, their handlers are about to run */
+	for (i = 0; i < n; i++) {
+		u8 event = batch[i].event;
+
+		if (event < DHD_MAX_WQ_EVENTS &&
+			(dhd_wq_event_attr[event].flags & DHD_WQ_F_COALESCE)) {
+			struct dhd_wq_coalesce *co = &deferred_wq->coalesce[event];
+
+			spin_lock_irqsave(&co->lock, flags);
+			co->queued--;
+			spin_unlock_irqrestore(&co->lock, flags);
+		}
+	}
+
+	return n;
+}
+#else
 struct dhd_deferred_wq {
 	struct work_struct deferred_work; /* should be the first member */
 
@@ -320,6 +813,7 @@ dhd_get_scheduled_work(struct dhd_deferred_wq *deferred_wq,
 
 	return (bytes_copied == DEFRD_EVT_SIZE);
 }
+#endif /* DHD_WQ_DISPATCH */
 
 static inline void
 dhd_deferred_dump_work_event(dhd_deferred_event_t *work_event)
@@ -337,6 +831,76 @@ dhd_deferred_dump_work_event(dhd_deferred_event_t *work_event)
 		work_event->event_handler));
 }
 
+#ifdef DHD_WQ_DISPATCH
+static void
+dhd_deferred_work_account(struct dhd_wq_class *wq_class, dhd_deferred_event_t *work_event)
+{
+	u64 lat_ns = OSL_LOCALTIME_NS() - work_event->enq_ns;
+	u32 lat_us = (u32)MIN(DIV_U64_BY_U32(lat_ns, NSEC_PER_USEC), (u64)0xFFFFFFFF);
+
+	/* bin j counts latencies below 2^j usec, the last one is open ended */
+	wq_class->lat_hist[MIN((u32)fls(lat_us), DHD_WQ_LAT_BINS - 1)]++;
+	wq_class->lat_total_ns += lat_ns;
+	wq_class->lat_max_ns = MAX(wq_class->lat_max_ns, lat_ns);
+	wq_class->dispatched++;
+}
+
+/*
+ *	Called when work is scheduled
+ */
+static void
+dhd_deferred_work_handler(struct work_struct *work)
+{
+	struct dhd_wq_class *wq_class;
+	struct dhd_deferred_wq *deferred_work;
+	dhd_deferred_event_t *work_event;
+	u32 i, n;
+
+	GCC_DIAGNOSTIC_PUSH_SUPPRESS_CAST();
+	wq_class = container_of(work, struct dhd_wq_class, work);
+	GCC_DIAGNOSTIC_POP();
+	deferred_work = wq_class->parent;
+
+	if (!deferred_work) {
+		DHD_ERROR(("%s: work queue not initialized\n", __FUNCTION__));
+		return;
+	}
+
+	while ((n = dhd_get_scheduled_work(deferred_work, wq_class)) != 0) {
+		wq_class->batches++;
+		for (i = 0; i < n; i++) {
+			work_event = &wq_class->batch[i];
+
+			if (work_event->event >= DHD_MAX_WQ_EVENTS) {
+				DHD_ERROR(("%s: unknown event\n", __FUNCTION__));
+				dhd_deferred_dump_work_event(work_event);
+				ASSERT(work_event->event < DHD_MAX_WQ_EVENTS);
+				continue;
+			}
+			dhd_deferred_work_account(wq_class, work_event);
+
+			/*
+			 * XXX: don't do NULL check for 'work_event->event_data'
+			 * as for some events like DHD_WQ_WORK_DHD_LOG_DUMP the
+			 * event data is always NULL even though rest of the
+			 * event parameters are valid
+			 */
+
+			if (work_event->event_handler) {
+				work_event->event_handler(deferred_work->dhd_info,
+					work_event->event_data, work_event->event);
+			} else {
+				DHD_ERROR(("%s: event handler is null\n",
+					__FUNCTION__));
+				dhd_deferred_dump_work_event(work_event);
+				ASSERT(work_event->event_handler != NULL);
+			}
+		}
+	}
+
+	return;
+}
+#else
 /*
  *	Called when work is scheduled
  */
@@ -384,6 +948,7 @@ dhd_deferred_work_handler(struct work_struct *work)
 
 	return;
 }
+#endif /* DHD_WQ_DISPATCH */
 
 void
 dhd_deferred_work_set_skip(void *work, u8 event, bool set)
@@ -403,3 +968,54 @@ dhd_deferred_work_set_skip(void *work, u8 event, bool set)
 		deferred_wq->event_skip_mask &= ~(1 << event);
 	}
 }
+
+#ifdef DHD_WQ_DISPATCH
+void
+dhd_deferred_work_dump(void *work, struct bcmstrbuf *strbuf)
+{
+	struct dhd_deferred_wq *deferred_wq = (struct dhd_deferred_wq *)work;
+	int i, j, cpu;
+
+	if (!deferred_wq) {
+		return;
+	}
+
+	for (i = 0; i < DHD_WQ_MAX_CLASS; i++) {
+		struct dhd_wq_class *wq_class = &deferred_wq->class[i];
+		u32 submitted = 0, dropped = 0, depth = 0, depth_max = 0;
+
+		if (!wq_class->cpus) {
+			continue;
+		}
+		for_each_possible_cpu(cpu) {
+			struct dhd_wq_cpu *c = &wq_class->cpus[cpu];
+
+			submitted += c->submitted;
+			dropped += c->dropped;
+			depth += (kfifo_len(&c->prio_fifo) + kfifo_len(&c->work_fifo)) /
+				DEFRD_EVT_SIZE;
+			depth_max = MAX(depth_max, c->depth_max);
+		}
+		bcm_bprintf(strbuf, "\nDeferred work %s: submitted %u dispatched %u dropped %u"
+			" batches %u depth %u max %u\n", dhd_wq_class_name[i], submitted,
+			wq_class->dispatched, dropped, wq_class->batches, depth, depth_max);
+		bcm_bprintf(strbuf, "latency avg %lluus max %lluus hist(us):",
+			wq_class->dispatched ?
+			DIV_U64_BY_U32(DIV_U64_BY_U32(wq_class->lat_total_ns, NSEC_PER_USEC),
+			wq_class->dispatched) : 0,
+			DIV_U64_BY_U32(wq_class->lat_max_ns, NSEC_PER_USEC));
+		for (j = 0; j < DHD_WQ_LAT_BINS; j++) {
+			bcm_bprintf(strbuf, " %u:%u", 1u << j, wq_class->lat_hist[j]);
+		}
+		bcm_bprintf(strbuf, "\n");
+	}
+
+	bcm_bprintf(strbuf, "Deferred work coalesced:");
+	for (i = 0; i < DHD_MAX_WQ_EVENTS; i++) {
+		if (deferred_wq->coalesce[i].coalesced) {
+			bcm_bprintf(strbuf, " %d:%u", i, deferred_wq->coalesce[i].coalesced);
+		}
+	}
+	bcm_bprintf(strbuf, "\n");
+}
+#endif /* DHD_WQ_DISPATCH */
@@ -52,6 +52,9 @@ enum _wq_event {
 	DHD_WQ_WORK_H2D_CONSOLE_TIME_STAMP_MATCH,
 	DHD_WQ_WORK_AXI_ERROR_DUMP,
 	DHD_WQ_WORK_CTO_RECOVERY,
+#ifdef DHD_HOSTREORDER_TIMER
+	DHD_WQ_WORK_REORDER_EXPIRE,
+#endif /* DHD_HOSTREORDER_TIMER */
 	DHD_MAX_WQ_EVENTS
 };
 
@@ -82,4 +85,8 @@ void dhd_deferred_work_deinit(void *workq);
 int dhd_deferred_schedule_work(void *workq, void *event_data, u8 event,
 	event_handler_t evt_handler, u8 priority);
 void dhd_deferred_work_set_skip(void *work, u8 event, bool set);
+#ifdef DHD_WQ_DISPATCH
+struct bcmstrbuf;
+void dhd_deferred_work_dump(void *work, struct bcmstrbuf *strbuf);
+#endif /* DHD_WQ_DISPATCH */
 #endif /* _dhd_linux_wq_h_ */
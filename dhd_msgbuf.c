@@ -529,6 +529,10 @@ typedef struct dhd_prot {
 #endif /* EWP_EDL */
 	ulong d2h_sync_wait_max; /* max number of wait loops to receive one msg */
 	ulong d2h_sync_wait_tot; /* total wait loops */
+#ifdef DHD_D2H_SYNC_BATCH
+	ulong d2h_sync_span_items; /* items validated along with their span */
+	ulong d2h_sync_poll_items; /* items left to the polling sync callback */
+#endif /* DHD_D2H_SYNC_BATCH */
 
 	dhd_dmaxfer_t	dmaxfer; /* for test/DMA loopback */
 
@@ -580,6 +584,9 @@ typedef struct dhd_prot {
 	dhd_dma_buf_t	host_scb_buf; /* scb host offload buffer */
 	bool no_tx_resource;
 	uint32 txcpl_db_cnt;
+#ifdef DHD_DPC_SCHED
+	uint32 dpc_items[DHD_DPC_RING_MAX];	/* items consumed per completion ring */
+#endif /* DHD_DPC_SCHED */
 } dhd_prot_t;
 
 #ifdef DHD_EWPR_VER2
@@ -1146,6 +1153,223 @@ dma_completed:
 	return msg->msg_type;
 }
 
+#ifdef DHD_D2H_SYNC_BATCH
+/* XOR of a work item already invalidated with its span, two words per load */
+static INLINE uint32
+dhd_prot_d2h_xor32(const uint32 *words, int num_words)
+{
+	uint64 acc = 0;
+	uint32 csum;
+	int i = 0;
+
+	if (!((uintptr)words & (sizeof(uint64) - 1))) {
+		const uint64 *dwords = (const uint64 *)words;
+
+		for (; (i + 1) < num_words; i += 2) {
+			acc ^= dwords[i >> 1];
+		}
+	}
+	csum = (uint32)acc ^ (uint32)(acc >> 32);
+	for (; i < num_words; i++) {
+		csum ^= words[i];
+	}
+
+	return csum;
+}
+
+/* Count the leading items of buf that carry the expected epochs/checksums */
+static uint32
+BCMFASTPATH(dhd_prot_d2h_sync_span_check)(dhd_pub_t *dhd, uint32 seqnum,
+	uint16 item_len, const uint8 *buf, uint32 items)
+{
+	int num_words = item_len / sizeof(uint32);
+	uint32 n = 0;
+
+	if (dhd->d2h_sync_mode & PCIE_SHARED_D2H_SYNC_SEQNUM) {
+		for (; n < items; n++, seqnum++, buf += item_len) {
+			const uint32 *marker = (const uint32 *)buf + (num_words - 1);
+
+			if (ltoh32(*marker) != (seqnum % D2H_EPOCH_MODULO)) {
+				break;
+			}
+		}
+	} else if (dhd->d2h_sync_mode & PCIE_SHARED_D2H_SYNC_XORCSUM) {
+		for (; n < items; n++, seqnum++, buf += item_len) {
+			const cmn_msg_hdr_t *msg = (const cmn_msg_hdr_t *)buf;
+
+			if ((msg->epoch != (uint8)(seqnum % D2H_EPOCH_MODULO)) ||
+				dhd_prot_d2h_xor32((const uint32 *)buf, num_words)) {
+				break;
+			}
+		}
+	}
+
+	return n;
+}
+
+/**
+ * dhd_prot_d2h_sync_span - Validate, in a single pass, the work items of a span
+ * returned by dhd_prot_get_read_addr, which invalidated the span as a whole.
+ * Returns the number of leading items whose DMA has completed. The caller
+ * consumes those by bumping ring->seqnum; items after the first one that has
+ * not landed yet go through the polling d2h_sync_cb.
+ */
+static uint32
+BCMFASTPATH(dhd_prot_d2h_sync_span)(dhd_pub_t *dhd, msgbuf_ring_t *ring,
+	const uint8 *buf, uint32 len)
+{
+	dhd_prot_t *prot = dhd->prot;
+	uint32 items = len / ring->item_len;
+	uint32 n;
+
+	if (dhd->dhd_induce_error == DHD_INDUCE_LIVELOCK) {
+		/* let the sync callback report it */
+		return 0;
+	}
+	if (!(dhd->d2h_sync_mode &
+		(PCIE_SHARED_D2H_SYNC_SEQNUM | PCIE_SHARED_D2H_SYNC_XORCSUM))) {
+		/* nothing to validate, the noop callback is as cheap */
+		return 0;
+	}
+
+	n = dhd_prot_d2h_sync_span_check(dhd, ring->seqnum, ring->item_len, buf, items);
+	prot->d2h_sync_span_items += n;
+	prot->d2h_sync_poll_items += items - n;
+
+	return n;
+}
+
+#define D2H_SYNC_BENCH_ITEMS	1024u
+#define D2H_SYNC_BENCH_REPS	16u
+
+/* Fill items as the dongle would in the current sync mode, starting at seqnum 0 */
+static void
+dhd_prot_d2h_sync_bench_fill(dhd_pub_t *dhd, uint8 *buf, uint16 item_len, uint32 items)
+{
+	int num_words = item_len / sizeof(uint32);
+	uint32 i;
+	int w;
+
+	for (i = 0; i < items; i++, buf += item_len) {
+		cmn_msg_hdr_t *msg = (cmn_msg_hdr_t *)buf;
+		uint32 *words = (uint32 *)buf;
+		uint32 csum = 0;
+
+		memset(buf, (int)(i & 0xFFu), item_len);
+		msg->msg_type = MSG_TYPE_RX_CMPLT;
+		msg->epoch = (uint8)(i % D2H_EPOCH_MODULO);
+		if (dhd->d2h_sync_mode & PCIE_SHARED_D2H_SYNC_SEQNUM) {
+			words[num_words - 1] = htol32(i % D2H_EPOCH_MODULO);
+		} else {
+			for (w = 0; w < num_words - 1; w++) {
+				csum ^= words[w];
+			}
+			words[num_words - 1] = csum;
+		}
+	}
+}
+
+/*
+ * Time the span validation against the per item sync callback over the same
+ * synthetic, fully landed items, for each D2H completion ring's item size.
+ * Runs on a private buffer and ring, the live rings are not touched.
+ */
+int
+dhd_prot_d2h_sync_bench(dhd_pub_t *dhd, struct bcmstrbuf *b)
+{
+	dhd_prot_t *prot = dhd->prot;
+	const msgbuf_ring_t *rings[] = {
+		&prot->d2hring_ctrl_cpln, &prot->d2hring_tx_cpln, &prot->d2hring_rx_cpln
+	};
+	msgbuf_ring_t *ring;
+	uint8 *buf = NULL;
+	uint32 buf_len = 0;
+	uint64 start, span_ns, cb_ns;
+	uint32 span_ps, cb_ps;
+	uint32 total = D2H_SYNC_BENCH_ITEMS * D2H_SYNC_BENCH_REPS;
+	uint32 r, i, n;
+	int ret = BCME_OK;
+
+	if (!(dhd->d2h_sync_mode &
+		(PCIE_SHARED_D2H_SYNC_SEQNUM | PCIE_SHARED_D2H_SYNC_XORCSUM))) {
+		bcm_bprintf(b, "d2h_sync: NONE, nothing to validate\n");
+		return BCME_UNSUPPORTED;
+	}
+	if (dhd->dhd_induce_error == DHD_INDUCE_LIVELOCK) {
+		/* the sync callback would report a livelock on every item */
+		return BCME_BUSY;
+	}
+
+	ring = (msgbuf_ring_t *)MALLOCZ(dhd->osh, sizeof(*ring));
+	if (ring == NULL) {
+		return BCME_NOMEM;
+	}
+	strlcpy((char *)ring->name, "d2h_sync_bench", sizeof(ring->name));
+
+	for (r = 0; r < ARRAYSIZE(rings); r++) {
+		uint16 item_len = rings[r]->item_len;
+
+		if (item_len < sizeof(cmn_msg_hdr_t) + sizeof(uint32)) {
+			continue;
+		}
+		buf_len = D2H_SYNC_BENCH_ITEMS * item_len;
+		buf = (uint8 *)MALLOC(dhd->osh, buf_len);
+		if (buf == NULL) {
+			ret = BCME_NOMEM;
+			break;
+		}
+		dhd_prot_d2h_sync_bench_fill(dhd, buf, item_len, D2H_SYNC_BENCH_ITEMS);
+		ring->item_len = item_len;
+
+		start = OSL_LOCALTIME_NS();
+		for (i = 0, n = 0; i < D2H_SYNC_BENCH_REPS; i++) {
+			n += dhd_prot_d2h_sync_span_check(dhd, 0, item_len, buf,
+				D2H_SYNC_BENCH_ITEMS);
+		}
+		span_ns = OSL_LOCALTIME_NS() - start;
+		if (n != total) {
+			/* a bad synthetic item would send the callback into livelock handling */
+			MFREE(dhd->osh, buf, buf_len);
+			ret = BCME_ERROR;
+			break;
+		}
+
+		start = OSL_LOCALTIME_NS();
+		for (i = 0; i < D2H_SYNC_BENCH_REPS; i++) {
+			uint32 j;
+
+			ring->seqnum = 0;
+			for (j = 0; j < D2H_SYNC_BENCH_ITEMS; j++) {
+				if (prot->d2h_sync_cb(dhd, ring,
+					(cmn_msg_hdr_t *)(buf + (j * item_len)),
+					item_len) != MSG_TYPE_INVALID) {
+					n++;
+				}
+			}
+		}
+		cb_ns = OSL_LOCALTIME_NS() - start;
+
+		MFREE(dhd->osh, buf, buf_len);
+		if (n != (total * 2u)) {
+			ret = BCME_ERROR;
+			break;
+		}
+
+		/* ps per item keeps two decimals of ns */
+		span_ps = (uint32)DIV_U64_BY_U32(span_ns * 1000u, total);
+		cb_ps = (uint32)DIV_U64_BY_U32(cb_ns * 1000u, total);
+		bcm_bprintf(b, "%s item %u bytes: span %u.%02u cb %u.%02u ns/item\n",
+			(const char *)rings[r]->name, item_len,
+			span_ps / 1000u, (span_ps % 1000u) / 10u,
+			cb_ps / 1000u, (cb_ps % 1000u) / 10u);
+	}
+
+	MFREE(dhd->osh, ring, sizeof(*ring));
+
+	return ret;
+}
+#endif /* DHD_D2H_SYNC_BATCH */
+
 /**
  * dhd_prot_d2h_sync_none - Dongle ensure that the DMA will complete and host
  * need to try to sync. This noop sync handler will be bound when the dongle
@@ -5020,6 +5244,9 @@ BCMFASTPATH(dhd_prot_process_msgbuf_infocpl)(dhd_pub_t *dhd, uint bound)
 		}
 	}
 
+#ifdef DHD_DPC_SCHED
+	prot->dpc_items[DHD_DPC_RING_INFOCPL] += n;
+#endif /* DHD_DPC_SCHED */
 	return more;
 }
 
@@ -5365,6 +5592,9 @@ BCMFASTPATH(dhd_prot_process_msgbuf_rxcpl)(dhd_pub_t *dhd, uint bound, int ringt
 	uint32 pktid;
 	int i;
 	uint8 sync;
+#ifdef DHD_D2H_SYNC_BATCH
+	uint32 ready;
+#endif /* DHD_D2H_SYNC_BATCH */
 
 #ifdef DHD_LB_RXP
 	/* must be the first check in this function */
@@ -5412,10 +5642,21 @@ BCMFASTPATH(dhd_prot_process_msgbuf_rxcpl)(dhd_pub_t *dhd, uint bound, int ringt
 			DHD_RING_UNLOCK(ring->ring_lock, flags);
 			break;
 		}
+#ifdef DHD_D2H_SYNC_BATCH
+		ready = dhd_prot_d2h_sync_span(dhd, ring, msg_addr, msg_len);
+#endif /* DHD_D2H_SYNC_BATCH */
 
 		while (msg_len > 0) {
 			msg = (host_rxbuf_cmpl_t *)msg_addr;
 
+#ifdef DHD_D2H_SYNC_BATCH
+			if (ready) {
+				/* validated along with the span */
+				ready--;
+				ring->seqnum++;
+				sync = msg->cmn_hdr.msg_type;
+			} else
+#endif /* DHD_D2H_SYNC_BATCH */
 			/* Wait until DMA completes, then fetch msg_type */
 			sync = prot->d2h_sync_cb(dhd, ring, &msg->cmn_hdr, item_len);
 			/*
@@ -5584,6 +5825,9 @@ BCMFASTPATH(dhd_prot_process_msgbuf_rxcpl)(dhd_pub_t *dhd, uint bound, int ringt
 		DHD_LB_DISPATCH_RX_PROCESS(dhd);
 	}
 
+#ifdef DHD_DPC_SCHED
+	prot->dpc_items[DHD_DPC_RING_RXCPL] += n;
+#endif /* DHD_DPC_SCHED */
 	return more;
 
 }
@@ -5680,9 +5924,47 @@ BCMFASTPATH(dhd_prot_process_msgbuf_txcpl)(dhd_pub_t *dhd, uint bound, int ringt
 			dhd->prot->txcpl_db_cnt++;
 		}
 	}
+#ifdef DHD_DPC_SCHED
+	dhd->prot->dpc_items[DHD_DPC_RING_TXCPL] += n;
+#endif /* DHD_DPC_SCHED */
 	return more;
 }
 
+#ifdef DHD_DPC_SCHED
+/**
+ * Report the running count of items consumed from a completion ring and the
+ * items known to have landed but not yet consumed, as of the last write index
+ * fetch. Called from the DPC right after the ring was processed.
+ */
+void
+dhd_prot_dpc_ring_state(dhd_pub_t *dhd, dhd_dpc_ring_t which, uint32 *items, uint32 *backlog)
+{
+	dhd_prot_t *prot = dhd->prot;
+	msgbuf_ring_t *ring;
+
+	switch (which) {
+	case DHD_DPC_RING_TXCPL:
+		ring = &prot->d2hring_tx_cpln;
+		break;
+	case DHD_DPC_RING_RXCPL:
+		ring = &prot->d2hring_rx_cpln;
+		break;
+	case DHD_DPC_RING_INFOCPL:
+		ring = prot->d2hring_info_cpln;
+		break;
+	default:
+		ring = NULL;
+		break;
+	}
+
+	*items = (which < DHD_DPC_RING_MAX) ? prot->dpc_items[which] : 0;
+	*backlog = 0;
+	if (ring && ring->inited && ring->wr < ring->max_items) {
+		*backlog = NTXPACTIVE(ring->rd, ring->wr, ring->max_items);
+	}
+}
+#endif /* DHD_DPC_SCHED */
+
 int
 BCMFASTPATH(dhd_prot_process_trapbuf)(dhd_pub_t *dhd)
 {
@@ -5785,6 +6067,9 @@ BCMFASTPATH(dhd_prot_process_msgtype)(dhd_pub_t *dhd, msgbuf_ring_t *ring, uint8
 	uint8 msg_type;
 	cmn_msg_hdr_t *msg = NULL;
 	int ret = BCME_OK;
+#ifdef DHD_D2H_SYNC_BATCH
+	uint32 ready;
+#endif /* DHD_D2H_SYNC_BATCH */
 
 	ASSERT(ring);
 	item_len = ring->item_len;
@@ -5793,6 +6078,9 @@ BCMFASTPATH(dhd_prot_process_msgtype)(dhd_pub_t *dhd, msgbuf_ring_t *ring, uint8
 			__FUNCTION__, ring->idx, item_len, buf_len));
 		return BCME_ERROR;
 	}
+#ifdef DHD_D2H_SYNC_BATCH
+	ready = dhd_prot_d2h_sync_span(dhd, ring, buf, len);
+#endif /* DHD_D2H_SYNC_BATCH */
 
 	while (buf_len > 0) {
 		if (dhd->hang_was_sent) {
@@ -5807,6 +6095,14 @@ BCMFASTPATH(dhd_prot_process_msgtype)(dhd_pub_t *dhd, msgbuf_ring_t *ring, uint8
 
 		msg = (cmn_msg_hdr_t *)buf;
 
+#ifdef DHD_D2H_SYNC_BATCH
+		if (ready) {
+			/* validated along with the span */
+			ready--;
+			ring->seqnum++;
+			msg_type = msg->msg_type;
+		} else
+#endif /* DHD_D2H_SYNC_BATCH */
 		/* Wait until DMA completes, then fetch msg_type */
 		msg_type = dhd->prot->d2h_sync_cb(dhd, ring, msg, item_len);
 
@@ -6232,7 +6528,7 @@ BCMFASTPATH(dhd_prot_txstatus_process)(dhd_pub_t *dhd, void *msg)
 		uint32 pkthash = __dhd_dbg_pkt_hash((uintptr_t)pkt, pktid);
 		DHD_PKTLOG_TXS(dhd, pkt, pktid, status);
 		dhd_dump_pkt(dhd, ltoh32(txstatus->cmn_hdr.if_id),
-			(uint8 *)PKTDATA(dhd->osh, pkt), len, TRUE,
+			(uint8 *)PKTDATA(dhd->osh, pkt), len, DHD_PKTCLS_TXQ(pkt), TRUE,
 			&pkthash, &status);
 	}
 #endif /* DHD_PKT_LOGGING */
@@ -6495,6 +6791,8 @@ BCMFASTPATH(dhd_prot_txdata)(dhd_pub_t *dhd, void *PKTBUF, uint8 ifidx)
 	 */
 
 	if (dhd->dhd_induce_error == DHD_INDUCE_TX_BIG_PKT && big_pktbuf) {
+		/* the copy carries the same frame, keep its classification */
+		*DHD_PKTCLS(big_pktbuf) = *DHD_PKTCLS(PKTBUF);
 		PKTFREE(dhd->osh, PKTBUF, TRUE);
 		PKTBUF = big_pktbuf;
 	}
@@ -6536,7 +6834,7 @@ BCMFASTPATH(dhd_prot_txdata)(dhd_pub_t *dhd, void *PKTBUF, uint8 ifidx)
 	DHD_PKTLOG_TX(dhd, PKTBUF, pktid);
 	/* Dump TX packet */
 	pkthash = __dhd_dbg_pkt_hash((uintptr_t)PKTBUF, pktid);
-	dhd_dump_pkt(dhd, ifidx, pktdata, pktlen, TRUE, &pkthash, NULL);
+	dhd_dump_pkt(dhd, ifidx, pktdata, pktlen, DHD_PKTCLS_TXQ(PKTBUF), TRUE, &pkthash, NULL);
 #endif /* DHD_PKT_LOGGING */
 
 	/* Ethernet header: Copy before we cache flush packet using DMA_MAP */
@@ -7760,6 +8058,10 @@ void dhd_prot_dump(dhd_pub_t *dhd, struct bcmstrbuf *b)
 		bcm_bprintf(b, "\nd2h_sync: NONE:");
 	bcm_bprintf(b, " d2h_sync_wait max<%lu> tot<%lu>\n",
 		dhd->prot->d2h_sync_wait_max, dhd->prot->d2h_sync_wait_tot);
+#ifdef DHD_D2H_SYNC_BATCH
+	bcm_bprintf(b, "d2h_sync span items<%lu> poll items<%lu>\n",
+		dhd->prot->d2h_sync_span_items, dhd->prot->d2h_sync_poll_items);
+#endif /* DHD_D2H_SYNC_BATCH */
 
 	bcm_bprintf(b, "\nDongle DMA Indices: h2d %d  d2h %d index size %d bytes\n",
 		dhd->dma_h2d_ring_upd_support,
@@ -7784,12 +8086,19 @@ void dhd_prot_dstats(dhd_pub_t *dhd)
 }
 
 /** Called by upper DHD layer */
-int dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf,
+int dhd_process_pkt_reorder_info(dhd_pub_t *dhd, int ifidx, uchar *reorder_info_buf,
 	uint reorder_info_len, void **pkt, uint32 *free_buf_count)
 {
 	return 0;
 }
 
+#ifdef DHD_HOSTREORDER_TIMER
+/* Reordering is done in the dongle, nothing is held on the host */
+void dhd_prot_reorder_expire(dhd_pub_t *dhd)
+{
+}
+#endif /* DHD_HOSTREORDER_TIMER */
+
 /** Debug related, post a dummy message to interrupt dongle. Used to process cons commands. */
 int
 dhd_post_dummy_msg(dhd_pub_t *dhd)
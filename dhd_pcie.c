@@ -352,6 +352,9 @@ enum {
 	IOV_EXTDTXS_IN_TXCPL,
 	IOV_HOSTRDY_AFTER_INIT,
 	IOV_HP2P_MF_ENABLE,
+#ifdef DHD_D2H_SYNC_BATCH
+	IOV_D2H_SYNC_BENCH,
+#endif /* DHD_D2H_SYNC_BATCH */
 	IOV_PCIE_LAST /**< unused IOVAR */
 };
 
@@ -426,6 +429,9 @@ const bcm_iovar_t dhdpcie_iovars[] = {
 	{"extdtxs_in_txcpl", IOV_EXTDTXS_IN_TXCPL,	0,	0, IOVT_UINT32,	0 },
 	{"hostrdy_after_init", IOV_HOSTRDY_AFTER_INIT,	0,	0, IOVT_UINT32,	0 },
 	{"hp2p_mf_enable", IOV_HP2P_MF_ENABLE,	0,	0, IOVT_UINT32,	0 },
+#ifdef DHD_D2H_SYNC_BATCH
+	{"d2h_sync_bench", IOV_D2H_SYNC_BENCH,	0,	0, IOVT_BUFFER,	0 },
+#endif /* DHD_D2H_SYNC_BATCH */
 	{NULL, 0, 0, 0, 0, 0 }
 };
 
@@ -444,6 +450,18 @@ const bcm_iovar_t dhdpcie_iovars[] = {
 uint dhd_rxbound = DHD_RXBOUND;
 uint dhd_txbound = DHD_TXBOUND;
 
+#ifdef DHD_DPC_SCHED
+#ifndef DHD_DPC_BUDGET_US
+#define DHD_DPC_BUDGET_US	2000
+#endif
+#define DHD_DPC_MAX_BUDGET_US	100000
+#define DHD_DPC_MIN_BOUND	8	/* floor so a quiet ring is never starved */
+#define DHD_DPC_MAX_WEIGHT	0x3FFF
+
+uint dhd_infobound = DHD_INFORING_BOUND;
+uint dhd_dpc_budget_us = DHD_DPC_BUDGET_US;	/* 0 keeps the static bounds */
+#endif /* DHD_DPC_SCHED */
+
 #if defined(DEBUGGER) || defined(DHD_DSCOPE)
 /** the GDB debugger layer will call back into this (bus) layer to read/write dongle memory */
 static struct dhd_gdb_bus_ops_s  bus_ops = {
@@ -1375,6 +1393,11 @@ dhdpcie_config_restore(dhd_bus_t *bus, bool restore_pmcsr)
 	OSL_PCI_WRITE_CONFIG(bus->osh, PCI_BAR0_WIN, sizeof(uint32),
 			bus->saved_config.bar0_win);
 	dhdpcie_setbar1win(bus, bus->saved_config.bar1_win);
+#ifdef SI_BAR0_WIN_CACHE
+	if (bus->sih) {
+		si_invalidate_bar0win(bus->sih);
+	}
+#endif /* SI_BAR0_WIN_CACHE */
 
 	return BCME_OK;
 }
@@ -1523,6 +1546,20 @@ dhdpcie_bus_mpu_disable(dhd_bus_t *bus)
 	}
 }
 
+#ifdef SI_BAR0_WIN_CACHE
+/* Log and restart the BAR0 window counters at the end of attach or resume */
+static void
+dhdpcie_bar0win_stats_log(dhd_bus_t *bus, const char *phase)
+{
+	si_bar0win_stats_t st;
+
+	si_bar0win_stats(bus->sih, &st, TRUE);
+	DHD_INFO(("%s: %s bar0win writes %u skips %u corereg fast %u switch %u\n",
+		__FUNCTION__, phase, st.win_writes, st.win_skips,
+		st.corereg_fast, st.corereg_switch));
+}
+#endif /* SI_BAR0_WIN_CACHE */
+
 static bool
 dhdpcie_dongle_attach(dhd_bus_t *bus)
 {
@@ -1533,6 +1570,10 @@ dhdpcie_dongle_attach(dhd_bus_t *bus)
 	sbpcieregs_t *sbpcieregs;
 	bool dongle_reset_needed;
 	uint16 chipid;
+#ifdef SI_EROM_CACHE
+	uint64 attach_start_ns = OSL_LOCALTIME_NS();
+	si_attach_prof_t prof;
+#endif /* SI_EROM_CACHE */
 
 	BCM_REFERENCE(chipid);
 
@@ -1578,6 +1619,13 @@ dhdpcie_dongle_attach(dhd_bus_t *bus)
 		goto fail;
 	}
 
+#ifdef SI_EROM_CACHE
+	si_attach_prof(bus->sih, &prof);
+	DHD_INFO(("%s: si_attach prep %u scan %u%s setup %u total %u us\n",
+		__FUNCTION__, prof.prep_us, prof.scan_us, prof.scan_cached ? " (cached)" : "",
+		prof.setup_us, prof.total_us));
+#endif /* SI_EROM_CACHE */
+
 	/* Configure CTO Prevention functionality */
 #if defined(BCMPCIE_CTO_PREVENTION)
 	chipid = dhd_get_chipid(bus);
@@ -1888,6 +1936,15 @@ dhdpcie_dongle_attach(dhd_bus_t *bus)
 		}
 	}
 
+#ifdef SI_BAR0_WIN_CACHE
+	dhdpcie_bar0win_stats_log(bus, "attach");
+#endif /* SI_BAR0_WIN_CACHE */
+#ifdef SI_EROM_CACHE
+	bus->attach_us = (uint32)DIV_U64_BY_U32(OSL_LOCALTIME_NS() - attach_start_ns,
+		NSEC_PER_USEC);
+	DHD_INFO(("%s: dongle attach took %u us\n", __FUNCTION__, bus->attach_us));
+#endif /* SI_EROM_CACHE */
+
 	DHD_TRACE(("%s: EXIT: SUCCESS\n", __FUNCTION__));
 
 	return 0;
@@ -2160,6 +2217,10 @@ dhdpcie_bus_release(dhd_bus_t *bus)
 			dhd_free(bus->dhd);
 			bus->dhd = NULL;
 		}
+#ifdef SI_EROM_CACHE
+		/* the next probe may be a different dongle */
+		si_erom_cache_invalidate();
+#endif /* SI_EROM_CACHE */
 		/* unmap the regs and tcm here!! */
 		if (bus->regs) {
 			dhdpcie_bus_reg_unmap(osh, bus->regs, DONGLE_REG_MAP_SIZE);
@@ -2268,6 +2329,11 @@ void
 dhdpcie_bus_cfg_set_bar0_win(dhd_bus_t *bus, uint32 data)
 {
 	OSL_PCI_WRITE_CONFIG(bus->osh, PCI_BAR0_WIN, 4, data);
+#ifdef SI_BAR0_WIN_CACHE
+	if (bus->sih) {
+		si_invalidate_bar0win(bus->sih);
+	}
+#endif /* SI_BAR0_WIN_CACHE */
 }
 
 void
@@ -5072,6 +5138,23 @@ uint32 dhd_bus_get_sharedflags(dhd_bus_t *bus)
 void
 dhd_bus_clearcounts(dhd_pub_t *dhdp)
 {
+#ifdef DHD_DPC_SCHED
+	dhd_dpc_sched_t *sched = &dhdp->bus->dpc_sched;
+	int i;
+
+	/* keep the estimates and item baselines, only drop the statistics */
+	for (i = 0; i < DHD_DPC_RING_MAX; i++) {
+		dhd_dpc_ring_sched_t *rs = &sched->ring[i];
+
+		rs->served = 0;
+		rs->deferred = 0;
+		rs->svc_ns = 0;
+		bzero(rs->svc_hist, sizeof(rs->svc_hist));
+		bzero(rs->backlog_hist, sizeof(rs->backlog_hist));
+	}
+	sched->passes = 0;
+	sched->yields = 0;
+#endif /* DHD_DPC_SCHED */
 }
 
 /**
@@ -5597,6 +5680,13 @@ dhd_bus_perform_flr(dhd_bus_t *bus, bool force_fail)
 		OSL_DELAY(DHD_SSRESET_STATUS_RETRY_DELAY);
 	} while (val && (retry++ < DHD_SSRESET_STATUS_RETRIES));
 
+#ifdef SI_BAR0_WIN_CACHE
+	/* FLR put the BAR0 windows back to their defaults */
+	if (bus->sih) {
+		si_invalidate_bar0win(bus->sih);
+	}
+#endif /* SI_BAR0_WIN_CACHE */
+
 	if (val) {
 		DHD_INFO(("ERROR: reg=0x%x bit %d is not cleared\n",
 			PCIE_CFG_SUBSYSTEM_CONTROL, PCIE_SSRESET_STATUS_BIT));
@@ -6542,6 +6632,15 @@ dhdpcie_bus_doiovar(dhd_bus_t *bus, const bcm_iovar_t *vi, uint32 actionid, cons
 		bcmerror = dhd_prot_ringupd_dump(bus->dhd, &dump_b);
 		break;
 	}
+#ifdef DHD_D2H_SYNC_BATCH
+	case IOV_GVAL(IOV_D2H_SYNC_BENCH):
+	{
+		struct bcmstrbuf dump_b;
+		bcm_binit(&dump_b, arg, len);
+		bcmerror = dhd_prot_d2h_sync_bench(bus->dhd, &dump_b);
+		break;
+	}
+#endif /* DHD_D2H_SYNC_BATCH */
 	case IOV_GVAL(IOV_DMA_RINGINDICES):
 	{
 		int_val = dhdpcie_get_dma_ring_indices(bus->dhd);
@@ -7454,6 +7553,10 @@ dhdpcie_bus_suspend(struct dhd_bus *bus, bool state)
 		 * PCIE2_BAR0_CORE2_WIN with right window.
 		 */
 		si_invalidate_second_bar0win(bus->sih);
+#ifdef SI_BAR0_WIN_CACHE
+		si_invalidate_bar0win(bus->sih);
+		si_bar0win_stats(bus->sih, NULL, TRUE);
+#endif /* SI_BAR0_WIN_CACHE */
 #if defined(BCMPCIE_OOB_HOST_WAKE)
 		DHD_OS_OOB_IRQ_WAKE_UNLOCK(bus->dhd);
 #endif /* BCMPCIE_OOB_HOST_WAKE */
@@ -7522,6 +7625,9 @@ dhdpcie_bus_suspend(struct dhd_bus *bus, bool state)
 		}
 
 		bus->last_resume_end_time = OSL_LOCALTIME_NS();
+#ifdef SI_BAR0_WIN_CACHE
+		dhdpcie_bar0win_stats_log(bus, "resume");
+#endif /* SI_BAR0_WIN_CACHE */
 
 		/* Update TCM rd index for EDL ring */
 		DHD_EDL_RING_TCM_RD_UPDATE(bus->dhd);
@@ -8911,6 +9017,32 @@ void dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 	bcm_bprintf(strbuf, "htput_flow_ring_start:%d total_htput:%d client_htput=%d\n",
 		dhdp->htput_flow_ring_start, HTPUT_TOTAL_FLOW_RINGS, dhdp->htput_client_flow_rings);
 #endif /* DHD_HTPUT_TUNABLES */
+#ifdef DHD_FLOWID_CACHE
+	dhd_flowid_cache_dump(dhdp, strbuf);
+#endif /* DHD_FLOWID_CACHE */
+#ifdef DHD_DPC_SCHED
+	dhd_bus_dpc_sched_dump(dhdp, strbuf);
+#endif /* DHD_DPC_SCHED */
+#ifdef SI_BAR0_WIN_CACHE
+	{
+		si_bar0win_stats_t st;
+
+		si_bar0win_stats(dhdp->bus->sih, &st, FALSE);
+		bcm_bprintf(strbuf, "bar0win: writes %u skips %u corereg fast %u switch %u\n",
+			st.win_writes, st.win_skips, st.corereg_fast, st.corereg_switch);
+	}
+#endif /* SI_BAR0_WIN_CACHE */
+#ifdef SI_EROM_CACHE
+	{
+		si_attach_prof_t prof;
+
+		si_attach_prof(dhdp->bus->sih, &prof);
+		bcm_bprintf(strbuf, "si_attach: prep %u scan %u%s setup %u total %u us, "
+			"dongle attach %u us\n", prof.prep_us, prof.scan_us,
+			prof.scan_cached ? " (cached)" : "", prof.setup_us, prof.total_us,
+			dhdp->bus->attach_us);
+	}
+#endif /* SI_EROM_CACHE */
 	bcm_bprintf(strbuf,
 		"%4s %4s %2s %4s %17s %4s %4s %6s %10s %17s %17s %17s %17s %14s %14s %10s ",
 		"Num:", "Flow", "If", "Prio", ":Dest_MacAddress:", "Qlen", "CLen", "L2CLen",
@@ -10281,6 +10413,204 @@ dhdpci_bus_rte_log_time_sync_poll(dhd_bus_t *bus)
 }
 #endif /* DHD_H2D_LOG_TIME_SYNC */
 
+#ifdef DHD_DPC_SCHED
+static const char *dhd_dpc_ring_names[DHD_DPC_RING_MAX] = { "txcpl", "rxcpl", "infocpl" };
+
+static uint
+dhd_dpc_hist_bin(uint32 val)
+{
+	uint bin = 0;
+
+	while (val && bin < (DHD_DPC_HIST_BINS - 1)) {
+		val >>= 1;
+		bin++;
+	}
+
+	return bin;
+}
+
+static uint32
+dhd_dpc_max_bound(dhd_dpc_ring_t which)
+{
+	switch (which) {
+	case DHD_DPC_RING_TXCPL:
+		return dhd_txbound;
+	case DHD_DPC_RING_RXCPL:
+		return dhd_rxbound;
+	default:
+		return dhd_infobound;
+	}
+}
+
+/*
+ * Split the pass budget across the completion rings by expected work, the
+ * backlog left over from the last pass plus the recent arrivals, and turn
+ * each share into an item bound using the ring's measured cost per item.
+ * The configured bounds stay the upper limit of every ring.
+ */
+static void
+dhd_dpc_sched_bounds(dhd_bus_t *bus, uint32 budget_us)
+{
+	dhd_dpc_sched_t *sched = &bus->dpc_sched;
+	uint32 weight[DHD_DPC_RING_MAX];
+	uint32 total = 0;
+	int i;
+
+	for (i = 0; i < DHD_DPC_RING_MAX; i++) {
+		dhd_dpc_ring_sched_t *rs = &sched->ring[i];
+
+		weight[i] = rs->backlog + (rs->arrivals >> 4);
+		weight[i] = MAX(1, MIN(weight[i], DHD_DPC_MAX_WEIGHT));
+		total += weight[i];
+	}
+
+	for (i = 0; i < DHD_DPC_RING_MAX; i++) {
+		dhd_dpc_ring_sched_t *rs = &sched->ring[i];
+		uint32 max_bound = dhd_dpc_max_bound((dhd_dpc_ring_t)i);
+		uint32 share_ns;
+
+		if (budget_us == 0 || rs->cost_ns == 0) {
+			/* static bounds, or no cost measured yet */
+			rs->bound = max_bound;
+			continue;
+		}
+		share_ns = (budget_us * weight[i] / total) * 1000;
+		rs->bound = MIN(share_ns / rs->cost_ns, max_bound);
+		rs->bound = MAX(rs->bound, MIN(DHD_DPC_MIN_BOUND, max_bound));
+	}
+}
+
+/* Process one completion ring within its bound and account the service time */
+static bool
+dhd_dpc_sched_service(dhd_bus_t *bus, dhd_dpc_ring_t which, uint64 *now)
+{
+	dhd_dpc_ring_sched_t *rs = &bus->dpc_sched.ring[which];
+	uint64 start = *now;
+	uint32 items, backlog, n, arrived, svc_ns;
+	bool more;
+
+	switch (which) {
+	case DHD_DPC_RING_TXCPL:
+		/* With heavy TX traffic, we could get a lot of TxStatus
+		 * so add bound
+		 */
+		more = dhd_prot_process_msgbuf_txcpl(bus->dhd, rs->bound, DHD_REGULAR_RING);
+		*now = OSL_LOCALTIME_NS();
+		bus->last_process_txcpl_time = *now;
+		break;
+	case DHD_DPC_RING_RXCPL:
+		more = dhd_prot_process_msgbuf_rxcpl(bus->dhd, rs->bound, DHD_REGULAR_RING);
+		*now = OSL_LOCALTIME_NS();
+		bus->last_process_rxcpl_time = *now;
+		break;
+	default:
+#ifdef EWP_EDL
+		if (bus->dhd->dongle_edl_support) {
+			more = dhd_prot_process_msgbuf_edl(bus->dhd);
+			*now = OSL_LOCALTIME_NS();
+			bus->last_process_edl_time = *now;
+			break;
+		}
+#endif /* EWP_EDL */
+		/* Process info ring completion messages */
+		more = dhd_prot_process_msgbuf_infocpl(bus->dhd, rs->bound);
+		*now = OSL_LOCALTIME_NS();
+		bus->last_process_infocpl_time = *now;
+		break;
+	}
+
+	svc_ns = (uint32)MIN(*now - start, (uint64)0xFFFFFFFFu);
+	dhd_prot_dpc_ring_state(bus->dhd, which, &items, &backlog);
+	/* the prot counters restart when the protocol layer is reinitialized */
+	n = (items >= rs->items) ? (items - rs->items) : items;
+	arrived = (n + backlog > rs->backlog) ? (n + backlog - rs->backlog) : 0;
+	arrived = MIN(arrived, DHD_DPC_MAX_WEIGHT);
+
+	rs->arrivals = rs->arrivals - (rs->arrivals >> 3) + (arrived << 1);
+	if (n) {
+		uint32 cost_ns = svc_ns / n;
+
+		rs->cost_ns = rs->cost_ns ?
+			(rs->cost_ns - (rs->cost_ns >> 3) + (cost_ns >> 3)) : cost_ns;
+	}
+	rs->items = items;
+	rs->backlog = backlog;
+	rs->served++;
+	rs->svc_ns += svc_ns;
+	rs->svc_hist[dhd_dpc_hist_bin(svc_ns / 1000)]++;
+	rs->backlog_hist[dhd_dpc_hist_bin(backlog)]++;
+
+	return more;
+}
+
+/*
+ * Process the completion rings against the per pass time budget. Every pass
+ * serves at least one ring; once the budget is spent the remaining rings are
+ * left for the next pass, which starts with them, and the DPC is rescheduled
+ * so the kernel gets to run in between.
+ */
+static bool
+dhd_dpc_sched_run(dhd_bus_t *bus)
+{
+	dhd_dpc_sched_t *sched = &bus->dpc_sched;
+	uint32 budget_us = MIN(dhd_dpc_budget_us, DHD_DPC_MAX_BUDGET_US);
+	uint64 budget_ns = (uint64)budget_us * 1000;
+	uint64 start, now;
+	bool more = FALSE;
+	uint first = sched->first;
+	uint i;
+
+	dhd_dpc_sched_bounds(bus, budget_us);
+	sched->passes++;
+	sched->first = DHD_DPC_RING_TXCPL;
+
+	start = now = OSL_LOCALTIME_NS();
+	for (i = 0; i < DHD_DPC_RING_MAX; i++) {
+		dhd_dpc_ring_t which = (dhd_dpc_ring_t)((first + i) % DHD_DPC_RING_MAX);
+
+		if (budget_ns && i && (now - start) >= budget_ns) {
+			sched->first = which;
+			sched->yields++;
+			for (; i < DHD_DPC_RING_MAX; i++) {
+				sched->ring[(first + i) % DHD_DPC_RING_MAX].deferred++;
+			}
+			return TRUE;
+		}
+		more |= dhd_dpc_sched_service(bus, which, &now);
+	}
+
+	return more;
+}
+
+void
+dhd_bus_dpc_sched_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
+{
+	dhd_dpc_sched_t *sched = &dhdp->bus->dpc_sched;
+	int i, j;
+
+	bcm_bprintf(strbuf, "dpc_sched: budget %uus passes %u yields %u\n",
+		dhd_dpc_budget_us, sched->passes, sched->yields);
+	for (i = 0; i < DHD_DPC_RING_MAX; i++) {
+		dhd_dpc_ring_sched_t *rs = &sched->ring[i];
+
+		bcm_bprintf(strbuf, " %s: bound %u/%u arrivals %u cost %uns backlog %u"
+			" served %u deferred %u svc %lluus\n",
+			dhd_dpc_ring_names[i], rs->bound, dhd_dpc_max_bound((dhd_dpc_ring_t)i),
+			rs->arrivals >> 4, rs->cost_ns, rs->backlog, rs->served, rs->deferred,
+			(unsigned long long)DIV_U64_BY_U32(rs->svc_ns, NSEC_PER_USEC));
+		bcm_bprintf(strbuf, "  svc_us  log2:");
+		for (j = 0; j < DHD_DPC_HIST_BINS; j++) {
+			bcm_bprintf(strbuf, " %u", rs->svc_hist[j]);
+		}
+		bcm_bprintf(strbuf, "\n  backlog log2:");
+		for (j = 0; j < DHD_DPC_HIST_BINS; j++) {
+			bcm_bprintf(strbuf, " %u", rs->backlog_hist[j]);
+		}
+		bcm_bprintf(strbuf, "\n");
+	}
+}
+#endif /* DHD_DPC_SCHED */
+
 static bool
 dhdpci_bus_read_frames(dhd_bus_t *bus)
 {
@@ -10315,6 +10645,9 @@ dhdpci_bus_read_frames(dhd_bus_t *bus)
 	dhd_update_txflowrings(bus->dhd);
 	bus->last_process_flowring_time = OSL_LOCALTIME_NS();
 
+#ifdef DHD_DPC_SCHED
+	more |= dhd_dpc_sched_run(bus);
+#else
 	/* With heavy TX traffic, we could get a lot of TxStatus
 	 * so add bound
 	 */
@@ -10341,6 +10674,7 @@ dhdpci_bus_read_frames(dhd_bus_t *bus)
 		bus->last_process_edl_time = OSL_LOCALTIME_NS();
 	}
 #endif /* EWP_EDL */
+#endif /* DHD_DPC_SCHED */
 
 #ifdef IDLE_TX_FLOW_MGMT
 	if (bus->enable_idle_flowring_mgmt) {
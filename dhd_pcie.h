@@ -228,6 +228,31 @@ enum dhd_bus_low_power_state {
 	DHD_BUS_D3_ACK_RECIEVED,	/* D3 ACK recieved */
 };
 
+#ifdef DHD_DPC_SCHED
+#define DHD_DPC_HIST_BINS	12	/* log2 buckets: 0, 1, 2-3, ... >= 1024 */
+
+/* DPC scheduling state of one D2H completion ring */
+typedef struct dhd_dpc_ring_sched {
+	uint32 bound;		/* items granted on the current pass */
+	uint32 arrivals;	/* EWMA of items landing between passes, x16 */
+	uint32 cost_ns;		/* EWMA of service time per item */
+	uint32 backlog;		/* items left on the ring after the last pass */
+	uint32 items;		/* prot item count after the last pass */
+	uint32 served;		/* passes that processed this ring */
+	uint32 deferred;	/* passes that ran out of budget before this ring */
+	uint64 svc_ns;		/* total service time */
+	uint32 svc_hist[DHD_DPC_HIST_BINS];	/* service time per pass, usec */
+	uint32 backlog_hist[DHD_DPC_HIST_BINS];	/* backlog left per pass, items */
+} dhd_dpc_ring_sched_t;
+
+typedef struct dhd_dpc_sched {
+	dhd_dpc_ring_sched_t ring[DHD_DPC_RING_MAX];
+	uint32 passes;
+	uint32 yields;		/* passes cut short by the time budget */
+	uint8 first;		/* ring served first on the next pass */
+} dhd_dpc_sched_t;
+#endif /* DHD_DPC_SCHED */
+
 /** Instantiated once for each hardware (dongle) instance that this DHD manages */
 typedef struct dhd_bus {
 	dhd_pub_t	*dhd;	/**< pointer to per hardware (dongle) unique instance */
@@ -492,6 +517,12 @@ typedef struct dhd_bus {
 	uint32 inb_dw_deassert_cnt;
 	uint64 arm_oor_time;
 	uint64 rd_shared_pass_time;
+#ifdef DHD_DPC_SCHED
+	dhd_dpc_sched_t dpc_sched;
+#endif /* DHD_DPC_SCHED */
+#ifdef SI_EROM_CACHE
+	uint32 attach_us;	/* last dongle attach time */
+#endif /* SI_EROM_CACHE */
 } dhd_bus_t;
 
 #ifdef DHD_MSI_SUPPORT
@@ -0,0 +1,462 @@
+/*
+ * DHD host side compiled packet pattern filter
+ *
+ * Copyright (C) 2020, Broadcom.
+ *
+ *      Unless you and Broadcom execute a separate written software license
+ * agreement governing use of this software, this software is licensed to you
+ * under the terms of the GNU General Public License version 2 (the "GPL"),
+ * available at http://www.broadcom.com/licenses/GPLv2.php, with the
+ * following added to such license:
+ *
+ *      As a special exception, the copyright holders of this software give you
+ * permission to link this software with independent modules, and to copy and
+ * distribute the resulting executable under terms of your choice, provided that
+ * you also meet, for each linked independent module, the terms and conditions of
+ * the license of that module.  An independent module is a module which is not
+ * derived from this software.  The special exception does not apply to any
+ * modifications of the software.
+ *
+ *
+ * <<Broadcom-WL-IPTag/Open:>>
+ *
+ * $Id$
+ */
+
+#include <typedefs.h>
+#include <osl.h>
+#include <bcmutils.h>
+#include <dhd_pktfilter_prog.h>
+
+/* Per filter word sequence used while compiling */
+typedef struct dhd_pfprog_seq {
+	uint32 id;
+	uint16 first;		/* first word in the scratch word array */
+	uint16 n_words;
+	uint16 lcp;		/* words shared with the previous emitted filter */
+	uint16 start;		/* first instruction emitted for this filter */
+	bool emitted;
+} dhd_pfprog_seq_t;
+
+/* Load up to 8 packet bytes into a word; byte order is irrelevant since mask
+ * and pattern go through the same load at compile time.
+ */
+static INLINE uint64
+dhd_pfprog_load(const uint8 *p, uint8 width)
+{
+	uint64 w = 0;
+
+	if (width == DHD_PFPROG_WORD_LEN) {
+		memcpy(&w, p, DHD_PFPROG_WORD_LEN);
+	} else {
+		memcpy(&w, p, width);
+	}
+
+	return w;
+}
+
+static int
+dhd_pfprog_word_cmp(const dhd_pfprog_insn_t *a, const dhd_pfprog_insn_t *b)
+{
+	if (a->offset != b->offset) {
+		return (a->offset < b->offset) ? -1 : 1;
+	}
+	if (a->width != b->width) {
+		return (a->width < b->width) ? -1 : 1;
+	}
+	if (a->mask != b->mask) {
+		return (a->mask < b->mask) ? -1 : 1;
+	}
+	if (a->value != b->value) {
+		return (a->value < b->value) ? -1 : 1;
+	}
+	return 0;
+}
+
+/* Returns the number of leading words two sequences have in common */
+static uint16
+dhd_pfprog_seq_lcp(const dhd_pfprog_insn_t *words,
+	const dhd_pfprog_seq_t *a, const dhd_pfprog_seq_t *b)
+{
+	uint16 i;
+	uint16 n = MIN(a->n_words, b->n_words);
+
+	for (i = 0; i < n; i++) {
+		if (dhd_pfprog_word_cmp(&words[a->first + i], &words[b->first + i])) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+/* Lexicographic order on the word sequences, a prefix sorts first */
+static int
+dhd_pfprog_seq_cmp(const dhd_pfprog_insn_t *words,
+	const dhd_pfprog_seq_t *a, const dhd_pfprog_seq_t *b)
+{
+	uint16 lcp = dhd_pfprog_seq_lcp(words, a, b);
+
+	if (lcp < a->n_words && lcp < b->n_words) {
+		return dhd_pfprog_word_cmp(&words[a->first + lcp], &words[b->first + lcp]);
+	}
+	if (a->n_words != b->n_words) {
+		return (a->n_words < b->n_words) ? -1 : 1;
+	}
+	/* identical patterns: keep the lower id first */
+	return (a->id < b->id) ? -1 : ((a->id > b->id) ? 1 : 0);
+}
+
+dhd_pfprog_t *
+dhd_pfprog_alloc(osl_t *osh, uint16 max_insn)
+{
+	dhd_pfprog_t *prog;
+
+	prog = (dhd_pfprog_t *)MALLOCZ(osh, DHD_PFPROG_ALLOC_LEN(max_insn));
+	if (prog == NULL) {
+		return NULL;
+	}
+	prog->max_insn = max_insn;
+
+	return prog;
+}
+
+void
+dhd_pfprog_free(osl_t *osh, dhd_pfprog_t *prog)
+{
+	if (prog) {
+		MFREE(osh, prog, DHD_PFPROG_ALLOC_LEN(prog->max_insn));
+	}
+}
+
+/*
+ * Compile the filter list into prog. Filters with a zero id are skipped.
+ * A filter whose pattern has bits outside of its mask can never match and is
+ * dropped. On error prog is left empty (matches nothing).
+ */
+int
+dhd_pfprog_compile(osl_t *osh, dhd_pfprog_t *prog, const dhd_pfprog_ent_t *ents, uint n_ents)
+{
+	dhd_pfprog_insn_t *words = NULL;
+	dhd_pfprog_seq_t *seqs = NULL;
+	uint16 *order = NULL;
+	uint32 total_words = 0;
+	uint32 words_len = 0, seqs_len = 0, order_len = 0;
+	uint16 n_seqs = 0;
+	uint16 n = 0;
+	uint16 w, d;
+	int prev = -1;
+	uint i, j;
+	int ret = BCME_OK;
+
+	if (prog == NULL || (n_ents && ents == NULL)) {
+		return BCME_BADARG;
+	}
+
+	prog->n_insn = 0;
+	prog->n_filters = 0;
+
+	if (n_ents == 0) {
+		return BCME_OK;
+	}
+
+	for (i = 0; i < n_ents; i++) {
+		if ((ents[i].offset + ents[i].size_bytes) > DHD_PFPROG_END) {
+			return BCME_BADARG;
+		}
+		total_words += MAX(1u, DHD_PFPROG_WORDS(ents[i].size_bytes));
+	}
+	if (total_words > DHD_PFPROG_END) {
+		return BCME_BADARG;
+	}
+
+	words_len = total_words * sizeof(*words);
+	seqs_len = n_ents * sizeof(*seqs);
+	order_len = n_ents * sizeof(*order);
+	words = (dhd_pfprog_insn_t *)MALLOCZ(osh, words_len);
+	seqs = (dhd_pfprog_seq_t *)MALLOCZ(osh, seqs_len);
+	order = (uint16 *)MALLOCZ(osh, order_len);
+	if (words == NULL || seqs == NULL || order == NULL) {
+		ret = BCME_NOMEM;
+		goto exit;
+	}
+
+	/* Split every filter into masked 64 bit words */
+	w = 0;
+	for (i = 0; i < n_ents; i++) {
+		const dhd_pfprog_ent_t *ent = &ents[i];
+		dhd_pfprog_seq_t *seq = &seqs[n_seqs];
+		bool dead = FALSE;
+		uint32 pos;
+
+		if (ent->id == DHD_PFPROG_NOMATCH) {
+			continue;
+		}
+
+		seq->id = ent->id;
+		seq->first = w;
+		seq->n_words = 0;
+
+		pos = 0;
+		do {
+			dhd_pfprog_insn_t *word = &words[w + seq->n_words];
+			uint8 width = (uint8)MIN(DHD_PFPROG_WORD_LEN, ent->size_bytes - pos);
+			uint64 pattern;
+
+			word->offset = (uint16)(ent->offset + pos);
+			word->width = width;
+			word->mask = dhd_pfprog_load(&ent->mask[pos], width);
+			pattern = dhd_pfprog_load(&ent->pattern[pos], width);
+			if (pattern & ~word->mask) {
+				dead = TRUE;
+			}
+			word->value = pattern & word->mask;
+			seq->n_words++;
+			pos += width;
+		} while (pos < ent->size_bytes);
+
+		if (dead) {
+			continue;
+		}
+
+		w += seq->n_words;
+		order[n_seqs] = n_seqs;
+		n_seqs++;
+	}
+
+	/* Sort so filters with common leading words are adjacent */
+	for (i = 1; i < n_seqs; i++) {
+		uint16 cur = order[i];
+
+		for (j = i; j > 0 &&
+			dhd_pfprog_seq_cmp(words, &seqs[order[j - 1]], &seqs[cur]) > 0; j--) {
+			order[j] = order[j - 1];
+		}
+		order[j] = cur;
+	}
+
+	/* Emit each filter's words, skipping those shared with the previous one */
+	for (i = 0; i < n_seqs; i++) {
+		dhd_pfprog_seq_t *seq = &seqs[order[i]];
+
+		seq->lcp = (prev < 0) ? 0 : dhd_pfprog_seq_lcp(words, &seqs[prev], seq);
+		if (prev >= 0 && seq->lcp == seqs[prev].n_words) {
+			/* previous filter is a prefix of this one and matches first */
+			continue;
+		}
+
+		if ((n + seq->n_words - seq->lcp) > prog->max_insn) {
+			ret = BCME_NOMEM;
+			goto exit;
+		}
+
+		seq->start = n;
+		seq->emitted = TRUE;
+		for (d = seq->lcp; d < seq->n_words; d++) {
+			prog->insn[n] = words[seq->first + d];
+			prog->insn[n].fail = DHD_PFPROG_END;
+			prog->insn[n].id = (d == (seq->n_words - 1)) ? (uint16)seq->id : 0;
+			n++;
+		}
+		prog->n_filters++;
+		prev = order[i];
+	}
+
+	/*
+	 * On a mismatch at depth d, continue with the first following filter
+	 * that shares at most d leading words with this one; every filter in
+	 * between shares the failed word and would fail the same way.
+	 */
+	for (i = 0; i < n_seqs; i++) {
+		dhd_pfprog_seq_t *seq = &seqs[order[i]];
+
+		if (!seq->emitted) {
+			continue;
+		}
+		for (d = seq->lcp; d < seq->n_words; d++) {
+			for (j = i + 1; j < n_seqs; j++) {
+				dhd_pfprog_seq_t *next = &seqs[order[j]];
+
+				if (next->emitted && next->lcp <= d) {
+					prog->insn[seq->start + d - seq->lcp].fail = next->start;
+					break;
+				}
+			}
+		}
+	}
+
+	prog->n_insn = n;
+
+exit:
+	if (ret != BCME_OK) {
+		prog->n_insn = 0;
+		prog->n_filters = 0;
+	}
+	if (order) {
+		MFREE(osh, order, order_len);
+	}
+	if (seqs) {
+		MFREE(osh, seqs, seqs_len);
+	}
+	if (words) {
+		MFREE(osh, words, words_len);
+	}
+
+	return ret;
+}
+
+/*
+ * Run the compiled program over a packet. Returns the id of a matching filter
+ * or DHD_PFPROG_NOMATCH. Words running past pktlen never match.
+ */
+uint32
+dhd_pfprog_match(const dhd_pfprog_t *prog, const uint8 *pkt, uint32 pktlen)
+{
+	const dhd_pfprog_insn_t *insn;
+	uint32 last_off = DHD_PFPROG_END;
+	uint8 last_width = 0;
+	uint64 word = 0;
+	uint16 i = 0;
+
+	while (i < prog->n_insn) {
+		insn = &prog->insn[i];
+
+		if ((uint32)(insn->offset + insn->width) <= pktlen) {
+			/* sibling words at the same offset reuse the loaded word */
+			if (insn->offset != last_off || insn->width != last_width) {
+				word = dhd_pfprog_load(&pkt[insn->offset], insn->width);
+				last_off = insn->offset;
+				last_width = insn->width;
+			}
+			if ((word & insn->mask) == insn->value) {
+				if (insn->id) {
+					return insn->id;
+				}
+				i++;
+				continue;
+			}
+		}
+		i = insn->fail;
+	}
+
+	return DHD_PFPROG_NOMATCH;
+}
+
+/* Same check as the compiled program, one filter and one byte at a time */
+static uint32
+dhd_pfprog_ref_match(const dhd_pfprog_ent_t *ents, uint n_ents,
+	const uint8 *pkt, uint32 pktlen)
+{
+	uint i, j;
+
+	for (i = 0; i < n_ents; i++) {
+		const dhd_pfprog_ent_t *ent = &ents[i];
+
+		if ((ent->offset + ent->size_bytes) > pktlen) {
+			continue;
+		}
+		for (j = 0; j < ent->size_bytes; j++) {
+			if ((ent->mask[j] & pkt[ent->offset + j]) != ent->pattern[j]) {
+				break;
+			}
+		}
+		if (j == ent->size_bytes) {
+			return ent->id;
+		}
+	}
+
+	return DHD_PFPROG_NOMATCH;
+}
+
+/*
+ * Time the compiled program against the per byte loop for n_filters synthetic
+ * filters. Every filter is 24 bytes long and shares a 20 byte prefix with the
+ * others, and the packet matches the prefix but none of the filters, so both
+ * sides walk the whole filter set. Total ns for iters packets are returned in
+ * prog_ns and ref_ns.
+ */
+int
+dhd_pfprog_bench(osl_t *osh, uint n_filters, uint iters, uint64 *prog_ns, uint64 *ref_ns)
+{
+	dhd_pfprog_ent_t *ents = NULL;
+	dhd_pfprog_t *prog = NULL;
+	uint8 *bytes = NULL;
+	uint8 pkt[DHD_PFPROG_BENCH_PKT_LEN];
+	uint32 ents_len = 0, bytes_len = 0;
+	volatile uint32 sink = 0;
+	uint64 start;
+	uint i, j;
+	int ret = BCME_OK;
+
+	if (n_filters == 0 || n_filters > DHD_PFPROG_BENCH_MAX_FILTERS ||
+		iters == 0 || prog_ns == NULL || ref_ns == NULL) {
+		return BCME_BADARG;
+	}
+
+	ents_len = n_filters * sizeof(*ents);
+	bytes_len = n_filters * DHD_PFPROG_BENCH_PATTERN_LEN * 2u;
+	ents = (dhd_pfprog_ent_t *)MALLOCZ(osh, ents_len);
+	bytes = (uint8 *)MALLOCZ(osh, bytes_len);
+	prog = dhd_pfprog_alloc(osh,
+		(uint16)(n_filters * DHD_PFPROG_WORDS(DHD_PFPROG_BENCH_PATTERN_LEN)));
+	if (ents == NULL || bytes == NULL || prog == NULL) {
+		ret = BCME_NOMEM;
+		goto exit;
+	}
+
+	for (i = 0; i < n_filters; i++) {
+		uint8 *mask = &bytes[i * DHD_PFPROG_BENCH_PATTERN_LEN * 2u];
+		uint8 *pattern = mask + DHD_PFPROG_BENCH_PATTERN_LEN;
+
+		memset(mask, 0xff, DHD_PFPROG_BENCH_PATTERN_LEN);
+		for (j = 0; j < DHD_PFPROG_BENCH_PREFIX_LEN; j++) {
+			pattern[j] = (uint8)(0xa0u + j);
+		}
+		/* distinct tails, none of them all ones */
+		pattern[DHD_PFPROG_BENCH_PATTERN_LEN - 1u] = (uint8)(i + 1u);
+
+		ents[i].id = i + 1u;
+		ents[i].offset = DHD_PFPROG_BENCH_OFFSET;
+		ents[i].size_bytes = DHD_PFPROG_BENCH_PATTERN_LEN;
+		ents[i].mask = mask;
+		ents[i].pattern = pattern;
+	}
+
+	ret = dhd_pfprog_compile(osh, prog, ents, n_filters);
+	if (ret != BCME_OK) {
+		goto exit;
+	}
+
+	memset(pkt, 0xff, sizeof(pkt));
+	for (j = 0; j < DHD_PFPROG_BENCH_PREFIX_LEN; j++) {
+		pkt[DHD_PFPROG_BENCH_OFFSET + j] = (uint8)(0xa0u + j);
+	}
+
+	start = OSL_LOCALTIME_NS();
+	for (i = 0; i < iters; i++) {
+		sink += dhd_pfprog_match(prog, pkt, sizeof(pkt));
+	}
+	*prog_ns = OSL_LOCALTIME_NS() - start;
+
+	start = OSL_LOCALTIME_NS();
+	for (i = 0; i < iters; i++) {
+		sink += dhd_pfprog_ref_match(ents, n_filters, pkt, sizeof(pkt));
+	}
+	*ref_ns = OSL_LOCALTIME_NS() - start;
+
+	/* both sides must agree that nothing matched */
+	if (sink != DHD_PFPROG_NOMATCH) {
+		ret = BCME_ERROR;
+	}
+
+exit:
+	dhd_pfprog_free(osh, prog);
+	if (bytes) {
+		MFREE(osh, bytes, bytes_len);
+	}
+	if (ents) {
+		MFREE(osh, ents, ents_len);
+	}
+
+	return ret;
+}
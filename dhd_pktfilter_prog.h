@@ -0,0 +1,93 @@
+/*
+ * DHD host side compiled packet pattern filter
+ *
+ * Copyright (C) 2020, Broadcom.
+ *
+ *      Unless you and Broadcom execute a separate written software license
+ * agreement governing use of this software, this software is licensed to you
+ * under the terms of the GNU General Public License version 2 (the "GPL"),
+ * available at http://www.broadcom.com/licenses/GPLv2.php, with the
+ * following added to such license:
+ *
+ *      As a special exception, the copyright holders of this software give you
+ * permission to link this software with independent modules, and to copy and
+ * distribute the resulting executable under terms of your choice, provided that
+ * you also meet, for each linked independent module, the terms and conditions of
+ * the license of that module.  An independent module is a module which is not
+ * derived from this software.  The special exception does not apply to any
+ * modifications of the software.
+ *
+ *
+ * <<Broadcom-WL-IPTag/Open:>>
+ *
+ * $Id$
+ */
+
+#ifndef __DHD_PKTFILTER_PROG_H_
+#define __DHD_PKTFILTER_PROG_H_
+
+#include <typedefs.h>
+#include <osl.h>
+
+/*
+ * A set of (offset, mask, pattern) filters is compiled into a flat program of
+ * 64 bit compare instructions. Filters are sorted so that filters sharing the
+ * same leading words share the same instructions, which are then evaluated
+ * only once per packet. Each instruction carries the index to continue at on
+ * mismatch, so the whole filter set is matched in a single forward pass.
+ */
+
+#define DHD_PFPROG_WORD_LEN		8u	/* bytes compared per instruction */
+#define DHD_PFPROG_END			0xFFFFu	/* no further instruction */
+#define DHD_PFPROG_NOMATCH		0u	/* filter ids start at 1 */
+
+/* Filter description handed to the compiler */
+typedef struct dhd_pfprog_ent {
+	uint32 id;		/* non-zero id reported on match */
+	uint32 offset;		/* packet offset of the pattern */
+	uint32 size_bytes;	/* size of mask and pattern */
+	const uint8 *mask;
+	const uint8 *pattern;
+} dhd_pfprog_ent_t;
+
+typedef struct dhd_pfprog_insn {
+	uint64 mask;
+	uint64 value;		/* pattern, pre-masked */
+	uint16 offset;		/* packet offset of this word */
+	uint8 width;		/* valid bytes in this word, 1..8 */
+	uint8 PAD;
+	uint16 fail;		/* next instruction on mismatch */
+	uint16 id;		/* filter id if this is the last word, else 0 */
+} dhd_pfprog_insn_t;
+
+typedef struct dhd_pfprog {
+	uint16 max_insn;	/* allocated instructions */
+	uint16 n_insn;		/* instructions in use */
+	uint16 n_filters;	/* filters compiled in */
+	uint16 PAD;
+	dhd_pfprog_insn_t insn[];
+} dhd_pfprog_t;
+
+#define DHD_PFPROG_WORDS(size_bytes) \
+	(((size_bytes) + DHD_PFPROG_WORD_LEN - 1u) / DHD_PFPROG_WORD_LEN)
+#define DHD_PFPROG_ALLOC_LEN(max_insn) \
+	(sizeof(dhd_pfprog_t) + ((max_insn) * sizeof(dhd_pfprog_insn_t)))
+
+extern dhd_pfprog_t *dhd_pfprog_alloc(osl_t *osh, uint16 max_insn);
+extern void dhd_pfprog_free(osl_t *osh, dhd_pfprog_t *prog);
+extern int dhd_pfprog_compile(osl_t *osh, dhd_pfprog_t *prog,
+	const dhd_pfprog_ent_t *ents, uint n_ents);
+extern uint32 dhd_pfprog_match(const dhd_pfprog_t *prog, const uint8 *pkt, uint32 pktlen);
+
+/* Synthetic filter set used by dhd_pfprog_bench() */
+#define DHD_PFPROG_BENCH_MAX_FILTERS	64u
+#define DHD_PFPROG_BENCH_PATTERN_LEN	24u
+#define DHD_PFPROG_BENCH_PREFIX_LEN	20u	/* leading bytes shared by all filters */
+#define DHD_PFPROG_BENCH_OFFSET		14u	/* right after the ethernet header */
+#define DHD_PFPROG_BENCH_PKT_LEN	64u
+#define DHD_PFPROG_BENCH_ITERS		10000u
+
+extern int dhd_pfprog_bench(osl_t *osh, uint n_filters, uint iters,
+	uint64 *prog_ns, uint64 *ref_ns);
+
+#endif /* __DHD_PKTFILTER_PROG_H_ */
@@ -128,6 +128,8 @@ static int dhd_cpkt_log_init_tt(dhd_pub_t *dhdp);
 static void dhd_cpkt_log_deinit_tt(dhd_pub_t *dhdp);
 #endif	/* DHD_COMPACT_PKT_LOG */
 
+static int dhd_pktlog_filter_compile_cnt(dhd_pktlog_filter_t *filter, uint32 list_cnt);
+
 int
 dhd_os_attach_pktlog(dhd_pub_t *dhdp)
 {
@@ -336,8 +338,8 @@ dhd_pktlog_ring_add_pkts(dhd_pub_t *dhdp, void *pkt, uint32 pktid, bool directio
 	    pktlog_case = PKTLOG_RXPKT_CASE;
 	}
 
-	if (dhd_pktlog_filter_matched(pktlog_filter, pktdata, pktlog_case)
-		== FALSE) {
+	if (dhd_pktlog_filter_matched(pktlog_filter, pktdata,
+		PKTLEN(dhdp->osh, pkt), pktlog_case) == FALSE) {
 	    return BCME_OK;
 	}
 
@@ -414,7 +416,7 @@ dhd_pktlog_ring_tx_status(dhd_pub_t *dhdp, void *pkt, uint32 pktid,
 
 	pktdata = (uint8 *)PKTDATA(dhdp->osh, pkt);
 	if (dhd_pktlog_filter_matched(pktlog_filter, pktdata,
-		PKTLOG_TXSTATUS_CASE) == FALSE) {
+		PKTLEN(dhdp->osh, pkt), PKTLOG_TXSTATUS_CASE) == FALSE) {
 		return BCME_OK;
 	}
 
@@ -475,6 +477,16 @@ dhd_pktlog_filter_init(int size)
 	filter->info = filter_info;
 	filter->list_cnt = 0;
 
+	for (i = 0; i < ARRAYSIZE(filter->prog_buf); i++) {
+		filter->prog_buf[i] = dhd_pfprog_alloc(NULL, MAX_DHD_PKTLOG_FILTER_INSN);
+		if (unlikely(!filter->prog_buf[i])) {
+			DHD_ERROR(("%s(): could not allocate memory for - "
+						"dhd_pfprog_t\n", __FUNCTION__));
+			goto fail;
+		}
+	}
+	RCU_INIT_POINTER(filter->prog, filter->prog_buf[0]);
+
 	for (i = 0; i < MAX_DHD_PKTLOG_FILTER_LEN; i++) {
 		filter->info[i].id = 0;
 	}
@@ -486,8 +498,14 @@ dhd_pktlog_filter_init(int size)
 	return filter;
 fail:
 	if (filter) {
+		for (i = 0; i < ARRAYSIZE(filter->prog_buf); i++) {
+			dhd_pfprog_free(NULL, filter->prog_buf[i]);
+		}
 		kfree(filter);
 	}
+	if (filter_info) {
+		kfree(filter_info);
+	}
 
 	return NULL;
 }
@@ -496,12 +514,18 @@ int
 dhd_pktlog_filter_deinit(dhd_pktlog_filter_t *filter)
 {
 	int ret = BCME_OK;
+	int i;
 
 	if (!filter) {
 		DHD_ERROR(("%s(): filter is NULL\n", __FUNCTION__));
 		return -EINVAL;
 	}
 
+	/* no reader may still be matching against either copy */
+	synchronize_rcu();
+	for (i = 0; i < ARRAYSIZE(filter->prog_buf); i++) {
+		dhd_pfprog_free(NULL, filter->prog_buf[i]);
+	}
 	if (filter->info) {
 		kfree(filter->info);
 	}
@@ -577,6 +601,7 @@ dhd_pktlog_filter_add(dhd_pktlog_filter_t *filter, char *arg)
 	int32 mask_size, pattern_size;
 	char *offset, *bitmask, *pattern;
 	uint32 id = 0;
+	int ret;
 
 	if  (!filter || !arg) {
 		DHD_ERROR(("%s(): pktlog_filter =%p arg =%p\n", __FUNCTION__, filter, arg));
@@ -643,6 +668,13 @@ dhd_pktlog_filter_add(dhd_pktlog_filter_t *filter, char *arg)
 	filter->info[filter->list_cnt].id = filter->list_cnt + 1;
 	filter->info[filter->list_cnt].enable = TRUE;
 
+	/* the new entry only counts once the program holding it is published */
+	ret = dhd_pktlog_filter_compile_cnt(filter, filter->list_cnt + 1);
+	if (ret != BCME_OK) {
+		bzero(&filter->info[filter->list_cnt], sizeof(dhd_pktlog_filter_info_t));
+		return ret;
+	}
+
 	filter->list_cnt++;
 
 	return BCME_OK;
@@ -669,7 +701,7 @@ dhd_pktlog_filter_del(dhd_pktlog_filter_t *filter, char *arg)
 
 	filter->list_cnt--;
 
-	return BCME_OK;
+	return dhd_pktlog_filter_compile(filter);
 }
 
 int
@@ -706,6 +738,7 @@ dhd_pktlog_filter_pattern_enable(dhd_pktlog_filter_t *filter, char *arg, uint32
 			filter->info[id-1].enable = enable;
 			DHD_ERROR(("%s(): This pattern id %d is %s\n",
 				__FUNCTION__, id, (enable ? "enabled" : "disabled")));
+			return dhd_pktlog_filter_compile(filter);
 		}
 	} else {
 		DHD_ERROR(("%s(): This pattern is not existed\n", __FUNCTION__));
@@ -719,6 +752,7 @@ int
 dhd_pktlog_filter_info(dhd_pktlog_filter_t *filter)
 {
 	char filter_pattern[MAX_FILTER_PATTERN_LEN];
+	dhd_pfprog_t *prog;
 	char *p;
 	int i, j;
 	int nchar;
@@ -729,10 +763,15 @@ dhd_pktlog_filter_info(dhd_pktlog_filter_t *filter)
 		return BCME_ERROR;
 	}
 
+	/* updates come from the same private command context */
+	prog = rcu_dereference_protected(filter->prog, 1);
+
 	DHD_ERROR(("---- PKTLOG FILTER INFO ----\n\n"));
 
 	DHD_ERROR(("Filter list cnt %d Filter is %s\n",
 		filter->list_cnt, (filter->enable ? "enabled" : "disabled")));
+	DHD_ERROR(("Compiled to %d insn for %d filters\n",
+		prog->n_insn, prog->n_filters));
 
 	for (i = 0; i < filter->list_cnt; i++) {
 		p = filter_pattern;
@@ -771,16 +810,71 @@ dhd_pktlog_filter_info(dhd_pktlog_filter_t *filter)
 
 	return BCME_OK;
 }
+
+/*
+ * Rebuild the first list_cnt filters into the idle program copy and publish
+ * them, so a packet being matched concurrently keeps a consistent program.
+ * Waits for a grace period before returning, so the copy just retired has no
+ * readers left when the next update compiles into it. On failure the
+ * published program is left as it was. Called from process context only,
+ * with updates serialized by the private command path.
+ */
+static int
+dhd_pktlog_filter_compile_cnt(dhd_pktlog_filter_t *filter, uint32 list_cnt)
+{
+	dhd_pfprog_ent_t ents[MAX_DHD_PKTLOG_FILTER_LEN];
+	dhd_pfprog_t *prog;
+	dhd_pfprog_t *cur;
+	uint32 n_ents = 0;
+	uint32 i;
+	int ret;
+
+	for (i = 0; i < list_cnt; i++) {
+		if (filter->info[i].id && filter->info[i].enable) {
+			ents[n_ents].id = filter->info[i].id;
+			ents[n_ents].offset = filter->info[i].offset;
+			ents[n_ents].size_bytes = filter->info[i].size_bytes;
+			ents[n_ents].mask = &filter->info[i].mask[0];
+			ents[n_ents].pattern = &filter->info[i].pattern[0];
+			n_ents++;
+		}
+	}
+
+	cur = rcu_dereference_protected(filter->prog, 1);
+	prog = (cur == filter->prog_buf[0]) ? filter->prog_buf[1] : filter->prog_buf[0];
+	ret = dhd_pfprog_compile(NULL, prog, ents, n_ents);
+	if (ret != BCME_OK) {
+		DHD_ERROR(("%s(): filter compile failed %d\n", __FUNCTION__, ret));
+		return ret;
+	}
+
+	rcu_assign_pointer(filter->prog, prog);
+	/* matchers still on the old copy finish before it can be rebuilt */
+	synchronize_rcu();
+
+	DHD_PKT_LOG(("%s(): %d filters compiled to %d insn\n",
+		__FUNCTION__, prog->n_filters, prog->n_insn));
+
+	return BCME_OK;
+}
+
+int
+dhd_pktlog_filter_compile(dhd_pktlog_filter_t *filter)
+{
+	if (!filter) {
+		DHD_ERROR(("%s(): filter is NULL\n", __FUNCTION__));
+		return BCME_ERROR;
+	}
+
+	return dhd_pktlog_filter_compile_cnt(filter, filter->list_cnt);
+}
+
 bool
-dhd_pktlog_filter_matched(dhd_pktlog_filter_t *filter, char *data, uint32 pktlog_case)
+dhd_pktlog_filter_matched(dhd_pktlog_filter_t *filter, char *data, uint32 len,
+	uint32 pktlog_case)
 {
-	uint16 szbts;	/* pattern size */
-	uint16 offset;	/* pattern offset */
-	int i, j;
-	uint8 *mask = NULL;		/* bitmask */
-	uint8 *pattern = NULL;
-	uint8 *pkt_offset = NULL;	/* packet offset */
-	bool matched;
+	dhd_pfprog_t *prog;
+	uint32 id;
 
 	if  (!filter || !data) {
 		DHD_PKT_LOG(("%s(): filter=%p data=%p\n",
@@ -794,31 +888,14 @@ dhd_pktlog_filter_matched(dhd_pktlog_filter_t *filter, char *data, uint32 pktlog
 		return TRUE;
 	}
 
-	for (i = 0; i < filter->list_cnt; i++) {
-		if (&filter->info[i] && filter->info[i].id && filter->info[i].enable) {
-			szbts = filter->info[i].size_bytes;
-			offset = filter->info[i].offset;
-			mask = &filter->info[i].mask[0];
-			pkt_offset = &data[offset];
-			pattern = &filter->info[i].pattern[0];
-
-			matched = TRUE;
-			for (j = 0; j < szbts; j++) {
-				if ((mask[j] & pkt_offset[j]) != pattern[j]) {
-					matched = FALSE;
-					break;
-				}
-			}
-
-			if (matched) {
-				DHD_PKT_LOG(("%s(): pktlog_filter return TRUE id %d\n",
-					__FUNCTION__, filter->info[i].id));
-				return TRUE;
-			}
-		} else {
-			DHD_PKT_LOG(("%s(): filter ino is null %p\n",
-				__FUNCTION__, &filter->info[i]));
-		}
+	rcu_read_lock();
+	prog = rcu_dereference(filter->prog);
+	id = dhd_pfprog_match(prog, (uint8 *)data, len);
+	rcu_read_unlock();
+	if (id != DHD_PFPROG_NOMATCH) {
+		DHD_PKT_LOG(("%s(): pktlog_filter return TRUE id %d\n",
+			__FUNCTION__, id));
+		return TRUE;
 	}
 
 	return FALSE;
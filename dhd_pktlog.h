@@ -28,7 +28,9 @@
 
 #include <dhd_debug.h>
 #include <dhd.h>
+#include <linux/rcupdate.h>
 #include <asm/atomic.h>
+#include <dhd_pktfilter_prog.h>
 #ifdef DHD_COMPACT_PKT_LOG
 #include <linux/rbtree.h>
 #endif	/* DHD_COMPACT_PKT_LOG */
@@ -42,6 +44,9 @@
 #define PKTLOG_TXPKT_CASE			0x0001
 #define PKTLOG_TXSTATUS_CASE		0x0002
 #define PKTLOG_RXPKT_CASE			0x0004
+/* Worst case compiled instructions for the pktlog filter list */
+#define MAX_DHD_PKTLOG_FILTER_INSN \
+	(MAX_DHD_PKTLOG_FILTER_LEN * DHD_PFPROG_WORDS(MAX_MASK_PATTERN_FILTER_LEN))
 /* MAX_FILTER_PATTERN_LEN is buf len to print bitmask/pattern with string */
 #define MAX_FILTER_PATTERN_LEN \
 	((MAX_MASK_PATTERN_FILTER_LEN * HD_BYTE_SIZE) + HD_PREFIX_SIZE + 1) * 2
@@ -97,6 +102,9 @@ typedef struct dhd_pktlog_filter
 	dhd_pktlog_filter_info_t *info;
 	uint32 list_cnt;
 	uint32 enable;
+	/* compiled form of info[], rebuilt into the idle copy on every change */
+	dhd_pfprog_t *prog_buf[2];
+	dhd_pfprog_t __rcu *prog;	/* copy in use by the data path */
 } dhd_pktlog_filter_t;
 
 typedef struct dhd_pktlog
@@ -142,6 +150,7 @@ extern int dhd_pktlog_ring_tx_status(dhd_pub_t *dhdp, void *pkt, uint32 pktid,
 extern dhd_pktlog_ring_t* dhd_pktlog_ring_change_size(dhd_pktlog_ring_t *ringbuf, int size);
 extern void dhd_pktlog_filter_pull_forward(dhd_pktlog_filter_t *filter,
 		uint32 del_filter_id, uint32 list_cnt);
+extern int dhd_pktlog_filter_compile(dhd_pktlog_filter_t *filter);
 
 #define PKT_TX 1
 #define PKT_RX 0
@@ -247,7 +256,8 @@ extern int dhd_pktlog_filter_del(dhd_pktlog_filter_t *filter, char *arg);
 extern int dhd_pktlog_filter_enable(dhd_pktlog_filter_t *filter, uint32 pktlog_case, uint32 enable);
 extern int dhd_pktlog_filter_pattern_enable(dhd_pktlog_filter_t *filter, char *arg, uint32 enable);
 extern int dhd_pktlog_filter_info(dhd_pktlog_filter_t *filter);
-extern bool dhd_pktlog_filter_matched(dhd_pktlog_filter_t *filter, char *data, uint32 pktlog_case);
+extern bool dhd_pktlog_filter_matched(dhd_pktlog_filter_t *filter, char *data, uint32 len,
+	uint32 pktlog_case);
 extern bool dhd_pktlog_filter_existed(dhd_pktlog_filter_t *filter, char *arg, uint32 *id);
 
 #define DHD_PKTLOG_FILTER_ADD(pattern, filter_pattern, dhdp)	\
@@ -87,6 +87,11 @@
 				} \
 			} while (0)
 #define PNO_GET_PNOSTATE(dhd) ((dhd_pno_status_info_t *)dhd->pno_state)
+#define PNO_BATCH_STATS_ALLOC(stats, len) \
+			do { \
+				(stats)->allocs++; \
+				(stats)->alloc_bytes += (len); \
+			} while (0)
 
 #define PNO_BESTNET_LEN		WLC_IOCTL_MEDLEN
 
@@ -307,10 +312,21 @@ dhd_gscan_clear_all_batch_results(dhd_pub_t *dhd)
 {
 	struct dhd_pno_gscan_params *gscan_params;
 	dhd_pno_status_info_t *_pno_state;
+#ifdef PNO_BATCH_ARENA
+	gscan_batch_arena_t *arena;
+#else
 	gscan_results_cache_t *iter;
+#endif /* PNO_BATCH_ARENA */
 
 	_pno_state = PNO_GET_PNOSTATE(dhd);
 	gscan_params = &_pno_state->pno_params_arr[INDEX_OF_GSCAN_PARAMS].params_gscan;
+#ifdef PNO_BATCH_ARENA
+	arena = gscan_params->gscan_batch_arena;
+	gscan_params->gscan_batch_arena = NULL;
+	if (arena) {
+		MFREE(dhd->osh, arena, arena->alloc_len);
+	}
+#else
 	iter = gscan_params->gscan_batch_cache;
 	/* Mark everything as consumed */
 	while (iter) {
@@ -318,6 +334,7 @@ dhd_gscan_clear_all_batch_results(dhd_pub_t *dhd)
 		iter = iter->next;
 	}
 	dhd_gscan_batch_cache_cleanup(dhd);
+#endif /* PNO_BATCH_ARENA */
 	return;
 }
 
@@ -777,6 +794,54 @@ _dhd_pno_get_channels(dhd_pub_t *dhd, uint16 *d_chan_list,
 	*nchan = j;
 	return err;
 }
+#ifdef PNO_BATCH_ARENA
+/* Headers and entries are carved from chunks owned by their scan results
+ * node, they are released together with it instead of one by one.
+ */
+static void
+_dhd_pno_free_scan_results(dhd_pub_t *dhd, dhd_pno_scan_results_t *scan_results)
+{
+	dhd_pno_batch_chunk_t *chunk, *next;
+
+	for (chunk = scan_results->chunks; chunk; chunk = next) {
+		next = chunk->next;
+		MFREE(dhd->osh, chunk, chunk->alloc_len);
+	}
+	MFREE(dhd->osh, scan_results, SCAN_RESULTS_SIZE);
+}
+
+/* Room for the entries of one pfnlbest read, and a header per entry at most */
+static dhd_pno_batch_chunk_t *
+_dhd_pno_batch_chunk_alloc(dhd_pub_t *dhd, dhd_pno_scan_results_t *scan_results, uint16 cnt)
+{
+	dhd_pno_batch_chunk_t *chunk;
+	uint32 len = BATCH_CHUNK_SIZE(cnt);
+
+	chunk = (dhd_pno_batch_chunk_t *)MALLOC(dhd->osh, len);
+	if (chunk == NULL) {
+		DHD_ERROR(("failed to allocate batch chunk of %d entries\n", cnt));
+		return NULL;
+	}
+	PNO_BATCH_STATS_ALLOC(&PNO_GET_PNOSTATE(dhd)->legacy_stats, len);
+	chunk->alloc_len = len;
+	chunk->nentries = 0;
+	chunk->nheaders = 0;
+	chunk->headers = (dhd_pno_best_header_t *)&chunk->entries[cnt];
+	chunk->next = scan_results->chunks;
+	scan_results->chunks = chunk;
+
+	return chunk;
+}
+
+#define PNO_BATCH_FREE_ENTRY(dhd, entry)	BCM_REFERENCE(entry)
+#define PNO_BATCH_FREE_HEADER(dhd, header)	BCM_REFERENCE(header)
+#define PNO_BATCH_FREE_RESULTS(dhd, results)	_dhd_pno_free_scan_results(dhd, results)
+#else
+#define PNO_BATCH_FREE_ENTRY(dhd, entry)	MFREE((dhd)->osh, entry, BESTNET_ENTRY_SIZE)
+#define PNO_BATCH_FREE_HEADER(dhd, header)	MFREE((dhd)->osh, header, BEST_HEADER_SIZE)
+#define PNO_BATCH_FREE_RESULTS(dhd, results)	MFREE((dhd)->osh, results, SCAN_RESULTS_SIZE)
+#endif /* PNO_BATCH_ARENA */
+
 static int
 _dhd_pno_convert_format(dhd_pub_t *dhd, struct dhd_pno_batch_params *params_batch,
 	char *buf, int nbufsize)
@@ -870,7 +935,7 @@ _dhd_pno_convert_format(dhd_pub_t *dhd, struct dhd_pno_batch_params *params_batc
 				bp += nreadsize = snprintf(bp, nleftsize, "%s", AP_END_MARKER);
 				nleftsize -= nreadsize;
 				list_del(&iter->list);
-				MFREE(dhd->osh, iter, BESTNET_ENTRY_SIZE);
+				PNO_BATCH_FREE_ENTRY(dhd, iter);
 #ifdef PNO_DEBUG
 				memcpy(msg, _base_bp, bp - _base_bp);
 				DHD_PNO(("Entry : \n%s", msg));
@@ -882,14 +947,14 @@ _dhd_pno_convert_format(dhd_pub_t *dhd, struct dhd_pno_batch_params *params_batc
 			pprev = phead;
 			/* reset the header */
 			siter->bestnetheader = phead = phead->next;
-			MFREE(dhd->osh, pprev, BEST_HEADER_SIZE);
+			PNO_BATCH_FREE_HEADER(dhd, pprev);
 
 			siter->cnt_header--;
 		}
 		if (phead == NULL) {
 			/* we store all entry in this scan , so it is ok to delete */
 			list_del(&siter->list);
-			MFREE(dhd->osh, siter, SCAN_RESULTS_SIZE);
+			PNO_BATCH_FREE_RESULTS(dhd, siter);
 		}
 	}
 exit:
@@ -942,16 +1007,16 @@ _dhd_pno_clear_all_batch_results(dhd_pub_t *dhd, struct list_head *head, bool on
 			list_for_each_entry_safe(iter, next,
 			&phead->entry_list, list) {
 				list_del(&iter->list);
-				MFREE(dhd->osh, iter, BESTNET_ENTRY_SIZE);
+				PNO_BATCH_FREE_ENTRY(dhd, iter);
 			}
 			pprev = phead;
 			phead = phead->next;
-			MFREE(dhd->osh, pprev, BEST_HEADER_SIZE);
+			PNO_BATCH_FREE_HEADER(dhd, pprev);
 		}
 		if (phead == NULL) {
 			/* it is ok to delete top node */
 			list_del(&siter->list);
-			MFREE(dhd->osh, siter, SCAN_RESULTS_SIZE);
+			PNO_BATCH_FREE_RESULTS(dhd, siter);
 		}
 	}
 	GCC_DIAGNOSTIC_POP();
@@ -1791,15 +1856,28 @@ dhd_wait_batch_results_complete(dhd_pub_t *dhd)
 		     is_batch_retrieval_complete(&_params->params_gscan),
 		     msecs_to_jiffies(GSCAN_BATCH_GET_MAX_WAIT));
 	} else { /* GSCAN_BATCH_RETRIEVAL_COMPLETE */
+#ifdef PNO_BATCH_ARENA
+		gscan_batch_arena_t *arena;
+		uint16 i;
+#else
 		gscan_results_cache_t *iter;
+#endif /* PNO_BATCH_ARENA */
 		uint16 num_results = 0;
 
 		mutex_lock(&_pno_state->pno_mutex);
+#ifdef PNO_BATCH_ARENA
+		arena = _params->params_gscan.gscan_batch_arena;
+		for (i = arena ? arena->scan_idx : 0; arena && i < arena->nscans; i++) {
+			num_results += arena->scans[i].tot_count -
+				arena->scans[i].tot_consumed;
+		}
+#else
 		iter = _params->params_gscan.gscan_batch_cache;
 		while (iter) {
 			num_results += iter->tot_count - iter->tot_consumed;
 			iter = iter->next;
 		}
+#endif /* PNO_BATCH_ARENA */
 		mutex_unlock(&_pno_state->pno_mutex);
 
 		/* All results consumed/No results cached??
@@ -2499,11 +2577,33 @@ int dhd_gscan_batch_cache_cleanup(dhd_pub_t *dhd)
 	dhd_pno_params_t *params;
 	struct dhd_pno_gscan_params *gscan_params;
 	dhd_pno_status_info_t *_pno_state;
+#ifdef PNO_BATCH_ARENA
+	gscan_batch_arena_t *arena;
+#else
 	gscan_results_cache_t *iter, *tmp;
+#endif /* PNO_BATCH_ARENA */
 
 	_pno_state = PNO_GET_PNOSTATE(dhd);
 	params = &_pno_state->pno_params_arr[INDEX_OF_GSCAN_PARAMS];
 	gscan_params = &params->params_gscan;
+#ifdef PNO_BATCH_ARENA
+	arena = gscan_params->gscan_batch_arena;
+	if (!arena) {
+		return TRUE;
+	}
+	while (arena->scan_idx < arena->nscans) {
+		gscan_batch_scan_t *scan = &arena->scans[arena->scan_idx];
+
+		if (scan->tot_consumed != scan->tot_count) {
+			return FALSE;
+		}
+		arena->scan_idx++;
+	}
+	/* Everything sent, the whole batch goes in one free */
+	gscan_params->gscan_batch_arena = NULL;
+	MFREE(dhd->osh, arena, arena->alloc_len);
+	ret = TRUE;
+#else
 	iter = gscan_params->gscan_batch_cache;
 
 	while (iter) {
@@ -2518,9 +2618,75 @@ int dhd_gscan_batch_cache_cleanup(dhd_pub_t *dhd)
 	}
 	gscan_params->gscan_batch_cache = iter;
 	ret = (iter == NULL);
+#endif /* PNO_BATCH_ARENA */
 	return ret;
 }
 
+#ifdef PNO_BATCH_ARENA
+/* Make room in the batch arena for nscans more scans carrying nresults more
+ * results. The first allocation is sized for a full fw batch (mscan scans of
+ * bestn APs, read BESTN_MAX at a time) so that normally nothing is copied; a
+ * continuation from fw that does not fit doubles the arena. The index refers
+ * to results by position, so growing does not need any fixups.
+ */
+static int
+dhd_gscan_batch_arena_reserve(dhd_pub_t *dhd, struct dhd_pno_gscan_params *gscan_params,
+	uint16 nscans, uint16 nresults)
+{
+	gscan_batch_arena_t *arena = gscan_params->gscan_batch_arena;
+	gscan_batch_arena_t *new_arena;
+	uint32 max_scans, max_results, len;
+
+	if (arena) {
+		max_scans = arena->nscans + nscans;
+		max_results = arena->nresults + nresults;
+		if (max_scans <= arena->max_scans && max_results <= arena->max_results) {
+			return BCME_OK;
+		}
+		max_scans = MAX(max_scans, (uint32)arena->max_scans << 1);
+		max_results = MAX(max_results, (uint32)arena->max_results << 1);
+	} else {
+		/* a scan continued in the next pfnlbest read takes one more entry */
+		max_scans = MAX(nscans, gscan_params->mscan + CEIL(
+			gscan_params->mscan * gscan_params->bestn, BESTN_MAX));
+		max_results = MAX(nresults, gscan_params->mscan * gscan_params->bestn);
+	}
+	max_scans = MIN(max_scans, 0xFFFF);
+	max_results = MIN(max_results, 0xFFFF);
+	if (arena && ((arena->nscans + nscans) > max_scans ||
+		(arena->nresults + nresults) > max_results)) {
+		DHD_ERROR(("%s: batch arena full, scans %d results %d\n",
+			__FUNCTION__, arena->nscans, arena->nresults));
+		return BCME_NORESOURCE;
+	}
+
+	len = GSCAN_BATCH_ARENA_LEN(max_scans, max_results);
+	new_arena = (gscan_batch_arena_t *)MALLOCZ(dhd->osh, len);
+	if (!new_arena) {
+		DHD_ERROR(("%s :Out of memory!! Cant malloc %u bytes\n", __FUNCTION__, len));
+		return BCME_NOMEM;
+	}
+	PNO_BATCH_STATS_ALLOC(&PNO_GET_PNOSTATE(dhd)->gscan_stats, len);
+	new_arena->alloc_len = len;
+	new_arena->max_scans = (uint16)max_scans;
+	new_arena->max_results = (uint16)max_results;
+	new_arena->scans = (gscan_batch_scan_t *)&new_arena->results[max_results];
+	if (arena) {
+		new_arena->nscans = arena->nscans;
+		new_arena->nresults = arena->nresults;
+		new_arena->scan_idx = arena->scan_idx;
+		memcpy(new_arena->results, arena->results,
+			arena->nresults * sizeof(wifi_gscan_result_t));
+		memcpy(new_arena->scans, arena->scans,
+			arena->nscans * sizeof(gscan_batch_scan_t));
+		MFREE(dhd->osh, arena, arena->alloc_len);
+	}
+	gscan_params->gscan_batch_arena = new_arena;
+
+	return BCME_OK;
+}
+#endif /* PNO_BATCH_ARENA */
+
 static int
 _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 {
@@ -2533,8 +2699,13 @@ _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 	struct dhd_pno_gscan_params *gscan_params;
 	wl_pfn_lscanresults_v1_t *plbestnet_v1 = NULL;
 	wl_pfn_lscanresults_v2_t *plbestnet_v2 = NULL;
+#ifdef PNO_BATCH_ARENA
+	gscan_batch_arena_t *arena;
+	gscan_batch_scan_t *iter;
+#else
 	gscan_results_cache_t *iter, *tail;
-	wifi_gscan_result_t *result;
+#endif /* PNO_BATCH_ARENA */
+	wifi_gscan_result_t *result, *results;
 	uint8 *nAPs_per_scan = NULL;
 	uint8 num_scans_in_cur_iter;
 	uint16 count;
@@ -2592,11 +2763,14 @@ _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 		goto exit_mutex_unlock;
 	}
 
+	_pno_state->gscan_stats.gets++;
 	timediff = gscan_params->scan_fr * 1000;
 	timediff = timediff >> 1;
 
 	/* Ok, now lets start getting results from the FW */
+#ifndef PNO_BATCH_ARENA
 	tail = gscan_params->gscan_batch_cache;
+#endif /* !PNO_BATCH_ARENA */
 	do {
 		err = dhd_iovar(dhd, 0, "pfnlbest", NULL, 0, (char *)plbestnet_v1, PNO_BESTNET_LEN,
 				FALSE);
@@ -2656,7 +2830,21 @@ _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 			/* reset plnetinfo to the first item for the next loop */
 			plnetinfo -= i;
 
+#ifdef PNO_BATCH_ARENA
+			err = dhd_gscan_batch_arena_reserve(dhd, gscan_params,
+				num_scans_in_cur_iter, fwcount);
+			if (err != BCME_OK) {
+				goto exit_mutex_unlock;
+			}
+			arena = gscan_params->gscan_batch_arena;
+#endif /* PNO_BATCH_ARENA */
 			for (i = 0; i < num_scans_in_cur_iter; i++) {
+#ifdef PNO_BATCH_ARENA
+				iter = &arena->scans[arena->nscans++];
+				iter->first = arena->nresults;
+				arena->nresults += nAPs_per_scan[i];
+				results = &arena->results[iter->first];
+#else
 				iter = (gscan_results_cache_t *)
 					MALLOCZ(dhd->osh, ((nAPs_per_scan[i] - 1) *
 					sizeof(wifi_gscan_result_t)) +
@@ -2667,6 +2855,12 @@ _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 					err = BCME_NOMEM;
 					goto exit_mutex_unlock;
 				}
+				PNO_BATCH_STATS_ALLOC(&_pno_state->gscan_stats,
+					((nAPs_per_scan[i] - 1) * sizeof(wifi_gscan_result_t)) +
+					sizeof(gscan_results_cache_t));
+				results = iter->results;
+#endif /* PNO_BATCH_ARENA */
+				_pno_state->gscan_stats.results += nAPs_per_scan[i];
 				/* Need this check because the new set of results from FW
 				 * maybe a continuation of previous sets' scan results
 				 */
@@ -2687,6 +2881,7 @@ _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 					iter->flag = (ENABLE << gscan_params->reason);
 				}
 
+#ifndef PNO_BATCH_ARENA
 				if (!tail) {
 					gscan_params->gscan_batch_cache = iter;
 				} else {
@@ -2694,8 +2889,9 @@ _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 				}
 				tail = iter;
 				iter->next = NULL;
+#endif /* !PNO_BATCH_ARENA */
 				for (j = 0; j < nAPs_per_scan[i]; j++, plnetinfo++) {
-					result = &iter->results[j];
+					result = &results[j];
 
 					result->channel =
 						wf_channel2mhz(plnetinfo->pfnsubnet.channel,
@@ -2783,7 +2979,21 @@ _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 			/* reset plnetinfo to the first item for the next loop */
 			plnetinfo_v2 -= i;
 
+#ifdef PNO_BATCH_ARENA
+			err = dhd_gscan_batch_arena_reserve(dhd, gscan_params,
+				num_scans_in_cur_iter, fwcount);
+			if (err != BCME_OK) {
+				goto exit_mutex_unlock;
+			}
+			arena = gscan_params->gscan_batch_arena;
+#endif /* PNO_BATCH_ARENA */
 			for (i = 0; i < num_scans_in_cur_iter; i++) {
+#ifdef PNO_BATCH_ARENA
+				iter = &arena->scans[arena->nscans++];
+				iter->first = arena->nresults;
+				arena->nresults += nAPs_per_scan[i];
+				results = &arena->results[iter->first];
+#else
 				iter = (gscan_results_cache_t *)
 					MALLOCZ(dhd->osh, ((nAPs_per_scan[i] - 1) *
 					sizeof(wifi_gscan_result_t)) +
@@ -2794,6 +3004,12 @@ _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 					err = BCME_NOMEM;
 					goto exit_mutex_unlock;
 				}
+				PNO_BATCH_STATS_ALLOC(&_pno_state->gscan_stats,
+					((nAPs_per_scan[i] - 1) * sizeof(wifi_gscan_result_t)) +
+					sizeof(gscan_results_cache_t));
+				results = iter->results;
+#endif /* PNO_BATCH_ARENA */
+				_pno_state->gscan_stats.results += nAPs_per_scan[i];
 				/* Need this check because the new set of results from FW
 				 * maybe a continuation of previous sets' scan results
 				 */
@@ -2816,6 +3032,7 @@ _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 					iter->flag = (ENABLE << gscan_params->reason);
 				}
 
+#ifndef PNO_BATCH_ARENA
 				if (!tail) {
 					gscan_params->gscan_batch_cache = iter;
 				} else {
@@ -2823,8 +3040,9 @@ _dhd_pno_get_gscan_batch_from_fw(dhd_pub_t *dhd)
 				}
 				tail = iter;
 				iter->next = NULL;
+#endif /* !PNO_BATCH_ARENA */
 				for (j = 0; j < nAPs_per_scan[i]; j++, plnetinfo_v2++) {
-					result = &iter->results[j];
+					result = &results[j];
 
 					result->channel =
 						wf_channel2mhz(plnetinfo_v2->pfnsubnet.channel,
@@ -2895,7 +3113,12 @@ exit:
 static void *
 dhd_get_gscan_batch_results(dhd_pub_t *dhd, uint32 *len)
 {
+#ifdef PNO_BATCH_ARENA
+	gscan_batch_arena_t *results;
+	uint16 i;
+#else
 	gscan_results_cache_t *iter, *results;
+#endif /* PNO_BATCH_ARENA */
 	dhd_pno_status_info_t *_pno_state;
 	dhd_pno_params_t *_params;
 	uint16 num_scan_ids = 0, num_results = 0;
@@ -2903,12 +3126,26 @@ dhd_get_gscan_batch_results(dhd_pub_t *dhd, uint32 *len)
 	_pno_state = PNO_GET_PNOSTATE(dhd);
 	_params = &_pno_state->pno_params_arr[INDEX_OF_GSCAN_PARAMS];
 
+#ifdef PNO_BATCH_ARENA
+	results = _params->params_gscan.gscan_batch_arena;
+	if (results) {
+		for (i = results->scan_idx; i < results->nscans; i++) {
+			num_results += results->scans[i].tot_count -
+				results->scans[i].tot_consumed;
+			num_scan_ids++;
+		}
+		if (!num_scan_ids) {
+			results = NULL;
+		}
+	}
+#else
 	iter = results = _params->params_gscan.gscan_batch_cache;
 	while (iter) {
 		num_results += iter->tot_count - iter->tot_consumed;
 		num_scan_ids++;
 		iter = iter->next;
 	}
+#endif /* PNO_BATCH_ARENA */
 
 	*len = ((num_results << 16) | (num_scan_ids));
 	return results;
@@ -3066,6 +3303,9 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 	dhd_pno_bestnet_entry_t *pbestnet_entry;
 	dhd_pno_best_header_t *pbestnetheader = NULL;
 	dhd_pno_scan_results_t *pscan_results = NULL, *siter, *snext;
+#ifdef PNO_BATCH_ARENA
+	dhd_pno_batch_chunk_t *chunk;
+#endif /* PNO_BATCH_ARENA */
 	bool allocate_header = FALSE;
 	uint16 fwstatus = PFN_INCOMPLETE;
 	uint16 fwcount;
@@ -3135,8 +3375,13 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 		DHD_ERROR(("failed to allocate dhd_pno_scan_results_t\n"));
 		goto exit;
 	}
+	_pno_state->legacy_stats.gets++;
+	PNO_BATCH_STATS_ALLOC(&_pno_state->legacy_stats, SCAN_RESULTS_SIZE);
 	pscan_results->bestnetheader = NULL;
 	pscan_results->cnt_header = 0;
+#ifdef PNO_BATCH_ARENA
+	pscan_results->chunks = NULL;
+#endif /* PNO_BATCH_ARENA */
 	/* add the element into list unless total node cnt is less than MAX_NODE_ CNT */
 	if (_params->params_batch.get_batch.top_node_cnt < MAX_NODE_CNT) {
 		list_add(&pscan_results->list, &_params->params_batch.get_batch.scan_results_list);
@@ -3187,7 +3432,17 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 				/* Process only BESTN_MAX number of results per batch */
 				fwcount = BESTN_MAX;
 			}
+#ifdef PNO_BATCH_ARENA
+			chunk = _dhd_pno_batch_chunk_alloc(dhd, pscan_results, fwcount);
+			if (chunk == NULL) {
+				err = BCME_NOMEM;
+				goto exit;
+			}
+#endif /* PNO_BATCH_ARENA */
 			for (i = 0; i < fwcount; i++) {
+#ifdef PNO_BATCH_ARENA
+				pbestnet_entry = &chunk->entries[chunk->nentries++];
+#else
 				pbestnet_entry = (dhd_pno_bestnet_entry_t *)
 					MALLOC(dhd->osh, BESTNET_ENTRY_SIZE);
 				if (pbestnet_entry == NULL) {
@@ -3195,6 +3450,9 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 					DHD_ERROR(("failed to allocate dhd_pno_bestnet_entry\n"));
 					goto exit;
 				}
+				PNO_BATCH_STATS_ALLOC(&_pno_state->legacy_stats, BESTNET_ENTRY_SIZE);
+#endif /* PNO_BATCH_ARENA */
+				_pno_state->legacy_stats.results++;
 				memset(pbestnet_entry, 0, BESTNET_ENTRY_SIZE);
 				/* record the current time */
 				pbestnet_entry->recorded_time = jiffies;
@@ -3206,6 +3464,9 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 					allocate_header = TRUE;
 				timestamp = plnetinfo->timestamp;
 				if (allocate_header) {
+#ifdef PNO_BATCH_ARENA
+					pbestnetheader = &chunk->headers[chunk->nheaders++];
+#else
 					pbestnetheader = (dhd_pno_best_header_t *)
 						MALLOC(dhd->osh, BEST_HEADER_SIZE);
 					if (pbestnetheader == NULL) {
@@ -3217,6 +3478,9 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 							" dhd_pno_bestnet_entry\n"));
 						goto exit;
 					}
+					PNO_BATCH_STATS_ALLOC(&_pno_state->legacy_stats,
+						BEST_HEADER_SIZE);
+#endif /* PNO_BATCH_ARENA */
 					/* increase total cnt of bestnet header */
 					pscan_results->cnt_header++;
 					/* need to record the reason to call dhd_pno_get_for_bach */
@@ -3294,8 +3558,18 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 			}
 			DHD_PNO(("ver %d, status : %d, count %d\n",
 				plbestnet_v2->version, fwstatus, fwcount));
+#ifdef PNO_BATCH_ARENA
+			chunk = _dhd_pno_batch_chunk_alloc(dhd, pscan_results, fwcount);
+			if (chunk == NULL) {
+				err = BCME_NOMEM;
+				goto exit;
+			}
+#endif /* PNO_BATCH_ARENA */
 
 			for (i = 0; i < fwcount; i++) {
+#ifdef PNO_BATCH_ARENA
+				pbestnet_entry = &chunk->entries[chunk->nentries++];
+#else
 				pbestnet_entry = (dhd_pno_bestnet_entry_t *)
 					MALLOC(dhd->osh, BESTNET_ENTRY_SIZE);
 				if (pbestnet_entry == NULL) {
@@ -3303,6 +3577,9 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 					DHD_ERROR(("failed to allocate dhd_pno_bestnet_entry\n"));
 					goto exit;
 				}
+				PNO_BATCH_STATS_ALLOC(&_pno_state->legacy_stats, BESTNET_ENTRY_SIZE);
+#endif /* PNO_BATCH_ARENA */
+				_pno_state->legacy_stats.results++;
 				memset(pbestnet_entry, 0, BESTNET_ENTRY_SIZE);
 				/* record the current time */
 				pbestnet_entry->recorded_time = jiffies;
@@ -3314,6 +3591,9 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 					allocate_header = TRUE;
 				timestamp = plnetinfo_v2->timestamp;
 				if (allocate_header) {
+#ifdef PNO_BATCH_ARENA
+					pbestnetheader = &chunk->headers[chunk->nheaders++];
+#else
 					pbestnetheader = (dhd_pno_best_header_t *)
 						MALLOC(dhd->osh, BEST_HEADER_SIZE);
 					if (pbestnetheader == NULL) {
@@ -3325,6 +3605,9 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 							" dhd_pno_bestnet_entry\n"));
 						goto exit;
 					}
+					PNO_BATCH_STATS_ALLOC(&_pno_state->legacy_stats,
+						BEST_HEADER_SIZE);
+#endif /* PNO_BATCH_ARENA */
 					/* increase total cnt of bestnet header */
 					pscan_results->cnt_header++;
 					/* need to record the reason to call dhd_pno_get_for_bach */
@@ -3401,7 +3684,7 @@ _dhd_pno_get_for_batch(dhd_pub_t *dhd, char *buf, int bufsize, int reason)
 		 */
 		DHD_PNO(("NO BATCH DATA from Firmware, Delete current SCAN RESULT LIST\n"));
 		list_del(&pscan_results->list);
-		MFREE(dhd->osh, pscan_results, SCAN_RESULTS_SIZE);
+		PNO_BATCH_FREE_RESULTS(dhd, pscan_results);
 		_params->params_batch.get_batch.top_node_cnt--;
 	} else {
 		/* increase total scan count using current scan count */
@@ -4421,4 +4704,311 @@ int dhd_pno_deinit(dhd_pub_t *dhd)
 	return err;
 }
 
+static void
+dhd_pno_batch_stats_print(struct bcmstrbuf *strbuf, const char *name,
+	const dhd_pno_batch_stats_t *stats)
+{
+	bcm_bprintf(strbuf, "%s: gets %u results %u allocs %u (%llu bytes)",
+		name, stats->gets, stats->results, stats->allocs, stats->alloc_bytes);
+	if (stats->gets) {
+		bcm_bprintf(strbuf, ", per get %u results %u allocs",
+			stats->results / stats->gets, stats->allocs / stats->gets);
+	}
+	bcm_bprintf(strbuf, "\n");
+}
+
+void
+dhd_pno_batch_stats_dump(dhd_pub_t *dhd, struct bcmstrbuf *strbuf)
+{
+	dhd_pno_status_info_t *_pno_state = PNO_GET_PNOSTATE(dhd);
+
+	if (!_pno_state) {
+		return;
+	}
+
+#ifdef PNO_BATCH_ARENA
+	bcm_bprintf(strbuf, "PNO batch storage (arena):\n");
+#else
+	bcm_bprintf(strbuf, "PNO batch storage:\n");
+#endif /* PNO_BATCH_ARENA */
+	dhd_pno_batch_stats_print(strbuf, "  gscan", &_pno_state->gscan_stats);
+	dhd_pno_batch_stats_print(strbuf, "  legacy", &_pno_state->legacy_stats);
+}
+
+
+#ifdef DHD_DEBUG
+#define PNO_BATCH_BENCH_SCANS	64
+#define PNO_BATCH_BENCH_APS	64	/* per scan */
+#define PNO_BATCH_BENCH_ROUNDS	32u
+
+/* Store one synthetic batch the way _dhd_pno_get_for_batch() does: BESTN_MAX
+ * entries per pfnlbest read, a new header for every scan.
+ */
+static int
+dhd_pno_batch_bench_legacy(dhd_pub_t *dhd, struct list_head *head)
+{
+	dhd_pno_scan_results_t *pscan_results;
+	dhd_pno_best_header_t *pbestnetheader = NULL;
+	dhd_pno_bestnet_entry_t *pbestnet_entry;
+#ifdef PNO_BATCH_ARENA
+	dhd_pno_batch_chunk_t *chunk;
+#endif /* PNO_BATCH_ARENA */
+	uint32 total = PNO_BATCH_BENCH_SCANS * PNO_BATCH_BENCH_APS;
+	uint32 i, n, fwcount;
+
+	pscan_results = (dhd_pno_scan_results_t *)MALLOC(dhd->osh, SCAN_RESULTS_SIZE);
+	if (pscan_results == NULL) {
+		return BCME_NOMEM;
+	}
+	PNO_BATCH_STATS_ALLOC(&PNO_GET_PNOSTATE(dhd)->legacy_stats, SCAN_RESULTS_SIZE);
+	pscan_results->bestnetheader = NULL;
+	pscan_results->cnt_header = 0;
+#ifdef PNO_BATCH_ARENA
+	pscan_results->chunks = NULL;
+#endif /* PNO_BATCH_ARENA */
+	list_add(&pscan_results->list, head);
+
+	for (n = 0; n < total; n += fwcount) {
+		fwcount = MIN(total - n, BESTN_MAX);
+#ifdef PNO_BATCH_ARENA
+		chunk = _dhd_pno_batch_chunk_alloc(dhd, pscan_results, fwcount);
+		if (chunk == NULL) {
+			return BCME_NOMEM;
+		}
+#endif /* PNO_BATCH_ARENA */
+		for (i = n; i < n + fwcount; i++) {
+			if ((i % PNO_BATCH_BENCH_APS) == 0) {
+#ifdef PNO_BATCH_ARENA
+				pbestnetheader = &chunk->headers[chunk->nheaders++];
+#else
+				pbestnetheader = (dhd_pno_best_header_t *)
+					MALLOC(dhd->osh, BEST_HEADER_SIZE);
+				if (pbestnetheader == NULL) {
+					return BCME_NOMEM;
+				}
+				PNO_BATCH_STATS_ALLOC(&PNO_GET_PNOSTATE(dhd)->legacy_stats,
+					BEST_HEADER_SIZE);
+#endif /* PNO_BATCH_ARENA */
+				memset(pbestnetheader, 0, BEST_HEADER_SIZE);
+				INIT_LIST_HEAD(&pbestnetheader->entry_list);
+				pbestnetheader->next = pscan_results->bestnetheader;
+				pscan_results->bestnetheader = pbestnetheader;
+				pscan_results->cnt_header++;
+			}
+#ifdef PNO_BATCH_ARENA
+			pbestnet_entry = &chunk->entries[chunk->nentries++];
+#else
+			pbestnet_entry = (dhd_pno_bestnet_entry_t *)
+				MALLOC(dhd->osh, BESTNET_ENTRY_SIZE);
+			if (pbestnet_entry == NULL) {
+				return BCME_NOMEM;
+			}
+			PNO_BATCH_STATS_ALLOC(&PNO_GET_PNOSTATE(dhd)->legacy_stats,
+				BESTNET_ENTRY_SIZE);
+#endif /* PNO_BATCH_ARENA */
+			memset(pbestnet_entry, 0, BESTNET_ENTRY_SIZE);
+			pbestnet_entry->recorded_time = jiffies;
+			pbestnet_entry->timestamp = i / PNO_BATCH_BENCH_APS;
+			pbestnet_entry->RSSI = -(int8)(i % PNO_BATCH_BENCH_APS);
+			list_add_tail(&pbestnet_entry->list, &pbestnetheader->entry_list);
+			pbestnetheader->tot_cnt++;
+			pbestnetheader->tot_size += BESTNET_ENTRY_SIZE;
+		}
+	}
+
+	return BCME_OK;
+}
+
+#ifdef GSCAN_SUPPORT
+/* Store one synthetic batch the way _dhd_pno_get_gscan_batch_from_fw() does:
+ * BESTN_MAX results per pfnlbest read, a scan split across two reads stored
+ * as two pieces.
+ */
+static int
+dhd_pno_batch_bench_gscan(dhd_pub_t *dhd, struct dhd_pno_gscan_params *gscan_params)
+{
+#ifdef PNO_BATCH_ARENA
+	gscan_batch_arena_t *arena;
+	gscan_batch_scan_t *iter;
+	uint16 nscans;
+	int err;
+#else
+	gscan_results_cache_t *iter, *tail = NULL;
+	uint32 len;
+#endif /* PNO_BATCH_ARENA */
+	wifi_gscan_result_t *results;
+	uint32 total = PNO_BATCH_BENCH_SCANS * PNO_BATCH_BENCH_APS;
+	uint32 i, j, n, cnt, fwcount;
+
+	for (n = 0; n < total; n += fwcount) {
+		fwcount = MIN(total - n, BESTN_MAX);
+#ifdef PNO_BATCH_ARENA
+		nscans = (uint16)(((n + fwcount - 1) / PNO_BATCH_BENCH_APS) -
+			(n / PNO_BATCH_BENCH_APS) + 1);
+		err = dhd_gscan_batch_arena_reserve(dhd, gscan_params, nscans, fwcount);
+		if (err != BCME_OK) {
+			return err;
+		}
+		arena = gscan_params->gscan_batch_arena;
+#endif /* PNO_BATCH_ARENA */
+		for (i = n; i < n + fwcount; i += cnt) {
+			cnt = MIN(n + fwcount - i,
+				PNO_BATCH_BENCH_APS - (i % PNO_BATCH_BENCH_APS));
+#ifdef PNO_BATCH_ARENA
+			iter = &arena->scans[arena->nscans++];
+			iter->first = arena->nresults;
+			arena->nresults += cnt;
+			results = &arena->results[iter->first];
+#else
+			len = ((cnt - 1) * sizeof(wifi_gscan_result_t)) +
+				sizeof(gscan_results_cache_t);
+			iter = (gscan_results_cache_t *)MALLOCZ(dhd->osh, len);
+			if (!iter) {
+				return BCME_NOMEM;
+			}
+			PNO_BATCH_STATS_ALLOC(&PNO_GET_PNOSTATE(dhd)->gscan_stats, len);
+			if (!tail) {
+				gscan_params->gscan_batch_cache = iter;
+			} else {
+				tail->next = iter;
+			}
+			tail = iter;
+			results = iter->results;
+#endif /* PNO_BATCH_ARENA */
+			iter->scan_id = (uint8)(i / PNO_BATCH_BENCH_APS);
+			iter->tot_count = (uint8)cnt;
+			iter->tot_consumed = 0;
+			iter->flag = 0;
+			for (j = 0; j < cnt; j++) {
+				results[j].ts = i / PNO_BATCH_BENCH_APS;
+				results[j].rssi = -(int32)((i + j) % PNO_BATCH_BENCH_APS);
+				results[j].channel = 2412;
+				results[j].beacon_period = 0;
+				results[j].capability = 0;
+			}
+		}
+	}
+
+	return BCME_OK;
+}
+
+static void
+dhd_pno_batch_bench_gscan_free(dhd_pub_t *dhd, struct dhd_pno_gscan_params *gscan_params)
+{
+#ifdef PNO_BATCH_ARENA
+	gscan_batch_arena_t *arena = gscan_params->gscan_batch_arena;
+
+	if (arena) {
+		MFREE(dhd->osh, arena, arena->alloc_len);
+	}
+	gscan_params->gscan_batch_arena = NULL;
+#else
+	gscan_results_cache_t *iter, *tmp;
+
+	for (iter = gscan_params->gscan_batch_cache; iter; iter = tmp) {
+		tmp = iter->next;
+		MFREE(dhd->osh, iter, ((iter->tot_count - 1) * sizeof(wifi_gscan_result_t))
+			+ sizeof(gscan_results_cache_t));
+	}
+	gscan_params->gscan_batch_cache = NULL;
+#endif /* PNO_BATCH_ARENA */
+}
+#endif /* GSCAN_SUPPORT */
+
+static void
+dhd_pno_batch_bench_print(struct bcmstrbuf *strbuf, const char *name,
+	const dhd_pno_batch_stats_t *stats, uint64 store_ns, uint64 free_ns)
+{
+	bcm_bprintf(strbuf, "%s: %u allocs (%u bytes), store %u ns, free %u ns per batch\n",
+		name, stats->allocs / PNO_BATCH_BENCH_ROUNDS,
+		(uint32)DIV_U64_BY_U32(stats->alloc_bytes, PNO_BATCH_BENCH_ROUNDS),
+		(uint32)DIV_U64_BY_U32(store_ns, PNO_BATCH_BENCH_ROUNDS),
+		(uint32)DIV_U64_BY_U32(free_ns, PNO_BATCH_BENCH_ROUNDS));
+}
+
+/*
+ * Store and release batches of PNO_BATCH_BENCH_SCANS scans of
+ * PNO_BATCH_BENCH_APS APs through the batch storage of both retrieval paths,
+ * with synthetic results in place of the pfnlbest reads. The allocations are
+ * taken from the batch stats, which are put back afterwards.
+ */
+int
+dhd_pno_batch_bench(dhd_pub_t *dhd, struct bcmstrbuf *strbuf)
+{
+	dhd_pno_status_info_t *_pno_state;
+	dhd_pno_batch_stats_t saved, *stats;
+	struct list_head head;
+#ifdef GSCAN_SUPPORT
+	struct dhd_pno_gscan_params *gscan_params;
+#endif /* GSCAN_SUPPORT */
+	uint64 start, store_ns = 0, free_ns = 0;
+	uint32 r;
+	int err = BCME_OK;
+
+	NULL_CHECK(dhd, "dhd is NULL", err);
+	NULL_CHECK(dhd->pno_state, "pno_state is NULL", err);
+	_pno_state = PNO_GET_PNOSTATE(dhd);
+
+	mutex_lock(&_pno_state->pno_mutex);
+#ifdef PNO_BATCH_ARENA
+	bcm_bprintf(strbuf, "PNO batch storage (arena), %d scans x %d APs:\n",
+		PNO_BATCH_BENCH_SCANS, PNO_BATCH_BENCH_APS);
+#else
+	bcm_bprintf(strbuf, "PNO batch storage, %d scans x %d APs:\n",
+		PNO_BATCH_BENCH_SCANS, PNO_BATCH_BENCH_APS);
+#endif /* PNO_BATCH_ARENA */
+
+	stats = &_pno_state->legacy_stats;
+	saved = *stats;
+	bzero(stats, sizeof(*stats));
+	INIT_LIST_HEAD(&head);
+	for (r = 0; r < PNO_BATCH_BENCH_ROUNDS && err == BCME_OK; r++) {
+		start = OSL_LOCALTIME_NS();
+		err = dhd_pno_batch_bench_legacy(dhd, &head);
+		store_ns += OSL_LOCALTIME_NS() - start;
+		start = OSL_LOCALTIME_NS();
+		_dhd_pno_clear_all_batch_results(dhd, &head, FALSE);
+		free_ns += OSL_LOCALTIME_NS() - start;
+	}
+	if (err == BCME_OK) {
+		dhd_pno_batch_bench_print(strbuf, "  legacy", stats, store_ns, free_ns);
+	}
+	*stats = saved;
+
+#ifdef GSCAN_SUPPORT
+	if (err != BCME_OK) {
+		goto exit;
+	}
+	gscan_params = (struct dhd_pno_gscan_params *)MALLOCZ(dhd->osh, sizeof(*gscan_params));
+	if (!gscan_params) {
+		err = BCME_NOMEM;
+		goto exit;
+	}
+	gscan_params->mscan = PNO_BATCH_BENCH_SCANS;
+	gscan_params->bestn = PNO_BATCH_BENCH_APS;
+	store_ns = free_ns = 0;
+	stats = &_pno_state->gscan_stats;
+	saved = *stats;
+	bzero(stats, sizeof(*stats));
+	for (r = 0; r < PNO_BATCH_BENCH_ROUNDS && err == BCME_OK; r++) {
+		start = OSL_LOCALTIME_NS();
+		err = dhd_pno_batch_bench_gscan(dhd, gscan_params);
+		store_ns += OSL_LOCALTIME_NS() - start;
+		start = OSL_LOCALTIME_NS();
+		dhd_pno_batch_bench_gscan_free(dhd, gscan_params);
+		free_ns += OSL_LOCALTIME_NS() - start;
+	}
+	if (err == BCME_OK) {
+		dhd_pno_batch_bench_print(strbuf, "  gscan", stats, store_ns, free_ns);
+	}
+	*stats = saved;
+	MFREE(dhd->osh, gscan_params, sizeof(*gscan_params));
+exit:
+#endif /* GSCAN_SUPPORT */
+	mutex_unlock(&_pno_state->pno_mutex);
+
+	return err;
+}
+#endif /* DHD_DEBUG */
+
 #endif /* PNO_SUPPORT */
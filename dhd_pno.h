@@ -252,10 +252,27 @@ typedef struct dhd_pno_bestnet_header {
 } dhd_pno_best_header_t;
 #define BEST_HEADER_SIZE (sizeof(dhd_pno_best_header_t))
 
+#ifdef PNO_BATCH_ARENA
+/* Backing store for the headers and entries of one pfnlbest read */
+typedef struct dhd_pno_batch_chunk {
+	struct dhd_pno_batch_chunk *next;
+	uint32 alloc_len;
+	uint16 nentries;
+	uint16 nheaders;
+	dhd_pno_best_header_t *headers;	/* follows entries */
+	dhd_pno_bestnet_entry_t entries[];
+} dhd_pno_batch_chunk_t;
+#define BATCH_CHUNK_SIZE(cnt) (sizeof(dhd_pno_batch_chunk_t) + \
+	((cnt) * (BESTNET_ENTRY_SIZE + BEST_HEADER_SIZE)))
+#endif /* PNO_BATCH_ARENA */
+
 typedef struct dhd_pno_scan_results {
 	dhd_pno_best_header_t *bestnetheader;
 	uint8 cnt_header;
 	struct list_head list;
+#ifdef PNO_BATCH_ARENA
+	dhd_pno_batch_chunk_t *chunks;	/* storage of all headers and entries */
+#endif /* PNO_BATCH_ARENA */
 } dhd_pno_scan_results_t;
 #define SCAN_RESULTS_SIZE (sizeof(dhd_pno_scan_results_t))
 
@@ -377,6 +394,36 @@ typedef struct gscan_results_cache {
 	wifi_gscan_result_t results[1];
 } gscan_results_cache_t;
 
+#ifdef PNO_BATCH_ARENA
+/* Index entry of one scan, its results are contiguous in the arena */
+typedef struct gscan_batch_scan {
+	uint8  scan_id;
+	uint8  flag;
+	uint8  tot_count;
+	uint8  tot_consumed;
+	uint32 scan_ch_bucket;
+	uint16 first;		/* arena index of the first result */
+	uint16 PAD;
+} gscan_batch_scan_t;
+
+/* Results of one batch retrieval, released with a single free */
+typedef struct gscan_batch_arena {
+	uint32 alloc_len;
+	uint16 max_scans;
+	uint16 max_results;
+	uint16 nscans;
+	uint16 nresults;
+	uint16 scan_idx;	/* first scan not yet fully consumed */
+	uint16 PAD;
+	gscan_batch_scan_t *scans;	/* index, placed after results */
+	wifi_gscan_result_t results[];
+} gscan_batch_arena_t;
+
+#define GSCAN_BATCH_ARENA_LEN(nscans, nresults) \
+	(sizeof(gscan_batch_arena_t) + ((nresults) * sizeof(wifi_gscan_result_t)) + \
+	((nscans) * sizeof(gscan_batch_scan_t)))
+#endif /* PNO_BATCH_ARENA */
+
 typedef struct dhd_pno_gscan_capabilities {
 	int max_scan_cache_size;
 	int max_scan_buckets;
@@ -411,7 +458,11 @@ struct dhd_pno_gscan_params {
 	uint8 get_batch_flag;
 	uint8 send_all_results_flag;
 	uint16 max_ch_bucket_freq;
+#ifdef PNO_BATCH_ARENA
+	gscan_batch_arena_t *gscan_batch_arena;
+#else
 	gscan_results_cache_t *gscan_batch_cache;
+#endif /* PNO_BATCH_ARENA */
 	gscan_results_cache_t *gscan_hotlist_found;
 	gscan_results_cache_t*gscan_hotlist_lost;
 	uint16 nbssid_significant_change;
@@ -458,6 +509,14 @@ typedef union dhd_pno_params {
 #endif /* GSCAN_SUPPORT || DHD_GET_VALID_CHANNELS */
 } dhd_pno_params_t;
 
+/* Storage used by batch retrievals, in the dhd dump */
+typedef struct dhd_pno_batch_stats {
+	uint32 gets;		/* retrievals from fw */
+	uint32 results;		/* results stored */
+	uint32 allocs;		/* allocations made to hold them */
+	uint64 alloc_bytes;
+} dhd_pno_batch_stats_t;
+
 typedef struct dhd_pno_status_info {
 	dhd_pub_t *dhd;
 	struct work_struct work;
@@ -471,6 +530,8 @@ typedef struct dhd_pno_status_info {
 	enum dhd_pno_mode pno_mode;
 	dhd_pno_params_t pno_params_arr[INDEX_MODE_MAX];
 	struct list_head head_list;
+	dhd_pno_batch_stats_t gscan_stats;
+	dhd_pno_batch_stats_t legacy_stats;
 } dhd_pno_status_info_t;
 
 /* wrapper functions */
@@ -544,6 +605,10 @@ extern int dhd_pno_stop_for_hotlist(dhd_pub_t *dhd);
 extern int dhd_pno_event_handler(dhd_pub_t *dhd, wl_event_msg_t *event, void *event_data);
 extern int dhd_pno_init(dhd_pub_t *dhd);
 extern int dhd_pno_deinit(dhd_pub_t *dhd);
+extern void dhd_pno_batch_stats_dump(dhd_pub_t *dhd, struct bcmstrbuf *strbuf);
+#ifdef DHD_DEBUG
+extern int dhd_pno_batch_bench(dhd_pub_t *dhd, struct bcmstrbuf *strbuf);
+#endif /* DHD_DEBUG */
 extern bool dhd_is_pno_supported(dhd_pub_t *dhd);
 extern bool dhd_is_legacy_pno_enabled(dhd_pub_t *dhd);
 #if defined(GSCAN_SUPPORT) || defined(DHD_GET_VALID_CHANNELS)
@@ -120,13 +120,27 @@ extern int dhd_ioctl(dhd_pub_t * dhd_pub, dhd_ioctl_t *ioc, void * buf, uint buf
 
 extern int dhd_preinit_ioctls(dhd_pub_t *dhd);
 
-extern int dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf,
+extern int dhd_process_pkt_reorder_info(dhd_pub_t *dhd, int ifidx, uchar *reorder_info_buf,
 	uint reorder_info_len, void **pkt, uint32 *free_buf_count);
+#ifdef DHD_HOSTREORDER_TIMER
+extern void dhd_prot_reorder_expire(dhd_pub_t *dhd);
+#endif /* DHD_HOSTREORDER_TIMER */
 
 #ifdef BCMPCIE
 extern bool dhd_prot_process_msgbuf_txcpl(dhd_pub_t *dhd, uint bound, int ringtype);
 extern bool dhd_prot_process_msgbuf_rxcpl(dhd_pub_t *dhd, uint bound, int ringtype);
 extern bool dhd_prot_process_msgbuf_infocpl(dhd_pub_t *dhd, uint bound);
+#ifdef DHD_DPC_SCHED
+/* D2H completion rings the bus DPC shares its time budget across */
+typedef enum dhd_dpc_ring {
+	DHD_DPC_RING_TXCPL = 0,
+	DHD_DPC_RING_RXCPL = 1,
+	DHD_DPC_RING_INFOCPL = 2,
+	DHD_DPC_RING_MAX = 3
+} dhd_dpc_ring_t;
+extern void dhd_prot_dpc_ring_state(dhd_pub_t *dhd, dhd_dpc_ring_t which,
+	uint32 *items, uint32 *backlog);
+#endif /* DHD_DPC_SCHED */
 extern int dhd_prot_process_ctrlbuf(dhd_pub_t * dhd);
 extern int dhd_prot_process_trapbuf(dhd_pub_t * dhd);
 extern bool dhd_prot_dtohsplit(dhd_pub_t * dhd);
@@ -154,6 +168,9 @@ extern uint32 dhd_prot_metadatalen_get(dhd_pub_t *dhd, bool rx);
 extern void dhd_prot_print_flow_ring(dhd_pub_t *dhd, void *msgbuf_flow_info, bool h2d,
 	struct bcmstrbuf *strbuf, const char * fmt);
 extern void dhd_prot_print_info(dhd_pub_t *dhd, struct bcmstrbuf *strbuf);
+#ifdef DHD_D2H_SYNC_BATCH
+extern int dhd_prot_d2h_sync_bench(dhd_pub_t *dhd, struct bcmstrbuf *b);
+#endif /* DHD_D2H_SYNC_BATCH */
 extern void dhd_prot_update_txflowring(dhd_pub_t *dhdp, uint16 flow_id, void *msgring_info);
 extern void dhd_prot_txdata_write_flush(dhd_pub_t *dhd, uint16 flow_id);
 extern uint32 dhd_prot_txp_threshold(dhd_pub_t *dhd, bool set, uint32 val);
@@ -141,6 +141,27 @@ static int dhdsdio_resume(void *context);
 
 #define MAX_RX_DATASZ	2048	/* XXX Should be based on PKTGET limits? */
 
+#ifdef DHD_RX_PREDICT
+/* Largest header read the rx size predictor may pick */
+#ifndef DHD_RXPRED_MAX
+#define DHD_RXPRED_MAX	512
+#endif
+#if (DHD_RXPRED_MAX < MAX_HDR_READ) || !ISPOWEROF2(DHD_RXPRED_MAX)
+#error DHD_RXPRED_MAX must be a power of 2 no smaller than MAX_HDR_READ!
+#endif
+/* Bytes an extra F2 read is worth when picking the header read size */
+#ifndef DHD_RXPRED_COST
+#define DHD_RXPRED_COST	256
+#endif
+#define DHD_RXPRED_BKT		16	/* histogram bucket width, as nextlen units */
+#define DHD_RXPRED_NBKT		((DHD_RXPRED_MAX / DHD_RXPRED_BKT) + 1)	/* last: longer */
+#define DHD_RXPRED_WINDOW	1024	/* halve the histogram at this many samples */
+#define DHD_RXPRED_EPOCH	64	/* samples between picks */
+#define RXHDR_BUF_LEN		DHD_RXPRED_MAX
+#else
+#define RXHDR_BUF_LEN		MAX_HDR_READ
+#endif /* DHD_RX_PREDICT */
+
 /* Maximum milliseconds to wait for F2 to come up */
 #define DHD_WAIT_F2RDY	3000
 
@@ -289,7 +310,7 @@ typedef struct dhd_bus {
 	uint8		tx_seq;			/* Transmit sequence number (next) */
 	uint8		tx_max;			/* Maximum transmit sequence allowed */
 
-	uint8		hdrbuf[MAX_HDR_READ + DHD_SDALIGN];
+	uint8		hdrbuf[RXHDR_BUF_LEN + DHD_SDALIGN];
 	uint8		*rxhdr;			/* Header of current rx frame (in hdrbuf) */
 	uint16		nextlen;		/* Next Read Len from last header */
 	uint8		rx_seq;			/* Receive sequence number (expected) */
@@ -397,6 +418,23 @@ typedef struct dhd_bus {
 	uint		rxglompkts;		/* Number of packets from glom frames */
 	uint		f2rxhdrs;		/* Number of header reads */
 	uint		f2rxdata;		/* Number of frame data reads */
+#ifdef DHD_RX_PREDICT
+	uint16		rxpred_hist[DHD_RXPRED_NBKT];	/* Decaying frame length histogram */
+	uint16		rxpred_samples;		/* Frames in rxpred_hist */
+	uint16		rxpred_epoch;		/* Frames since rxpred_len was picked */
+	uint16		rxpred_len;		/* Size of the next header read */
+	uint32		rxpred_frames;		/* Frames received */
+	uint32		rxpred_reads;		/* F2 reads those frames took */
+	uint32		rxpred_saved;		/* Frames a firstread header read would split */
+	uint64		rxpred_waste;		/* Bytes read past the end of frames */
+	uint64		rxpred_sec_start;	/* Start of the current one second window */
+	uint32		rxpred_sec_frames;	/* rxpred_frames at rxpred_sec_start */
+	uint32		rxpred_sec_reads;	/* rxpred_reads at rxpred_sec_start */
+	uint64		rxpred_sec_waste;	/* rxpred_waste at rxpred_sec_start */
+	uint32		rxpred_ps_frames;	/* Frames per second, last window */
+	uint32		rxpred_ps_reads;	/* Reads per second, last window */
+	uint32		rxpred_ps_waste;	/* Wasted bytes per second, last window */
+#endif /* DHD_RX_PREDICT */
 	uint		f2txdata;		/* Number of f2 frame writes */
 	uint		f1regdata;		/* Number of f1 register accesses */
 	wake_counts_t	wake_counts;		/* Wake up counter */
@@ -431,6 +469,14 @@ typedef struct dhd_bus {
 	uint32		txglom_total_len;	/* Total length of pkts in glom array */
 	bool		txglom_enable;	/* Flag to indicate whether tx glom is enabled/disabled */
 	uint32		txglomsize;	/* Glom size limitation */
+#ifdef BCMSDIOH_TX_BURST
+	uint32		tx_writes;	/* F2 data writes completed */
+	uint32		tx_chain_writes;	/* of those, passed down as a packet chain */
+	uint32		tx_write_pkts;	/* data frames carried by those writes */
+	uint32		tx_write_max;	/* most frames in one write */
+	uint64		tx_write_bytes;	/* bytes carried by those writes */
+	uint64		tx_write_ns;	/* time spent in those writes */
+#endif /* BCMSDIOH_TX_BURST */
 #ifdef DHDENABLE_TAILPAD
 	void		*pad_pkt;
 #endif /* DHDENABLE_TAILPAD */
@@ -685,6 +731,14 @@ do {												\
 
 #endif /* BCMSPI */
 
+/* Stop reading frames while the RXF thread is behind, it reschedules the DPC */
+#ifdef DHD_RXF_RING
+#define RXF_THROTTLED(bus)	dhd_rxf_throttled((bus)->dhd)
+#else
+#define RXF_THROTTLED(bus)	FALSE
+#endif /* DHD_RXF_RING */
+#define RXF_PAUSED_MASK(bus)	(RXF_THROTTLED(bus) ? FRAME_AVAIL_MASK(bus) : 0)
+
 #ifdef SDTEST
 static void dhdsdio_testrcv(dhd_bus_t *bus, void *pkt, uint seq);
 static void dhdsdio_sdtest_set(dhd_bus_t *bus, uint count);
@@ -2467,6 +2521,9 @@ static int dhdsdio_txpkt(dhd_bus_t *bus, uint chan, void** pkts, int num_pkt, bo
 	int new_pkt_num = 0;
 	void *new_pkts[MAX_TX_PKTCHAIN_CNT];
 	bool wlfc_enabled = FALSE;
+#ifdef BCMSDIOH_TX_BURST
+	uint64 xfer_start;
+#endif /* BCMSDIOH_TX_BURST */
 
 	if (bus->dhd->dongle_reset)
 		return BCME_NOTREADY;
@@ -2528,10 +2585,24 @@ static int dhdsdio_txpkt(dhd_bus_t *bus, uint chan, void** pkts, int num_pkt, bo
 	 * so it will take the aligned length and buffer pointer.
 	 */
 	pkt_chain = PKTNEXT(osh, head_pkt) ? head_pkt : NULL;
+#ifdef BCMSDIOH_TX_BURST
+	xfer_start = OSL_LOCALTIME_NS();
+#endif /* BCMSDIOH_TX_BURST */
 	ret = dhd_bcmsdh_send_buf(bus, bcmsdh_cur_sbwad(sdh), SDIO_FUNC_2, F2SYNC,
 		PKTDATA(osh, head_pkt), total_len, pkt_chain, NULL, NULL, TXRETRIES);
 	if (ret == BCME_OK)
 		bus->tx_seq = (bus->tx_seq + num_pkt) % SDPCM_SEQUENCE_WRAP;
+#ifdef BCMSDIOH_TX_BURST
+	if ((ret == BCME_OK) && (chan == SDPCM_DATA_CHANNEL)) {
+		bus->tx_write_ns += OSL_LOCALTIME_NS() - xfer_start;
+		bus->tx_writes++;
+		if (pkt_chain)
+			bus->tx_chain_writes++;
+		bus->tx_write_pkts += num_pkt;
+		bus->tx_write_bytes += total_len;
+		bus->tx_write_max = MAX(bus->tx_write_max, (uint32)num_pkt);
+	}
+#endif /* BCMSDIOH_TX_BURST */
 
 	/* if a padding packet was needed, remove it from the link list as it not a data pkt */
 	if (pad_pkt_len && pkt)
@@ -2610,6 +2681,9 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 		int num_pkt = 1;
 		void *pkts[MAX_TX_PKTCHAIN_CNT];
 		int prec_out;
+#ifdef HND_PKTQ_PREC_BMP
+		struct spktq chain;
+#endif /* HND_PKTQ_PREC_BMP */
 
 		dhd_os_sdlock_txq(bus->dhd);
 		if (bus->txglom_enable) {
@@ -2623,8 +2697,18 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 			num_pkt = MIN(num_pkt, ARRAYSIZE(pkts));
 		}
 		num_pkt = MIN(num_pkt, pktq_mlen(&bus->txq, tx_prec_map));
+#ifdef HND_PKTQ_PREC_BMP
+		/* unlink the whole glom in one go, then hand the packets out in order */
+		BCM_REFERENCE(prec_out);
+		spktq_init(&chain, num_pkt);
+		num_pkt = pktq_mdeq_n(&bus->txq, tx_prec_map, num_pkt, &chain);
+#endif /* HND_PKTQ_PREC_BMP */
 		for (i = 0; i < num_pkt; i++) {
+#ifdef HND_PKTQ_PREC_BMP
+			pkts[i] = spktq_deq(&chain);
+#else
 			pkts[i] = pktq_mdeq(&bus->txq, tx_prec_map, &prec_out);
+#endif /* HND_PKTQ_PREC_BMP */
 			if (!pkts[i]) {
 				DHD_ERROR(("%s: pktq_mlen non-zero when no pkt\n",
 					__FUNCTION__));
@@ -2657,6 +2741,9 @@ dhdsdio_sendfromq(dhd_bus_t *bus, uint maxframes)
 			PKTORPHAN(pkts[i]);
 			datalen += PKTLEN(osh, pkts[i]);
 		}
+#ifdef HND_PKTQ_PREC_BMP
+		spktq_deinit(&chain);
+#endif /* HND_PKTQ_PREC_BMP */
 		dhd_os_sdunlock_txq(bus->dhd);
 
 		if (i == 0)
@@ -3199,6 +3286,31 @@ dhd_bus_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 	bcm_bprintf(strbuf, "f2rx (hdrs/data) %u (%u/%u), f2tx %u f1regs %u\n",
 	            (bus->f2rxhdrs + bus->f2rxdata), bus->f2rxhdrs, bus->f2rxdata,
 	            bus->f2txdata, bus->f1regdata);
+#ifdef BCMSDIOH_TX_BURST
+	{
+		uint32 ms = (uint32)DIV_U64_BY_U32(bus->tx_write_ns, NSEC_PER_MSEC);
+		uint32 chain_cmd53 = 0;
+
+		bcmsdh_iovar_op(bus->sdh, "sd_txchain_cmd53", NULL, 0,
+			&chain_cmd53, sizeof(chain_cmd53), FALSE);
+		bcm_bprintf(strbuf, "tx writes %u frames %u max frames/write %u\n",
+		            bus->tx_writes, bus->tx_write_pkts, bus->tx_write_max);
+		dhd_dump_pct(strbuf, "Tx: frames/write", bus->tx_write_pkts, bus->tx_writes);
+		bcm_bprintf(strbuf, ", %llu bytes in %u ms on the bus, %u kbps\n",
+		            bus->tx_write_bytes, ms,
+		            ms ? (uint32)DIV_U64_BY_U32(bus->tx_write_bytes * 8, ms) : 0);
+		bcm_bprintf(strbuf, "tx chained writes %u CMD53 %u (incl. retries)\n",
+		            bus->tx_chain_writes, chain_cmd53);
+	}
+#endif /* BCMSDIOH_TX_BURST */
+#ifdef DHD_RX_PREDICT
+	bcm_bprintf(strbuf, "rx hdr read %u frames %u reads %u saved %u wasted %llu bytes\n",
+	            bus->rxpred_len, bus->rxpred_frames, bus->rxpred_reads,
+	            bus->rxpred_saved, bus->rxpred_waste);
+	dhd_dump_pct(strbuf, "Rx: reads/frame", bus->rxpred_reads, bus->rxpred_frames);
+	bcm_bprintf(strbuf, ", last second: frames %u reads %u wasted %u bytes\n",
+	            bus->rxpred_ps_frames, bus->rxpred_ps_reads, bus->rxpred_ps_waste);
+#endif /* DHD_RX_PREDICT */
 	{
 		dhd_dump_pct(strbuf, "\nRx: pkts/f2rd", bus->dhd->rx_packets,
 		             (bus->f2rxhdrs + bus->f2rxdata));
@@ -3257,6 +3369,9 @@ void
 dhd_bus_clearcounts(dhd_pub_t *dhdp)
 {
 	dhd_bus_t *bus = (dhd_bus_t *)dhdp->bus;
+#ifdef BCMSDIOH_TX_BURST
+	uint32 chain_cmd53 = 0;
+#endif /* BCMSDIOH_TX_BURST */
 
 	bus->intrcount = bus->lastintrs = bus->spurious = bus->regfails = 0;
 	bus->rxrtx = bus->rx_toolong = bus->rxc_errors = 0;
@@ -3267,6 +3382,20 @@ dhd_bus_clearcounts(dhd_pub_t *dhdp)
 	bus->tx_sderrs = bus->fc_rcvd = bus->fc_xoff = bus->fc_xon = 0;
 	bus->rxglomfail = bus->rxglomframes = bus->rxglompkts = 0;
 	bus->f2rxhdrs = bus->f2rxdata = bus->f2txdata = bus->f1regdata = 0;
+#ifdef BCMSDIOH_TX_BURST
+	bus->tx_writes = bus->tx_chain_writes = bus->tx_write_pkts = bus->tx_write_max = 0;
+	bus->tx_write_bytes = bus->tx_write_ns = 0;
+	bcmsdh_iovar_op(bus->sdh, "sd_txchain_cmd53", NULL, 0,
+		&chain_cmd53, sizeof(chain_cmd53), TRUE);
+#endif /* BCMSDIOH_TX_BURST */
+#ifdef DHD_RX_PREDICT
+	bus->rxpred_frames = bus->rxpred_reads = bus->rxpred_saved = 0;
+	bus->rxpred_waste = 0;
+	bus->rxpred_sec_start = 0;
+	bus->rxpred_sec_frames = bus->rxpred_sec_reads = 0;
+	bus->rxpred_sec_waste = 0;
+	bus->rxpred_ps_frames = bus->rxpred_ps_reads = bus->rxpred_ps_waste = 0;
+#endif /* DHD_RX_PREDICT */
 }
 
 #ifdef SDTEST
@@ -5298,7 +5427,7 @@ fail:
 }
 
 static void
-dhdsdio_read_control(dhd_bus_t *bus, uint8 *hdr, uint len, uint doff)
+dhdsdio_read_control(dhd_bus_t *bus, uint8 *hdr, uint hdrlen, uint len, uint doff)
 {
 	bcmsdh_info_t *sdh = bus->sdh;
 	uint rdlen, pad;
@@ -5315,16 +5444,16 @@ dhdsdio_read_control(dhd_bus_t *bus, uint8 *hdr, uint len, uint doff)
 	/* Set rxctl for frame (w/optional alignment) */
 	bus->rxctl = bus->rxbuf;
 	if (dhd_alignctl) {
-		bus->rxctl += firstread;
+		bus->rxctl += hdrlen;
 		if ((pad = ((uintptr)bus->rxctl % DHD_SDALIGN)))
 			bus->rxctl += (DHD_SDALIGN - pad);
-		bus->rxctl -= firstread;
+		bus->rxctl -= hdrlen;
 	}
 	ASSERT(bus->rxctl >= bus->rxbuf);
 
 	/* Copy the already-read portion over */
-	bcopy(hdr, bus->rxctl, firstread);
-	if (len <= firstread)
+	bcopy(hdr, bus->rxctl, hdrlen);
+	if (len <= hdrlen)
 		goto gotpkt;
 
 	/* Copy the full data pkt in gSPI case and process ioctl. */
@@ -5334,7 +5463,7 @@ dhdsdio_read_control(dhd_bus_t *bus, uint8 *hdr, uint len, uint doff)
 	}
 
 	/* Raise rdlen to next SDIO block to avoid tail command */
-	rdlen = len - firstread;
+	rdlen = len - hdrlen;
 	if (bus->roundup && bus->blocksize && (rdlen > bus->blocksize)) {
 		pad = bus->blocksize - (rdlen % bus->blocksize);
 		if ((pad <= bus->roundup) && (pad < bus->blocksize) &&
@@ -5349,7 +5478,7 @@ dhdsdio_read_control(dhd_bus_t *bus, uint8 *hdr, uint len, uint doff)
 		rdlen = ROUNDUP(rdlen, ALIGNMENT);
 
 	/* Drop if the read is too big or it exceeds our maximum */
-	if ((rdlen + firstread) > bus->dhd->maxctl) {
+	if ((rdlen + hdrlen) > bus->dhd->maxctl) {
 		DHD_ERROR(("%s: %d-byte control read exceeds %d-byte buffer\n",
 		           __FUNCTION__, rdlen, bus->dhd->maxctl));
 		bus->dhd->rx_errors++;
@@ -5369,7 +5498,7 @@ dhdsdio_read_control(dhd_bus_t *bus, uint8 *hdr, uint len, uint doff)
 
 	/* Read remainder of frame body into the rxctl buffer */
 	sdret = dhd_bcmsdh_recv_buf(bus, bcmsdh_cur_sbwad(sdh), SDIO_FUNC_2, F2SYNC,
-	                            (bus->rxctl + firstread), rdlen, NULL, NULL, NULL);
+	                            (bus->rxctl + hdrlen), rdlen, NULL, NULL, NULL);
 	bus->f2rxdata++;
 	ASSERT(sdret != BCME_PENDING);
 
@@ -5398,8 +5527,103 @@ done:
 	dhd_os_ioctl_resp_wake(bus->dhd);
 }
 int
-dhd_process_pkt_reorder_info(dhd_pub_t *dhd, uchar *reorder_info_buf, uint reorder_info_len,
-	void **pkt, uint32 *pkt_count);
+dhd_process_pkt_reorder_info(dhd_pub_t *dhd, int ifidx, uchar *reorder_info_buf,
+	uint reorder_info_len, void **pkt, uint32 *pkt_count);
+
+#ifdef DHD_RX_PREDICT
+/*
+ * Pick the header read size from the recent frame length histogram: each
+ * candidate costs DHD_RXPRED_COST bytes for every frame still needing a
+ * second read plus the bytes read past the end of the frames it covers.
+ * Candidates are firstread and the block multiples up to DHD_RXPRED_MAX.
+ */
+static uint16
+dhdsdio_rxpred_pick(dhd_bus_t *bus)
+{
+	uint step = DHD_RXPRED_BKT;
+	uint32 fit = 0, fitlen = 0;
+	uint32 cost, best_cost = (uint32)-1;
+	uint16 best = firstread;
+	uint rdlen, b = 0;
+
+	if ((bus->blocksize > step) && (bus->blocksize <= DHD_RXPRED_MAX))
+		step = bus->blocksize;
+
+	for (rdlen = firstread; rdlen <= DHD_RXPRED_MAX; rdlen = ROUNDUP(rdlen + 1, step)) {
+		/* Bucket b holds lengths (b * BKT, (b + 1) * BKT], count it at the middle */
+		for (; (b + 1) * DHD_RXPRED_BKT <= rdlen; b++) {
+			fit += bus->rxpred_hist[b];
+			fitlen += bus->rxpred_hist[b] * (b * DHD_RXPRED_BKT + DHD_RXPRED_BKT / 2);
+		}
+		cost = (bus->rxpred_samples - fit) * DHD_RXPRED_COST + (fit * rdlen - fitlen);
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = (uint16)rdlen;
+		}
+	}
+
+	return best;
+}
+
+static void
+dhdsdio_rxpred_sample(dhd_bus_t *bus, uint16 len)
+{
+	uint b;
+
+	b = MIN((uint)(len - 1) / DHD_RXPRED_BKT, DHD_RXPRED_NBKT - 1);
+	bus->rxpred_hist[b]++;
+
+	/* Decay so the histogram follows the traffic mix */
+	if (++bus->rxpred_samples >= DHD_RXPRED_WINDOW) {
+		bus->rxpred_samples = 0;
+		for (b = 0; b < DHD_RXPRED_NBKT; b++) {
+			bus->rxpred_hist[b] >>= 1;
+			bus->rxpred_samples += bus->rxpred_hist[b];
+		}
+	}
+
+	if (++bus->rxpred_epoch >= DHD_RXPRED_EPOCH) {
+		bus->rxpred_epoch = 0;
+		bus->rxpred_len = dhdsdio_rxpred_pick(bus);
+	}
+}
+
+static void
+dhdsdio_rxpred_account(dhd_bus_t *bus, uint frames, uint reads, uint waste)
+{
+	bus->rxpred_frames += frames;
+	bus->rxpred_reads += reads;
+	bus->rxpred_waste += waste;
+}
+
+/* Latch per second rates once a second has passed since the last latch */
+static void
+dhdsdio_rxpred_tick(dhd_bus_t *bus)
+{
+	uint64 now = OSL_LOCALTIME_NS();
+	uint32 ms;
+
+	if (!bus->rxpred_sec_start) {
+		bus->rxpred_sec_start = now;
+		return;
+	}
+	if ((now - bus->rxpred_sec_start) < NSEC_PER_SEC)
+		return;
+
+	ms = (uint32)DIV_U64_BY_U32(now - bus->rxpred_sec_start, NSEC_PER_MSEC);
+	bus->rxpred_ps_frames = (uint32)DIV_U64_BY_U32((uint64)(bus->rxpred_frames -
+		bus->rxpred_sec_frames) * 1000, ms);
+	bus->rxpred_ps_reads = (uint32)DIV_U64_BY_U32((uint64)(bus->rxpred_reads -
+		bus->rxpred_sec_reads) * 1000, ms);
+	bus->rxpred_ps_waste = (uint32)DIV_U64_BY_U32((bus->rxpred_waste -
+		bus->rxpred_sec_waste) * 1000, ms);
+
+	bus->rxpred_sec_start = now;
+	bus->rxpred_sec_frames = bus->rxpred_frames;
+	bus->rxpred_sec_reads = bus->rxpred_reads;
+	bus->rxpred_sec_waste = bus->rxpred_waste;
+}
+#endif /* DHD_RX_PREDICT */
 
 static uint8
 dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
@@ -5422,6 +5646,9 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 
 	int ifidx = 0;
 	bool usechain = bus->use_rxchain;
+#ifdef DHD_RX_PREDICT
+	uint waste = 0;
+#endif /* DHD_RX_PREDICT */
 
 	/* If packets, issue read(s) and send up packet chain */
 	/* Return sequence numbers consumed? */
@@ -5679,6 +5906,11 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 				           __FUNCTION__, num, doff, sublen, SDPCM_HDRLEN));
 				errcode = -1;
 			}
+#ifdef DHD_RX_PREDICT
+			/* Subframe padding, including the block roundup of the last one */
+			if (!errcode)
+				waste += dlen - sublen;
+#endif /* DHD_RX_PREDICT */
 		}
 
 		if (errcode) {
@@ -5755,7 +5987,7 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 
 				ppfirst = pfirst;
 				/* Reordering info from the firmware */
-				dhd_process_pkt_reorder_info(bus->dhd, reorder_info_buf,
+				dhd_process_pkt_reorder_info(bus->dhd, ifidx, reorder_info_buf,
 					reorder_info_len, &ppfirst, &free_buf_count);
 
 				if (free_buf_count == 0) {
@@ -5819,6 +6051,9 @@ dhdsdio_rxglom(dhd_bus_t *bus, uint8 rxseq)
 		}
 		bus->rxglomframes++;
 		bus->rxglompkts += num;
+#ifdef DHD_RX_PREDICT
+		dhdsdio_rxpred_account(bus, num, 1, waste);
+#endif /* DHD_RX_PREDICT */
 	}
 	return num;
 }
@@ -5838,6 +6073,10 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 	void *pkt;	/* Packet for event or data frames */
 	uint16 pad;	/* Number of pad bytes to read */
 	uint16 rdlen;	/* Total number of bytes to read */
+	uint16 hdrlen;	/* Bytes of the frame read along with the header */
+#ifdef DHD_RX_PREDICT
+	uint waste;	/* Bytes read past the end of the frame */
+#endif /* DHD_RX_PREDICT */
 	uint8 rxseq;	/* Next sequence number to expect */
 	uint rxleft = 0;	/* Remaining number of frames allowed */
 	int sdret;	/* Return code from bcmsdh calls */
@@ -5914,7 +6153,8 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 #endif /* BCMSPI */
 
 	for (rxseq = bus->rx_seq, rxleft = maxframes;
-	     !bus->rxskip && rxleft && bus->dhd->busstate != DHD_BUS_DOWN;
+	     !bus->rxskip && rxleft && bus->dhd->busstate != DHD_BUS_DOWN &&
+	     !RXF_THROTTLED(bus);
 	     rxseq++, rxleft--) {
 #ifdef DHDTCPACK_SUP_DBG
 		if (bus->dhd->tcpack_sup_mode != TCPACK_SUP_DELAYTX) {
@@ -6138,6 +6378,13 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 				continue;
 			}
 
+#ifdef DHD_RX_PREDICT
+			if (bus->bus != SPI_BUS) {
+				dhdsdio_rxpred_sample(bus, len);
+				dhdsdio_rxpred_account(bus, 1, 1, (rdlen > len) ? (rdlen - len) : 0);
+			}
+#endif /* DHD_RX_PREDICT */
+
 			/* Check for consistency with readahead info */
 #ifdef BCMSPI
 			if (bus->bus == SPI_BUS) {
@@ -6259,7 +6506,7 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 
 			if (chan == SDPCM_CONTROL_CHANNEL) {
 				if (bus->bus == SPI_BUS) {
-					dhdsdio_read_control(bus, rxbuf, len, doff);
+					dhdsdio_read_control(bus, rxbuf, firstread, len, doff);
 					if (bus->usebufpool) {
 						dhd_os_sdlock_rxq(bus->dhd);
 						PKTFREE(bus->dhd->osh, pkt, FALSE);
@@ -6306,8 +6553,13 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 		}
 
 		/* Read frame header (hardware and software) */
+#ifdef DHD_RX_PREDICT
+		hdrlen = bus->rxpred_len;
+#else
+		hdrlen = firstread;
+#endif /* DHD_RX_PREDICT */
 		sdret = dhd_bcmsdh_recv_buf(bus, bcmsdh_cur_sbwad(sdh), SDIO_FUNC_2, F2SYNC,
-		                            bus->rxhdr, firstread, NULL, NULL, NULL);
+		                            bus->rxhdr, hdrlen, NULL, NULL, NULL);
 		bus->f2rxhdrs++;
 		ASSERT(sdret != BCME_PENDING);
 
@@ -6366,6 +6618,19 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 			continue;
 		}
 
+#ifdef DHD_RX_PREDICT
+		dhdsdio_rxpred_sample(bus, len);
+		if ((len > firstread) && (len <= hdrlen))
+			bus->rxpred_saved++;
+
+		/* The header read may have taken the whole frame */
+		waste = 0;
+		if (hdrlen > len) {
+			waste = hdrlen - len;
+			hdrlen = len;
+		}
+#endif /* DHD_RX_PREDICT */
+
 		/* Save the readahead length if there is one */
 		bus->nextlen = bus->rxhdr[SDPCM_FRAMETAG_LEN + SDPCM_NEXTLEN_OFFSET];
 		if ((bus->nextlen << 4) > MAX_RX_DATASZ) {
@@ -6409,7 +6674,10 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 
 		/* Call a separate function for control frames */
 		if (chan == SDPCM_CONTROL_CHANNEL) {
-			dhdsdio_read_control(bus, bus->rxhdr, len, doff);
+#ifdef DHD_RX_PREDICT
+			dhdsdio_rxpred_account(bus, 1, (len > hdrlen) ? 2 : 1, waste);
+#endif /* DHD_RX_PREDICT */
+			dhdsdio_read_control(bus, bus->rxhdr, hdrlen, len, doff);
 			continue;
 		}
 
@@ -6417,13 +6685,13 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 		       (chan == SDPCM_TEST_CHANNEL) || (chan == SDPCM_GLOM_CHANNEL));
 
 		/* Length to read */
-		rdlen = (len > firstread) ? (len - firstread) : 0;
+		rdlen = (len > hdrlen) ? (len - hdrlen) : 0;
 
 		/* May pad read to blocksize for efficiency */
 		if (bus->roundup && bus->blocksize && (rdlen > bus->blocksize)) {
 			pad = bus->blocksize - (rdlen % bus->blocksize);
 			if ((pad <= bus->roundup) && (pad < bus->blocksize) &&
-			    ((rdlen + pad + firstread) < MAX_RX_DATASZ))
+			    ((rdlen + pad + hdrlen) < MAX_RX_DATASZ))
 				rdlen += pad;
 		} else if (rdlen % DHD_SDALIGN) {
 			rdlen += DHD_SDALIGN - (rdlen % DHD_SDALIGN);
@@ -6433,7 +6701,7 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 		if (forcealign && (rdlen & (ALIGNMENT - 1)))
 			rdlen = ROUNDUP(rdlen, ALIGNMENT);
 
-		if ((rdlen + firstread) > MAX_RX_DATASZ) {
+		if ((rdlen + hdrlen) > MAX_RX_DATASZ) {
 			/* Too long -- skip this frame */
 			DHD_ERROR(("%s: too long: len %d rdlen %d\n", __FUNCTION__, len, rdlen));
 			bus->dhd->rx_errors++; bus->rx_toolong++;
@@ -6442,7 +6710,7 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 		}
 
 		dhd_os_sdlock_rxq(bus->dhd);
-		if (!(pkt = PKTGET(osh, (rdlen + firstread + DHD_SDALIGN), FALSE))) {
+		if (!(pkt = PKTGET(osh, (rdlen + hdrlen + DHD_SDALIGN), FALSE))) {
 			/* Give up on data, request rtx of events */
 			DHD_ERROR(("%s: PKTGET failed: rdlen %d chan %d\n",
 			           __FUNCTION__, rdlen, chan));
@@ -6457,14 +6725,28 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 
 		/* XXX Should check len for small packets in case we're done? */
 		/* Leave room for what we already read, and align remainder */
-		ASSERT(firstread < (PKTLEN(osh, pkt)));
-		PKTPULL(osh, pkt, firstread);
+		ASSERT(hdrlen < (PKTLEN(osh, pkt)));
+		PKTPULL(osh, pkt, hdrlen);
 		PKTALIGN(osh, pkt, rdlen, DHD_SDALIGN);
 
-		/* Read the remaining frame data */
-		sdret = dhd_bcmsdh_recv_buf(bus, bcmsdh_cur_sbwad(sdh), SDIO_FUNC_2, F2SYNC,
-		                            ((uint8 *)PKTDATA(osh, pkt)), rdlen, pkt, NULL, NULL);
-		bus->f2rxdata++;
+#ifdef DHD_RX_PREDICT
+		if (rdlen)
+			waste += rdlen - (len - hdrlen);
+		dhdsdio_rxpred_account(bus, (chan == SDPCM_GLOM_CHANNEL) ? 0 : 1,
+		                       rdlen ? 2 : 1, waste);
+
+		/* Nothing left to read if the header read took the whole frame */
+		if (rdlen == 0) {
+			sdret = BCME_OK;
+		} else
+#endif /* DHD_RX_PREDICT */
+		{
+			/* Read the remaining frame data */
+			sdret = dhd_bcmsdh_recv_buf(bus, bcmsdh_cur_sbwad(sdh), SDIO_FUNC_2,
+			                            F2SYNC, ((uint8 *)PKTDATA(osh, pkt)), rdlen,
+			                            pkt, NULL, NULL);
+			bus->f2rxdata++;
+		}
 		ASSERT(sdret != BCME_PENDING);
 
 		if (sdret < 0) {
@@ -6480,8 +6762,8 @@ dhdsdio_readframes(dhd_bus_t *bus, uint maxframes, bool *finished)
 		}
 
 		/* Copy the already-read portion */
-		PKTPUSH(osh, pkt, firstread);
-		bcopy(bus->rxhdr, PKTDATA(osh, pkt), firstread);
+		PKTPUSH(osh, pkt, hdrlen);
+		bcopy(bus->rxhdr, PKTDATA(osh, pkt), hdrlen);
 
 #ifdef DHD_DEBUG
 		if (DHD_BYTES_ON() && DHD_DATA_ON()) {
@@ -6540,8 +6822,8 @@ deliver:
 
 		if (reorder_info_len) {
 			/* Reordering info from the firmware */
-			dhd_process_pkt_reorder_info(bus->dhd, reorder_info_buf, reorder_info_len,
-				&pkt, &pkt_count);
+			dhd_process_pkt_reorder_info(bus->dhd, ifidx, reorder_info_buf,
+				reorder_info_len, &pkt, &pkt_count);
 			if (pkt_count == 0)
 				continue;
 		} else {
@@ -6569,6 +6851,10 @@ deliver:
 		rxseq--;
 	bus->rx_seq = rxseq;
 
+#ifdef DHD_RX_PREDICT
+	dhdsdio_rxpred_tick(bus);
+#endif /* DHD_RX_PREDICT */
+
 	if (bus->reqbussleep)
 	{
 	    dhdsdio_bussleep(bus, TRUE);
@@ -6966,9 +7252,9 @@ clkwait:
 		}
 	} else if (bus->clkstate == CLK_PENDING) {
 		/* Awaiting I_CHIPACTIVE; don't resched */
-	} else if (bus->intstatus || bus->ipend ||
+	} else if ((bus->intstatus & ~RXF_PAUSED_MASK(bus)) || bus->ipend ||
 	           (!bus->fcstate && pktq_mlen(&bus->txq, ~bus->flowcontrol) && DATAOK(bus)) ||
-			PKT_AVAILABLE(bus, bus->intstatus)) {  /* Read multiple frames */
+			(PKT_AVAILABLE(bus, bus->intstatus) && !RXF_THROTTLED(bus))) {  /* Read multiple frames */
 		resched = TRUE;
 	}
 
@@ -8223,6 +8509,9 @@ dhdsdio_probe_attach(struct dhd_bus *bus, osl_t *osh, void *sdh, void *regsva,
 
 	/* Locate an appropriately-aligned portion of hdrbuf */
 	bus->rxhdr = (uint8 *)ROUNDUP((uintptr)&bus->hdrbuf[0], DHD_SDALIGN);
+#ifdef DHD_RX_PREDICT
+	bus->rxpred_len = firstread;
+#endif /* DHD_RX_PREDICT */
 
 	/* Set the poll and/or interrupt flags */
 	bus->intr = (bool)dhd_intr;
@@ -151,14 +151,19 @@ _dhd_wlfc_prec_enque(struct pktq *pq, int prec, void* p, bool qHead,
 
 				if (p2_prev == NULL) {
 					/* insert head */
+					if (q->head == q->tail)
+						PKTQ_PREC_TAIL_PREV_SET(q, p);
 					PKTSETLINK(p, q->head);
 					q->head = p;
 				} else if (p2 == NULL) {
 					/* insert tail */
 					PKTSETLINK(p2_prev, p);
+					PKTQ_PREC_TAIL_PREV_SET(q, p2_prev);
 					q->tail = p;
 				} else {
 					/* insert after p2_prev */
+					if (PKTLINK(p2_prev) == q->tail)
+						PKTQ_PREC_TAIL_PREV_SET(q, p);
 					PKTSETLINK(p, PKTLINK(p2_prev));
 					PKTSETLINK(p2_prev, p);
 				}
@@ -167,10 +172,13 @@ _dhd_wlfc_prec_enque(struct pktq *pq, int prec, void* p, bool qHead,
 		}
 
 		if (qHead) {
+			if (q->head == q->tail)
+				PKTQ_PREC_TAIL_PREV_SET(q, p);
 			PKTSETLINK(p, q->head);
 			q->head = p;
 		} else {
 			PKTSETLINK(q->tail, p);
+			PKTQ_PREC_TAIL_PREV_SET(q, q->tail);
 			q->tail = p;
 		}
 	}
@@ -182,8 +190,88 @@ exit:
 
 	if (pq->hi_prec < prec)
 		pq->hi_prec = (uint8)prec;
+	PKTQ_PREC_BMP_SET(pq, prec);
 } /* _dhd_wlfc_prec_enque */
 
+#ifdef DHD_WLFC_HANGER_BITMAP
+/** mark a hanger slot free in the free slot bitmap */
+static INLINE void
+_dhd_wlfc_hanger_map_set(wlfc_hanger_t* h, uint32 slot_id)
+{
+	uint32 w = slot_id >> 5;
+	uint32 bit = 1u << (slot_id & 31);
+
+	if (!(h->free_map[w] & bit)) {
+		h->free_map[w] |= bit;
+		h->free_sum[w >> 5] |= 1u << (w & 31);
+		h->nfree++;
+	}
+}
+
+/** mark a hanger slot taken in the free slot bitmap */
+static INLINE void
+_dhd_wlfc_hanger_map_clr(wlfc_hanger_t* h, uint32 slot_id)
+{
+	uint32 w = slot_id >> 5;
+	uint32 bit = 1u << (slot_id & 31);
+
+	if (h->free_map[w] & bit) {
+		h->free_map[w] &= ~bit;
+		if (!h->free_map[w]) {
+			h->free_sum[w >> 5] &= ~(1u << (w & 31));
+		}
+		h->nfree--;
+		if (h->nfree < h->min_free) {
+			h->min_free = h->nfree;
+		}
+	}
+}
+
+/**
+ * First free slot at or after start, wrapping around. The summary bitmap
+ * leads straight to the next non empty map word, so the lookup touches at
+ * most WLFC_HANGER_SUM_WORDS + 2 words whatever the occupancy.
+ */
+static uint32
+_dhd_wlfc_hanger_map_next(wlfc_hanger_t* h, uint32 start)
+{
+	uint32 w, next, bits;
+	int i;
+
+	if (start >= (uint32)h->max_items) {
+		start = 0;
+	}
+
+	w = start >> 5;
+	bits = h->free_map[w] & (~0u << (start & 31));
+	if (bits) {
+		return (w << 5) + __builtin_ctz(bits);
+	}
+
+	/* the start word comes around last, for the slots below start */
+	next = w + 1;
+	for (i = 0; i <= WLFC_HANGER_SUM_WORDS; i++) {
+		if (next >= WLFC_HANGER_MAP_WORDS) {
+			next = 0;
+		}
+		bits = h->free_sum[next >> 5] & (~0u << (next & 31));
+		if (bits) {
+			w = ((next >> 5) << 5) + __builtin_ctz(bits);
+			return (w << 5) + __builtin_ctz(h->free_map[w]);
+		}
+		next = ((next >> 5) + 1) << 5;
+	}
+
+	return WLFC_HANGER_MAXITEMS;
+}
+
+#define WLFC_HANGER_SLOT_FREED(h, slot_id)	_dhd_wlfc_hanger_map_set((h), (slot_id))
+#define WLFC_HANGER_SLOT_TAKEN(h, slot_id)	_dhd_wlfc_hanger_map_clr((h), (slot_id))
+#else
+#define WLFC_HANGER_SLOT_FREED(h, slot_id)
+#define WLFC_HANGER_SLOT_TAKEN(h, slot_id)
+#endif /* DHD_WLFC_HANGER_BITMAP */
+
 /**
  * Create a place to store all packet pointers submitted to the firmware until a status comes back,
  * suppress or otherwise.
@@ -209,7 +297,11 @@ _dhd_wlfc_hanger_create(dhd_pub_t *dhd, int max_items)
 
 	for (i = 0; i < hanger->max_items; i++) {
 		hanger->items[i].state = WLFC_HANGER_ITEM_STATE_FREE;
+		WLFC_HANGER_SLOT_FREED(hanger, i);
 	}
+#ifdef DHD_WLFC_HANGER_BITMAP
+	hanger->min_free = hanger->nfree;
+#endif /* DHD_WLFC_HANGER_BITMAP */
 	return hanger;
 }
 
@@ -233,6 +325,21 @@ _dhd_wlfc_hanger_get_free_slot(void* hanger)
 	uint32 i;
 	wlfc_hanger_t* h = (wlfc_hanger_t*)hanger;
 
+#ifdef DHD_WLFC_HANGER_BITMAP
+	if (h) {
+		while ((i = _dhd_wlfc_hanger_map_next(h, h->slot_pos + 1)) <
+			WLFC_HANGER_MAXITEMS) {
+			if (h->items[i].state == WLFC_HANGER_ITEM_STATE_FREE) {
+				h->slot_pos = i;
+				return (uint16)i;
+			}
+			/* slot was taken without going through the hanger API */
+			_dhd_wlfc_hanger_map_clr(h, i);
+		}
+		h->failed_slotfind++;
+	}
+	return WLFC_HANGER_MAXITEMS;
+#else
 	if (h) {
 		i = h->slot_pos + 1;
 		if (i == h->max_items) {
@@ -250,6 +357,7 @@ _dhd_wlfc_hanger_get_free_slot(void* hanger)
 		h->failed_slotfind++;
 	}
 	return WLFC_HANGER_MAXITEMS;
+#endif /* DHD_WLFC_HANGER_BITMAP */
 }
 
 /** @deprecated soon */
@@ -292,6 +400,7 @@ _dhd_wlfc_hanger_pushpkt(void* hanger, void* pkt, uint32 slot_id)
 	if (h && (slot_id < WLFC_HANGER_MAXITEMS)) {
 		if (h->items[slot_id].state == WLFC_HANGER_ITEM_STATE_FREE) {
 			h->items[slot_id].state = WLFC_HANGER_ITEM_STATE_INUSE;
+			WLFC_HANGER_SLOT_TAKEN(h, slot_id);
 			h->items[slot_id].pkt = pkt;
 			h->items[slot_id].pkt_state = 0;
 			h->items[slot_id].pkt_txstatus = 0;
@@ -326,6 +435,7 @@ _dhd_wlfc_hanger_poppkt(void* hanger, uint32 slot_id, void** pktout, bool remove
 			if (remove_from_hanger) {
 				h->items[slot_id].state =
 					WLFC_HANGER_ITEM_STATE_FREE;
+				WLFC_HANGER_SLOT_FREED(h, slot_id);
 				h->items[slot_id].pkt = NULL;
 				h->items[slot_id].gen = 0xff;
 				h->items[slot_id].identifier = 0;
@@ -382,6 +492,7 @@ _dhd_wlfc_hanger_remove_reference(wlfc_hanger_t* h, void* pkt)
 	if ((i < h->max_items) && (pkt == h->items[i].pkt)) {
 		if (h->items[i].state == WLFC_HANGER_ITEM_STATE_INUSE_SUPPRESSED) {
 			h->items[i].state = WLFC_HANGER_ITEM_STATE_FREE;
+			WLFC_HANGER_SLOT_FREED(h, i);
 			h->items[i].pkt = NULL;
 			h->items[i].gen = 0xff;
 			h->items[i].identifier = 0;
@@ -471,6 +582,7 @@ _dhd_wlfc_deque_afq(athost_wl_status_info_t* ctx, uint16 hslot, uint8 hcnt, uint
 
 	bcm_pkt_validate_chk(p, "_dhd_wlfc_deque_afq");
 
+	PKTQ_PREC_TAIL_PREV_DEL(q, p);
 	if (!b) {
 		/* head packet is matched */
 		if ((q->head = PKTLINK(p)) == NULL) {
@@ -619,6 +731,62 @@ _dhd_wlfc_pullheader(athost_wl_status_info_t* ctx, void* pktbuf)
 	return BCME_OK;
 }
 
+#ifdef DHD_WLFC_MAC_HASH
+/** unlink a node entry from the MAC hash, keyed by the MAC it was added with */
+static void
+_dhd_wlfc_mac_hash_del(athost_wl_status_info_t* ctx, wlfc_mac_descriptor_t* entry)
+{
+	wlfc_mac_descriptor_t* table = ctx->destination_entries.nodes;
+	uint8 idx = (uint8)(entry - table);
+	uint8 *link;
+
+	link = &ctx->mac_hash[WLFC_MAC_HASH(entry->ea)];
+	while (*link) {
+		if (*link == (idx + 1)) {
+			*link = ctx->mac_hash_next[idx];
+			ctx->mac_hash_next[idx] = 0;
+			return;
+		}
+		link = &ctx->mac_hash_next[*link - 1];
+	}
+}
+
+static void
+_dhd_wlfc_mac_hash_add(athost_wl_status_info_t* ctx, wlfc_mac_descriptor_t* entry)
+{
+	wlfc_mac_descriptor_t* table = ctx->destination_entries.nodes;
+	uint8 idx = (uint8)(entry - table);
+	uint8 bucket = WLFC_MAC_HASH(entry->ea);
+
+	ctx->mac_hash_next[idx] = ctx->mac_hash[bucket];
+	ctx->mac_hash[bucket] = idx + 1;
+}
+
+/** occupied node entry for the MAC, on interface ifid unless ifid is 0xff */
+static wlfc_mac_descriptor_t*
+_dhd_wlfc_mac_hash_find(athost_wl_status_info_t* ctx, const uint8* ea, uint8 ifid)
+{
+	wlfc_mac_descriptor_t* table = ctx->destination_entries.nodes;
+	uint8 i = ctx->mac_hash[WLFC_MAC_HASH(ea)];
+
+	while (i) {
+		wlfc_mac_descriptor_t* entry = &table[i - 1];
+
+		if (entry->occupied && ((ifid == 0xff) || (entry->interface_id == ifid)) &&
+			!memcmp(entry->ea, ea, ETHER_ADDR_LEN)) {
+			return entry;
+		}
+		i = ctx->mac_hash_next[i - 1];
+	}
+
+	return NULL;
+}
+
+#define WLFC_IS_NODE_ENTRY(ctx, entry) \
+	(((entry) >= &(ctx)->destination_entries.nodes[0]) && \
+	((entry) < &(ctx)->destination_entries.nodes[WLFC_MAC_DESC_TABLE_SIZE]))
+#endif /* DHD_WLFC_MAC_HASH */
+
 /**
  * @param[in/out] p packet
  */
@@ -651,6 +819,17 @@ _dhd_wlfc_find_table_entry(athost_wl_status_info_t* ctx, void* p)
 		return entry;
 	}
 
+#ifdef DHD_WLFC_MAC_HASH
+	BCM_REFERENCE(i);
+	BCM_REFERENCE(table);
+	{
+		wlfc_mac_descriptor_t* node = _dhd_wlfc_mac_hash_find(ctx, dstn, ifid);
+
+		if (node) {
+			entry = node;
+		}
+	}
+#else
 	for (i = 0; i < WLFC_MAC_DESC_TABLE_SIZE; i++) {
 		if (table[i].occupied) {
 			if (table[i].interface_id == ifid) {
@@ -661,6 +840,7 @@ _dhd_wlfc_find_table_entry(athost_wl_status_info_t* ctx, void* p)
 			}
 		}
 	}
+#endif /* DHD_WLFC_MAC_HASH */
 
 	if (entry == NULL)
 		entry = &ctx->destination_entries.other;
@@ -1520,6 +1700,7 @@ _dhd_wlfc_hanger_free_pkt(athost_wl_status_info_t* wlfc, uint32 slot_id, uint8 p
 			DHD_ERROR(("Error: %s():%d Multiple TXSTATUS or BUSRETURNED: %d (%d)\n",
 			    __FUNCTION__, __LINE__, item->pkt_state, pkt_state));
 		item->state = WLFC_HANGER_ITEM_STATE_FREE;
+		WLFC_HANGER_SLOT_FREED(hanger, slot_id);
 	}
 } /* _dhd_wlfc_hanger_free_pkt */
 
@@ -1550,6 +1731,7 @@ _dhd_wlfc_pktq_flush(athost_wl_status_info_t* ctx, struct pktq *pq,
 			bcm_pkt_validate_chk(p, "_dhd_wlfc_pktq_flush");
 			if (fn == NULL || (*fn)(p, arg)) {
 				bool head = (p == q->head);
+				PKTQ_PREC_TAIL_PREV_DEL(q, p);
 				if (head)
 					q->head = PKTLINK(p);
 				else
@@ -1650,6 +1832,7 @@ _dhd_wlfc_pktq_pdeq_with_fn(struct pktq *pq, int prec, f_processpkt_t fn, void *
 
 	bcm_pkt_validate_chk(p, "_dhd_wlfc_pktq_flush");
 
+	PKTQ_PREC_TAIL_PREV_DEL(q, p);
 	if (prev == NULL) {
 		if ((q->head = PKTLINK(p)) == NULL) {
 			q->tail = NULL;
@@ -1775,6 +1958,11 @@ _dhd_wlfc_cleanup(dhd_pub_t *dhd, f_processpkt_t fn, void *arg)
 			}
 
 			if ((fn == NULL) && (&table[i] != &wlfc->destination_entries.other)) {
+#ifdef DHD_WLFC_MAC_HASH
+				if (WLFC_IS_NODE_ENTRY(wlfc, &table[i])) {
+					_dhd_wlfc_mac_hash_del(wlfc, &table[i]);
+				}
+#endif /* DHD_WLFC_MAC_HASH */
 				table[i].occupied = 0;
 				if (table[i].transit_count || table[i].suppr_transit_count) {
 					DHD_ERROR(("%s: table[%d] transit(%d), suppr_tansit(%d)\n",
@@ -1814,6 +2002,12 @@ _dhd_wlfc_mac_entry_update(athost_wl_status_info_t* ctx, wlfc_mac_descriptor_t*
 	int rc = BCME_OK;
 
 	if ((action == eWLFC_MAC_ENTRY_ACTION_ADD) || (action == eWLFC_MAC_ENTRY_ACTION_UPDATE)) {
+#ifdef DHD_WLFC_MAC_HASH
+		if (WLFC_IS_NODE_ENTRY(ctx, entry) && entry->occupied) {
+			/* rehashed below, the MAC may change */
+			_dhd_wlfc_mac_hash_del(ctx, entry);
+		}
+#endif /* DHD_WLFC_MAC_HASH */
 		entry->occupied = 1;
 		entry->state = WLFC_STATE_OPEN;
 		entry->requested_credit = 0;
@@ -1824,6 +2018,11 @@ _dhd_wlfc_mac_entry_update(athost_wl_status_info_t* ctx, wlfc_mac_descriptor_t*
 		/* for an interface entry we may not care about the MAC address */
 		if (ea != NULL)
 			memcpy(&entry->ea[0], ea, ETHER_ADDR_LEN);
+#ifdef DHD_WLFC_MAC_HASH
+		if (WLFC_IS_NODE_ENTRY(ctx, entry)) {
+			_dhd_wlfc_mac_hash_add(ctx, entry);
+		}
+#endif /* DHD_WLFC_MAC_HASH */
 
 		if (action == eWLFC_MAC_ENTRY_ACTION_ADD) {
 			entry->suppressed = FALSE;
@@ -1867,6 +2066,11 @@ _dhd_wlfc_mac_entry_update(athost_wl_status_info_t* ctx, wlfc_mac_descriptor_t*
 		_dhd_wlfc_cleanup(ctx->dhdp, fn, arg);
 		_dhd_wlfc_flow_control_check(ctx, &entry->psq, ifid);
 
+#ifdef DHD_WLFC_MAC_HASH
+		if (WLFC_IS_NODE_ENTRY(ctx, entry) && entry->occupied) {
+			_dhd_wlfc_mac_hash_del(ctx, entry);
+		}
+#endif /* DHD_WLFC_MAC_HASH */
 		entry->occupied = 0;
 		entry->state = WLFC_STATE_CLOSE;
 		memset(&entry->ea[0], 0, ETHER_ADDR_LEN);
@@ -2102,6 +2306,17 @@ _dhd_wlfc_find_mac_desc_id_from_mac(dhd_pub_t *dhdp, uint8 *ea)
 		((athost_wl_status_info_t*)dhdp->wlfc_state)->destination_entries.nodes;
 	uint8 table_index;
 
+#ifdef DHD_WLFC_MAC_HASH
+	if (ea != NULL) {
+		wlfc_mac_descriptor_t* entry =
+			_dhd_wlfc_mac_hash_find((athost_wl_status_info_t*)dhdp->wlfc_state, ea, 0xff);
+
+		BCM_REFERENCE(table_index);
+		if (entry) {
+			return (uint8)(entry - table);
+		}
+	}
+#else
 	if (ea != NULL) {
 		for (table_index = 0; table_index < WLFC_MAC_DESC_TABLE_SIZE; table_index++) {
 			if ((memcmp(ea, &table[table_index].ea[0], ETHER_ADDR_LEN) == 0) &&
@@ -2109,6 +2324,7 @@ _dhd_wlfc_find_mac_desc_id_from_mac(dhd_pub_t *dhdp, uint8 *ea)
 				return table_index;
 		}
 	}
+#endif /* DHD_WLFC_MAC_HASH */
 	return WLFC_MAC_DESC_ID_INVALID;
 }
 
@@ -2169,6 +2385,7 @@ dhd_wlfc_suppressed_acked_update(dhd_pub_t *dhd, uint16 hslot, uint8 prec, uint8
 		return BCME_ERROR;
 	}
 
+	PKTQ_PREC_TAIL_PREV_DEL(q, p);
 	if (!b) {
 		/* head packet is matched */
 		if ((q->head = PKTLINK(p)) == NULL) {
@@ -3928,6 +4145,9 @@ dhd_wlfc_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 		if (h == NULL) {
 			bcm_bprintf(strbuf, "wlfc-hanger not initialized yet\n");
 		} else {
+			uint32 occ[WLFC_HANGER_ITEM_STATE_FLUSHED + 1] = {0};
+			int j;
+
 			bcm_bprintf(strbuf, "wlfc hanger (pushed,popped,f_push,"
 				"f_pop,f_slot, pending) = (%d,%d,%d,%d,%d,%d)\n",
 				h->pushed,
@@ -3936,6 +4156,22 @@ dhd_wlfc_dump(dhd_pub_t *dhdp, struct bcmstrbuf *strbuf)
 				h->failed_to_pop,
 				h->failed_slotfind,
 				(h->pushed - h->popped));
+			for (j = 0; j < h->max_items; j++) {
+				if (h->items[j].state <= WLFC_HANGER_ITEM_STATE_FLUSHED) {
+					occ[h->items[j].state]++;
+				}
+			}
+			bcm_bprintf(strbuf, "wlfc hanger occupancy (free,inuse,suppressed,"
+				"flushed) = (%d,%d,%d,%d)/%d\n",
+				occ[WLFC_HANGER_ITEM_STATE_FREE],
+				occ[WLFC_HANGER_ITEM_STATE_INUSE],
+				occ[WLFC_HANGER_ITEM_STATE_INUSE_SUPPRESSED],
+				occ[WLFC_HANGER_ITEM_STATE_FLUSHED],
+				h->max_items);
+#ifdef DHD_WLFC_HANGER_BITMAP
+			bcm_bprintf(strbuf, "wlfc hanger free map (free,peak_inuse) = (%d,%d)\n",
+				h->nfree, h->max_items - h->min_free);
+#endif /* DHD_WLFC_HANGER_BITMAP */
 		}
 	}
 
@@ -46,6 +46,17 @@ typedef bool (*f_processpkt_t)(void* p, void* arg);
 #define WLFC_HANGER_ITEM_STATE_INUSE_SUPPRESSED		3
 #define WLFC_HANGER_ITEM_STATE_FLUSHED			4
 
+#ifdef DHD_WLFC_MAC_HASH
+#define WLFC_MAC_HASH_SIZE	32	/* power of 2 */
+#define WLFC_MAC_HASH(ea)	(((ea)[3] ^ (ea)[4] ^ (ea)[5]) & (WLFC_MAC_HASH_SIZE - 1))
+#endif /* DHD_WLFC_MAC_HASH */
+
+#ifdef DHD_WLFC_HANGER_BITMAP
+/** one bit per slot, plus one summary bit per non empty map word */
+#define WLFC_HANGER_MAP_WORDS	((WLFC_HANGER_MAXITEMS + 31) / 32)
+#define WLFC_HANGER_SUM_WORDS	((WLFC_HANGER_MAP_WORDS + 31) / 32)
+#endif /* DHD_WLFC_HANGER_BITMAP */
+
 #define WLFC_HANGER_PKT_STATE_TXSTATUS			1
 #define WLFC_HANGER_PKT_STATE_BUSRETURNED		2
 #define WLFC_HANGER_PKT_STATE_COMPLETE			\
@@ -92,6 +103,12 @@ typedef struct wlfc_hanger {
 	uint32 failed_to_pop;
 	uint32 failed_slotfind;
 	uint32 slot_pos;
+#ifdef DHD_WLFC_HANGER_BITMAP
+	uint32 nfree;		/**< slots with a bit set in free_map */
+	uint32 min_free;	/**< low watermark of nfree */
+	uint32 free_map[WLFC_HANGER_MAP_WORDS];	/**< bit set: slot is free */
+	uint32 free_sum[WLFC_HANGER_SUM_WORDS];	/**< bit set: free_map word is non zero */
+#endif /* DHD_WLFC_HANGER_BITMAP */
 	/** XXX: items[1] should be the last element here. Do not add new elements below it. */
 	wlfc_hanger_item_t items[1];
 } wlfc_hanger_t;
@@ -303,6 +320,12 @@ typedef struct athost_wl_status_info {
 	wlfc_mac_descriptor_t *active_entry_head; /**< a chain of MAC descriptors */
 	int active_entry_count;
 
+#ifdef DHD_WLFC_MAC_HASH
+	/** MAC -> node index + 1 chains over destination_entries.nodes, 0 ends a chain */
+	uint8 mac_hash[WLFC_MAC_HASH_SIZE];
+	uint8 mac_hash_next[WLFC_MAC_DESC_TABLE_SIZE];
+#endif /* DHD_WLFC_MAC_HASH */
+
 	wlfc_mac_descriptor_t *requested_entry[WLFC_MAC_DESC_TABLE_SIZE];
 	int requested_entry_count;
 
@@ -45,6 +45,76 @@
 #define TXQ_PKT_DEL		0x01
 #define HEAD_PKT_FLUSHED	0xFF
 #endif /* defined(PROP_TXSTATUS) */
+
+#ifdef HND_PKTQ_PREC_BMP
+/*
+ * Highest non-empty precedence in prec_bmp, or -1. Bits of precedences that
+ * were emptied by a direct unlink are cleared on the way.
+ */
+static INLINE int
+BCMFASTPATH(_pktq_hi_prec)(struct pktq *pq, uint prec_bmp)
+{
+	uint bmp = pq->prec_bmp & prec_bmp;
+	int prec;
+
+	while (bmp) {
+		prec = 31 - __builtin_clz(bmp);
+		if (pq->q[prec].head)
+			return prec;
+		pq->prec_bmp &= ~(1u << prec);
+		bmp &= ~(1u << prec);
+	}
+
+	return -1;
+}
+
+/* Lowest non-empty precedence in prec_bmp, or -1 */
+static INLINE int
+BCMFASTPATH(_pktq_lo_prec)(struct pktq *pq, uint prec_bmp)
+{
+	uint bmp = pq->prec_bmp & prec_bmp;
+	int prec;
+
+	while (bmp) {
+		prec = __builtin_ctz(bmp);
+		if (pq->q[prec].head)
+			return prec;
+		pq->prec_bmp &= ~(1u << prec);
+		bmp &= bmp - 1;
+	}
+
+	return -1;
+}
+
+/*
+ * Unlink the tail of a non-empty queue. The list is singly linked, so the
+ * predecessor comes from the cache filled by tail enqueue; failing that the
+ * list is walked once, which also yields the predecessor of the new tail.
+ */
+static void *
+BCMFASTPATH(_pktq_prec_deq_tail)(struct pktq_prec *q)
+{
+	void *p = q->tail;
+	void *prev = q->tail_prev;
+	void *prev2 = NULL;
+
+	if (prev == NULL && q->head != p) {
+		for (prev = q->head; PKTLINK(prev) != p; prev = PKTLINK(prev))
+			prev2 = prev;
+	}
+
+	if (prev)
+		PKTSETLINK(prev, NULL);
+	else
+		q->head = NULL;
+
+	q->tail = prev;
+	q->tail_prev = prev2;
+	q->n_pkts--;
+
+	return p;
+}
+#endif /* HND_PKTQ_PREC_BMP */
 /*
  * osl multiple-precedence packet queue
  * hi_prec is always >= the number of the highest non-empty precedence
@@ -71,6 +141,7 @@ BCMFASTPATH(pktq_penq)(struct pktq *pq, int prec, void *p)
 	else
 		q->head = p;
 
+	PKTQ_PREC_TAIL_PREV_SET(q, q->tail);
 	q->tail = p;
 	q->n_pkts++;
 
@@ -78,6 +149,7 @@ BCMFASTPATH(pktq_penq)(struct pktq *pq, int prec, void *p)
 
 	if (pq->hi_prec < prec)
 		pq->hi_prec = (uint8)prec;
+	PKTQ_PREC_BMP_SET(pq, prec);
 
 	/* protect shared resource */
 	if (HND_PKTQ_MUTEX_RELEASE(&pq->mutex) != OSL_EXT_SUCCESS)
@@ -110,6 +182,7 @@ BCMFASTPATH(spktq_enq_chain)(struct spktq *dspq, struct spktq *sspq)
 		dq->head = sq->head;
 	}
 
+	PKTQ_PREC_TAIL_PREV_SET(dq, (sq->n_pkts > 1) ? sq->tail_prev : dq->tail);
 	dq->tail = sq->tail;
 	dq->n_pkts += sq->n_pkts;
 
@@ -147,6 +220,7 @@ BCMFASTPATH(spktq_enq)(struct spktq *spq, void *p)
 	else
 		q->head = p;
 
+	PKTQ_PREC_TAIL_PREV_SET(q, q->tail);
 	q->tail = p;
 	q->n_pkts++;
 
@@ -176,6 +250,8 @@ BCMFASTPATH(pktq_penq_head)(struct pktq *pq, int prec, void *p)
 
 	if (q->head == NULL)
 		q->tail = p;
+	else if (q->head == q->tail)
+		PKTQ_PREC_TAIL_PREV_SET(q, p);
 
 	PKTSETLINK(p, q->head);
 	q->head = p;
@@ -185,6 +261,7 @@ BCMFASTPATH(pktq_penq_head)(struct pktq *pq, int prec, void *p)
 
 	if (pq->hi_prec < prec)
 		pq->hi_prec = (uint8)prec;
+	PKTQ_PREC_BMP_SET(pq, prec);
 
 	/* protect shared resource */
 	if (HND_PKTQ_MUTEX_RELEASE(&pq->mutex) != OSL_EXT_SUCCESS)
@@ -210,6 +287,8 @@ BCMFASTPATH(spktq_enq_head)(struct spktq *spq, void *p)
 
 	if (q->head == NULL)
 		q->tail = p;
+	else if (q->head == q->tail)
+		PKTQ_PREC_TAIL_PREV_SET(q, p);
 
 	PKTSETLINK(p, q->head);
 	q->head = p;
@@ -239,6 +318,7 @@ BCMFASTPATH(pktq_pdeq)(struct pktq *pq, int prec)
 	if ((p = q->head) == NULL)
 		goto done;
 
+	PKTQ_PREC_TAIL_PREV_DEL(q, p);
 	if ((q->head = PKTLINK(p)) == NULL)
 		q->tail = NULL;
 
@@ -275,6 +355,7 @@ BCMFASTPATH(spktq_deq)(struct spktq *spq)
 	if ((p = q->head) == NULL)
 		goto done;
 
+	PKTQ_PREC_TAIL_PREV_DEL(q, p);
 	if ((q->head = PKTLINK(p)) == NULL)
 		q->tail = NULL;
 
@@ -311,6 +392,10 @@ BCMFASTPATH(pktq_pdeq_tail)(struct pktq *pq, int prec)
 	if ((p = q->head) == NULL)
 		goto done;
 
+#ifdef HND_PKTQ_PREC_BMP
+	BCM_REFERENCE(prev);
+	p = _pktq_prec_deq_tail(q);
+#else
 	for (prev = NULL; p != q->tail; p = PKTLINK(p))
 		prev = p;
 
@@ -321,6 +406,7 @@ BCMFASTPATH(pktq_pdeq_tail)(struct pktq *pq, int prec)
 
 	q->tail = prev;
 	q->n_pkts--;
+#endif /* HND_PKTQ_PREC_BMP */
 
 	pq->n_pkts_tot--;
 
@@ -350,6 +436,10 @@ BCMFASTPATH(spktq_deq_tail)(struct spktq *spq)
 	if ((p = q->head) == NULL)
 		goto done;
 
+#ifdef HND_PKTQ_PREC_BMP
+	BCM_REFERENCE(prev);
+	p = _pktq_prec_deq_tail(q);
+#else
 	for (prev = NULL; p != q->tail; p = PKTLINK(p))
 		prev = p;
 
@@ -360,6 +450,7 @@ BCMFASTPATH(spktq_deq_tail)(struct spktq *spq)
 
 	q->tail = prev;
 	q->n_pkts--;
+#endif /* HND_PKTQ_PREC_BMP */
 
 #ifdef WL_TXQ_STALL
 	q->dequeue_count++;
@@ -385,9 +476,14 @@ pktq_peek_tail(struct pktq *pq, int *prec_out)
 	if (pq->n_pkts_tot == 0)
 		goto done;
 
+#ifdef HND_PKTQ_PREC_BMP
+	if ((prec = _pktq_lo_prec(pq, ~0u)) < 0)
+		goto done;
+#else
 	for (prec = 0; prec < pq->hi_prec; prec++)
 		if (pq->q[prec].head)
 			break;
+#endif /* HND_PKTQ_PREC_BMP */
 
 	if (prec_out)
 		*prec_out = prec;
@@ -434,12 +530,14 @@ BCMFASTPATH(pktq_append)(struct pktq *pq, int prec, struct spktq *list)
 	else
 		q->head = list_q->head;
 
+	PKTQ_PREC_TAIL_PREV_SET(q, (list_q->n_pkts > 1) ? list_q->tail_prev : q->tail);
 	q->tail = list_q->tail;
 	q->n_pkts += list_q->n_pkts;
 	pq->n_pkts_tot += list_q->n_pkts;
 
 	if (pq->hi_prec < prec)
 		pq->hi_prec = (uint8)prec;
+	PKTQ_PREC_BMP_SET(pq, prec);
 
 #ifdef WL_TXQ_STALL
 	list_q->dequeue_count += list_q->n_pkts;
@@ -447,6 +545,7 @@ BCMFASTPATH(pktq_append)(struct pktq *pq, int prec, struct spktq *list)
 
 	list_q->head = NULL;
 	list_q->tail = NULL;
+	PKTQ_PREC_TAIL_PREV_SET(list_q, NULL);
 	list_q->n_pkts = 0;
 
 done:
@@ -485,6 +584,7 @@ BCMFASTPATH(spktq_append)(struct spktq *spq, struct spktq *list)
 	else
 		q->head = list_q->head;
 
+	PKTQ_PREC_TAIL_PREV_SET(q, (list_q->n_pkts > 1) ? list_q->tail_prev : q->tail);
 	q->tail = list_q->tail;
 	q->n_pkts += list_q->n_pkts;
 
@@ -494,6 +594,7 @@ BCMFASTPATH(spktq_append)(struct spktq *spq, struct spktq *list)
 
 	list_q->head = NULL;
 	list_q->tail = NULL;
+	PKTQ_PREC_TAIL_PREV_SET(list_q, NULL);
 	list_q->n_pkts = 0;
 
 done:
@@ -529,6 +630,11 @@ BCMFASTPATH(pktq_prepend)(struct pktq *pq, int prec, struct spktq *list)
 
 	q = &pq->q[prec];
 
+	if (q->head == NULL)
+		PKTQ_PREC_TAIL_PREV_SET(q, list_q->tail_prev);
+	else if (q->head == q->tail)
+		PKTQ_PREC_TAIL_PREV_SET(q, list_q->tail);
+
 	/* set the tail packet of list to point at the former pq head */
 	PKTSETLINK(list_q->tail, q->head);
 	/* the new q head is the head of list */
@@ -546,6 +652,7 @@ BCMFASTPATH(pktq_prepend)(struct pktq *pq, int prec, struct spktq *list)
 
 	if (pq->hi_prec < prec)
 		pq->hi_prec = (uint8)prec;
+	PKTQ_PREC_BMP_SET(pq, prec);
 
 #ifdef WL_TXQ_STALL
 	list_q->dequeue_count += list_q->n_pkts;
@@ -553,6 +660,7 @@ BCMFASTPATH(pktq_prepend)(struct pktq *pq, int prec, struct spktq *list)
 
 	list_q->head = NULL;
 	list_q->tail = NULL;
+	PKTQ_PREC_TAIL_PREV_SET(list_q, NULL);
 	list_q->n_pkts = 0;
 
 done:
@@ -586,6 +694,11 @@ BCMFASTPATH(spktq_prepend)(struct spktq *spq, struct spktq *list)
 
 	q = &spq->q;
 
+	if (q->head == NULL)
+		PKTQ_PREC_TAIL_PREV_SET(q, list_q->tail_prev);
+	else if (q->head == q->tail)
+		PKTQ_PREC_TAIL_PREV_SET(q, list_q->tail);
+
 	/* set the tail packet of list to point at the former pq head */
 	PKTSETLINK(list_q->tail, q->head);
 	/* the new q head is the head of list */
@@ -606,6 +719,7 @@ BCMFASTPATH(spktq_prepend)(struct spktq *spq, struct spktq *list)
 
 	list_q->head = NULL;
 	list_q->tail = NULL;
+	PKTQ_PREC_TAIL_PREV_SET(list_q, NULL);
 	list_q->n_pkts = 0;
 
 done:
@@ -634,6 +748,8 @@ BCMFASTPATH(pktq_pdeq_prev)(struct pktq *pq, int prec, void *prev_p)
 	if ((p = PKTLINK(prev_p)) == NULL)
 		goto done;
 
+	PKTQ_PREC_TAIL_PREV_DEL(q, p);
+
 	q->n_pkts--;
 
 	pq->n_pkts_tot--;
@@ -678,6 +794,7 @@ BCMFASTPATH(pktq_pdeq_with_fn)(struct pktq *pq, int prec, ifpkt_cb_t fn, int arg
 	if (p == NULL)
 		goto done;
 
+	PKTQ_PREC_TAIL_PREV_DEL(q, p);
 	if (prev == NULL) {
 		if ((q->head = PKTLINK(p)) == NULL) {
 			q->tail = NULL;
@@ -725,6 +842,7 @@ BCMFASTPATH(pktq_pdel)(struct pktq *pq, void *pktbuf, int prec)
 
 	q = &pq->q[prec];
 
+	PKTQ_PREC_TAIL_PREV_DEL(q, pktbuf);
 	if (q->head == pktbuf) {
 		if ((q->head = PKTLINK(pktbuf)) == NULL)
 			q->tail = NULL;
@@ -776,6 +894,7 @@ _pktq_pfilter(struct pktq *pq, int prec, pktq_filter_t fltr, void* fltr_ctx,
 
 	q->head = NULL;
 	q->tail = NULL;
+	PKTQ_PREC_TAIL_PREV_SET(q, NULL);
 	q->n_pkts = 0;
 
 #ifdef WL_TXQ_STALL
@@ -893,6 +1012,7 @@ spktq_filter(struct spktq *spq, pktq_filter_t fltr, void* fltr_ctx,
 
 	q->head = NULL;
 	q->tail = NULL;
+	PKTQ_PREC_TAIL_PREV_SET(q, NULL);
 	q->n_pkts = 0;
 
 #ifdef WL_TXQ_STALL
@@ -991,6 +1111,7 @@ spktq_init_list(struct spktq *spq, uint max_pkts, void *head, void *tail, uint16
 	PKTSETLINK(tail, NULL);
 	spq->q.head = head;
 	spq->q.tail = tail;
+	PKTQ_PREC_TAIL_PREV_SET(&spq->q, NULL);
 	spq->q.max_pkts = (uint16)max_pkts;
 	spq->q.n_pkts = n_pkts;
 	spq->q.stall_count = 0;
@@ -1050,14 +1171,20 @@ BCMFASTPATH(pktq_deq)(struct pktq *pq, int *prec_out)
 	if (pq->n_pkts_tot == 0)
 		goto done;
 
+#ifdef HND_PKTQ_PREC_BMP
+	if ((prec = _pktq_hi_prec(pq, ~0u)) < 0)
+		goto done;
+#else
 	while ((prec = pq->hi_prec) > 0 && pq->q[prec].head == NULL)
 		pq->hi_prec--;
+#endif /* HND_PKTQ_PREC_BMP */
 
 	q = &pq->q[prec];
 
 	if ((p = q->head) == NULL)
 		goto done;
 
+	PKTQ_PREC_TAIL_PREV_DEL(q, p);
 	if ((q->head = PKTLINK(p)) == NULL)
 		q->tail = NULL;
 
@@ -1096,15 +1223,24 @@ BCMFASTPATH(pktq_deq_tail)(struct pktq *pq, int *prec_out)
 	if (pq->n_pkts_tot == 0)
 		goto done;
 
+#ifdef HND_PKTQ_PREC_BMP
+	if ((prec = _pktq_lo_prec(pq, ~0u)) < 0)
+		goto done;
+#else
 	for (prec = 0; prec < pq->hi_prec; prec++)
 		if (pq->q[prec].head)
 			break;
+#endif /* HND_PKTQ_PREC_BMP */
 
 	q = &pq->q[prec];
 
 	if ((p = q->head) == NULL)
 		goto done;
 
+#ifdef HND_PKTQ_PREC_BMP
+	BCM_REFERENCE(prev);
+	p = _pktq_prec_deq_tail(q);
+#else
 	for (prev = NULL; p != q->tail; p = PKTLINK(p))
 		prev = p;
 
@@ -1115,6 +1251,7 @@ BCMFASTPATH(pktq_deq_tail)(struct pktq *pq, int *prec_out)
 
 	q->tail = prev;
 	q->n_pkts--;
+#endif /* HND_PKTQ_PREC_BMP */
 
 	pq->n_pkts_tot--;
 
@@ -1148,8 +1285,13 @@ pktq_peek(struct pktq *pq, int *prec_out)
 	if (pq->n_pkts_tot == 0)
 		goto done;
 
+#ifdef HND_PKTQ_PREC_BMP
+	if ((prec = _pktq_hi_prec(pq, ~0u)) < 0)
+		goto done;
+#else
 	while ((prec = pq->hi_prec) > 0 && pq->q[prec].head == NULL)
 		pq->hi_prec--;
+#endif /* HND_PKTQ_PREC_BMP */
 
 	if (prec_out)
 		*prec_out = prec;
@@ -1291,9 +1433,16 @@ pktq_mlen(struct pktq *pq, uint prec_bmp)
 
 	len = 0;
 
+#ifdef HND_PKTQ_PREC_BMP
+	for (prec_bmp &= pq->prec_bmp; prec_bmp; prec_bmp &= prec_bmp - 1) {
+		prec = __builtin_ctz(prec_bmp);
+		len += pq->q[prec].n_pkts;
+	}
+#else
 	for (prec = 0; prec <= pq->hi_prec; prec++)
 		if (prec_bmp & (1 << prec))
 			len += pq->q[prec].n_pkts;
+#endif /* HND_PKTQ_PREC_BMP */
 
 	/* protect shared resource */
 	if (HND_PKTQ_MUTEX_RELEASE(&pq->mutex) != OSL_EXT_SUCCESS)
@@ -1317,12 +1466,17 @@ BCMFASTPATH(pktq_mpeek)(struct pktq *pq, uint prec_bmp, int *prec_out)
 	if (pq->n_pkts_tot == 0)
 		goto done;
 
+#ifdef HND_PKTQ_PREC_BMP
+	if ((prec = _pktq_hi_prec(pq, prec_bmp)) < 0)
+		goto done;
+#else
 	while ((prec = pq->hi_prec) > 0 && pq->q[prec].head == NULL)
 		pq->hi_prec--;
 
 	while ((prec_bmp & (1 << prec)) == 0 || pq->q[prec].head == NULL)
 		if (prec-- == 0)
 			goto done;
+#endif /* HND_PKTQ_PREC_BMP */
 
 	q = &pq->q[prec];
 
@@ -1354,18 +1508,24 @@ BCMFASTPATH(pktq_mdeq)(struct pktq *pq, uint prec_bmp, int *prec_out)
 	if (pq->n_pkts_tot == 0)
 		goto done;
 
+#ifdef HND_PKTQ_PREC_BMP
+	if ((prec = _pktq_hi_prec(pq, prec_bmp)) < 0)
+		goto done;
+#else
 	while ((prec = pq->hi_prec) > 0 && pq->q[prec].head == NULL)
 		pq->hi_prec--;
 
 	while ((pq->q[prec].head == NULL) || ((prec_bmp & (1 << prec)) == 0))
 		if (prec-- == 0)
 			goto done;
+#endif /* HND_PKTQ_PREC_BMP */
 
 	q = &pq->q[prec];
 
 	if ((p = q->head) == NULL)
 		goto done;
 
+	PKTQ_PREC_TAIL_PREV_DEL(q, p);
 	if ((q->head = PKTLINK(p)) == NULL)
 		q->tail = NULL;
 
@@ -1390,6 +1550,75 @@ done:
 	return p;
 }
 
+#ifdef HND_PKTQ_PREC_BMP
+/*
+ * Priority dequeue of up to n_max packets from a specific set of precedences.
+ * Packets are appended to list in the order pktq_mdeq would return them; a
+ * precedence drained completely is unlinked as a whole chain without a walk.
+ * Returns the number of packets moved.
+ */
+int
+BCMFASTPATH(pktq_mdeq_n)(struct pktq *pq, uint prec_bmp, int n_max, struct spktq *list)
+{
+	struct pktq_prec *q;
+	struct pktq_prec *list_q = &list->q;
+	void *head, *tail, *tail_prev;
+	int prec, n, i;
+	int cnt = 0;
+
+	/* protect shared resource */
+	if (HND_PKTQ_MUTEX_ACQUIRE(&pq->mutex, OSL_EXT_TIME_FOREVER) != OSL_EXT_SUCCESS)
+		return 0;
+
+	while (cnt < n_max && (prec = _pktq_hi_prec(pq, prec_bmp)) >= 0) {
+		q = &pq->q[prec];
+		head = q->head;
+		n = MIN(n_max - cnt, (int)q->n_pkts);
+
+		if (n == q->n_pkts) {
+			tail = q->tail;
+			tail_prev = q->tail_prev;
+			q->head = NULL;
+			q->tail = NULL;
+			q->tail_prev = NULL;
+		} else {
+			tail_prev = NULL;
+			for (tail = head, i = 1; i < n; i++) {
+				tail_prev = tail;
+				tail = PKTLINK(tail);
+			}
+			q->head = PKTLINK(tail);
+			PKTSETLINK(tail, NULL);
+			if ((q->n_pkts - n) < 2)
+				q->tail_prev = NULL;
+		}
+
+		q->n_pkts -= (uint16)n;
+		pq->n_pkts_tot -= (uint16)n;
+#ifdef WL_TXQ_STALL
+		q->dequeue_count += (uint16)n;
+#endif
+
+		if (list_q->head)
+			PKTSETLINK(list_q->tail, head);
+		else
+			list_q->head = head;
+		list_q->tail_prev = (n > 1) ? tail_prev : list_q->tail;
+		list_q->tail = tail;
+		list_q->n_pkts += (uint16)n;
+
+		prec_bmp &= ~(1u << prec);
+		cnt += n;
+	}
+
+	/* protect shared resource */
+	if (HND_PKTQ_MUTEX_RELEASE(&pq->mutex) != OSL_EXT_SUCCESS)
+		return 0;
+
+	return cnt;
+}
+#endif /* HND_PKTQ_PREC_BMP */
+
 #ifdef HND_PKTQ_THREAD_SAFE
 int
 pktqprec_avail_pkts(struct pktq *pq, int prec)
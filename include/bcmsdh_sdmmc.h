@@ -79,6 +79,9 @@ struct sdioh_info {
 	struct sdio_func	fake_func0;
 	struct sdio_func	*func[SDIOD_MAX_IOFUNCS];
 	uint		sd_clk_rate;
+#ifdef BCMSDIOH_TX_BURST
+	uint32		tx_chain_cmd53;		/* CMD53 writes issued for packet chains */
+#endif /* BCMSDIOH_TX_BURST */
 };
 
 /************************************************************
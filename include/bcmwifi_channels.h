@@ -757,6 +757,25 @@ int wf_mhz2channel(uint freq, uint start_factor);
  */
 int wf_channel2mhz(uint channel, uint start_factor);
 
+#ifdef WF_CHSPEC_TBL
+/**
+ * Build the lookup tables behind wf_chspec_malformed(), wf_chspec_valid(),
+ * wf_chspec_primary20_chan() and wf_channel2mhz().
+ */
+int wf_chspec_tbl_init(void);
+
+/* Arithmetic versions of the table driven helpers */
+bool wf_chspec_malformed_ref(chanspec_t chanspec);
+bool wf_chspec_valid_ref(chanspec_t chanspec);
+uint8 wf_chspec_primary20_chan_ref(chanspec_t chspec);
+int wf_channel2mhz_ref(uint channel, uint start_factor);
+
+#ifdef WF_CHSPEC_TBL_CHECK
+/* Exhaustive compare against the *_ref versions, disables the tables on mismatch */
+uint wf_chspec_tbl_check(uint32 *first_bad);
+#endif /* WF_CHSPEC_TBL_CHECK */
+#endif /* WF_CHSPEC_TBL */
+
 /**
  * Returns the chanspec 80Mhz channel corresponding to the following input
  * parameters
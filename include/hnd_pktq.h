@@ -51,6 +51,9 @@ extern "C" {
 typedef struct pktq_prec {
 	void *head;     /**< first packet to dequeue */
 	void *tail;     /**< last packet to dequeue */
+#ifdef HND_PKTQ_PREC_BMP
+	void *tail_prev;     /**< packet linking to tail, NULL if not known */
+#endif /* HND_PKTQ_PREC_BMP */
 	uint16 n_pkts;       /**< number of queued packets */
 	uint16 max_pkts;     /**< maximum number of queued packets */
 	uint16 stall_count;    /**< # seconds since no packets are dequeued  */
@@ -115,6 +118,9 @@ struct pktq {
 	uint16 hi_prec;         /**< rapid dequeue hint (>= highest non-empty prec) */
 	uint16 max_pkts;        /**< max  packets */
 	uint16 n_pkts_tot;      /**< total (cummulative over all precedences) number of packets */
+#ifdef HND_PKTQ_PREC_BMP
+	uint16 prec_bmp;        /**< superset of the non-empty precedences */
+#endif /* HND_PKTQ_PREC_BMP */
 	/* q array must be last since # of elements can be either PKTQ_MAX_PREC or 1 */
 	struct pktq_prec q[PKTQ_MAX_PREC];
 };
@@ -127,6 +133,26 @@ struct spktq {
 
 #define PKTQ_PREC_ITER(pq, prec)        for (prec = (pq)->num_prec - 1; prec >= 0; prec--)
 
+/*
+ * Code that links or unlinks packets of a pktq_prec directly, rather than
+ * through the functions below, must keep the precedence bitmap and the cached
+ * tail predecessor in step: set the bit when a precedence gets a packet, and
+ * drop the cached predecessor before unlinking either of the last two packets.
+ */
+#ifdef HND_PKTQ_PREC_BMP
+#define PKTQ_PREC_BMP_SET(pq, prec)	((pq)->prec_bmp |= (uint16)(1u << (prec)))
+#define PKTQ_PREC_TAIL_PREV_SET(q, p)	((q)->tail_prev = (p))
+#define PKTQ_PREC_TAIL_PREV_DEL(q, p) \
+	do { \
+		if ((p) == (q)->tail_prev || (p) == (q)->tail) \
+			(q)->tail_prev = NULL; \
+	} while (0)
+#else
+#define PKTQ_PREC_BMP_SET(pq, prec)	do {} while (0)
+#define PKTQ_PREC_TAIL_PREV_SET(q, p)	do {} while (0)
+#define PKTQ_PREC_TAIL_PREV_DEL(q, p)	do {} while (0)
+#endif /* HND_PKTQ_PREC_BMP */
+
 /* fn(pkt, arg).  return true if pkt belongs to bsscfg */
 typedef bool (*ifpkt_cb_t)(void*, int);
 
@@ -242,6 +268,11 @@ extern void *spktq_deq_tail(struct spktq *spq);
 extern int pktq_mlen(struct pktq *pq, uint prec_bmp);
 extern void *pktq_mdeq(struct pktq *pq, uint prec_bmp, int *prec_out);
 extern void *pktq_mpeek(struct pktq *pq, uint prec_bmp, int *prec_out);
+#ifdef HND_PKTQ_PREC_BMP
+/** move up to n_max packets, highest precedence first, to the tail of list */
+extern int pktq_mdeq_n(struct pktq *pq, uint prec_bmp, int n_max, struct spktq *list);
+#define pktq_deq_n(pq, n_max, list)	pktq_mdeq_n((pq), ~0u, (n_max), (list))
+#endif /* HND_PKTQ_PREC_BMP */
 
 /* operations on packet queue as a whole */
 
@@ -374,6 +374,31 @@ extern void si_gci_host_wake_gpio_tristate(si_t *sih, uint8 gpio, bool state);
 extern int si_gpio_enable(si_t *sih, uint32 mask);
 
 extern void si_invalidate_second_bar0win(si_t *sih);
+#ifdef SI_BAR0_WIN_CACHE
+/* BAR0 window programming counters, to profile attach and resume */
+typedef struct si_bar0win_stats {
+	uint32 win_writes;	/* window config writes issued */
+	uint32 win_skips;	/* window config writes avoided */
+	uint32 corereg_fast;	/* si_corereg() without a core switch */
+	uint32 corereg_switch;	/* si_corereg() through a core switch */
+} si_bar0win_stats_t;
+
+extern void si_invalidate_bar0win(si_t *sih);
+extern void si_bar0win_stats(si_t *sih, si_bar0win_stats_t *stats, bool clear);
+#endif /* SI_BAR0_WIN_CACHE */
+#ifdef SI_EROM_CACHE
+/* Time spent in each si_attach() phase */
+typedef struct si_attach_prof {
+	uint32 prep_us;		/* bus prep and chip id */
+	uint32 scan_us;		/* backplane enumeration */
+	uint32 setup_us;	/* bus core setup */
+	uint32 total_us;
+	bool scan_cached;	/* enumeration came from the EROM cache */
+} si_attach_prof_t;
+
+extern void si_attach_prof(const si_t *sih, si_attach_prof_t *prof);
+extern void si_erom_cache_invalidate(void);
+#endif /* SI_EROM_CACHE */
 
 extern void si_gci_shif_config_wake_pin(si_t *sih, uint8 gpio_n,
 		uint8 wake_events, bool gci_gpio);
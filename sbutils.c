@@ -40,7 +40,7 @@ static uint _sb_coreidx(const si_info_t *sii, uint32 sba);
 static uint _sb_scan(si_info_t *sii, uint32 sba, volatile void *regs, uint bus, uint32 sbba,
                      uint ncores, uint devid);
 static uint32 _sb_coresba(const si_info_t *sii);
-static volatile void *_sb_setcoreidx(const si_info_t *sii, uint coreidx);
+static volatile void *_sb_setcoreidx(si_info_t *sii, uint coreidx);
 #define	SET_SBREG(sii, r, mask, val)	\
 		W_SBREG((sii), (r), ((R_SBREG((sii), (r)) & ~(mask)) | (val)))
 #define	REGS2SB(va)	(sbconfig_t*) ((volatile int8*)(va) + SBCONFIGOFF)
@@ -564,7 +564,7 @@ sb_setcoreidx(si_t *sih, uint coreidx)
  * Return the current core's virtual address.
  */
 static volatile void *
-_sb_setcoreidx(const si_info_t *sii, uint coreidx)
+_sb_setcoreidx(si_info_t *sii, uint coreidx)
 {
 	si_cores_info_t *cores_info = (si_cores_info_t *)sii->cores_info;
 	uint32 sbaddr = cores_info->coresba[coreidx];
@@ -582,7 +582,7 @@ _sb_setcoreidx(const si_info_t *sii, uint coreidx)
 
 	case PCI_BUS:
 		/* point bar0 window */
-		OSL_PCI_WRITE_CONFIG(sii->osh, PCI_BAR0_WIN, 4, sbaddr);
+		SI_SET_BAR0_WIN(sii, PCI_BAR0_WIN, bar0win, sbaddr);
 		regs = sii->curmap;
 		break;
 
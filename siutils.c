@@ -714,10 +714,17 @@ si_doattach(si_info_t *sii, uint devid, osl_t *osh, volatile void *regs,
 	char *sromvars;
 #endif
 	uint err_at = 0;
+#ifdef SI_EROM_CACHE
+	uint32 t_start = OSL_SYSUPTIME_US();
+	uint32 t_phase = t_start;
+#endif /* SI_EROM_CACHE */
 
 	ASSERT(GOODREGS(regs));
 
 	savewin = 0;
+#ifdef SI_EROM_CACHE
+	bzero(&sii->attach_prof, sizeof(sii->attach_prof));
+#endif /* SI_EROM_CACHE */
 
 	sih->buscoreidx = BADIDX;
 	sii->device_removed = FALSE;
@@ -726,6 +733,11 @@ si_doattach(si_info_t *sii, uint devid, osl_t *osh, volatile void *regs,
 	sii->sdh = sdh;
 	sii->osh = osh;
 	sii->second_bar0win = ~0x0;
+#ifdef SI_BAR0_WIN_CACHE
+	sii->bar0win = ~0x0;
+	sii->bar0win2 = ~0x0;
+	bzero(&sii->bar0win_stats, sizeof(sii->bar0win_stats));
+#endif /* SI_BAR0_WIN_CACHE */
 	sih->enum_base = si_enum_base(devid);
 
 #if defined(AXI_TIMEOUTS_NIC)
@@ -754,7 +766,7 @@ si_doattach(si_info_t *sii, uint devid, osl_t *osh, volatile void *regs,
 		/* PR 29857: init to core0 if bar0window is not programmed properly */
 		if (!GOODCOREADDR(savewin, SI_ENUM_BASE(sih)))
 			savewin = SI_ENUM_BASE(sih);
-		OSL_PCI_WRITE_CONFIG(sii->osh, PCI_BAR0_WIN, 4, SI_ENUM_BASE(sih));
+		SI_SET_BAR0_WIN(sii, PCI_BAR0_WIN, bar0win, SI_ENUM_BASE(sih));
 		if (!regs) {
 			err_at = 1;
 			goto exit;
@@ -811,6 +823,11 @@ si_doattach(si_info_t *sii, uint devid, osl_t *osh, volatile void *regs,
 		sih->_multibp_enable = TRUE;
 	}
 
+#ifdef SI_EROM_CACHE
+	sii->attach_prof.prep_us = OSL_SYSUPTIME_US() - t_phase;
+	t_phase = OSL_SYSUPTIME_US();
+#endif /* SI_EROM_CACHE */
+
 	/* scan for cores */
 	 if (CHIPTYPE(sii->pub.socitype) == SOCI_NCI) {
 
@@ -883,12 +900,19 @@ si_doattach(si_info_t *sii, uint devid, osl_t *osh, volatile void *regs,
 		err_at = 10;
 		goto exit;
 	}
+#ifdef SI_EROM_CACHE
+	sii->attach_prof.scan_us = OSL_SYSUPTIME_US() - t_phase;
+	t_phase = OSL_SYSUPTIME_US();
+#endif /* SI_EROM_CACHE */
 	/* bus/core/clk setup */
 	origidx = SI_CC_IDX;
 	if (!si_buscore_setup(sii, cc, bustype, savewin, &origidx, regs)) {
 		err_at = 11;
 		goto exit;
 	}
+#ifdef SI_EROM_CACHE
+	sii->attach_prof.setup_us = OSL_SYSUPTIME_US() - t_phase;
+#endif /* SI_EROM_CACHE */
 
 	/* JIRA: SWWLAN-98321: SPROM read showing wrong values */
 	/* Set the clkdiv2 divisor bits (2:0) to 0x4 if srom is present */
@@ -995,12 +1019,20 @@ si_doattach(si_info_t *sii, uint devid, osl_t *osh, volatile void *regs,
 		si_oob_war_BT_F1(sih);
 	}
 
+#ifdef SI_EROM_CACHE
+	sii->attach_prof.total_us = OSL_SYSUPTIME_US() - t_start;
+#endif /* SI_EROM_CACHE */
+
 	return (sii);
 
 exit:
 
 	if (err_at) {
 		SI_ERROR(("si_doattach Failed. Error at %d\n", err_at));
+#ifdef SI_EROM_CACHE
+		/* do not trust a cached enumeration that led to a failed attach */
+		ai_erom_cache_invalidate();
+#endif /* SI_EROM_CACHE */
 		si_free_coresinfo(sii, osh);
 		si_free_wrapper(sii);
 	}
@@ -1777,6 +1809,51 @@ si_invalidate_second_bar0win(si_t *sih)
 	sii->second_bar0win = ~0x0;
 }
 
+#ifdef SI_BAR0_WIN_CACHE
+/*
+ * Forget the cached BAR0 windows, to be called whenever they may have been
+ * changed behind siutils (config space restore, FLR, D3 cold).
+ */
+void
+si_invalidate_bar0win(si_t *sih)
+{
+	si_info_t *sii = SI_INFO(sih);
+	sii->bar0win = ~0x0;
+	sii->bar0win2 = ~0x0;
+	sii->second_bar0win = ~0x0;
+}
+
+void
+si_bar0win_stats(si_t *sih, si_bar0win_stats_t *stats, bool clear)
+{
+	si_info_t *sii = SI_INFO(sih);
+
+	if (stats) {
+		*stats = sii->bar0win_stats;
+	}
+	if (clear) {
+		bzero(&sii->bar0win_stats, sizeof(sii->bar0win_stats));
+	}
+}
+#endif /* SI_BAR0_WIN_CACHE */
+
+#ifdef SI_EROM_CACHE
+void
+si_attach_prof(const si_t *sih, si_attach_prof_t *prof)
+{
+	const si_info_t *sii = SI_INFO(sih);
+
+	*prof = sii->attach_prof;
+}
+
+/* Force the next attach to enumerate the backplane from the EROM */
+void
+si_erom_cache_invalidate(void)
+{
+	ai_erom_cache_invalidate();
+}
+#endif /* SI_EROM_CACHE */
+
 int
 si_backplane_access(si_t *sih, uint addr, uint size, uint *val, bool read)
 {
@@ -199,6 +199,14 @@ typedef struct si_info {
 	gci_gpio_item_t	*gci_gpio_head;	/**< gci gpio interrupts head */
 	uint	chipnew;		/**< new chip number */
 	uint second_bar0win;		/**< Backplane region */
+#ifdef SI_BAR0_WIN_CACHE
+	uint32	bar0win;		/**< last value written to the BAR0 window */
+	uint32	bar0win2;		/**< last value written to the BAR0 wrapper window */
+	si_bar0win_stats_t bar0win_stats;
+#endif /* SI_BAR0_WIN_CACHE */
+#ifdef SI_EROM_CACHE
+	si_attach_prof_t attach_prof;
+#endif /* SI_EROM_CACHE */
 	uint	num_br;			/**< # discovered bridges */
 	uint32	br_wrapba[SI_MAXBR];	/**< address of bridge controlling wrapper */
 	uint32	xtalfreq;
@@ -253,6 +261,24 @@ typedef struct si_info {
 	    ((volatile char *)((si)->curmap) + PCI_16KB0_CCREGS_OFFSET))
 #define PCIEREGS(si) (((volatile char *)((si)->curmap) + PCI_16KB0_PCIREGS_OFFSET))
 
+/* Point a BAR0 window at addr, skipping the config write if it is already there */
+#ifdef SI_BAR0_WIN_CACHE
+#define SI_SET_BAR0_WIN(si, cfg_reg, win, addr) do { \
+	if ((si)->win != (addr)) { \
+		OSL_PCI_WRITE_CONFIG((si)->osh, (cfg_reg), 4, (addr)); \
+		(si)->win = (addr); \
+		(si)->bar0win_stats.win_writes++; \
+	} else { \
+		(si)->bar0win_stats.win_skips++; \
+	} \
+} while (0)
+#define SI_BAR0_WIN_STAT_INCR(si, ctr)	((si)->bar0win_stats.ctr++)
+#else
+#define SI_SET_BAR0_WIN(si, cfg_reg, win, addr) \
+	OSL_PCI_WRITE_CONFIG((si)->osh, (cfg_reg), 4, (addr))
+#define SI_BAR0_WIN_STAT_INCR(si, ctr)	do {} while (0)
+#endif /* SI_BAR0_WIN_CACHE */
+
 /*
  * Macros to disable/restore function core(D11, ENET, ILINE20, etc) interrupts before/
  * after core switching to avoid invalid register accesss inside ISR.
@@ -328,6 +354,9 @@ extern si_t *ai_attach(uint pcidev, osl_t *osh, void *regs, uint bustype,
                        void *sdh, char **vars, uint *varsz);
 extern si_t *ai_kattach(osl_t *osh);
 extern void ai_scan(si_t *sih, void *regs, uint devid);
+#ifdef SI_EROM_CACHE
+extern void ai_erom_cache_invalidate(void);
+#endif /* SI_EROM_CACHE */
 
 extern uint ai_flag(si_t *sih);
 extern uint ai_flag_alt(const si_t *sih);
@@ -645,6 +645,7 @@ static const wl_natoe_sub_cmd_t natoe_cmd_list[] = {
 #define CMD_PKTLOG_FILTER_ADD	"PKTLOG_FILTER_ADD"
 #define CMD_PKTLOG_FILTER_DEL	"PKTLOG_FILTER_DEL"
 #define CMD_PKTLOG_FILTER_INFO	"PKTLOG_FILTER_INFO"
+#define CMD_PKTLOG_FILTER_BENCH	"PKTLOG_FILTER_BENCH"
 #define CMD_PKTLOG_START	"PKTLOG_START"
 #define CMD_PKTLOG_STOP		"PKTLOG_STOP"
 #define CMD_PKTLOG_FILTER_EXIST "PKTLOG_FILTER_EXIST"
@@ -8780,6 +8781,38 @@ wl_android_pktlog_filter_info(struct net_device *dev, char *command, int total_l
 	return bytes_written;
 }
 
+/* Compare the compiled filter matcher against the byte loop for 1/16/64 filters */
+static int
+wl_android_pktlog_filter_bench(struct net_device *dev, char *command, int total_len)
+{
+	static const uint n_filters[] = { 1, 16, 64 };
+	dhd_pub_t *dhdp = wl_cfg80211_get_dhdp(dev);
+	uint64 prog_ns, ref_ns;
+	int bytes_written = 0;
+	int err;
+	int i;
+
+	if (!dhdp) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < ARRAYSIZE(n_filters); i++) {
+		err = dhd_pfprog_bench(dhdp->osh, n_filters[i], DHD_PFPROG_BENCH_ITERS,
+			&prog_ns, &ref_ns);
+		if (err != BCME_OK) {
+			DHD_ERROR(("%s: bench of %u filters failed %d\n",
+				__FUNCTION__, n_filters[i], err));
+			return BCME_ERROR;
+		}
+		bytes_written += scnprintf(command + bytes_written, total_len - bytes_written,
+			"filters %u prog %u ref %u ns/pkt\n", n_filters[i],
+			(uint32)DIV_U64_BY_U32(prog_ns, DHD_PFPROG_BENCH_ITERS),
+			(uint32)DIV_U64_BY_U32(ref_ns, DHD_PFPROG_BENCH_ITERS));
+	}
+
+	return bytes_written;
+}
+
 static int
 wl_android_pktlog_start(struct net_device *dev, char *command, int total_len)
 {
@@ -10936,6 +10969,9 @@ wl_handle_private_cmd(struct net_device *net, char *command, u32 cmd_len)
 	else if (strnicmp(command, CMD_PKTLOG_FILTER_INFO, strlen(CMD_PKTLOG_FILTER_INFO)) == 0) {
 		bytes_written = wl_android_pktlog_filter_info(net, command, priv_cmd.total_len);
 	}
+	else if (strnicmp(command, CMD_PKTLOG_FILTER_BENCH, strlen(CMD_PKTLOG_FILTER_BENCH)) == 0) {
+		bytes_written = wl_android_pktlog_filter_bench(net, command, priv_cmd.total_len);
+	}
 	else if (strnicmp(command, CMD_PKTLOG_START, strlen(CMD_PKTLOG_START)) == 0) {
 		bytes_written = wl_android_pktlog_start(net, command, priv_cmd.total_len);
 	}
@@ -16396,6 +16396,9 @@ wl_bss_roaming_done(struct bcm_cfg80211 *cfg, struct net_device *ndev,
 		WL_ERR(("failed to update bss info, err=%d\n", err));
 		goto fail;
 	}
+#ifdef ESCAN_CHANNEL_CACHE
+	wl_roam_cache_assoc_done(cfg, ndev);
+#endif /* ESCAN_CHANNEL_CACHE */
 	if (cfg->wlc_ver.wlc_ver_major < PMKDB_WLC_VER) {
 		wl_update_pmklist(ndev, cfg->pmk_list, err);
 	}
@@ -16678,6 +16681,9 @@ wl_bss_connect_done(struct bcm_cfg80211 *cfg, struct net_device *ndev,
 			 * need to update the cache based on bss info from fw.
 			 */
 			wl_update_bss_info(cfg, ndev, true);
+#ifdef ESCAN_CHANNEL_CACHE
+			wl_roam_cache_assoc_done(cfg, ndev);
+#endif /* ESCAN_CHANNEL_CACHE */
 			if (cfg->wlc_ver.wlc_ver_major < PMKDB_WLC_VER) {
 				wl_update_pmklist(ndev, cfg->pmk_list, err);
 			}
@@ -19819,6 +19825,11 @@ static s32 __wl_cfg80211_up(struct bcm_cfg80211 *cfg)
 	/* Reserve 0x8000 toggle bit for P2P GO/GC */
 	cfg->vif_macaddr_mask = 0x8000;
 
+#ifdef LINKSTAT_SUPPORT
+	/* the dongle counters start over */
+	WL_LSTATS_SNAP_RESET(cfg);
+#endif /* LINKSTAT_SUPPORT */
+
 	err = dhd_config_dongle(cfg);
 	if (unlikely(err))
 		return err;
@@ -19991,6 +20002,10 @@ static s32 __wl_cfg80211_down(struct bcm_cfg80211 *cfg)
 	/* clear vendor OUI list */
 	wl_vndr_ies_clear_vendor_oui_list(cfg);
 
+#ifdef LINKSTAT_SUPPORT
+	WL_LSTATS_SNAP_RESET(cfg);
+#endif /* LINKSTAT_SUPPORT */
+
 	/* clear timestamps */
 	CLR_TS(cfg, scan_start);
 	CLR_TS(cfg, scan_cmplt);
@@ -20486,6 +20501,9 @@ static __used s32 wl_add_ie(struct bcm_cfg80211 *cfg, u8 t, u8 l, u8 *v)
 static void wl_link_up(struct bcm_cfg80211 *cfg)
 {
 	cfg->link_up = true;
+#ifdef LINKSTAT_SUPPORT
+	WL_LSTATS_SNAP_INVALIDATE(cfg);
+#endif /* LINKSTAT_SUPPORT */
 }
 
 static void wl_link_down(struct bcm_cfg80211 *cfg)
@@ -20496,6 +20514,9 @@ static void wl_link_down(struct bcm_cfg80211 *cfg)
 	cfg->link_up = false;
 	conn_info->req_ie_len = 0;
 	conn_info->resp_ie_len = 0;
+#ifdef LINKSTAT_SUPPORT
+	WL_LSTATS_SNAP_INVALIDATE(cfg);
+#endif /* LINKSTAT_SUPPORT */
 }
 
 static unsigned long wl_lock_eq(struct bcm_cfg80211 *cfg)
@@ -21311,6 +21332,60 @@ static const struct file_operations fops_debuglevel = {
 	.llseek = NULL,
 };
 
+#ifdef ROAM_CHANNEL_CACHE
+#define WL_ROAM_CACHE_DUMP_LEN	8192
+
+static ssize_t
+wl_roam_cache_read(struct file *file, char __user *user_buf,
+	size_t count, loff_t *ppos)
+{
+	struct bcm_cfg80211 *cfg = file->private_data;
+	char *tbuf;
+	ssize_t ret;
+	int len;
+
+	tbuf = (char *)MALLOCZ(cfg->osh, WL_ROAM_CACHE_DUMP_LEN);
+	if (!tbuf) {
+		return -ENOMEM;
+	}
+	len = wl_roam_cache_dump(tbuf, WL_ROAM_CACHE_DUMP_LEN);
+	ret = simple_read_from_buffer(user_buf, count, ppos, tbuf, len);
+	MFREE(cfg->osh, tbuf, WL_ROAM_CACHE_DUMP_LEN);
+
+	return ret;
+}
+
+static const struct file_operations fops_roam_cache = {
+	.open = simple_open,
+	.read = wl_roam_cache_read,
+	.owner = THIS_MODULE,
+	.llseek = default_llseek,
+};
+#endif /* ROAM_CHANNEL_CACHE */
+
+#if defined(LINKSTAT_SUPPORT) && defined(WL_LSTATS_SNAPSHOT)
+#define WL_LSTATS_DUMP_LEN	512
+
+static ssize_t
+wl_lstats_read(struct file *file, char __user *user_buf,
+	size_t count, loff_t *ppos)
+{
+	struct bcm_cfg80211 *cfg = file->private_data;
+	char tbuf[WL_LSTATS_DUMP_LEN];
+	int len;
+
+	len = wl_cfgvendor_lstats_dump(cfg, tbuf, sizeof(tbuf));
+	return simple_read_from_buffer(user_buf, count, ppos, tbuf, len);
+}
+
+static const struct file_operations fops_lstats = {
+	.open = simple_open,
+	.read = wl_lstats_read,
+	.owner = THIS_MODULE,
+	.llseek = default_llseek,
+};
+#endif /* LINKSTAT_SUPPORT && WL_LSTATS_SNAPSHOT */
+
 static s32 wl_setup_debugfs(struct bcm_cfg80211 *cfg)
 {
 	s32 err = 0;
@@ -21332,7 +21407,22 @@ static s32 wl_setup_debugfs(struct bcm_cfg80211 *cfg)
 	if (!_dentry || IS_ERR(_dentry)) {
 		WL_ERR(("failed to create debug_level debug file\n"));
 		wl_free_debugfs(cfg);
+		goto exit;
+	}
+#ifdef ROAM_CHANNEL_CACHE
+	_dentry = debugfs_create_file("roam_cache", S_IRUSR,
+		cfg->debugfs, cfg, &fops_roam_cache);
+	if (!_dentry || IS_ERR(_dentry)) {
+		WL_ERR(("failed to create roam_cache debug file\n"));
+	}
+#endif /* ROAM_CHANNEL_CACHE */
+#if defined(LINKSTAT_SUPPORT) && defined(WL_LSTATS_SNAPSHOT)
+	_dentry = debugfs_create_file("lstats", S_IRUSR,
+		cfg->debugfs, cfg, &fops_lstats);
+	if (!_dentry || IS_ERR(_dentry)) {
+		WL_ERR(("failed to create lstats debug file\n"));
 	}
+#endif /* LINKSTAT_SUPPORT && WL_LSTATS_SNAPSHOT */
 exit:
 	return err;
 }
@@ -1034,6 +1034,25 @@ struct wl_pmk_list {
 #define MAC_RAND_BYTES	3
 #define ESCAN_BUF_SIZE (64 * 1024)
 
+#ifdef WL_ESCAN_STREAM
+/* bss_info entries of one escan buffer that can be tracked as already informed */
+#define WL_ESCAN_STREAM_MAX_BSS		512u
+/* at most WL_ESCAN_STREAM_BURST informs per WL_ESCAN_STREAM_WINDOW_MS while scanning */
+#define WL_ESCAN_STREAM_BURST		32u
+#define WL_ESCAN_STREAM_WINDOW_MS	100u
+/* an RSSI update of at least this many dB is informed right away */
+#define WL_ESCAN_STREAM_RSSI_DELTA	5
+
+struct wl_escan_stream {
+	wl_scan_results_t *list;	/* escan buffer the informed bits refer to */
+	u8 informed[WL_ESCAN_STREAM_MAX_BSS / NBBY];	/* by position in list */
+	unsigned long window_start;	/* jiffies */
+	u32 window_cnt;
+	u32 streamed;			/* informed while the scan was running */
+	u32 deferred;			/* left to the completion pass */
+};
+#endif /* WL_ESCAN_STREAM */
+
 struct escan_info {
 	u32 escan_state;
 #ifdef STATIC_WL_PRIV_STRUCT
@@ -1061,6 +1080,9 @@ struct escan_info {
 #ifdef DHD_SEND_HANG_ESCAN_SYNCID_MISMATCH
 	bool prev_escan_aborted;
 #endif /* DHD_SEND_HANG_ESCAN_SYNCID_MISMATCH */
+#ifdef WL_ESCAN_STREAM
+	struct wl_escan_stream stream;
+#endif /* WL_ESCAN_STREAM */
 };
 
 #ifdef ESCAN_BUF_OVERFLOW_MGMT
@@ -1375,6 +1397,60 @@ struct bcm_assoclist {
 };
 
 /* private data of cfg80211 interface */
+#ifdef LINKSTAT_SUPPORT
+/* Cumulative link stats counters, kept to compute per refresh deltas */
+struct wl_lstats_cnt {
+	u32 on_time;
+	u32 tx_time;
+	u32 rx_time;
+	u32 tx_mpdu;
+	u32 rx_mpdu;
+	u32 mpdu_lost;
+	u32 retries;
+	u32 beacon_rx;
+};
+
+#ifdef WL_LSTATS_SNAPSHOT
+#ifndef WL_LSTATS_POLL_MS
+#define WL_LSTATS_POLL_MS	3000	/* initial poll period estimate */
+#endif /* WL_LSTATS_POLL_MS */
+#define WL_LSTATS_POLL_MAX_MS	10000	/* longer gaps are idle time, not the period */
+
+/*
+ * Last link stats reply, served again to polls within the freshness window.
+ * The window follows the poll period, so a cached reply is never older than
+ * one period and a lone periodic poller still gets fresh stats every time.
+ */
+struct wl_lstats_snap {
+	struct mutex lock;		/* serializes refresh and readers */
+	char *buf;			/* reply as sent to the HAL */
+	u32 len;
+	u32 corerev;			/* WLC_GET_REVINFO, looked up once */
+	bool valid;
+	bool stale;			/* link changed since the refresh */
+	bool rebase;			/* dongle reset, counters restart */
+	bool compat;			/* buf is laid out for a compat task */
+	unsigned long stamp;		/* jiffies of the refresh */
+	unsigned long last_poll;	/* jiffies of the previous poll */
+	u32 period_ms;			/* EWMA of the poll period */
+	u32 delta_ms;			/* time covered by delta */
+	struct wl_lstats_cnt cnt;	/* counters at the refresh */
+	struct wl_lstats_cnt delta;	/* change since the previous refresh */
+	u32 refreshed;
+	u32 served;			/* polls answered from buf */
+};
+#define WL_LSTATS_SNAP_INVALIDATE(cfg)	((cfg)->lstats_snap.stale = TRUE)
+#define WL_LSTATS_SNAP_RESET(cfg) \
+	do { \
+		(cfg)->lstats_snap.rebase = TRUE; \
+		(cfg)->lstats_snap.stale = TRUE; \
+	} while (0)
+#else
+#define WL_LSTATS_SNAP_INVALIDATE(cfg)
+#define WL_LSTATS_SNAP_RESET(cfg)
+#endif /* WL_LSTATS_SNAPSHOT */
+#endif /* LINKSTAT_SUPPORT */
+
 struct bcm_cfg80211 {
 	struct wireless_dev *wdev;	/* representing cfg cfg80211 device */
 
@@ -1624,6 +1700,9 @@ struct bcm_cfg80211 {
 	wl_ctx_tsinfo_t tsinfo;
 	struct wl_pmk_list *spmk_info_list;	/* single pmk info list */
 	struct bcm_assoclist assoclist;
+#if defined(LINKSTAT_SUPPORT) && defined(WL_LSTATS_SNAPSHOT)
+	struct wl_lstats_snap lstats_snap;
+#endif /* LINKSTAT_SUPPORT && WL_LSTATS_SNAPSHOT */
 };
 
 /* Max auth timeout allowed in case of EAP is 70sec, additional 5 sec for
@@ -2691,7 +2770,14 @@ bool wl_cfg80211_is_dpp_gas_action(void *frame, u32 frame_len);
 extern bool wl_cfg80211_find_gas_subtype(u8 subtype, u16 adv_id, u8* data, u32 len);
 #ifdef ESCAN_CHANNEL_CACHE
 extern void wl_update_rcc_list(struct net_device *dev);
+extern void wl_roam_cache_assoc_done(struct bcm_cfg80211 *cfg, struct net_device *dev);
 #endif /* ESCAN_CHANNEL_CACHE */
+#ifdef ROAM_CHANNEL_CACHE
+extern int wl_roam_cache_dump(char *buf, int buflen);
+#endif /* ROAM_CHANNEL_CACHE */
+#if defined(LINKSTAT_SUPPORT) && defined(WL_LSTATS_SNAPSHOT)
+extern int wl_cfgvendor_lstats_dump(struct bcm_cfg80211 *cfg, char *buf, int buflen);
+#endif /* LINKSTAT_SUPPORT && WL_LSTATS_SNAPSHOT */
 
 #ifdef WL_SAE
 extern s32 wl_cfg80211_set_wsec_info(struct net_device *dev, uint32 *data,
@@ -54,6 +54,7 @@
 static int wl_cfgnan_cache_disc_result(struct bcm_cfg80211 *cfg, void * data,
 	u16 *disc_cache_update_flags);
 static int wl_cfgnan_remove_disc_result(struct bcm_cfg80211 * cfg, uint8 local_subid);
+static void wl_cfgnan_disc_cache_release(struct bcm_cfg80211 *cfg, uint8 idx);
 static nan_disc_result_cache * wl_cfgnan_get_disc_result(struct bcm_cfg80211 *cfg,
 	uint8 remote_pubid, struct ether_addr *peer);
 #endif /* WL_NAN_DISC_CACHE */
@@ -3271,6 +3272,8 @@ fail:
 	nancfg->inst_id_start = 0;
 	memset(nancfg->svc_inst_id_mask, 0, sizeof(nancfg->svc_inst_id_mask));
 	memset(nancfg->svc_info, 0, NAN_MAX_SVC_INST * sizeof(nan_svc_info_t));
+	memset(nancfg->svc_inst_idx, 0, sizeof(nancfg->svc_inst_idx));
+	memset(nancfg->ndp_svc_idx, 0, sizeof(nancfg->ndp_svc_idx));
 	nancfg->nan_enable = false;
 	WL_INFORM_MEM(("[NAN] Disable done\n"));
 
@@ -3559,25 +3562,14 @@ nan_svc_info_t *
 wl_cfgnan_get_svc_inst(struct bcm_cfg80211 *cfg,
 	wl_nan_instance_id svc_inst_id, uint8 ndp_id)
 {
-	uint8 i, j;
+	uint8 idx = 0;
 	wl_nancfg_t *nancfg = cfg->nancfg;
 	if (ndp_id) {
-		for (i = 0; i < NAN_MAX_SVC_INST; i++) {
-			for (j = 0; j < NAN_MAX_SVC_INST; j++) {
-				if (nancfg->svc_info[i].ndp_id[j] == ndp_id) {
-					return &nancfg->svc_info[i];
-				}
-			}
-		}
+		idx = nancfg->ndp_svc_idx[ndp_id];
 	} else if (svc_inst_id) {
-		for (i = 0; i < NAN_MAX_SVC_INST; i++) {
-			if (nancfg->svc_info[i].svc_id == svc_inst_id) {
-				return &nancfg->svc_info[i];
-			}
-		}
-
+		idx = nancfg->svc_inst_idx[svc_inst_id];
 	}
-	return NULL;
+	return idx ? &nancfg->svc_info[idx - 1] : NULL;
 }
 
 static int
@@ -3586,6 +3578,7 @@ wl_cfgnan_svc_inst_add_ndp(struct bcm_cfg80211 *cfg,
 {
 	int ret = BCME_OK, i;
 	nan_svc_info_t *svc_info;
+	wl_nancfg_t *nancfg = cfg->nancfg;
 
 	svc_info = wl_cfgnan_get_svc_inst(cfg, svc_inst_id, 0);
 	if (svc_info) {
@@ -3601,6 +3594,7 @@ wl_cfgnan_svc_inst_add_ndp(struct bcm_cfg80211 *cfg,
 			goto done;
 		}
 		svc_info->ndp_id[i] = ndp_id;
+		nancfg->ndp_svc_idx[ndp_id] = (uint8)(svc_info - nancfg->svc_info) + 1;
 	}
 
 done:
@@ -3613,6 +3607,7 @@ wl_cfgnan_svc_inst_del_ndp(struct bcm_cfg80211 *cfg,
 {
 	int ret = BCME_OK, i;
 	nan_svc_info_t *svc_info;
+	wl_nancfg_t *nancfg = cfg->nancfg;
 
 	svc_info = wl_cfgnan_get_svc_inst(cfg, svc_inst_id, 0);
 
@@ -3626,6 +3621,9 @@ wl_cfgnan_svc_inst_del_ndp(struct bcm_cfg80211 *cfg,
 		if (i == NAN_MAX_SVC_INST) {
 			WL_ERR(("couldn't find entry for ndp id = %d\n", ndp_id));
 			ret = BCME_NOTFOUND;
+		} else if (nancfg->ndp_svc_idx[ndp_id] ==
+			(uint8)(svc_info - nancfg->svc_info) + 1) {
+			nancfg->ndp_svc_idx[ndp_id] = 0;
 		}
 	}
 	return ret;
@@ -3839,9 +3837,22 @@ wl_cfgnan_clear_svc_cache(struct bcm_cfg80211 *cfg,
 	wl_nan_instance_id svc_id)
 {
 	nan_svc_info_t *svc;
+	wl_nancfg_t *nancfg = cfg->nancfg;
+	uint8 idx;
+	int i;
+
 	svc = wl_cfgnan_get_svc_inst(cfg, svc_id, 0);
 	if (svc) {
 		WL_DBG(("clearing cached svc info for svc id %d\n", svc_id));
+		idx = (uint8)(svc - nancfg->svc_info) + 1;
+		nancfg->svc_inst_idx[svc->svc_id] = 0;
+		for (i = 0; i < NAN_MAX_SVC_INST; i++) {
+			uint8 ndp_id = (uint8)svc->ndp_id[i];
+
+			if (ndp_id && (nancfg->ndp_svc_idx[ndp_id] == idx)) {
+				nancfg->ndp_svc_idx[ndp_id] = 0;
+			}
+		}
 		memset(svc, 0, sizeof(*svc));
 	}
 }
@@ -3852,26 +3863,22 @@ wl_cfgnan_cache_svc_info(struct bcm_cfg80211 *cfg,
 {
 	int ret = BCME_OK;
 	int i;
-	nan_svc_info_t *svc_info;
+	nan_svc_info_t *svc_info = NULL;
 	uint8 svc_id = (cmd_id == WL_NAN_CMD_SD_SUBSCRIBE) ? cmd_data->sub_id :
 		cmd_data->pub_id;
 	wl_nancfg_t *nancfg = cfg->nancfg;
 
-	for (i = 0; i < NAN_MAX_SVC_INST; i++) {
-		if (update) {
-			if (nancfg->svc_info[i].svc_id == svc_id) {
+	if (update) {
+		svc_info = wl_cfgnan_get_svc_inst(cfg, svc_id, 0);
+	} else {
+		for (i = 0; i < NAN_MAX_SVC_INST; i++) {
+			if (!nancfg->svc_info[i].svc_id) {
 				svc_info = &nancfg->svc_info[i];
 				break;
-			} else {
-				continue;
 			}
 		}
-		if (!nancfg->svc_info[i].svc_id) {
-			svc_info = &nancfg->svc_info[i];
-			break;
-		}
 	}
-	if (i == NAN_MAX_SVC_INST) {
+	if (svc_info == NULL) {
 		WL_ERR(("%s:cannot accomodate ranging session\n", __FUNCTION__));
 		ret = BCME_NORESOURCE;
 		goto fail;
@@ -3913,6 +3920,7 @@ wl_cfgnan_cache_svc_info(struct bcm_cfg80211 *cfg,
 	} else {
 		svc_info->svc_id = cmd_data->pub_id;
 	}
+	nancfg->svc_inst_idx[svc_info->svc_id] = (uint8)(svc_info - nancfg->svc_info) + 1;
 	ret = memcpy_s(svc_info->svc_hash, sizeof(svc_info->svc_hash),
 			cmd_data->svc_hash.data, WL_NAN_SVC_HASH_LEN);
 	if (ret != BCME_OK) {
@@ -6171,6 +6179,18 @@ wl_cfgnan_init(struct bcm_cfg80211 *cfg)
 		ret = BCME_NOMEM;
 		goto fail;
 	}
+	cfg->nancfg->nan_disc_arena = MALLOCZ(cfg->osh,
+			NAN_MAX_CACHE_DISC_RESULT * NAN_DISC_CACHE_PAYLOAD_LEN);
+	if (!cfg->nancfg->nan_disc_arena) {
+		WL_ERR(("%s: memory allocation failed\n", __func__));
+		MFREE(cfg->osh, cfg->nancfg->nan_disc_cache,
+			NAN_MAX_CACHE_DISC_RESULT * sizeof(nan_disc_result_cache));
+		cfg->nancfg->nan_disc_cache = NULL;
+		ret = BCME_NOMEM;
+		goto fail;
+	}
+	bzero(cfg->nancfg->nan_disc_hash, sizeof(cfg->nancfg->nan_disc_hash));
+	cfg->nancfg->nan_disc_count = 0;
 #endif /* WL_NAN_DISC_CACHE */
 	cfg->nancfg->nan_init_state = true;
 	return ret;
@@ -6190,21 +6210,24 @@ wl_cfgnan_deinit_cleanup(struct bcm_cfg80211 *cfg)
 #ifdef WL_NAN_DISC_CACHE
 	if (nancfg->nan_disc_cache) {
 		for (i = 0; i < NAN_MAX_CACHE_DISC_RESULT; i++) {
-			if (nancfg->nan_disc_cache[i].tx_match_filter.data) {
-				MFREE(cfg->osh, nancfg->nan_disc_cache[i].tx_match_filter.data,
-					nancfg->nan_disc_cache[i].tx_match_filter.dlen);
-			}
-			if (nancfg->nan_disc_cache[i].svc_info.data) {
-				MFREE(cfg->osh, nancfg->nan_disc_cache[i].svc_info.data,
-					nancfg->nan_disc_cache[i].svc_info.dlen);
+			if (nancfg->nan_disc_cache[i].valid) {
+				wl_cfgnan_disc_cache_release(cfg, i);
 			}
 		}
 		MFREE(cfg->osh, nancfg->nan_disc_cache,
 			NAN_MAX_CACHE_DISC_RESULT * sizeof(nan_disc_result_cache));
 		nancfg->nan_disc_cache = NULL;
 	}
+	if (nancfg->nan_disc_arena) {
+		MFREE(cfg->osh, nancfg->nan_disc_arena,
+			NAN_MAX_CACHE_DISC_RESULT * NAN_DISC_CACHE_PAYLOAD_LEN);
+		nancfg->nan_disc_arena = NULL;
+	}
 	nancfg->nan_disc_count = 0;
+	bzero(nancfg->nan_disc_hash, sizeof(nancfg->nan_disc_hash));
 	bzero(nancfg->svc_info, NAN_MAX_SVC_INST * sizeof(nan_svc_info_t));
+	bzero(nancfg->svc_inst_idx, sizeof(nancfg->svc_inst_idx));
+	bzero(nancfg->ndp_svc_idx, sizeof(nancfg->ndp_svc_idx));
 	bzero(nancfg->nan_ranging_info, NAN_MAX_RANGING_INST * sizeof(nan_ranging_inst_t));
 #endif /* WL_NAN_DISC_CACHE */
 	return;
@@ -8585,99 +8608,157 @@ exit:
 }
 
 #ifdef WL_NAN_DISC_CACHE
+static uint8
+wl_cfgnan_disc_cache_hash(const struct ether_addr *nmi, const uint8 *svc_hash)
+{
+	uint8 h = nmi->octet[3] ^ nmi->octet[4] ^ nmi->octet[5];
+	int i;
+
+	for (i = 0; i < WL_NAN_SVC_HASH_LEN; i++) {
+		h = ((h << 1) | (h >> 7)) ^ svc_hash[i];
+	}
+
+	return h & (NAN_DISC_CACHE_HASH_SIZE - 1);
+}
+
+static void
+wl_cfgnan_disc_cache_unlink(wl_nancfg_t *nancfg, uint8 idx)
+{
+	nan_disc_result_cache *disc_res = nancfg->nan_disc_cache;
+	uint8 *link = &nancfg->nan_disc_hash[wl_cfgnan_disc_cache_hash(&disc_res[idx].peer,
+		disc_res[idx].svc_hash)];
+
+	while (*link) {
+		if (*link == (idx + 1)) {
+			*link = disc_res[idx].hnext;
+			break;
+		}
+		link = &disc_res[*link - 1].hnext;
+	}
+}
+
+/* Unlink an entry and give back its payload */
+static void
+wl_cfgnan_disc_cache_release(struct bcm_cfg80211 *cfg, uint8 idx)
+{
+	wl_nancfg_t *nancfg = cfg->nancfg;
+	nan_disc_result_cache *res = &nancfg->nan_disc_cache[idx];
+
+	wl_cfgnan_disc_cache_unlink(nancfg, idx);
+	if (res->svc_info_ext && res->svc_info.data) {
+		MFREE(cfg->osh, res->svc_info.data, res->svc_info.dlen);
+	}
+	bzero(res, sizeof(*res));
+	nancfg->nan_disc_count--;
+}
+
 static int
 wl_cfgnan_cache_disc_result(struct bcm_cfg80211 *cfg, void * data,
 	u16 *disc_cache_update_flags)
 {
 	nan_event_data_t* disc = (nan_event_data_t*)data;
-	int i, add_index = 0;
+	int i, add_index = -1;
 	int ret = BCME_OK;
 	wl_nancfg_t *nancfg = cfg->nancfg;
 	nan_disc_result_cache *disc_res = nancfg->nan_disc_cache;
+	nan_disc_result_cache *res;
+	uint32 now = OSL_SYSUPTIME();
+	uint8 bucket, idx;
+	uint8 *payload;
 	*disc_cache_update_flags = 0;
 
 	if (!nancfg->nan_enable) {
 		WL_DBG(("nan not enabled"));
 		return BCME_NOTENABLED;
 	}
-	if (nancfg->nan_disc_count == NAN_MAX_CACHE_DISC_RESULT) {
-		WL_DBG(("cache full"));
-		ret = BCME_NORESOURCE;
-		goto done;
-	}
 
-	for (i = 0; i < NAN_MAX_CACHE_DISC_RESULT; i++) {
-		if (!disc_res[i].valid) {
-			add_index = i;
-			continue;
-		}
-		if (!memcmp(&disc_res[i].peer, &disc->remote_nmi, ETHER_ADDR_LEN) &&
-			!memcmp(disc_res[i].svc_hash, disc->svc_name, WL_NAN_SVC_HASH_LEN)) {
-			WL_DBG(("cache entry already present, i = %d", i));
+	bucket = wl_cfgnan_disc_cache_hash(&disc->remote_nmi, disc->svc_name);
+	for (idx = nancfg->nan_disc_hash[bucket]; idx; idx = disc_res[idx - 1].hnext) {
+		res = &disc_res[idx - 1];
+		if (!memcmp(&res->peer, &disc->remote_nmi, ETHER_ADDR_LEN) &&
+			!memcmp(res->svc_hash, disc->svc_name, WL_NAN_SVC_HASH_LEN)) {
+			WL_DBG(("cache entry already present, i = %d", idx - 1));
 			/* Update needed parameters here */
-			if (disc_res[i].sde_control_flag != disc->sde_control_flag) {
-				disc_res[i].sde_control_flag = disc->sde_control_flag;
+			if (res->sde_control_flag != disc->sde_control_flag) {
+				res->sde_control_flag = disc->sde_control_flag;
 				*disc_cache_update_flags |= NAN_DISC_CACHE_PARAM_SDE_CONTROL;
 			}
+			res->last_seen = now;
 			ret = BCME_OK; /* entry already present */
 			goto done;
 		}
 	}
-	WL_DBG(("adding cache entry: add_index = %d\n", add_index));
-	disc_res[add_index].valid = 1;
-	disc_res[add_index].pub_id = disc->pub_id;
-	disc_res[add_index].sub_id = disc->sub_id;
-	disc_res[add_index].publish_rssi = disc->publish_rssi;
-	disc_res[add_index].peer_cipher_suite = disc->peer_cipher_suite;
-	disc_res[add_index].sde_control_flag = disc->sde_control_flag;
-	ret = memcpy_s(&disc_res[add_index].peer, ETHER_ADDR_LEN,
-			&disc->remote_nmi, ETHER_ADDR_LEN);
-	if (ret != BCME_OK) {
-		WL_ERR(("Failed to copy remote nmi\n"));
+
+	if (disc->tx_match_filter.dlen > MAX_MATCH_FILTER_LEN) {
+		WL_ERR(("tx match filter too long %d\n", disc->tx_match_filter.dlen));
+		ret = BCME_BUFTOOLONG;
 		goto done;
 	}
-	ret = memcpy_s(disc_res[add_index].svc_hash, WL_NAN_SVC_HASH_LEN,
-			disc->svc_name, WL_NAN_SVC_HASH_LEN);
-	if (ret != BCME_OK) {
-		WL_ERR(("Failed to copy svc hash\n"));
+
+	if (nancfg->nan_disc_count == NAN_MAX_CACHE_DISC_RESULT) {
+		/* make room by dropping the least recently discovered entry */
+		add_index = 0;
+		for (i = 1; i < NAN_MAX_CACHE_DISC_RESULT; i++) {
+			if ((now - disc_res[i].last_seen) > (now - disc_res[add_index].last_seen)) {
+				add_index = i;
+			}
+		}
+		WL_INFORM_MEM(("disc cache full, evict peer " MACDBG " sub_id %d\n",
+			MAC2STRDBG(disc_res[add_index].peer.octet), disc_res[add_index].sub_id));
+		wl_cfgnan_disc_cache_release(cfg, add_index);
+	} else {
+		for (i = 0; i < NAN_MAX_CACHE_DISC_RESULT; i++) {
+			if (!disc_res[i].valid) {
+				add_index = i;
+				break;
+			}
+		}
+	}
+	if (add_index < 0) {
+		WL_ERR(("disc cache count out of sync\n"));
+		ret = BCME_ERROR;
 		goto done;
 	}
 
+	WL_DBG(("adding cache entry: add_index = %d\n", add_index));
+	res = &disc_res[add_index];
+	payload = nancfg->nan_disc_arena + (add_index * NAN_DISC_CACHE_PAYLOAD_LEN);
+
+	/* Copy the payload first so a failed entry is never visible in the cache */
 	if (disc->svc_info.dlen && disc->svc_info.data) {
-		disc_res[add_index].svc_info.dlen = disc->svc_info.dlen;
-		disc_res[add_index].svc_info.data =
-			MALLOCZ(cfg->osh, disc_res[add_index].svc_info.dlen);
-		if (!disc_res[add_index].svc_info.data) {
-			WL_ERR(("%s: memory allocation failed\n", __FUNCTION__));
-			disc_res[add_index].svc_info.dlen = 0;
-			ret = BCME_NOMEM;
-			goto done;
-		}
-		ret = memcpy_s(disc_res[add_index].svc_info.data, disc_res[add_index].svc_info.dlen,
-				disc->svc_info.data, disc->svc_info.dlen);
-		if (ret != BCME_OK) {
-			WL_ERR(("Failed to copy svc info\n"));
-			goto done;
+		if (disc->svc_info.dlen <= NAN_DISC_CACHE_SVC_INFO_LEN) {
+			res->svc_info.data = payload;
+		} else {
+			res->svc_info.data = MALLOCZ(cfg->osh, disc->svc_info.dlen);
+			if (!res->svc_info.data) {
+				WL_ERR(("%s: memory allocation failed\n", __FUNCTION__));
+				ret = BCME_NOMEM;
+				goto done;
+			}
+			res->svc_info_ext = TRUE;
 		}
+		res->svc_info.dlen = disc->svc_info.dlen;
+		(void)memcpy_s(res->svc_info.data, res->svc_info.dlen,
+			disc->svc_info.data, disc->svc_info.dlen);
 	}
 	if (disc->tx_match_filter.dlen && disc->tx_match_filter.data) {
-		disc_res[add_index].tx_match_filter.dlen = disc->tx_match_filter.dlen;
-		disc_res[add_index].tx_match_filter.data =
-			MALLOCZ(cfg->osh, disc_res[add_index].tx_match_filter.dlen);
-		if (!disc_res[add_index].tx_match_filter.data) {
-			WL_ERR(("%s: memory allocation failed\n", __FUNCTION__));
-			disc_res[add_index].tx_match_filter.dlen = 0;
-			ret = BCME_NOMEM;
-			goto done;
-		}
-		ret = memcpy_s(disc_res[add_index].tx_match_filter.data,
-			disc_res[add_index].tx_match_filter.dlen,
+		res->tx_match_filter.data = payload + NAN_DISC_CACHE_SVC_INFO_LEN;
+		res->tx_match_filter.dlen = disc->tx_match_filter.dlen;
+		(void)memcpy_s(res->tx_match_filter.data, res->tx_match_filter.dlen,
 			disc->tx_match_filter.data, disc->tx_match_filter.dlen);
-		if (ret != BCME_OK) {
-			WL_ERR(("Failed to copy tx match filter\n"));
-			goto done;
-		}
 	}
+
+	res->valid = 1;
+	res->last_seen = now;
+	res->pub_id = disc->pub_id;
+	res->sub_id = disc->sub_id;
+	res->publish_rssi = disc->publish_rssi;
+	res->peer_cipher_suite = disc->peer_cipher_suite;
+	res->sde_control_flag = disc->sde_control_flag;
+	(void)memcpy_s(&res->peer, ETHER_ADDR_LEN, &disc->remote_nmi, ETHER_ADDR_LEN);
+	(void)memcpy_s(res->svc_hash, WL_NAN_SVC_HASH_LEN, disc->svc_name, WL_NAN_SVC_HASH_LEN);
+	res->hnext = nancfg->nan_disc_hash[bucket];
+	nancfg->nan_disc_hash[bucket] = add_index + 1;
 	nancfg->nan_disc_count++;
 	WL_DBG(("cfg->nan_disc_count = %d\n", nancfg->nan_disc_count));
 
@@ -8759,16 +8840,7 @@ static int wl_cfgnan_remove_disc_result(struct bcm_cfg80211 *cfg,
 	for (i = 0; i < NAN_MAX_CACHE_DISC_RESULT; i++) {
 		if ((disc_res[i].valid) && (disc_res[i].sub_id == local_subid)) {
 			WL_TRACE(("make cache entry invalid\n"));
-			if (disc_res[i].tx_match_filter.data) {
-				MFREE(cfg->osh, disc_res[i].tx_match_filter.data,
-					disc_res[i].tx_match_filter.dlen);
-			}
-			if (disc_res[i].svc_info.data) {
-				MFREE(cfg->osh, disc_res[i].svc_info.data,
-					disc_res[i].svc_info.dlen);
-			}
-			bzero(&disc_res[i], sizeof(disc_res[i]));
-			cfg->nancfg->nan_disc_count--;
+			wl_cfgnan_disc_cache_release(cfg, i);
 			ret = BCME_OK;
 		}
 	}
@@ -157,6 +157,7 @@
 #define NAN_MAX_RANGING_SSN_ALLOWED		1u
 #define NAN_MAX_SVC_INST			(MAX_PUBLISHES + MAX_SUBSCRIBES)
 #define NAN_SVC_INST_SIZE			32u
+#define NAN_SVC_INST_IDX_SIZE			(NAN_SVC_INST_SIZE * 8u) /* 8 bit ids */
 #define NAN_START_STOP_TIMEOUT			5000u
 #define NAN_MAX_NDP_PEER			8u
 #define NAN_DISABLE_CMD_DELAY			530u
@@ -656,8 +657,16 @@ typedef struct wl_nan_iov {
 #ifdef WL_NAN_DISC_CACHE
 
 #define NAN_MAX_CACHE_DISC_RESULT 16
+#define NAN_DISC_CACHE_HASH_SIZE	32u	/* power of 2 */
+/* Per entry payload space, larger service info falls back to the heap */
+#define NAN_DISC_CACHE_SVC_INFO_LEN	(NAN_MAX_SERVICE_SPECIFIC_INFO_LEN + \
+	MAX_SDEA_SVC_INFO_LEN + 2u)
+#define NAN_DISC_CACHE_PAYLOAD_LEN	(NAN_DISC_CACHE_SVC_INFO_LEN + MAX_MATCH_FILTER_LEN)
 typedef struct {
 	bool valid;
+	bool svc_info_ext;	/* svc_info.data was allocated outside the arena */
+	uint8 hnext;		/* next entry + 1 in the hash bucket, 0 ends */
+	uint32 last_seen;	/* OSL_SYSUPTIME() of the last discovery, for LRU */
 	wl_nan_instance_id_t pub_id;
 	wl_nan_instance_id_t sub_id;
 	uint8 svc_hash[WL_NAN_SVC_HASH_LEN];
@@ -707,7 +716,15 @@ typedef struct wl_nancfg
 	struct delayed_work	nan_disable;
 	int nan_disc_count;
 	nan_disc_result_cache *nan_disc_cache;
+#ifdef WL_NAN_DISC_CACHE
+	uint8 *nan_disc_arena;	/* NAN_DISC_CACHE_PAYLOAD_LEN per cache entry */
+	/* cache entry + 1 heading each (NMI, svc hash) bucket, 0 if empty */
+	uint8 nan_disc_hash[NAN_DISC_CACHE_HASH_SIZE];
+#endif /* WL_NAN_DISC_CACHE */
 	nan_svc_info_t svc_info[NAN_MAX_SVC_INST];
+	/* svc_info slot + 1 by service instance id and by ndp id, 0 if none */
+	uint8 svc_inst_idx[NAN_SVC_INST_IDX_SIZE];
+	uint8 ndp_svc_idx[NAN_SVC_INST_IDX_SIZE];
 	nan_ranging_inst_t nan_ranging_info[NAN_MAX_RANGING_INST];
 	wl_nan_ver_t version;
 	struct mutex nan_sync;
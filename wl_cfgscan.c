@@ -460,6 +460,73 @@ out_err:
 	return err;
 }
 
+#ifdef WL_ESCAN_STREAM
+/*
+ * Incremental escan reporting: bss entries are informed to cfg80211 as partial
+ * results are merged into the escan buffer, so connection managers see them
+ * before the whole scan completes. The completion pass in wl_inform_bss() then
+ * only informs the entries that were not streamed, or changed since.
+ */
+static void
+wl_escan_stream_reset(struct bcm_cfg80211 *cfg, wl_scan_results_t *list)
+{
+	struct wl_escan_stream *stream = &cfg->escan_info.stream;
+
+	bzero(stream, sizeof(*stream));
+	stream->list = list;
+	stream->window_start = jiffies;
+}
+
+#ifndef WL_DRV_AVOID_SCANCACHE
+/* Entries moved inside the buffer, let the completion pass inform all of them */
+static inline void
+wl_escan_stream_invalidate(struct bcm_cfg80211 *cfg)
+{
+	bzero(cfg->escan_info.stream.informed, sizeof(cfg->escan_info.stream.informed));
+}
+
+/* Inform the entry at position idx of list now if the rate limit allows it */
+static void
+wl_escan_stream_bss(struct bcm_cfg80211 *cfg, wl_scan_results_t *list, u32 idx,
+	wl_bss_info_t *bss, bool changed)
+{
+	struct wl_escan_stream *stream = &cfg->escan_info.stream;
+
+	if (stream->list != list) {
+		wl_escan_stream_reset(cfg, list);
+	}
+	if (idx >= WL_ESCAN_STREAM_MAX_BSS) {
+		return;
+	}
+
+	/* p2p discovery results are only needed once the search is over */
+	if (!changed || scan_req_match(cfg)) {
+		clrbit(stream->informed, idx);
+		return;
+	}
+
+	if (time_after(jiffies, stream->window_start +
+		msecs_to_jiffies(WL_ESCAN_STREAM_WINDOW_MS))) {
+		stream->window_start = jiffies;
+		stream->window_cnt = 0;
+	}
+	if (stream->window_cnt >= WL_ESCAN_STREAM_BURST) {
+		clrbit(stream->informed, idx);
+		stream->deferred++;
+		return;
+	}
+
+	if (wl_inform_single_bss(cfg, bss, false) == BCME_OK) {
+		setbit(stream->informed, idx);
+		stream->window_cnt++;
+		stream->streamed++;
+	} else {
+		clrbit(stream->informed, idx);
+	}
+}
+#endif /* !WL_DRV_AVOID_SCANCACHE */
+#endif /* WL_ESCAN_STREAM */
+
 static s32
 wl_inform_bss(struct bcm_cfg80211 *cfg)
 {
@@ -467,9 +534,19 @@ wl_inform_bss(struct bcm_cfg80211 *cfg)
 	wl_bss_info_t *bi = NULL;	/* must be initialized */
 	s32 err = 0;
 	s32 i;
+#ifdef WL_ESCAN_STREAM
+	struct wl_escan_stream *stream = &cfg->escan_info.stream;
+	bool streamed = (stream->list == cfg->bss_list);
+#endif /* WL_ESCAN_STREAM */
 
 	bss_list = cfg->bss_list;
 	WL_INFORM_MEM(("scanned AP count (%d)\n", bss_list->count));
+#ifdef WL_ESCAN_STREAM
+	if (streamed) {
+		WL_INFORM_MEM(("streamed %u, deferred %u while scanning\n",
+			stream->streamed, stream->deferred));
+	}
+#endif /* WL_ESCAN_STREAM */
 #ifdef ESCAN_CHANNEL_CACHE
 	reset_roam_cache(cfg);
 #endif /* ESCAN_CHANNEL_CACHE */
@@ -479,12 +556,25 @@ wl_inform_bss(struct bcm_cfg80211 *cfg)
 #ifdef ESCAN_CHANNEL_CACHE
 		add_roam_cache(cfg, bi);
 #endif /* ESCAN_CHANNEL_CACHE */
+#ifdef WL_ESCAN_STREAM
+		if (streamed && ((u32)i < WL_ESCAN_STREAM_MAX_BSS) &&
+			isset(stream->informed, i)) {
+			/* cfg80211 already has this one as it is */
+			continue;
+		}
+#endif /* WL_ESCAN_STREAM */
 		err = wl_inform_single_bss(cfg, bi, false);
 		if (unlikely(err)) {
 			WL_ERR(("bss inform failed\n"));
 		}
 	}
 	preempt_enable();
+#ifdef WL_ESCAN_STREAM
+	if (streamed) {
+		/* a later inform of the same buffer is a full one */
+		stream->list = NULL;
+	}
+#endif /* WL_ESCAN_STREAM */
 	WL_MEM(("cfg80211 scan cache updated\n"));
 #ifdef ROAM_CHANNEL_CACHE
 	/* print_roam_cache(); */
@@ -754,6 +844,10 @@ wl_escan_handler(struct bcm_cfg80211 *cfg, bcm_struct_cfgdev *cfgdev,
 	wl_scan_results_t *list;
 	wl_bss_info_t *bss = NULL;
 	u32 i;
+#ifdef WL_ESCAN_STREAM
+	s16 prev_rssi;
+	u32 prev_bss_len;
+#endif /* WL_ESCAN_STREAM */
 #endif /* WL_DRV_AVOID_SCANCACHE */
 
 	WL_DBG((" enter event type : %d, status : %d \n",
@@ -938,6 +1032,10 @@ wl_escan_handler(struct bcm_cfg80211 *cfg, bcm_struct_cfgdev *cfgdev,
 					if (!(bss->flags & WL_BSS_FLAGS_FROM_BEACON) &&
 						(bi->flags & WL_BSS_FLAGS_FROM_BEACON))
 						goto exit;
+#ifdef WL_ESCAN_STREAM
+					prev_rssi = bss->RSSI;
+					prev_bss_len = dtoh32(bss->length);
+#endif /* WL_ESCAN_STREAM */
 
 					WL_DBG(("%s("MACDBG"), i=%d prev: RSSI %d"
 						" flags 0x%x, new: RSSI %d flags 0x%x\n",
@@ -984,6 +1082,9 @@ wl_escan_handler(struct bcm_cfg80211 *cfg, bcm_struct_cfgdev *cfgdev,
 							bss->RSSI = bi->RSSI;
 							bss->flags |= (bi->flags
 								& WL_BSS_FLAGS_RSSI_ONCHANNEL);
+#ifdef WL_ESCAN_STREAM
+							wl_escan_stream_bss(cfg, list, i, bss, FALSE);
+#endif /* WL_ESCAN_STREAM */
 							goto exit;
 						}
 
@@ -1016,6 +1117,17 @@ wl_escan_handler(struct bcm_cfg80211 *cfg, bcm_struct_cfgdev *cfgdev,
 						list->buflen = 0;
 						ASSERT(0);
 					}
+#ifdef WL_ESCAN_STREAM
+					else {
+						/* a beacon turned probe response, or a
+						 * large RSSI move, is worth reporting now
+						 */
+						wl_escan_stream_bss(cfg, list, i, bss,
+							(bi_length != prev_bss_len) ||
+							(ABS(bss->RSSI - prev_rssi) >=
+							WL_ESCAN_STREAM_RSSI_DELTA));
+					}
+#endif /* WL_ESCAN_STREAM */
 					goto exit;
 				}
 				cur_len += dtoh32(bss->length);
@@ -1023,6 +1135,9 @@ wl_escan_handler(struct bcm_cfg80211 *cfg, bcm_struct_cfgdev *cfgdev,
 			if (bi_length > ESCAN_BUF_SIZE - list->buflen) {
 #ifdef ESCAN_BUF_OVERFLOW_MGMT
 				wl_cfg80211_remove_lowRSSI_info(list, candidate, bi);
+#ifdef WL_ESCAN_STREAM
+				wl_escan_stream_invalidate(cfg);
+#endif /* WL_ESCAN_STREAM */
 				if (bi_length > ESCAN_BUF_SIZE - list->buflen) {
 					WL_DBG(("RSSI(" MACDBG ") is too low(%d) to add Buffer\n",
 						MAC2STRDBG(bi->BSSID.octet), bi->RSSI));
@@ -1041,6 +1156,10 @@ wl_escan_handler(struct bcm_cfg80211 *cfg, bcm_struct_cfgdev *cfgdev,
 			list->version = dtoh32(bi->version);
 			list->buflen += bi_length;
 			list->count++;
+#ifdef WL_ESCAN_STREAM
+			wl_escan_stream_bss(cfg, list, list->count - 1,
+				(wl_bss_info_t *)&(((char *)list)[list->buflen - bi_length]), TRUE);
+#endif /* WL_ESCAN_STREAM */
 
 			/*
 			 * !Broadcast && number of ssid = 1 && number of channels =1
@@ -1970,6 +2089,9 @@ wl_do_escan(struct bcm_cfg80211 *cfg, struct wiphy *wiphy, struct net_device *nd
 	results->version = 0;
 	results->count = 0;
 	results->buflen = WL_SCAN_RESULTS_FIXED_SIZE;
+#ifdef WL_ESCAN_STREAM
+	wl_escan_stream_reset(cfg, results);
+#endif /* WL_ESCAN_STREAM */
 
 	cfg->escan_info.ndev = ndev;
 	cfg->escan_info.wiphy = wiphy;
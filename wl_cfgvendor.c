@@ -521,7 +521,13 @@ wl_cfgvendor_gscan_get_batch_results(struct wiphy *wiphy,
 {
 	int err = 0;
 	struct bcm_cfg80211 *cfg = wiphy_priv(wiphy);
+#ifdef PNO_BATCH_ARENA
+	gscan_batch_arena_t *results;
+	gscan_batch_scan_t *iter;
+	uint16 scan_idx;
+#else
 	gscan_results_cache_t *results, *iter;
+#endif /* PNO_BATCH_ARENA */
 	uint32 reply_len, is_done = 1;
 	int32 mem_needed, num_results_iter;
 	wifi_gscan_result_t *ptr;
@@ -569,7 +575,13 @@ wl_cfgvendor_gscan_get_batch_results(struct wiphy *wiphy,
 		dhd_dev_pno_unlock_access_batch_results(bcmcfg_to_prmry_ndev(cfg));
 		return -ENOMEM;
 	}
+#ifdef PNO_BATCH_ARENA
+	/* Walk the arena index, results go out straight from the arena */
+	scan_idx = results->scan_idx;
+	iter = &results->scans[scan_idx];
+#else
 	iter = results;
+#endif /* PNO_BATCH_ARENA */
 	complete_flag = nla_reserve(skb, GSCAN_ATTRIBUTE_SCAN_RESULTS_COMPLETE,
 	                    sizeof(is_done));
 
@@ -613,7 +625,11 @@ wl_cfgvendor_gscan_get_batch_results(struct wiphy *wiphy,
 			goto fail;
 		}
 		if (num_results_iter) {
+#ifdef PNO_BATCH_ARENA
+			ptr = &results->results[iter->first + iter->tot_consumed];
+#else
 			ptr = &iter->results[iter->tot_consumed];
+#endif /* PNO_BATCH_ARENA */
 			err = nla_put(skb, GSCAN_ATTRIBUTE_SCAN_RESULTS,
 			 num_results_iter * sizeof(wifi_gscan_result_t), ptr);
 			if (unlikely(err)) {
@@ -624,7 +640,11 @@ wl_cfgvendor_gscan_get_batch_results(struct wiphy *wiphy,
 		nla_nest_end(skb, scan_hdr);
 		mem_needed -= GSCAN_BATCH_RESULT_HDR_LEN +
 		    (num_results_iter * sizeof(wifi_gscan_result_t));
+#ifdef PNO_BATCH_ARENA
+		iter = (++scan_idx < results->nscans) ? &results->scans[scan_idx] : NULL;
+#else
 		iter = iter->next;
+#endif /* PNO_BATCH_ARENA */
 	}
 	/* Cleans up consumed results and returns TRUE if all results are consumed */
 	is_done = dhd_dev_gscan_batch_cache_cleanup(bcmcfg_to_prmry_ndev(cfg));
@@ -6752,24 +6772,25 @@ static int wl_cfgvendor_lstats_get_bcn_mbss(char *buf, uint32 *rxbeaconmbss)
 	return BCME_OK;
 }
 
-static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
-	struct wireless_dev *wdev, const void  *data, int len)
+/* Gathers every link stats component into outdata (WLC_IOCTL_MAXLEN bytes)
+ * laid out as the HAL expects. corerev is looked up once and cached by the
+ * caller; cnt receives the cumulative counters used for host side deltas.
+ */
+static int
+wl_cfgvendor_lstats_collect(struct bcm_cfg80211 *cfg, char *outdata, uint *out_len,
+	uint32 *corerev, struct wl_lstats_cnt *cnt)
 {
 	static char iovar_buf[WLC_IOCTL_MAXLEN];
-	struct bcm_cfg80211 *cfg = wiphy_priv(wiphy);
+	struct net_device *ndev = bcmcfg_to_prmry_ndev(cfg);
 	int err = 0, i;
 	wifi_radio_stat *radio;
+	wifi_radio_stat_h *radio_h;
 #ifdef CHAN_STATS_SUPPORT
-	wifi_radio_stat_h *radio_h = NULL;
-	wifi_channel_stat *chan_stats = NULL;
 	uint msize = 0, buf_len;
-#else
-	wifi_radio_stat_h radio_h;
 #endif
 	const wl_cnt_wlc_t *wlc_cnt;
 	scb_val_t scbval;
-	char *output = NULL;
-	char *outdata = NULL;
+	char *output = outdata;
 	wifi_rate_stat_v1 *p_wifi_rate_stat_v1 = NULL;
 	wifi_rate_stat *p_wifi_rate_stat = NULL;
 	uint total_len = 0;
@@ -6779,30 +6800,23 @@ static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
 	dhd_pub_t *dhdp = (dhd_pub_t *)(cfg->pub);
 	COMPAT_STRUCT_IFACE(wifi_iface_stat, iface);
 
-	WL_TRACE(("%s: Enter \n", __func__));
-	RETURN_EIO_IF_NOT_UP(cfg);
-
 	BCM_REFERENCE(if_stats);
 	BCM_REFERENCE(dhdp);
-	/* Get the device rev info */
-	bzero(&revinfo, sizeof(revinfo));
-	err = wldev_ioctl_get(bcmcfg_to_prmry_ndev(cfg), WLC_GET_REVINFO, &revinfo,
-			sizeof(revinfo));
-	if (err != BCME_OK) {
-		goto exit;
-	}
-
-	outdata = (void *)MALLOCZ(cfg->osh, WLC_IOCTL_MAXLEN);
-	if (outdata == NULL) {
-		WL_ERR(("outdata alloc failed\n"));
-		return BCME_NOMEM;
+	if (*corerev == 0) {
+		/* Get the device rev info */
+		bzero(&revinfo, sizeof(revinfo));
+		err = wldev_ioctl_get(ndev, WLC_GET_REVINFO, &revinfo, sizeof(revinfo));
+		if (err != BCME_OK) {
+			goto exit;
+		}
+		*corerev = revinfo.corerev;
 	}
 
 	bzero(&scbval, sizeof(scb_val_t));
 	bzero(outdata, WLC_IOCTL_MAXLEN);
-	output = outdata;
+	bzero(cnt, sizeof(*cnt));
 
-	err = wldev_iovar_getbuf(bcmcfg_to_prmry_ndev(cfg), "radiostat", NULL, 0,
+	err = wldev_iovar_getbuf(ndev, "radiostat", NULL, 0,
 		iovar_buf, WLC_IOCTL_MAXLEN, NULL);
 	if (err != BCME_OK && err != BCME_UNSUPPORTED) {
 		WL_ERR(("error (%d) - size = %zu\n", err, sizeof(wifi_radio_stat)));
@@ -6810,15 +6824,8 @@ static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
 	}
 	radio = (wifi_radio_stat *)iovar_buf;
 
-#ifdef CHAN_STATS_SUPPORT
-	err = wldev_iovar_getint(bcmcfg_to_prmry_ndev(cfg), "cca_chan_cnt", &buf_len);
-	if (unlikely(err)) {
-		WL_ERR(("Could not get cca_chan_cnt %d\n", err));
-		goto exit;
-	}
-	msize = sizeof(wifi_radio_stat_h) + buf_len * sizeof(wifi_channel_stat);
-	radio_h = (void *)MALLOCZ(cfg->osh, msize);
-	bzero(radio_h, msize);
+	/* The radio stats are built in place in the reply */
+	radio_h = (wifi_radio_stat_h *)output;
 	radio_h->on_time = radio->on_time;
 	radio_h->tx_time = radio->tx_time;
 	radio_h->rx_time = radio->rx_time;
@@ -6828,33 +6835,35 @@ static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
 	radio_h->on_time_roam_scan = radio->on_time_roam_scan;
 	radio_h->on_time_pno_scan = radio->on_time_pno_scan;
 	radio_h->on_time_hs20 = radio->on_time_hs20;
+	cnt->on_time = radio->on_time;
+	cnt->tx_time = radio->tx_time;
+	cnt->rx_time = radio->rx_time;
+
+#ifdef CHAN_STATS_SUPPORT
+	err = wldev_iovar_getint(ndev, "cca_chan_cnt", &buf_len);
+	if (unlikely(err)) {
+		WL_ERR(("Could not get cca_chan_cnt %d\n", err));
+		goto exit;
+	}
 	radio_h->num_channels = buf_len;
+	msize = sizeof(wifi_radio_stat_h) + buf_len * sizeof(wifi_channel_stat);
 
+	/* fetch the channel stats straight behind the radio stats */
 	buf_len = sizeof(wifi_channel_stat) * radio_h->num_channels + (uint)strlen("cca_chan_stats") + 1;
-	chan_stats = (wifi_channel_stat *)MALLOCZ(cfg->osh, buf_len);
-	err = wldev_iovar_getbuf(bcmcfg_to_prmry_ndev(cfg), "cca_chan_stats", NULL, 0,
-		chan_stats, buf_len, NULL);
+	if ((sizeof(wifi_radio_stat_h) + buf_len) > WLC_IOCTL_MAXLEN) {
+		WL_ERR(("cca_chan_stats num_channels = %d too large\n", radio_h->num_channels));
+		err = BCME_BUFTOOSHORT;
+		goto exit;
+	}
+	err = wldev_iovar_getbuf(ndev, "cca_chan_stats", NULL, 0,
+		radio_h->channels, buf_len, NULL);
 	if (err != BCME_OK) {
 		WL_ERR(("error (%d) getting cca_chan_stats num_channels = %d\n", err, radio_h->num_channels));
 		goto exit;
 	}
-	memcpy(radio_h->channels, chan_stats, sizeof(wifi_channel_stat) * radio_h->num_channels);
-	memcpy(output, radio_h, msize);
 	output += msize;
 #else
-	bzero(&radio_h, sizeof(wifi_radio_stat_h));
-	radio_h.on_time = radio->on_time;
-	radio_h.tx_time = radio->tx_time;
-	radio_h.rx_time = radio->rx_time;
-	radio_h.on_time_scan = radio->on_time_scan;
-	radio_h.on_time_nbd = radio->on_time_nbd;
-	radio_h.on_time_gscan = radio->on_time_gscan;
-	radio_h.on_time_roam_scan = radio->on_time_roam_scan;
-	radio_h.on_time_pno_scan = radio->on_time_pno_scan;
-	radio_h.on_time_hs20 = radio->on_time_hs20;
-	radio_h.num_channels = NUM_CHAN;
-
-	memcpy(output, &radio_h, sizeof(wifi_radio_stat_h));
+	radio_h->num_channels = NUM_CHAN;
 
 	output += sizeof(wifi_radio_stat_h);
 	output += (NUM_CHAN * sizeof(wifi_channel_stat));
@@ -6866,7 +6875,7 @@ static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
 	COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].ac, WIFI_AC_BE);
 	COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BK].ac, WIFI_AC_BK);
 
-	err = wldev_iovar_getbuf(bcmcfg_to_prmry_ndev(cfg), "counters", NULL, 0,
+	err = wldev_iovar_getbuf(ndev, "counters", NULL, 0,
 		iovar_buf, WLC_IOCTL_MAXLEN, NULL);
 	if (unlikely(err)) {
 		WL_ERR(("error (%d) - size = %zu\n", err, sizeof(wl_cnt_wlc_t)));
@@ -6878,7 +6887,7 @@ static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
 	/* traditional(ver<=10)counters will use WL_CNT_XTLV_CNTV_LE10_UCODE.
 	 * Other cases will use its xtlv type accroding to corerev
 	 */
-	err = wl_cntbuf_to_xtlv_format(NULL, iovar_buf, WLC_IOCTL_MAXLEN, revinfo.corerev);
+	err = wl_cntbuf_to_xtlv_format(NULL, iovar_buf, WLC_IOCTL_MAXLEN, *corerev);
 	if (err != BCME_OK) {
 		WL_ERR(("wl_cntbuf_to_xtlv_format ERR %d\n", err));
 		goto exit;
@@ -6899,9 +6908,9 @@ static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
 	}
 
 	if (FW_SUPPORTED(dhdp, ifst)) {
-		err = wl_cfg80211_ifstats_counters(bcmcfg_to_prmry_ndev(cfg), if_stats);
+		err = wl_cfg80211_ifstats_counters(ndev, if_stats);
 	} else {
-		err = wldev_iovar_getbuf(bcmcfg_to_prmry_ndev(cfg), "if_counters",
+		err = wldev_iovar_getbuf(ndev, "if_counters",
 			NULL, 0, (char *)if_stats, sizeof(*if_stats), NULL);
 	}
 
@@ -6911,30 +6920,34 @@ static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
 			WL_ERR(("incorrect version of wl_if_stats_t,"
 				" expected=%u got=%u\n", WL_IF_STATS_T_VERSION,
 				if_stats->version));
+			err = BCME_VERSION;
 			goto exit;
 		}
-		COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].tx_mpdu, (uint32)if_stats->txframe);
-		COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].rx_mpdu,
-			(uint32)(if_stats->rxframe - if_stats->rxmulti));
-		COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].mpdu_lost, (uint32)if_stats->txfail);
-		COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].retries, (uint32)if_stats->txretrans);
+		cnt->tx_mpdu = (uint32)if_stats->txframe;
+		cnt->rx_mpdu = (uint32)(if_stats->rxframe - if_stats->rxmulti);
+		cnt->mpdu_lost = (uint32)if_stats->txfail;
+		cnt->retries = (uint32)if_stats->txretrans;
 	} else
 #endif /* !DISABLE_IF_COUNTERS */
 	{
-		COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].tx_mpdu,
-			(wlc_cnt->txfrmsnt - wlc_cnt->txmulti));
-		COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].rx_mpdu, wlc_cnt->rxframe);
-		COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].mpdu_lost, wlc_cnt->txfail);
-		COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].retries, wlc_cnt->txretrans);
+		cnt->tx_mpdu = wlc_cnt->txfrmsnt - wlc_cnt->txmulti;
+		cnt->rx_mpdu = wlc_cnt->rxframe;
+		cnt->mpdu_lost = wlc_cnt->txfail;
+		cnt->retries = wlc_cnt->txretrans;
 	}
+	COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].tx_mpdu, cnt->tx_mpdu);
+	COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].rx_mpdu, cnt->rx_mpdu);
+	COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].mpdu_lost, cnt->mpdu_lost);
+	COMPAT_ASSIGN_VALUE(iface, ac[WIFI_AC_BE].retries, cnt->retries);
 
 	err = wl_cfgvendor_lstats_get_bcn_mbss(iovar_buf, &rxbeaconmbss);
 	if (unlikely(err)) {
 		WL_ERR(("get_bcn_mbss error (%d)\n", err));
 		goto exit;
 	}
+	cnt->beacon_rx = rxbeaconmbss;
 
-	err = wldev_get_rssi(bcmcfg_to_prmry_ndev(cfg), &scbval);
+	err = wldev_get_rssi(ndev, &scbval);
 	if (unlikely(err)) {
 		WL_ERR(("get_rssi error (%d)\n", err));
 		goto exit;
@@ -6947,7 +6960,7 @@ static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
 
 	COMPAT_MEMCOPY_IFACE(output, total_len, wifi_iface_stat, iface, wifi_rate_stat);
 
-	err = wldev_iovar_getbuf(bcmcfg_to_prmry_ndev(cfg), "ratestat", NULL, 0,
+	err = wldev_iovar_getbuf(ndev, "ratestat", NULL, 0,
 		iovar_buf, WLC_IOCTL_MAXLEN, NULL);
 	if (err != BCME_OK && err != BCME_UNSUPPORTED) {
 		WL_ERR(("error (%d) - size = %zu\n", err, NUM_RATE*sizeof(wifi_rate_stat)));
@@ -6989,26 +7002,219 @@ static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
 		err = BCME_BADLEN;
 		goto exit;
 	}
-	err =  wl_cfgvendor_send_cmd_reply(wiphy, outdata, total_len);
+	*out_len = total_len;
+
+exit:
+	if (if_stats) {
+		MFREE(cfg->osh, if_stats, sizeof(wl_if_stats_t));
+	}
+	return err;
+}
+
+#ifdef WL_LSTATS_SNAPSHOT
+/*
+ * Link stats polls within this many ms of a refresh are served from the cache.
+ * -1 follows the poll period, 0 disables the cache.
+ */
+static int wl_lstats_fresh_ms = -1;
+module_param(wl_lstats_fresh_ms, int, 0660);
+
+/* 3/4 of the poll period, so the next periodic poll always refreshes */
+static u32
+wl_cfgvendor_lstats_window_ms(struct wl_lstats_snap *snap)
+{
+	if (wl_lstats_fresh_ms >= 0) {
+		return (u32)wl_lstats_fresh_ms;
+	}
+	return snap->period_ms - (snap->period_ms / 4);
+}
+
+static void
+wl_cfgvendor_lstats_track_poll(struct wl_lstats_snap *snap)
+{
+	unsigned long now = jiffies;
+	u32 gap;
+
+	if (snap->last_poll) {
+		gap = jiffies_to_msecs(now - snap->last_poll);
+		if (gap <= WL_LSTATS_POLL_MAX_MS) {
+			snap->period_ms = snap->period_ms - (snap->period_ms / 8) + (gap / 8);
+		}
+	}
+	snap->last_poll = now;
+}
+
+/* Counters restart from zero when the dongle is reloaded */
+#define WL_LSTATS_DELTA(cur, prev)	(((cur) >= (prev)) ? ((cur) - (prev)) : (cur))
+
+static void
+wl_cfgvendor_lstats_update_delta(struct wl_lstats_snap *snap, const struct wl_lstats_cnt *cur,
+	bool rebase)
+{
+	struct wl_lstats_cnt *prev = &snap->cnt;
+	struct wl_lstats_cnt *delta = &snap->delta;
+	unsigned long now = jiffies;
+
+	if (rebase || !snap->refreshed) {
+		/* no baseline yet, or the dongle restarted its counters */
+		bzero(delta, sizeof(*delta));
+		snap->delta_ms = 0;
+		*prev = *cur;
+		snap->stamp = now;
+		return;
+	}
+
+	snap->delta_ms = jiffies_to_msecs(now - snap->stamp);
+	snap->stamp = now;
+	delta->on_time = WL_LSTATS_DELTA(cur->on_time, prev->on_time);
+	delta->tx_time = WL_LSTATS_DELTA(cur->tx_time, prev->tx_time);
+	delta->rx_time = WL_LSTATS_DELTA(cur->rx_time, prev->rx_time);
+	delta->tx_mpdu = WL_LSTATS_DELTA(cur->tx_mpdu, prev->tx_mpdu);
+	delta->rx_mpdu = WL_LSTATS_DELTA(cur->rx_mpdu, prev->rx_mpdu);
+	delta->mpdu_lost = WL_LSTATS_DELTA(cur->mpdu_lost, prev->mpdu_lost);
+	delta->retries = WL_LSTATS_DELTA(cur->retries, prev->retries);
+	delta->beacon_rx = WL_LSTATS_DELTA(cur->beacon_rx, prev->beacon_rx);
+	*prev = *cur;
+
+	WL_DBG(("lstats delta: on %u tx %u rx %u ms, mpdu tx %u rx %u lost %u retry %u,"
+		" bcn %u (refreshed %u served %u)\n", delta->on_time, delta->tx_time,
+		delta->rx_time, delta->tx_mpdu, delta->rx_mpdu, delta->mpdu_lost,
+		delta->retries, delta->beacon_rx, snap->refreshed, snap->served));
+}
+
+static void
+wl_cfgvendor_lstats_snap_init(struct bcm_cfg80211 *cfg)
+{
+	struct wl_lstats_snap *snap = &cfg->lstats_snap;
+
+	bzero(snap, sizeof(*snap));
+	mutex_init(&snap->lock);
+	snap->period_ms = WL_LSTATS_POLL_MS;
+}
+
+static void
+wl_cfgvendor_lstats_snap_deinit(struct bcm_cfg80211 *cfg)
+{
+	struct wl_lstats_snap *snap = &cfg->lstats_snap;
+
+	mutex_lock(&snap->lock);
+	if (snap->buf) {
+		MFREE(cfg->osh, snap->buf, WLC_IOCTL_MAXLEN);
+		snap->buf = NULL;
+	}
+	snap->valid = FALSE;
+	mutex_unlock(&snap->lock);
+}
+
+/* Text dump of the snapshot state and the last per refresh deltas */
+int
+wl_cfgvendor_lstats_dump(struct bcm_cfg80211 *cfg, char *buf, int buflen)
+{
+	struct wl_lstats_snap *snap = &cfg->lstats_snap;
+	struct wl_lstats_cnt *d = &snap->delta;
+	int len;
+
+	mutex_lock(&snap->lock);
+	len = scnprintf(buf, buflen,
+		"refreshed %u served %u period %u ms window %u ms%s\n"
+		"delta over %u ms: on %u tx %u rx %u ms\n"
+		"mpdu tx %u rx %u lost %u retries %u beacons %u\n",
+		snap->refreshed, snap->served, snap->period_ms,
+		wl_cfgvendor_lstats_window_ms(snap), snap->stale ? " (stale)" : "",
+		snap->delta_ms, d->on_time, d->tx_time, d->rx_time,
+		d->tx_mpdu, d->rx_mpdu, d->mpdu_lost, d->retries, d->beacon_rx);
+	mutex_unlock(&snap->lock);
+
+	return len;
+}
+#endif /* WL_LSTATS_SNAPSHOT */
+
+static int wl_cfgvendor_lstats_get_info(struct wiphy *wiphy,
+	struct wireless_dev *wdev, const void  *data, int len)
+{
+	struct bcm_cfg80211 *cfg = wiphy_priv(wiphy);
+	int err = 0;
+	struct wl_lstats_cnt cnt;
+	uint total_len = 0;
+#ifdef WL_LSTATS_SNAPSHOT
+	struct wl_lstats_snap *snap = &cfg->lstats_snap;
+	bool compat = FALSE;
+	bool rebase;
+#else
+	char *outdata = NULL;
+	uint32 corerev = 0;
+#endif /* WL_LSTATS_SNAPSHOT */
+
+	WL_TRACE(("%s: Enter \n", __func__));
+	RETURN_EIO_IF_NOT_UP(cfg);
+
+#ifdef WL_LSTATS_SNAPSHOT
+#ifdef CONFIG_COMPAT
+	/* the reply layout depends on the caller */
+	compat = is_compat_task() ? TRUE : FALSE;
+#endif /* CONFIG_COMPAT */
+	mutex_lock(&snap->lock);
+	wl_cfgvendor_lstats_track_poll(snap);
+	if (snap->valid && !snap->stale && snap->compat == compat &&
+		time_before(jiffies, snap->stamp +
+		msecs_to_jiffies(wl_cfgvendor_lstats_window_ms(snap)))) {
+		snap->served++;
+		err = wl_cfgvendor_send_cmd_reply(wiphy, snap->buf, snap->len);
+		goto exit;
+	}
+
+	if (!snap->buf) {
+		snap->buf = (char *)MALLOCZ(cfg->osh, WLC_IOCTL_MAXLEN);
+		if (snap->buf == NULL) {
+			WL_ERR(("outdata alloc failed\n"));
+			err = BCME_NOMEM;
+			goto exit;
+		}
+	}
+	snap->valid = FALSE;
+	/* a link change or reset while collecting marks the new snapshot stale again */
+	snap->stale = FALSE;
+	rebase = snap->rebase;
+	snap->rebase = FALSE;
+	err = wl_cfgvendor_lstats_collect(cfg, snap->buf, &total_len, &snap->corerev, &cnt);
+	if (err != BCME_OK) {
+		if (rebase) {
+			snap->rebase = TRUE;
+		}
+		goto exit;
+	}
+	snap->len = total_len;
+	snap->compat = compat;
+	wl_cfgvendor_lstats_update_delta(snap, &cnt, rebase);
+	snap->refreshed++;
+	snap->valid = TRUE;
+
+	err = wl_cfgvendor_send_cmd_reply(wiphy, snap->buf, snap->len);
+#else
+	outdata = (void *)MALLOCZ(cfg->osh, WLC_IOCTL_MAXLEN);
+	if (outdata == NULL) {
+		WL_ERR(("outdata alloc failed\n"));
+		return BCME_NOMEM;
+	}
+
+	err = wl_cfgvendor_lstats_collect(cfg, outdata, &total_len, &corerev, &cnt);
+	if (err != BCME_OK) {
+		goto exit;
+	}
+	err = wl_cfgvendor_send_cmd_reply(wiphy, outdata, total_len);
+#endif /* WL_LSTATS_SNAPSHOT */
 
 	if (unlikely(err))
 		WL_ERR(("Vendor Command reply failed ret:%d \n", err));
 
 exit:
+#ifdef WL_LSTATS_SNAPSHOT
+	mutex_unlock(&snap->lock);
+#else
 	if (outdata) {
 		MFREE(cfg->osh, outdata, WLC_IOCTL_MAXLEN);
 	}
-	if (if_stats) {
-		MFREE(cfg->osh, if_stats, sizeof(wl_if_stats_t));
-	}
-#ifdef CHAN_STATS_SUPPORT
-	if (chan_stats) {
-		MFREE(cfg->osh, chan_stats, sizeof(wifi_channel_stat) * radio_h->num_channels);
-	}
-	if (radio_h) {
-		MFREE(cfg->osh, radio_h, msize);
-	}
-#endif /* CHAN_STATS_SUPPORT */
+#endif /* WL_LSTATS_SNAPSHOT */
 	return err;
 }
 #endif /* LINKSTAT_SUPPORT */
@@ -10353,6 +10559,10 @@ int wl_cfgvendor_attach(struct wiphy *wiphy, dhd_pub_t *dhd)
 	wiphy->vendor_events	= wl_vendor_events;
 	wiphy->n_vendor_events	= ARRAY_SIZE(wl_vendor_events);
 
+#if defined(LINKSTAT_SUPPORT) && defined(WL_LSTATS_SNAPSHOT)
+	wl_cfgvendor_lstats_snap_init(wiphy_priv(wiphy));
+#endif /* LINKSTAT_SUPPORT && WL_LSTATS_SNAPSHOT */
+
 #ifdef DEBUGABILITY
 	dhd_os_dbg_register_callback(FW_VERBOSE_RING_ID, wl_cfgvendor_dbg_ring_send_evt);
 	dhd_os_dbg_register_callback(DRIVER_LOG_RING_ID, wl_cfgvendor_dbg_ring_send_evt);
@@ -10369,6 +10579,10 @@ int wl_cfgvendor_detach(struct wiphy *wiphy)
 {
 	WL_INFORM_MEM(("Vendor: Unregister BRCM cfg80211 vendor interface \n"));
 
+#if defined(LINKSTAT_SUPPORT) && defined(WL_LSTATS_SNAPSHOT)
+	wl_cfgvendor_lstats_snap_deinit(wiphy_priv(wiphy));
+#endif /* LINKSTAT_SUPPORT && WL_LSTATS_SNAPSHOT */
+
 	wiphy->vendor_commands  = NULL;
 	wiphy->vendor_events    = NULL;
 	wiphy->n_vendor_commands = 0;
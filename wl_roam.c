@@ -35,23 +35,52 @@
 #endif /* defined(__linux__) */
 
 #ifdef ESCAN_CHANNEL_CACHE
-#define MAX_ROAM_CACHE		200
 #define MAX_SSID_BUFSIZE	36
+#define MAX_ROAM_CACHE_SSID	16	/* SSIDs tracked, least recently used is evicted */
+#define MAX_ROAM_CACHE_CHAN	24	/* channels tracked per SSID */
+
+/*
+ * Each sighting of the SSID on a channel scores 1 and each association on it
+ * scores ROAM_CACHE_ASSOC_WEIGHT. Scores halve every ROAM_CACHE_HALFLIFE_MS,
+ * and channels not seen for ROAM_CACHE_EXPIRE_MS are no longer handed out.
+ */
+#define ROAM_CACHE_ASSOC_WEIGHT	8u
+#define ROAM_CACHE_HALFLIFE_MS	(5u * 60u * 1000u)
+#define ROAM_CACHE_EXPIRE_MS	(30u * 60u * 1000u)
+#define ROAM_CACHE_CNT_MAX	0xFFFFu
+
+typedef struct {
+	chanspec_t chanspec;	/* band | band_bw | control channel */
+	uint16 hits;		/* decayed scan sightings */
+	uint16 assoc;		/* decayed associations */
+	uint16 PAD;
+	uint32 last_seen;	/* OSL_SYSUPTIME() of the last sighting */
+	uint32 decayed;		/* OSL_SYSUPTIME() the counters were last halved at */
+} roam_cache_chan_t;
 
 typedef struct {
-	chanspec_t chanspec;
 	int ssid_len;
 	char ssid[MAX_SSID_BUFSIZE];
+	uint32 last_used;	/* OSL_SYSUPTIME() of the last update or lookup */
+	int n_chan;
+	roam_cache_chan_t chan[MAX_ROAM_CACHE_CHAN];
 } roam_channel_cache;
 
 static int n_roam_cache = 0;
 static int roam_band = WLC_BAND_AUTO;
-static roam_channel_cache roam_cache[MAX_ROAM_CACHE];
+static roam_channel_cache roam_cache[MAX_ROAM_CACHE_SSID];
+/* updated from the scan result path with preemption disabled */
+static DEFINE_SPINLOCK(roam_cache_lock);
 static uint band_bw;
+#ifdef WES_SUPPORT
+/* channels pinned by the WES roamscan commands */
+static int n_wes_chanspec = 0;
+static chanspec_t wes_chanspec[MAX_ROAM_CHANNEL];
+#endif /* WES_SUPPORT */
 
 #ifdef ROAM_CHANNEL_CACHE
 void update_roam_cache(struct bcm_cfg80211 *cfg, int ioctl_ver);
-static void add_roam_cache_list(uint8 *SSID, uint32 SSID_len, chanspec_t chanspec);
+static void add_roam_cache_list(uint8 *SSID, uint32 SSID_len, chanspec_t chanspec, bool assoc);
 
 int init_roam_cache(struct bcm_cfg80211 *cfg, int ioctl_ver)
 {
@@ -74,6 +103,9 @@ int init_roam_cache(struct bcm_cfg80211 *cfg, int ioctl_ver)
 #endif /* D11AC_IOTYPES */
 
 	n_roam_cache = 0;
+#ifdef WES_SUPPORT
+	n_wes_chanspec = 0;
+#endif /* WES_SUPPORT */
 	roam_band = WLC_BAND_AUTO;
 	cfg->roamscan_mode = ROAMSCAN_MODE_NORMAL;
 
@@ -135,7 +167,7 @@ int set_roamscan_mode(struct net_device *dev, int mode)
 	struct bcm_cfg80211 *cfg = wl_get_cfg(dev);
 	int error = 0;
 	cfg->roamscan_mode = mode;
-	n_roam_cache = 0;
+	n_wes_chanspec = 0;
 
 	error = wldev_iovar_setint(dev, "roamscan_mode", mode);
 	if (error) {
@@ -194,13 +226,13 @@ int set_roamscan_channel_list(struct net_device *dev,
 		} else {
 			chanspec = WL_CHANSPEC_BAND_5G | band_bw | channels[i];
 		}
-		roam_cache[i].chanspec = chanspec;
+		wes_chanspec[i] = chanspec;
 		channel_list.channels[i] = chanspec;
 
 		WL_DBG(("channel[%d] - [%02d] \n", i, channels[i]));
 	}
 
-	n_roam_cache = n;
+	n_wes_chanspec = n;
 	channel_list.n = n;
 
 	/* need to set ROAMSCAN_MODE_NORMAL to update roamscan_channels,
@@ -283,7 +315,7 @@ add_roamscan_channel_list(struct net_device *dev, char *pcmd, int ioctl_ver)
 		} else {
 			chanspec = WL_CHANSPEC_BAND_5G | band_bw | channel;
 		}
-		add_roam_cache_list(ssid.SSID, ssid.SSID_len, chanspec);
+		add_roam_cache_list(ssid.SSID, ssid.SSID_len, chanspec, FALSE);
 
 		WL_DBG(("channel[%d] - [%02d:%s] SSID %s\n", i, channel,
 			wf_chspec_ntoa_ex(chanspec, chanbuf), ssid.SSID));
@@ -301,48 +333,219 @@ void set_roam_band(int band)
 	roam_band = band;
 }
 
-void reset_roam_cache(struct bcm_cfg80211 *cfg)
+static bool
+roam_band_match(int band, chanspec_t ch)
 {
-	if (!cfg->rcc_enabled) {
+	return ((band == WLC_BAND_AUTO) ||
+#ifdef WL_6G_BAND
+		((band == WLC_BAND_6G) && (CHSPEC_IS6G(ch))) ||
+#endif /* WL_6G_BAND */
+		((band == WLC_BAND_2G) && (CHSPEC_IS2G(ch))) ||
+		((band == WLC_BAND_5G) && (CHSPEC_IS5G(ch))));
+}
+
+/* Halve the counters once per elapsed half-life */
+static void
+roam_cache_decay(roam_cache_chan_t *c, uint32 now)
+{
+	uint32 steps = (now - c->decayed) / ROAM_CACHE_HALFLIFE_MS;
+
+	if (steps == 0) {
 		return;
 	}
+	if (steps >= 16u) {
+		c->hits = 0;
+		c->assoc = 0;
+	} else {
+		c->hits >>= steps;
+		c->assoc >>= steps;
+	}
+	c->decayed += steps * ROAM_CACHE_HALFLIFE_MS;
+}
 
-#ifdef WES_SUPPORT
-	if (cfg->roamscan_mode == ROAMSCAN_MODE_WES)
-		return;
-#endif /* WES_SUPPORT */
+static uint32
+roam_cache_score(const roam_cache_chan_t *c, uint32 now)
+{
+	uint32 steps = (now - c->decayed) / ROAM_CACHE_HALFLIFE_MS;
+	uint32 score = c->hits + (ROAM_CACHE_ASSOC_WEIGHT * c->assoc);
 
-	n_roam_cache = 0;
+	return (steps >= 32u) ? 0 : (score >> steps);
 }
 
-static void
-add_roam_cache_list(uint8 *SSID, uint32 SSID_len, chanspec_t chanspec)
+static roam_channel_cache *
+roam_cache_find_ssid(const uint8 *SSID, uint32 SSID_len)
 {
 	int i;
-	uint8 channel;
-	char chanbuf[CHANSPEC_STR_LEN];
-
-	if (n_roam_cache >= MAX_ROAM_CACHE) {
-		return;
-	}
 
 	for (i = 0; i < n_roam_cache; i++) {
 		if ((roam_cache[i].ssid_len == SSID_len) &&
-			(roam_cache[i].chanspec == chanspec) &&
 			(memcmp(roam_cache[i].ssid, SSID, SSID_len) == 0)) {
-			/* identical one found, just return */
-			return;
+			return &roam_cache[i];
 		}
 	}
 
-	roam_cache[n_roam_cache].ssid_len = SSID_len;
+	return NULL;
+}
+
+/* Find the entry of an SSID, recycling the least recently used one if new */
+static roam_channel_cache *
+roam_cache_get_ssid(const uint8 *SSID, uint32 SSID_len, uint32 now)
+{
+	roam_channel_cache *rc;
+	int i;
+
+	rc = roam_cache_find_ssid(SSID, SSID_len);
+	if (rc) {
+		return rc;
+	}
+
+	if (n_roam_cache < MAX_ROAM_CACHE_SSID) {
+		rc = &roam_cache[n_roam_cache++];
+	} else {
+		rc = &roam_cache[0];
+		for (i = 1; i < MAX_ROAM_CACHE_SSID; i++) {
+			if ((now - roam_cache[i].last_used) > (now - rc->last_used)) {
+				rc = &roam_cache[i];
+			}
+		}
+		WL_DBG(("evict SSID %.*s\n", rc->ssid_len, rc->ssid));
+	}
+
+	bzero(rc, sizeof(*rc));
+	rc->ssid_len = SSID_len;
+	(void)memcpy_s(rc->ssid, sizeof(rc->ssid), SSID, SSID_len);
+
+	return rc;
+}
+
+/*
+ * Fill chspecs with the live channels of rc, best score first and most
+ * recently seen first among equal scores. Returns the number of channels.
+ */
+static int
+roam_cache_rank(const roam_channel_cache *rc, uint32 now, chanspec_t *chspecs, int max)
+{
+	uint8 order[MAX_ROAM_CACHE_CHAN];
+	uint32 score[MAX_ROAM_CACHE_CHAN];
+	int i, j, n = 0;
+
+	for (i = 0; i < rc->n_chan; i++) {
+		const roam_cache_chan_t *c = &rc->chan[i];
+		uint32 s;
+
+		if ((now - c->last_seen) > ROAM_CACHE_EXPIRE_MS) {
+			continue;
+		}
+		s = roam_cache_score(c, now);
+		for (j = n; j > 0; j--) {
+			const roam_cache_chan_t *p = &rc->chan[order[j - 1]];
+
+			if ((score[j - 1] > s) || ((score[j - 1] == s) &&
+				((now - p->last_seen) <= (now - c->last_seen)))) {
+				break;
+			}
+			order[j] = order[j - 1];
+			score[j] = score[j - 1];
+		}
+		order[j] = (uint8)i;
+		score[j] = s;
+		n++;
+	}
+
+	n = MIN(n, max);
+	for (i = 0; i < n; i++) {
+		chspecs[i] = rc->chan[order[i]].chanspec;
+	}
+
+	return n;
+}
+
+/* Ranked channels of an SSID, also marking the SSID as recently used */
+static int
+roam_cache_get_ranked(const uint8 *SSID, uint32 SSID_len, chanspec_t *chspecs, int max)
+{
+	roam_channel_cache *rc;
+	uint32 now = OSL_SYSUPTIME();
+	unsigned long flags;
+	int n = 0;
+
+	spin_lock_irqsave(&roam_cache_lock, flags);
+	rc = roam_cache_find_ssid(SSID, SSID_len);
+	if (rc) {
+		rc->last_used = now;
+		n = roam_cache_rank(rc, now, chspecs, max);
+	}
+	spin_unlock_irqrestore(&roam_cache_lock, flags);
+
+	return n;
+}
+
+void reset_roam_cache(struct bcm_cfg80211 *cfg)
+{
+	/*
+	 * Entries now age out by themselves, so a new scan no longer drops
+	 * what was learned from the previous ones.
+	 */
+	BCM_REFERENCE(cfg);
+}
+
+static void
+add_roam_cache_list(uint8 *SSID, uint32 SSID_len, chanspec_t chanspec, bool assoc)
+{
+	roam_channel_cache *rc;
+	roam_cache_chan_t *c = NULL;
+	uint32 now = OSL_SYSUPTIME();
+	unsigned long flags;
+	uint8 channel;
+	int i;
+	char chanbuf[CHANSPEC_STR_LEN];
+
+	if ((SSID_len == 0) || (SSID_len > DOT11_MAX_SSID_LEN)) {
+		return;
+	}
+
 	channel = wf_chspec_ctlchan(chanspec);
-	WL_DBG(("CHSPEC  = %s, CTL %d SSID %s\n",
-		wf_chspec_ntoa_ex(chanspec, chanbuf), channel, SSID));
-	roam_cache[n_roam_cache].chanspec = CHSPEC_BAND(chanspec) | band_bw | channel;
-	(void)memcpy_s(roam_cache[n_roam_cache].ssid, SSID_len, SSID, SSID_len);
+	WL_DBG(("CHSPEC  = %s, CTL %d SSID %.*s%s\n",
+		wf_chspec_ntoa_ex(chanspec, chanbuf), channel, (int)SSID_len, SSID,
+		assoc ? " (assoc)" : ""));
+	chanspec = CHSPEC_BAND(chanspec) | band_bw | channel;
+
+	spin_lock_irqsave(&roam_cache_lock, flags);
+	rc = roam_cache_get_ssid(SSID, SSID_len, now);
+	for (i = 0; i < rc->n_chan; i++) {
+		if (rc->chan[i].chanspec == chanspec) {
+			c = &rc->chan[i];
+			break;
+		}
+	}
+	if (c == NULL) {
+		if (rc->n_chan < MAX_ROAM_CACHE_CHAN) {
+			c = &rc->chan[rc->n_chan++];
+		} else {
+			/* recycle the channel seen longest ago */
+			c = &rc->chan[0];
+			for (i = 1; i < MAX_ROAM_CACHE_CHAN; i++) {
+				if ((now - rc->chan[i].last_seen) > (now - c->last_seen)) {
+					c = &rc->chan[i];
+				}
+			}
+		}
+		bzero(c, sizeof(*c));
+		c->chanspec = chanspec;
+		c->decayed = now;
+	}
 
-	n_roam_cache++;
+	roam_cache_decay(c, now);
+	if (assoc) {
+		if (c->assoc < ROAM_CACHE_CNT_MAX) {
+			c->assoc++;
+		}
+	} else if (c->hits < ROAM_CACHE_CNT_MAX) {
+		c->hits++;
+	}
+	c->last_seen = now;
+	rc->last_used = now;
+	spin_unlock_irqrestore(&roam_cache_lock, flags);
 }
 
 void
@@ -358,7 +561,27 @@ add_roam_cache(struct bcm_cfg80211 *cfg, wl_bss_info_t *bi)
 	}
 #endif /* WES_SUPPORT */
 
-	add_roam_cache_list(bi->SSID, bi->SSID_len, bi->chanspec);
+	add_roam_cache_list(bi->SSID, bi->SSID_len, bi->chanspec, FALSE);
+}
+
+/* Credit the channel of the BSS just associated or roamed to */
+void
+wl_roam_cache_assoc_done(struct bcm_cfg80211 *cfg, struct net_device *dev)
+{
+	wlc_ssid_t *ssid;
+	chanspec_t *chanspec;
+
+	if (!cfg->rcc_enabled) {
+		return;
+	}
+
+	ssid = (wlc_ssid_t *)wl_read_prof(cfg, dev, WL_PROF_SSID);
+	chanspec = (chanspec_t *)wl_read_prof(cfg, dev, WL_PROF_CHAN);
+	if ((ssid == NULL) || (chanspec == NULL) || (*chanspec == INVCHANSPEC)) {
+		return;
+	}
+
+	add_roam_cache_list(ssid->SSID, ssid->SSID_len, *chanspec, TRUE);
 }
 
 static bool is_duplicated_channel(const chanspec_t *channels, int n_channels, chanspec_t new)
@@ -376,7 +599,8 @@ static bool is_duplicated_channel(const chanspec_t *channels, int n_channels, ch
 int get_roam_channel_list(struct bcm_cfg80211 *cfg, chanspec_t target_chan,
 	chanspec_t *channels, int n_channels, const wlc_ssid_t *ssid, int ioctl_ver)
 {
-	int i, n = 0;
+	int i, n = 0, n_ranked;
+	chanspec_t ranked[MAX_ROAM_CACHE_CHAN];
 	char chanbuf[CHANSPEC_STR_LEN];
 
 	/* first index is filled with the given target channel */
@@ -389,14 +613,9 @@ int get_roam_channel_list(struct bcm_cfg80211 *cfg, chanspec_t target_chan,
 
 #ifdef WES_SUPPORT
 	if (cfg->roamscan_mode == ROAMSCAN_MODE_WES) {
-		for (i = 0; i < n_roam_cache; i++) {
-			chanspec_t ch = roam_cache[i].chanspec;
-			bool band_match = ((roam_band == WLC_BAND_AUTO) ||
-#ifdef WL_6G_BAND
-				((roam_band == WLC_BAND_6G) && (CHSPEC_IS6G(ch))) ||
-#endif /* WL_6G_BAND */
-				((roam_band == WLC_BAND_2G) && (CHSPEC_IS2G(ch))) ||
-				((roam_band == WLC_BAND_5G) && (CHSPEC_IS5G(ch))));
+		for (i = 0; i < n_wes_chanspec; i++) {
+			chanspec_t ch = wes_chanspec[i];
+			bool band_match = roam_band_match(roam_band, ch);
 
 			ch = CHSPEC_CHANNEL(ch) | CHSPEC_BAND(ch) | band_bw;
 
@@ -415,19 +634,12 @@ int get_roam_channel_list(struct bcm_cfg80211 *cfg, chanspec_t target_chan,
 	}
 #endif /* WES_SUPPORT */
 
-	for (i = 0; i < n_roam_cache; i++) {
-		chanspec_t ch = roam_cache[i].chanspec;
-		bool band_match = ((roam_band == WLC_BAND_AUTO) ||
-#ifdef WL_6G_BAND
-			((roam_band == WLC_BAND_6G) && (CHSPEC_IS6G(ch))) ||
-#endif /* WL_6G_BAND */
-			((roam_band == WLC_BAND_2G) && (CHSPEC_IS2G(ch))) ||
-			((roam_band == WLC_BAND_5G) && (CHSPEC_IS5G(ch))));
+	n_ranked = roam_cache_get_ranked(ssid->SSID, ssid->SSID_len,
+		ranked, ARRAYSIZE(ranked));
+	for (i = 0; i < n_ranked; i++) {
+		chanspec_t ch = ranked[i];
 
-		ch = CHSPEC_CHANNEL(ch) | CHSPEC_BAND(ch) | band_bw;
-		if ((roam_cache[i].ssid_len == ssid->SSID_len) &&
-			band_match && !is_duplicated_channel(channels, n, ch) &&
-			(memcmp(roam_cache[i].ssid, ssid->SSID, ssid->SSID_len) == 0)) {
+		if (roam_band_match(roam_band, ch) && !is_duplicated_channel(channels, n, ch)) {
 			/* match found, add it */
 			WL_DBG(("%s: Chanspec = %s\n", __FUNCTION__,
 				wf_chspec_ntoa_ex(ch, chanbuf)));
@@ -484,10 +696,60 @@ void print_roam_cache(struct bcm_cfg80211 *cfg)
 	WL_DBG((" %d cache\n", n_roam_cache));
 
 	for (i = 0; i < n_roam_cache; i++) {
-		roam_cache[i].ssid[roam_cache[i].ssid_len] = 0;
-		WL_DBG(("0x%02X %02d %s\n", roam_cache[i].chanspec,
-			roam_cache[i].ssid_len, roam_cache[i].ssid));
+		WL_DBG(("%02d %.*s %d chan(s)\n", roam_cache[i].ssid_len,
+			roam_cache[i].ssid_len, roam_cache[i].ssid, roam_cache[i].n_chan));
+	}
+}
+
+/* Print the cache in ranked order to buf, returns the length written */
+int wl_roam_cache_dump(char *buf, int buflen)
+{
+	struct bcmstrbuf b;
+	chanspec_t ranked[MAX_ROAM_CACHE_CHAN];
+	char chanbuf[CHANSPEC_STR_LEN];
+	uint32 now = OSL_SYSUPTIME();
+	unsigned long flags;
+	int i, j, k, n;
+
+	bcm_binit(&b, buf, buflen);
+	spin_lock_irqsave(&roam_cache_lock, flags);
+	bcm_bprintf(&b, "%d/%d SSID(s) band %d\n", n_roam_cache, MAX_ROAM_CACHE_SSID, roam_band);
+	for (i = 0; i < n_roam_cache; i++) {
+		const roam_channel_cache *rc = &roam_cache[i];
+
+		bcm_bprintf(&b, "SSID %.*s used %ums ago\n", rc->ssid_len, rc->ssid,
+			now - rc->last_used);
+		n = roam_cache_rank(rc, now, ranked, ARRAYSIZE(ranked));
+		for (j = 0; j < n; j++) {
+			const roam_cache_chan_t *c = NULL;
+
+			for (k = 0; k < rc->n_chan; k++) {
+				if (rc->chan[k].chanspec == ranked[j]) {
+					c = &rc->chan[k];
+					break;
+				}
+			}
+			if (c == NULL) {
+				continue;
+			}
+			bcm_bprintf(&b, "  %-8s score %u hits %u assoc %u seen %ums ago\n",
+				wf_chspec_ntoa_ex(c->chanspec, chanbuf), roam_cache_score(c, now),
+				c->hits, c->assoc, now - c->last_seen);
+		}
+		if (n < rc->n_chan) {
+			bcm_bprintf(&b, "  %d expired\n", rc->n_chan - n);
+		}
 	}
+#ifdef WES_SUPPORT
+	bcm_bprintf(&b, "WES %d chan(s)", n_wes_chanspec);
+	for (i = 0; i < n_wes_chanspec; i++) {
+		bcm_bprintf(&b, " %s", wf_chspec_ntoa_ex(wes_chanspec[i], chanbuf));
+	}
+	bcm_bprintf(&b, "\n");
+#endif /* WES_SUPPORT */
+	spin_unlock_irqrestore(&roam_cache_lock, flags);
+
+	return buflen - b.size;
 }
 
 static void add_roamcache_channel(wl_roam_channel_list_t *channels, chanspec_t ch)
@@ -511,7 +773,8 @@ static void add_roamcache_channel(wl_roam_channel_list_t *channels, chanspec_t c
 
 void update_roam_cache(struct bcm_cfg80211 *cfg, int ioctl_ver)
 {
-	int error, i, prev_channels;
+	int error, i, prev_channels, n_ranked;
+	chanspec_t ranked[MAX_ROAM_CACHE_CHAN];
 	wl_roam_channel_list_t channel_list;
 	char iobuf[WLC_IOCTL_SMLEN];
 	struct net_device *dev = bcmcfg_to_prmry_ndev(cfg);
@@ -549,21 +812,12 @@ void update_roam_cache(struct bcm_cfg80211 *cfg, int ioctl_ver)
 		return;
 	}
 
+	n_ranked = roam_cache_get_ranked(ssid.SSID, ssid.SSID_len,
+		ranked, ARRAYSIZE(ranked));
 	prev_channels = channel_list.n;
-	for (i = 0; i < n_roam_cache; i++) {
-		chanspec_t ch = roam_cache[i].chanspec;
-		bool band_match = ((roam_band == WLC_BAND_AUTO) ||
-#ifdef WL_6G_BAND
-			((roam_band == WLC_BAND_6G) && (CHSPEC_IS6G(ch))) ||
-#endif /* WL_6G_BAND */
-			((roam_band == WLC_BAND_2G) && (CHSPEC_IS2G(ch))) ||
-			((roam_band == WLC_BAND_5G) && (CHSPEC_IS5G(ch))));
-
-		if ((roam_cache[i].ssid_len == ssid.SSID_len) &&
-			band_match && (memcmp(roam_cache[i].ssid, ssid.SSID, ssid.SSID_len) == 0)) {
-			/* match found, add it */
-			ch = CHSPEC_CHANNEL(ch) | CHSPEC_BAND(ch) | band_bw;
-			add_roamcache_channel(&channel_list, ch);
+	for (i = 0; i < n_ranked; i++) {
+		if (roam_band_match(roam_band, ranked[i])) {
+			add_roamcache_channel(&channel_list, ranked[i]);
 		}
 	}
 	if (prev_channels != channel_list.n) {
@@ -575,7 +829,7 @@ void update_roam_cache(struct bcm_cfg80211 *cfg, int ioctl_ver)
 		}
 	}
 
-	WL_DBG(("%d AP, %d cache item(s), err=%d\n", n_roam_cache, channel_list.n, error));
+	WL_DBG(("%d cached, %d cache item(s), err=%d\n", n_ranked, channel_list.n, error));
 }
 
 void wl_update_roamscan_cache_by_band(struct net_device *dev, int band)
@@ -594,14 +848,18 @@ void wl_update_roamscan_cache_by_band(struct net_device *dev, int band)
 
 	/* in case of WES mode, update channel list by band based on the cache in DHD */
 	if (roamscan_mode) {
+#ifdef WES_SUPPORT
 		int n = 0;
-		chanlist_before.n = n_roam_cache;
+		chanlist_before.n = n_wes_chanspec;
 
-		for (n = 0; n < n_roam_cache; n++) {
-			chanspec_t ch = roam_cache[n].chanspec;
+		for (n = 0; n < n_wes_chanspec; n++) {
+			chanspec_t ch = wes_chanspec[n];
 			chanlist_before.channels[n] = CHSPEC_CHANNEL(ch) |
 				CHSPEC_BAND(ch) | band_bw;
 		}
+#else
+		chanlist_before.n = 0;
+#endif /* WES_SUPPORT */
 	} else {
 		if (band == WLC_BAND_AUTO) {
 			return;
@@ -617,13 +875,8 @@ void wl_update_roamscan_cache_by_band(struct net_device *dev, int band)
 	/* filtering by the given band */
 	for (i = 0; i < chanlist_before.n; i++) {
 		chanspec_t chspec = chanlist_before.channels[i];
-		bool band_match = ((band == WLC_BAND_AUTO) ||
-#ifdef WL_6G_BAND
-				((band == WLC_BAND_6G) && (CHSPEC_IS6G(chspec))) ||
-#endif /* WL_6G_BAND */
-				((band == WLC_BAND_2G) && (CHSPEC_IS2G(chspec))) ||
-				((band == WLC_BAND_5G) && (CHSPEC_IS5G(chspec))));
-		if (band_match) {
+
+		if (roam_band_match(band, chspec)) {
 			chanlist_after.channels[chanlist_after.n++] = chspec;
 		}
 	}